@@ -4,6 +4,7 @@
 #include <assert.h>
 #include <errno.h>
 #include <cairo.h>
+#include <zlib.h>
 
 #include "broadway-output.h"
 
@@ -14,16 +15,37 @@
  *                Basic I/O primitives                                  *
  ************************************************************************/
 
+/* Messages smaller than this are sent uncompressed */
+#define MIN_COMPRESS_SIZE 128
+
 struct BroadwayOutput {
   GOutputStream *out;
   GString *buf;
   int error;
   guint32 serial;
+
+  /* permessage-deflate, see RFC 7692 */
+  z_stream *deflate;
+  gboolean deflate_reset;
+  GByteArray *compressed;
+
+  /* Statistics for the client */
+  gint64 start_time;
+  guint64 n_messages;
+  guint64 payload_bytes;
+  guint64 wire_bytes;
+  guint64 n_roundtrips;
+  gint64 roundtrip_time;
+  gint64 max_roundtrip_time;
+  guint64 node_bytes_sent;
+  guint64 node_bytes_reused;
+  guint64 n_content_matches;
 };
 
 static void
 broadway_output_send_cmd (BroadwayOutput *output,
-                          gboolean fin, BroadwayWSOpCode code,
+                          gboolean fin, gboolean compressed,
+                          BroadwayWSOpCode code,
                           const void *buf, gsize count)
 {
   gboolean mask = FALSE;
@@ -34,7 +56,7 @@ broadway_output_send_cmd (BroadwayOutput *output,
   gboolean long_header = count > 65535;
 
   /* NB. big-endian spec => bit 0 == MSB */
-  header[0] = ( (fin ? 0x80 : 0) | (code & 0x0f) );
+  header[0] = ( (fin ? 0x80 : 0) | (compressed ? 0x40 : 0) | (code & 0x0f) );
   header[1] = ( (mask ? 0x80 : 0) |
                 (mid_header ? 126 : long_header ? 127 : count) );
   p = 2;
@@ -52,11 +74,51 @@ broadway_output_send_cmd (BroadwayOutput *output,
   // FIXME: we should really emit these as a single write
   g_output_stream_write_all (output->out, header, p, NULL, NULL, NULL);
   g_output_stream_write_all (output->out, buf, count, NULL, NULL, NULL);
+
+  output->wire_bytes += p + count;
 }
 
 void broadway_output_pong (BroadwayOutput *output)
 {
-  broadway_output_send_cmd (output, TRUE, BROADWAY_WS_CNX_PONG, NULL, 0);
+  broadway_output_send_cmd (output, TRUE, FALSE, BROADWAY_WS_CNX_PONG, NULL, 0);
+}
+
+static gboolean
+broadway_output_compress (BroadwayOutput *output)
+{
+  z_stream *zs = output->deflate;
+  gsize used;
+  int res;
+
+  zs->next_in = (Bytef *) output->buf->str;
+  zs->avail_in = output->buf->len;
+
+  g_byte_array_set_size (output->compressed, deflateBound (zs, output->buf->len) + 16);
+  used = 0;
+
+  do
+    {
+      zs->next_out = output->compressed->data + used;
+      zs->avail_out = output->compressed->len - used;
+
+      res = deflate (zs, Z_SYNC_FLUSH);
+      if (res != Z_OK && res != Z_BUF_ERROR)
+        return FALSE;
+
+      used = output->compressed->len - zs->avail_out;
+      if (zs->avail_out == 0)
+        g_byte_array_set_size (output->compressed, output->compressed->len * 2);
+    }
+  while (zs->avail_out == 0);
+
+  /* The flush ends in an empty block, which the other side adds back */
+  g_assert (used >= 4);
+  g_byte_array_set_size (output->compressed, used - 4);
+
+  if (output->deflate_reset)
+    deflateReset (zs);
+
+  return TRUE;
 }
 
 int
@@ -65,8 +127,17 @@ broadway_output_flush (BroadwayOutput *output)
   if (output->buf->len == 0)
     return TRUE;
 
-  broadway_output_send_cmd (output, TRUE, BROADWAY_WS_BINARY,
-                            output->buf->str, output->buf->len);
+  output->n_messages++;
+  output->payload_bytes += output->buf->len;
+
+  if (output->deflate != NULL &&
+      output->buf->len >= MIN_COMPRESS_SIZE &&
+      broadway_output_compress (output))
+    broadway_output_send_cmd (output, TRUE, TRUE, BROADWAY_WS_BINARY,
+                              output->compressed->data, output->compressed->len);
+  else
+    broadway_output_send_cmd (output, TRUE, FALSE, BROADWAY_WS_BINARY,
+                              output->buf->str, output->buf->len);
 
   g_string_set_size (output->buf, 0);
 
@@ -84,13 +155,82 @@ broadway_output_new (GOutputStream *out, guint32 serial)
   output->out = g_object_ref (out);
   output->buf = g_string_new ("");
   output->serial = serial;
+  output->start_time = g_get_monotonic_time ();
 
   return output;
 }
 
+/*
+ * broadway_output_enable_deflate:
+ * @output: the output
+ * @no_context_takeover: whether every message must be compressed
+ *   on its own
+ *
+ * Compresses messages as negotiated with the permessage-deflate
+ * websocket extension.
+ */
+void
+broadway_output_enable_deflate (BroadwayOutput *output,
+                                gboolean        no_context_takeover)
+{
+  g_return_if_fail (output->deflate == NULL);
+
+  output->deflate = g_new0 (z_stream, 1);
+  if (deflateInit2 (output->deflate, Z_BEST_SPEED, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+      g_warning ("Failed to initialize compression");
+      g_clear_pointer (&output->deflate, g_free);
+      return;
+    }
+
+  output->deflate_reset = no_context_takeover;
+  output->compressed = g_byte_array_new ();
+}
+
+void
+broadway_output_add_roundtrip_time (BroadwayOutput *output,
+                                    gint64          roundtrip_time)
+{
+  output->n_roundtrips++;
+  output->roundtrip_time += roundtrip_time;
+  output->max_roundtrip_time = MAX (output->max_roundtrip_time, roundtrip_time);
+}
+
+static void
+broadway_output_print_stats (BroadwayOutput *output)
+{
+  gint64 elapsed = g_get_monotonic_time () - output->start_time;
+
+  g_debug ("Client connected for %.1fs: "
+           "%" G_GUINT64_FORMAT " messages, "
+           "%" G_GUINT64_FORMAT " kB sent as %" G_GUINT64_FORMAT " kB (%.1f kB/s), "
+           "roundtrip avg %.1fms max %.1fms, "
+           "nodes %" G_GUINT64_FORMAT " kB sent, %" G_GUINT64_FORMAT " kB reused "
+           "(%" G_GUINT64_FORMAT " subtrees matched by content)",
+           elapsed / (double) G_USEC_PER_SEC,
+           output->n_messages,
+           output->payload_bytes / 1024,
+           output->wire_bytes / 1024,
+           elapsed > 0 ? output->wire_bytes / 1024.0 / (elapsed / (double) G_USEC_PER_SEC) : 0.0,
+           output->n_roundtrips > 0 ? output->roundtrip_time / 1000.0 / output->n_roundtrips : 0.0,
+           output->max_roundtrip_time / 1000.0,
+           output->node_bytes_sent / 1024,
+           output->node_bytes_reused / 1024,
+           output->n_content_matches);
+}
+
 void
 broadway_output_free (BroadwayOutput *output)
 {
+  broadway_output_print_stats (output);
+
+  if (output->deflate)
+    {
+      deflateEnd (output->deflate);
+      g_free (output->deflate);
+      g_byte_array_unref (output->compressed);
+    }
+
   g_object_unref (output->out);
   free (output);
 }
@@ -336,6 +476,148 @@ lookup_old_node (GHashTable *old_node_lookup,
 }
 
 
+/* The number of bytes it takes to send the subtree */
+static gsize
+node_size (BroadwayNode *node)
+{
+  gsize size = (2 + node->n_data) * 4;
+
+  for (guint32 i = 0; i < node->n_children; i++)
+    size += node_size (node->children[i]);
+
+  return size;
+}
+
+/***********************************
+ * Node identity is lost whenever GSK rebuilds a subtree, even if
+ * the result is the same. To avoid resending those, all nodes of the
+ * old tree are also indexed by content, using the deep hash of the
+ * nodes, and an old subtree that is deep equal to a new one can be
+ * moved into place instead.
+ *
+ * This is only safe if neither subtree shares any node between the
+ * old and the new tree, as those are handled by identity and their
+ * output ids must not change.
+ ***********************************/
+
+static guint
+node_content_hash (gconstpointer key)
+{
+  const BroadwayNode *node = key;
+
+  return node->hash;
+}
+
+static gboolean
+node_content_equal (gconstpointer a,
+                    gconstpointer b)
+{
+  return broadway_node_deep_equal ((BroadwayNode *) a, (BroadwayNode *) b);
+}
+
+static void
+add_to_content_lookup (BroadwayNode *node,
+                       GHashTable   *content_lookup)
+{
+  GPtrArray *nodes;
+
+  if (!node->reused)
+    {
+      nodes = g_hash_table_lookup (content_lookup, node);
+      if (nodes == NULL)
+        {
+          nodes = g_ptr_array_new ();
+          g_hash_table_insert (content_lookup, node, nodes);
+        }
+      g_ptr_array_add (nodes, node);
+    }
+
+  for (guint32 i = 0; i < node->n_children; i++)
+    add_to_content_lookup (node->children[i], content_lookup);
+}
+
+static gboolean
+old_subtree_is_unused (BroadwayNode *node)
+{
+  if (node->reused || node->consumed)
+    return FALSE;
+
+  for (guint32 i = 0; i < node->n_children; i++)
+    if (!old_subtree_is_unused (node->children[i]))
+      return FALSE;
+
+  return TRUE;
+}
+
+static gboolean
+new_subtree_is_unshared (BroadwayNode *node,
+                         GHashTable   *old_node_lookup)
+{
+  if (lookup_old_node (old_node_lookup, node->id) != NULL)
+    return FALSE;
+
+  for (guint32 i = 0; i < node->n_children; i++)
+    if (!new_subtree_is_unshared (node->children[i], old_node_lookup))
+      return FALSE;
+
+  return TRUE;
+}
+
+static void
+copy_output_ids (BroadwayNode *node,
+                 BroadwayNode *old_node)
+{
+  node->output_id = old_node->output_id;
+
+  for (guint32 i = 0; i < node->n_children; i++)
+    copy_output_ids (node->children[i], old_node->children[i]);
+}
+
+/* Finds an unused old subtree with the same content as @node, and
+ * makes @node take over its dom nodes.
+ */
+static BroadwayNode *
+lookup_content_node (BroadwayOutput *output,
+                     BroadwayNode   *node,
+                     GHashTable     *content_lookup,
+                     GHashTable     *old_node_lookup)
+{
+  GPtrArray *nodes;
+
+  if (content_lookup == NULL)
+    return NULL;
+
+  nodes = g_hash_table_lookup (content_lookup, node);
+  if (nodes == NULL)
+    return NULL;
+
+  for (guint i = 0; i < nodes->len; i++)
+    {
+      BroadwayNode *old_node = g_ptr_array_index (nodes, i);
+
+      if (!old_subtree_is_unused (old_node))
+        continue;
+
+      if (!new_subtree_is_unshared (node, old_node_lookup))
+        return NULL;
+
+#ifdef DEBUG_NODE_SENDING
+      g_print ("Matched node %d/%d by content to old node %d/%d\n",
+               node->id, node->output_id,
+               old_node->id, old_node->output_id);
+#endif
+      broadway_node_mark_deep_consumed (old_node, TRUE);
+      copy_output_ids (node, old_node);
+
+      output->n_content_matches++;
+      output->node_bytes_reused += node_size (node);
+
+      return old_node;
+    }
+
+  return NULL;
+}
+
 /***********************************
  * This outputs the tree to the client, while at the same time diffing
  * against the old tree.  This allows us to avoid sending certain
@@ -356,7 +638,8 @@ lookup_old_node (GHashTable *old_node_lookup,
 static void
 append_node (BroadwayOutput *output,
              BroadwayNode   *node,
-             GHashTable     *old_node_lookup)
+             GHashTable     *old_node_lookup,
+             GHashTable     *content_lookup)
 {
   guint32 i;
   BroadwayNode *reused_node;
@@ -369,6 +652,12 @@ append_node (BroadwayOutput *output,
       broadway_node_mark_deep_consumed (reused_node, TRUE);
       append_type (output, BROADWAY_NODE_REUSE, node);
       append_uint32 (output, node->output_id);
+      output->node_bytes_reused += node_size (node);
+    }
+  else if (lookup_content_node (output, node, content_lookup, old_node_lookup))
+    {
+      append_type (output, BROADWAY_NODE_REUSE, node);
+      append_uint32 (output, node->output_id);
     }
   else
     {
@@ -379,7 +668,8 @@ append_node (BroadwayOutput *output,
       for (i = 0; i < node->n_children; i++)
         append_node (output,
                      node->children[i],
-                     old_node_lookup);
+                     old_node_lookup,
+                     content_lookup);
     }
 
   append_node_depth--;
@@ -444,7 +734,8 @@ append_node_ops (BroadwayOutput *output,
                  BroadwayNode   *parent,
                  BroadwayNode   *previous_sibling,
                  BroadwayNode   *old_node,
-                 GHashTable     *old_node_lookup)
+                 GHashTable     *old_node_lookup,
+                 GHashTable     *content_lookup)
 {
   BroadwayNode *reused_node;
   guint32 i;
@@ -458,6 +749,7 @@ append_node_ops (BroadwayOutput *output,
       g_assert (!reused_node->consumed); /* Should only be once in the tree, and not consumed otherwise */
 
       broadway_node_mark_deep_consumed (reused_node, TRUE);
+      output->node_bytes_reused += node_size (node);
 
       if (node == old_node)
         {
@@ -486,6 +778,29 @@ append_node_ops (BroadwayOutput *output,
       return reused_node;
     }
 
+  /* A subtree that was rebuilt with the same content may exist
+   * elsewhere in the old tree. Unless the old node in place is
+   * already the same, move that one here.
+   */
+  if ((old_node == NULL || !broadway_node_deep_equal (node, old_node)) &&
+      (reused_node = lookup_content_node (output, node, content_lookup, old_node_lookup)))
+    {
+#ifdef DEBUG_NODE_SENDING
+      g_print ("Move matched node %d/%d to parent %d/%d after %d/%d\n",
+               node->id, node->output_id,
+               parent ? parent->id : 0,
+               parent ? parent->output_id : 0,
+               previous_sibling ? previous_sibling->id : 0,
+               previous_sibling ? previous_sibling->output_id : 0);
+#endif
+      append_uint32 (output, BROADWAY_NODE_OP_MOVE_AFTER_CHILD);
+      append_uint32 (output, parent ? parent->output_id : 0);
+      append_uint32 (output, previous_sibling ? previous_sibling->output_id : 0);
+      append_uint32 (output, node->output_id);
+
+      return node;
+    }
+
   /* If the next node in place is shallowly equal (but not necessarily
    * deep equal) we reuse it and tweak its children as needed.
    * Except we avoid this for reused node as those make more sense to reuse deeply.
@@ -497,6 +812,7 @@ append_node_ops (BroadwayOutput *output,
       BroadwayNode *last_child = NULL;
 
       old_node->consumed = TRUE; // Don't reuse again
+      output->node_bytes_reused += (2 + node->n_data) * 4;
 
       // We rewrite this new node as it now represents the old node in the browser
       node->output_id = old_node->output_id;
@@ -517,7 +833,8 @@ append_node_ops (BroadwayOutput *output,
                              node, /* parent */
                              last_child,
                              (old_i < old_node->n_children) ? old_node->children[old_i] : NULL,
-                             old_node_lookup);
+                             old_node_lookup,
+                             content_lookup);
         }
 
       /* Remaining old nodes are either reused elsewhere, or end up marked not consumed so are deleted at the end */
@@ -536,7 +853,7 @@ append_node_ops (BroadwayOutput *output,
    append_uint32 (output, parent ? parent->output_id : 0);
    append_uint32 (output, previous_sibling ? previous_sibling->output_id : 0);
 
-   append_node(output, node, old_node_lookup);
+   append_node (output, node, old_node_lookup, content_lookup);
 
    return node;
 }
@@ -571,7 +888,7 @@ broadway_output_surface_set_nodes (BroadwayOutput *output,
                                    GHashTable     *old_node_lookup)
 {
   gsize size_pos, start, end;
-
+  GHashTable *content_lookup = NULL;
 
   if (old_root)
     {
@@ -579,6 +896,10 @@ broadway_output_surface_set_nodes (BroadwayOutput *output,
       broadway_node_mark_deep_reused (old_root, FALSE);
       /* This will modify children of old_root if any are shared */
       broadway_node_mark_deep_reused (root, TRUE);
+
+      content_lookup = g_hash_table_new_full (node_content_hash, node_content_equal,
+                                              NULL, (GDestroyNotify) g_ptr_array_unref);
+      add_to_content_lookup (old_root, content_lookup);
     }
 
   write_header (output, BROADWAY_OP_SET_NODES);
@@ -592,11 +913,15 @@ broadway_output_surface_set_nodes (BroadwayOutput *output,
 #ifdef DEBUG_NODE_SENDING
   g_print ("====== node ops for surface %d =======\n", id);
 #endif
-  append_node_ops (output, root, NULL, NULL, old_root, old_node_lookup);
+  append_node_ops (output, root, NULL, NULL, old_root, old_node_lookup, content_lookup);
   if (old_root)
     append_node_removes (output, old_root);
   end = output->buf->len;
   patch_uint32 (output, (end - start) / 4, size_pos);
+
+  output->node_bytes_sent += end - start;
+
+  g_clear_pointer (&content_lookup, g_hash_table_unref);
 }
 
 void
@@ -611,6 +936,24 @@ broadway_output_upload_texture (BroadwayOutput *output,
   g_string_append_len (output->buf, g_bytes_get_data (texture, NULL), len);
 }
 
+void
+broadway_output_upload_texture_delta (BroadwayOutput *output,
+                                      guint32 id,
+                                      guint32 base_id,
+                                      guint32 x,
+                                      guint32 y,
+                                      GBytes *patch)
+{
+  gsize len = g_bytes_get_size (patch);
+  write_header (output, BROADWAY_OP_UPLOAD_TEXTURE_DELTA);
+  append_uint32 (output, id);
+  append_uint32 (output, base_id);
+  append_uint16 (output, x);
+  append_uint16 (output, y);
+  append_uint32 (output, (guint32)len);
+  g_string_append_len (output->buf, g_bytes_get_data (patch, NULL), len);
+}
+
 void
 broadway_output_release_texture (BroadwayOutput *output,
                                  guint32 id)
@@ -19,6 +19,10 @@ typedef enum {
 BroadwayOutput *broadway_output_new                 (GOutputStream  *out,
                                                      guint32         serial);
 void            broadway_output_free                (BroadwayOutput *output);
+void            broadway_output_enable_deflate      (BroadwayOutput *output,
+                                                     gboolean        no_context_takeover);
+void            broadway_output_add_roundtrip_time  (BroadwayOutput *output,
+                                                     gint64          roundtrip_time);
 int             broadway_output_flush               (BroadwayOutput *output);
 void            broadway_output_set_next_serial     (BroadwayOutput *output,
                                                      guint32         serial);
@@ -62,6 +66,12 @@ void            broadway_output_surface_set_nodes   (BroadwayOutput *output,
 void            broadway_output_upload_texture      (BroadwayOutput *output,
                                                      guint32         id,
                                                      GBytes         *texture);
+void            broadway_output_upload_texture_delta (BroadwayOutput *output,
+                                                     guint32         id,
+                                                     guint32         base_id,
+                                                     guint32         x,
+                                                     guint32         y,
+                                                     GBytes         *patch);
 void            broadway_output_release_texture     (BroadwayOutput *output,
                                                      guint32         id);
 void            broadway_output_grab_pointer        (BroadwayOutput *output,
@@ -85,6 +85,7 @@ typedef enum {
   BROADWAY_OP_RELEASE_TEXTURE = 14,
   BROADWAY_OP_SET_NODES = 15,
   BROADWAY_OP_ROUNDTRIP = 16,
+  BROADWAY_OP_UPLOAD_TEXTURE_DELTA = 17,
 } BroadwayOpType;
 
 typedef struct {
@@ -243,6 +244,12 @@ typedef struct {
   guint32 id;
   guint32 offset;
   guint32 size;
+  /* If base_id is not 0, the data only covers the area at x,y
+   * that differs from the texture base_id of the same size
+   */
+  guint32 base_id;
+  guint32 x;
+  guint32 y;
 } BroadwayRequestUploadTexture;
 
 typedef struct {
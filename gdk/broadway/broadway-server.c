@@ -6,11 +6,13 @@
 
 #include <glib.h>
 #include <glib/gprintf.h>
+#include <glib/gstdio.h>
 #include "gdktypes.h"
 #include "gdkdeviceprivate.h"
 #include <stdlib.h>
 #include <string.h>
 #include <errno.h>
+#include <zlib.h>
 
 #ifdef HAVE_UNISTD_H
 #include <unistd.h>
@@ -39,6 +41,7 @@
 typedef struct {
   int id;
   guint32 tag;
+  gint64 send_time;
 } BroadwayOutstandingRoundtrip;
 
 typedef struct BroadwayInput BroadwayInput;
@@ -88,6 +91,11 @@ struct _BroadwayServer {
   int future_mouse_in_surface;
 
   GList *outstanding_roundtrips;
+
+  /* Input recording, see broadway_server_record_input() */
+  FILE *record;
+  guint64 record_time;
+  gint32 record_surface_id;
 };
 
 struct _BroadwayServerClass
@@ -108,6 +116,8 @@ struct BroadwayInput {
   BroadwayOutput *output;
   GIOStream *connection;
   GByteArray *buffer;
+  z_stream *inflate; /* permessage-deflate */
+  GByteArray *inflated;
   GSource *source;
   gboolean seen_time;
   gint64 time_base;
@@ -133,6 +143,10 @@ struct _BroadwayTexture {
   grefcount refcount;
   guint32 id;
   GBytes *bytes;
+  /* For deltas, bytes only cover the area at x,y that differs from base_id */
+  guint32 base_id;
+  guint32 x;
+  guint32 y;
 };
 
 static void broadway_server_resync_surfaces (BroadwayServer *server);
@@ -289,6 +303,8 @@ broadway_server_finalize (GObject *object)
   g_free (server->ssl_cert);
   g_free (server->ssl_key);
   g_hash_table_destroy (server->textures);
+  if (server->record)
+    fclose (server->record);
 
   G_OBJECT_CLASS (broadway_server_parent_class)->finalize (object);
 }
@@ -334,6 +350,12 @@ http_request_free (HttpRequest *request)
 static void
 broadway_input_free (BroadwayInput *input)
 {
+  if (input->inflate)
+    {
+      inflateEnd (input->inflate);
+      g_free (input->inflate);
+      g_byte_array_unref (input->inflated);
+    }
   g_object_unref (input->connection);
   g_byte_array_free (input->buffer, FALSE);
   g_source_destroy (input->source);
@@ -617,6 +639,82 @@ queue_input_message (BroadwayServer *server, BroadwayInputMsg *msg)
   server->input_messages = g_list_append (server->input_messages, g_memdup2 (msg, sizeof (BroadwayInputMsg)));
 }
 
+/* Writes the input in the script format of tests/broadway-load.c,
+ * with pointer positions relative to the most recently shown surface,
+ * so that the load test can replay it.
+ */
+static void
+record_input_message (BroadwayServer   *server,
+                      BroadwayInputMsg *msg)
+{
+  BroadwaySurface *surface;
+  guint delay;
+  int x, y;
+
+  switch (msg->base.type)
+    {
+    case BROADWAY_EVENT_POINTER_MOVE:
+    case BROADWAY_EVENT_BUTTON_PRESS:
+    case BROADWAY_EVENT_BUTTON_RELEASE:
+    case BROADWAY_EVENT_SCROLL:
+    case BROADWAY_EVENT_KEY_PRESS:
+    case BROADWAY_EVENT_KEY_RELEASE:
+    case BROADWAY_EVENT_SCREEN_SIZE_CHANGED:
+      break;
+
+    default:
+      return;
+    }
+
+  if (server->record_time == 0 || msg->base.time < server->record_time)
+    delay = 0;
+  else
+    delay = msg->base.time - server->record_time;
+  server->record_time = msg->base.time;
+
+  switch (msg->base.type)
+    {
+    case BROADWAY_EVENT_POINTER_MOVE:
+      surface = broadway_server_lookup_surface (server, server->record_surface_id);
+      x = msg->pointer.root_x - (surface ? surface->x : 0);
+      y = msg->pointer.root_y - (surface ? surface->y : 0);
+      fprintf (server->record, "%u move %d %d\n", delay, x, y);
+      break;
+
+    case BROADWAY_EVENT_BUTTON_PRESS:
+      fprintf (server->record, "%u press %u\n", delay, msg->button.button);
+      break;
+
+    case BROADWAY_EVENT_BUTTON_RELEASE:
+      fprintf (server->record, "%u release %u\n", delay, msg->button.button);
+      break;
+
+    case BROADWAY_EVENT_SCROLL:
+      fprintf (server->record, "%u scroll %d\n", delay, msg->scroll.dir);
+      break;
+
+    case BROADWAY_EVENT_KEY_PRESS:
+      fprintf (server->record, "%u key-press %d\n", delay, msg->key.key);
+      break;
+
+    case BROADWAY_EVENT_KEY_RELEASE:
+      fprintf (server->record, "%u key-release %d\n", delay, msg->key.key);
+      break;
+
+    case BROADWAY_EVENT_SCREEN_SIZE_CHANGED:
+      fprintf (server->record, "%u screen-size %u %u %u\n", delay,
+               msg->screen_resize_notify.width,
+               msg->screen_resize_notify.height,
+               msg->screen_resize_notify.scale);
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+
+  fflush (server->record);
+}
+
 static void
 parse_input_message (BroadwayInput *input, const unsigned char *message)
 {
@@ -723,6 +821,10 @@ parse_input_message (BroadwayInput *input, const unsigned char *message)
       {
         BroadwayOutstandingRoundtrip *rt = l->data;
 
+        if (server->output)
+          broadway_output_add_roundtrip_time (server->output,
+                                              g_get_monotonic_time () - rt->send_time);
+
         server->outstanding_roundtrips = g_list_delete_link (server->outstanding_roundtrips, l);
         g_free (rt);
       }
@@ -740,6 +842,9 @@ parse_input_message (BroadwayInput *input, const unsigned char *message)
     break;
   }
 
+  if (server->record)
+    record_input_message (server, &msg);
+
   queue_input_message (server, &msg);
 }
 
@@ -772,6 +877,54 @@ hex_dump (guchar *data, gsize len)
 #endif
 }
 
+/* Input messages are small, anything bigger than this is garbage */
+#define MAX_INFLATED_SIZE (1024 * 1024)
+
+/* Decompresses a message that was compressed with permessage-deflate */
+static const guchar *
+inflate_message (BroadwayInput *input,
+                 const guchar  *data,
+                 gsize          len)
+{
+  static const guchar tail[] = { 0x00, 0x00, 0xff, 0xff };
+  z_stream *zs = input->inflate;
+  gsize used;
+  int i, res;
+
+  g_byte_array_set_size (input->inflated, MAX (input->inflated->len, 256));
+  used = 0;
+
+  /* The sender drops the empty block at the end of each message */
+  for (i = 0; i < 2; i++)
+    {
+      zs->next_in = (Bytef *) (i == 0 ? data : tail);
+      zs->avail_in = i == 0 ? len : sizeof (tail);
+
+      do
+        {
+          if (used == input->inflated->len)
+            {
+              if (input->inflated->len >= MAX_INFLATED_SIZE)
+                return NULL;
+
+              g_byte_array_set_size (input->inflated, input->inflated->len * 2);
+            }
+
+          zs->next_out = input->inflated->data + used;
+          zs->avail_out = input->inflated->len - used;
+
+          res = inflate (zs, Z_SYNC_FLUSH);
+          if (res != Z_OK && res != Z_BUF_ERROR)
+            return NULL;
+
+          used = input->inflated->len - zs->avail_out;
+        }
+      while (zs->avail_in > 0 || zs->avail_out == 0);
+    }
+
+  return input->inflated->data;
+}
+
 static void
 parse_input (BroadwayInput *input)
 {
@@ -784,7 +937,7 @@ parse_input (BroadwayInput *input)
     {
       gsize len, payload_len;
       BroadwayWSOpCode code;
-      gboolean is_mask, fin;
+      gboolean is_mask, fin, compressed;
       guchar *buf, *data, *mask;
 
       buf = input->buffer->data;
@@ -795,6 +948,7 @@ parse_input (BroadwayInput *input)
 #endif
 
       fin = buf[0] & 0x80;
+      compressed = buf[0] & 0x40;
       code = buf[0] & 0x0f;
       payload_len = buf[1] & 0x7f;
       is_mask = buf[1] & 0x80;
@@ -844,6 +998,15 @@ parse_input (BroadwayInput *input)
             g_warning ("can't yet accept fragmented input");
 #endif
           }
+        else if (compressed && input->inflate != NULL)
+          {
+            const guchar *message = inflate_message (input, data, payload_len);
+
+            if (message != NULL)
+              parse_input_message (input, message);
+            else
+              g_warning ("can't decompress input");
+          }
         else
           {
             parse_input_message (input, data);
@@ -1017,6 +1180,7 @@ broadway_server_roundtrip (BroadwayServer *server,
       BroadwayOutstandingRoundtrip *rt = g_new0 (BroadwayOutstandingRoundtrip, 1);
       rt->id = id;
       rt->tag = tag;
+      rt->send_time = g_get_monotonic_time ();
       server->outstanding_roundtrips = g_list_prepend (server->outstanding_roundtrips, rt);
 
       broadway_output_roundtrip (server->output, id, tag);
@@ -1064,6 +1228,48 @@ send_error (HttpRequest *request,
   http_request_free (request);
 }
 
+/* Checks whether the client offered permessage-deflate with parameters
+ * that we support, see RFC 7692
+ */
+static gboolean
+accept_deflate_offer (const char *extensions,
+                      gboolean   *no_context_takeover)
+{
+  char **offers;
+  gboolean accept = FALSE;
+  int i, j;
+
+  offers = g_strsplit (extensions, ",", 0);
+
+  for (i = 0; offers[i] != NULL && !accept; i++)
+    {
+      char **params = g_strsplit (offers[i], ";", 0);
+
+      if (strcmp (g_strstrip (params[0]), "permessage-deflate") == 0)
+        {
+          accept = TRUE;
+          *no_context_takeover = FALSE;
+
+          for (j = 1; params[j] != NULL; j++)
+            {
+              const char *param = g_strstrip (params[j]);
+
+              if (strcmp (param, "server_no_context_takeover") == 0)
+                *no_context_takeover = TRUE;
+              else if (strcmp (param, "client_no_context_takeover") != 0 &&
+                       !g_str_has_prefix (param, "client_max_window_bits"))
+                accept = FALSE;
+            }
+        }
+
+      g_strfreev (params);
+    }
+
+  g_strfreev (offers);
+
+  return accept;
+}
+
 /* magic from: http://tools.ietf.org/html/draft-ietf-hybi-thewebsocketprotocol-17 */
 #define SEC_WEB_SOCKET_KEY_MAGIC "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
 
@@ -1097,7 +1303,8 @@ start_input (HttpRequest *request)
   const char *p;
   int i;
   char *res;
-  const char *origin, *host;
+  const char *origin, *host, *extensions;
+  gboolean deflate, no_context_takeover;
   BroadwayInput *input;
   const void *data_buffer;
   gsize data_buffer_size;
@@ -1114,10 +1321,13 @@ start_input (HttpRequest *request)
   key = NULL;
   origin = NULL;
   host = NULL;
+  extensions = NULL;
   for (i = 0; lines[i] != NULL; i++)
     {
       if ((p = parse_line (lines[i], "Sec-WebSocket-Key")))
         key = p;
+      else if ((p = parse_line (lines[i], "Sec-WebSocket-Extensions")))
+        extensions = p;
       else if ((p = parse_line (lines[i], "Origin")))
         origin = p;
       else if ((p = parse_line (lines[i], "Host")))
@@ -1133,6 +1343,9 @@ start_input (HttpRequest *request)
       return;
     }
 
+  no_context_takeover = FALSE;
+  deflate = extensions != NULL && accept_deflate_offer (extensions, &no_context_takeover);
+
   if (key != NULL)
     {
       char* accept = generate_handshake_response_wsietf_v7 (key);
@@ -1141,10 +1354,14 @@ start_input (HttpRequest *request)
                              "Connection: Upgrade\r\n"
                              "Sec-WebSocket-Accept: %s\r\n"
                              "%s%s%s"
+                             "%s"
                              "Sec-WebSocket-Location: ws://%s/socket\r\n"
                              "Sec-WebSocket-Protocol: broadway\r\n"
                              "\r\n", accept,
                              origin?"Sec-WebSocket-Origin: ":"", origin?origin:"", origin?"\r\n":"",
+                             !deflate ? "" :
+                               no_context_takeover ? "Sec-WebSocket-Extensions: permessage-deflate; server_no_context_takeover\r\n" :
+                                                     "Sec-WebSocket-Extensions: permessage-deflate\r\n",
                              host);
       g_free (accept);
 
@@ -1178,6 +1395,17 @@ start_input (HttpRequest *request)
   input->output =
     broadway_output_new (g_io_stream_get_output_stream (request->connection), 0);
 
+  if (deflate)
+    {
+      broadway_output_enable_deflate (input->output, no_context_takeover);
+
+      input->inflate = g_new0 (z_stream, 1);
+      if (inflateInit2 (input->inflate, -MAX_WBITS) != Z_OK)
+        g_clear_pointer (&input->inflate, g_free);
+      else
+        input->inflated = g_byte_array_new ();
+    }
+
   /* This will free and close the data input stream, but we got all the buffered content already */
   http_request_free (request);
 
@@ -1421,6 +1649,44 @@ handle_incoming_connection (GSocketService    *service,
   return TRUE;
 }
 
+/*
+ * broadway_server_record_input:
+ * @server: the server
+ * @filename: the file to write to
+ * @error: return location for an error
+ *
+ * Starts writing all input from the browser to @filename, as a
+ * script that tests/broadway-load.c can replay.
+ *
+ * Returns: %TRUE if the file could be opened
+ */
+gboolean
+broadway_server_record_input (BroadwayServer  *server,
+                              const char      *filename,
+                              GError         **error)
+{
+  FILE *record;
+
+  record = g_fopen (filename, "w");
+  if (record == NULL)
+    {
+      int errsv = errno;
+
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errsv),
+                   "Failed to open %s: %s", filename, g_strerror (errsv));
+      return FALSE;
+    }
+
+  if (server->record)
+    fclose (server->record);
+  server->record = record;
+  server->record_time = 0;
+
+  fprintf (server->record, "# delay-ms  event  arguments\n");
+
+  return TRUE;
+}
+
 BroadwayServer *
 broadway_server_new (char        *address,
                      int          port,
@@ -1569,6 +1835,28 @@ broadway_server_query_mouse (BroadwayServer *server,
     *surface = server->mouse_in_surface_id;
 }
 
+/* Like the load test, fall back to any visible surface when
+ * the one that pointer positions are relative to goes away.
+ */
+static void
+pick_record_surface (BroadwayServer *server)
+{
+  GList *l;
+
+  server->record_surface_id = 0;
+
+  for (l = server->surfaces; l != NULL; l = l->next)
+    {
+      BroadwaySurface *surface = l->data;
+
+      if (surface->visible)
+        {
+          server->record_surface_id = surface->id;
+          break;
+        }
+    }
+}
+
 void
 broadway_server_destroy_surface (BroadwayServer *server,
                                  int id,
@@ -1599,6 +1887,9 @@ broadway_server_destroy_surface (BroadwayServer *server,
       g_hash_table_remove (server->surface_id_hash,
                            GINT_TO_POINTER (id));
       broadway_surface_free (server, surface);
+
+      if (server->record_surface_id == id)
+        pick_record_surface (server);
     }
 
   if (transient_for != -1 && !disconnected)
@@ -1624,6 +1915,7 @@ broadway_server_surface_show (BroadwayServer *server,
     return FALSE;
 
   surface->visible = TRUE;
+  server->record_surface_id = id;
 
   if (server->output)
     {
@@ -1647,6 +1939,9 @@ broadway_server_surface_hide (BroadwayServer *server,
 
   surface->visible = FALSE;
 
+  if (server->record_surface_id == id)
+    pick_record_surface (server);
+
   if (server->mouse_in_surface_id == id)
     {
       /* TODO: Send leave + enter event, update cursors, etc */
@@ -1928,27 +2223,69 @@ broadway_server_surface_update_nodes (BroadwayServer   *server,
   broadway_node_add_to_lookup (root, surface->node_lookup);
 }
 
+static void
+broadway_server_send_texture (BroadwayServer  *server,
+                              BroadwayTexture *texture)
+{
+  if (texture->base_id != 0)
+    broadway_output_upload_texture_delta (server->output, texture->id,
+                                          texture->base_id,
+                                          texture->x, texture->y,
+                                          texture->bytes);
+  else
+    broadway_output_upload_texture (server->output, texture->id, texture->bytes);
+}
+
 guint32
-broadway_server_upload_texture (BroadwayServer   *server,
-                                GBytes           *bytes)
+broadway_server_upload_texture_delta (BroadwayServer   *server,
+                                      GBytes           *bytes,
+                                      guint32           base_id,
+                                      guint32           x,
+                                      guint32           y)
 {
   BroadwayTexture *texture;
 
+  /* Without the base, the delta is only a part of the texture */
+  if (base_id != 0 &&
+      !g_hash_table_contains (server->textures, GINT_TO_POINTER (base_id)))
+    {
+      g_warning ("Unknown base texture %u for texture delta", base_id);
+      return 0;
+    }
+
   texture = g_new0 (BroadwayTexture, 1);
   g_ref_count_init (&texture->refcount);
   texture->id = ++server->next_texture_id;
   texture->bytes = g_bytes_ref (bytes);
 
+  /* The base has to stay around as long as the delta,
+   * so we can send both when a new client connects.
+   */
+  if (base_id != 0)
+    {
+      broadway_server_ref_texture (server, base_id);
+      texture->base_id = base_id;
+      texture->x = x;
+      texture->y = y;
+    }
+
   g_hash_table_replace (server->textures,
                         GINT_TO_POINTER (texture->id),
                         texture);
 
   if (server->output)
-    broadway_output_upload_texture (server->output, texture->id, texture->bytes);
+    broadway_server_send_texture (server, texture);
 
   return texture->id;
 }
 
+guint32
+broadway_server_upload_texture (BroadwayServer   *server,
+                                GBytes           *bytes)
+{
+  return broadway_server_upload_texture_delta (server, bytes, 0, 0, 0);
+}
+
 static void
 broadway_server_ref_texture (BroadwayServer   *server,
                              guint32           id)
@@ -1970,10 +2307,15 @@ broadway_server_release_texture (BroadwayServer   *server,
 
   if (texture && g_ref_count_dec (&texture->refcount))
     {
+      guint32 base_id = texture->base_id;
+
       g_hash_table_remove (server->textures, GINT_TO_POINTER (id));
 
       if (server->output)
         broadway_output_release_texture (server->output, id);
+
+      if (base_id != 0)
+        broadway_server_release_texture (server, base_id);
     }
 }
 
@@ -2138,25 +2480,34 @@ broadway_server_new_surface (BroadwayServer *server,
   return surface->id;
 }
 
+static int
+compare_texture_ids (gconstpointer a,
+                     gconstpointer b)
+{
+  const BroadwayTexture *texture_a = a;
+  const BroadwayTexture *texture_b = b;
+
+  if (texture_a->id < texture_b->id)
+    return -1;
+
+  return texture_a->id > texture_b->id;
+}
+
 static void
 broadway_server_resync_surfaces (BroadwayServer *server)
 {
-  GHashTableIter iter;
-  gpointer key, value;
-  GList *l;
+  GList *textures, *l;
 
   if (server->output == NULL)
     return;
 
-  /* First upload all textures */
-  g_hash_table_iter_init (&iter, server->textures);
-  while (g_hash_table_iter_next (&iter, &key, &value))
-    {
-      BroadwayTexture *texture = value;
-      broadway_output_upload_texture (server->output,
-                                      GPOINTER_TO_INT (key),
-                                      texture->bytes);
-    }
+  /* First upload all textures. Deltas are always newer than their
+   * base, so sending them in order of their ids sends bases first.
+   */
+  textures = g_list_sort (g_hash_table_get_values (server->textures), compare_texture_ids);
+  for (l = textures; l != NULL; l = l->next)
+    broadway_server_send_texture (server, l->data);
+  g_list_free (textures);
 
   /* Then create all surfaces */
   for (l = server->surfaces; l != NULL; l = l->next)
@@ -55,6 +55,9 @@ BroadwayServer     *broadway_server_new                       (char            *
                                                                GError         **error);
 BroadwayServer     *broadway_server_on_unix_socket_new        (char            *address,
                                                                GError         **error);
+gboolean            broadway_server_record_input              (BroadwayServer  *server,
+                                                               const char      *filename,
+                                                               GError         **error);
 gboolean            broadway_server_has_client                (BroadwayServer  *server);
 void                broadway_server_flush                     (BroadwayServer  *server);
 void                broadway_server_roundtrip                 (BroadwayServer  *server,
@@ -104,6 +107,11 @@ void                broadway_server_surface_set_transient_for (BroadwayServer  *
                                                                int              parent);
 guint32             broadway_server_upload_texture            (BroadwayServer  *server,
                                                                GBytes          *bytes);
+guint32             broadway_server_upload_texture_delta      (BroadwayServer  *server,
+                                                               GBytes          *bytes,
+                                                               guint32          base_id,
+                                                               guint32          x,
+                                                               guint32          y);
 void                broadway_server_release_texture           (BroadwayServer  *server,
                                                                guint32          id);
 void                broadway_server_surface_update_nodes      (BroadwayServer  *server,
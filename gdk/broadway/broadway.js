@@ -38,6 +38,7 @@ const BROADWAY_OP_UPLOAD_TEXTURE = 13;
 const BROADWAY_OP_RELEASE_TEXTURE = 14;
 const BROADWAY_OP_SET_NODES = 15;
 const BROADWAY_OP_ROUNDTRIP = 16;
+const BROADWAY_OP_UPLOAD_TEXTURE_DELTA = 17;
 
 const BROADWAY_EVENT_ENTER = 0;
 const BROADWAY_EVENT_LEAVE = 1;
@@ -299,23 +300,37 @@ function getButtonMask (button) {
     return 0;
 }
 
-function Texture(id, data) {
-    var url;
-    if (useDataUrls) {
-        url = bytesToDataUri(data);
-    } else {
-        var blob = new Blob([data],{type: "image/png"});
-        url = window.URL.createObjectURL(blob);
+function createImageUrl(data) {
+    if (useDataUrls)
+        return bytesToDataUri(data);
+
+    var blob = new Blob([data],{type: "image/png"});
+    return window.URL.createObjectURL(blob);
+}
+
+function revokeImageUrl(url) {
+    if (url != null && url.startsWith("blob")) {
+        window.URL.revokeObjectURL(url);
     }
+}
+
+// Texture nodes are canvases that the source of the texture gets
+// drawn into, once it is decoded
+function Texture(id, data) {
+    var texture = this;
 
-    this.url = url;
+    this.url = createImageUrl(data);
     this.refcount = 1;
     this.id = id;
 
     var image = new Image();
     image.src = this.url;
-    this.image = image;
-    this.decoded = image.decode();
+    this.source = image;
+    this.decoded = image.decode().then(
+        () => {
+            texture.width = image.naturalWidth;
+            texture.height = image.naturalHeight;
+        });
     textures[id] = this;
 }
 
@@ -327,13 +342,63 @@ Texture.prototype.ref = function() {
 Texture.prototype.unref = function() {
     this.refcount -= 1;
     if (this.refcount == 0) {
-        if (this.url.startsWith("blob")) {
-            window.URL.revokeObjectURL(this.url);
-        }
+        revokeImageUrl(this.url);
+        this.source = null;
         delete textures[this.id];
     }
 }
 
+function drawTexture(canvas, texture) {
+    texture.decoded.then(
+        () => {
+            canvas.width = texture.width;
+            canvas.height = texture.height;
+            canvas.getContext("2d").drawImage(texture.source, 0, 0);
+        }).finally(
+            () => {
+                texture.unref();
+            });
+}
+
+// A texture that is equal to the base texture, except for the
+// area at x,y that is covered by the image in data. The composed
+// canvas is the source, so it never needs to be encoded again.
+function TextureDelta(id, baseId, x, y, data) {
+    var base = textures[baseId].ref();
+    var patch = new Image();
+    var texture = this;
+
+    this.url = null;
+    this.refcount = 1;
+    this.id = id;
+    this.source = null;
+
+    patch.src = createImageUrl(data);
+    this.decoded = Promise.all([base.decoded, patch.decode()]).then(
+        () => {
+            var canvas = document.createElement("canvas");
+            canvas.width = base.width;
+            canvas.height = base.height;
+
+            var context = canvas.getContext("2d");
+            context.drawImage(base.source, 0, 0);
+            context.clearRect(x, y, patch.naturalWidth, patch.naturalHeight);
+            context.drawImage(patch, x, y);
+
+            texture.source = canvas;
+            texture.width = canvas.width;
+            texture.height = canvas.height;
+        }).finally(
+            () => {
+                revokeImageUrl(patch.src);
+                base.unref();
+            });
+    textures[id] = this;
+}
+
+TextureDelta.prototype.ref = Texture.prototype.ref;
+TextureDelta.prototype.unref = Texture.prototype.unref;
+
 function sendConfigureNotify(surface)
 {
     sendInput(BROADWAY_EVENT_CONFIGURE_NOTIFY, [surface.id, surface.x, surface.y, surface.width, surface.height]);
@@ -617,12 +682,12 @@ TransformNodes.prototype.createDiv = function(id)
     return div;
 }
 
-TransformNodes.prototype.createImage = function(id)
+TransformNodes.prototype.createCanvas = function(id)
 {
-    var image = new Image();
-    image.node_id = id;
-    this.nodes[id] = image;
-    return image;
+    var canvas = document.createElement("canvas");
+    canvas.node_id = id;
+    this.nodes[id] = canvas;
+    return canvas;
 }
 
 TransformNodes.prototype.insertNode = function(parent, previousSibling, is_toplevel)
@@ -646,16 +711,11 @@ TransformNodes.prototype.insertNode = function(parent, previousSibling, is_tople
         {
             var rect = this.decode_rect();
             var texture_id = this.decode_uint32();
-            var image = this.createImage(id);
-            image.width = rect.width;
-            image.height = rect.height;
-            image.style["position"] = "absolute";
-            set_rect_style(image, rect);
-            var texture = textures[texture_id].ref();
-            image.src = texture.url;
-            // Unref blob url when loaded
-            image.onload = function() { texture.unref(); };
-            newNode = image;
+            var canvas = this.createCanvas(id);
+            canvas.style["position"] = "absolute";
+            set_rect_style(canvas, rect);
+            drawTexture(canvas, textures[texture_id].ref());
+            newNode = canvas;
         }
         break;
 
@@ -1043,15 +1103,7 @@ function handleDisplayCommands(display_commands)
            delete surfaces[id];
             break;
         case DISPLAY_OP_CHANGE_TEXTURE:
-            var image = cmd[1];
-            var texture = cmd[2];
-            // We need a new closure here to have a separate copy of "texture" for each iteration in the onload callback...
-            var block = function(t) {
-                image.src = t.url;
-                // Unref blob url when loaded
-                image.onload = function() { t.unref(); };
-            };
-            block(texture);
+            drawTexture(cmd[1], cmd[2]);
             break;
         case DISPLAY_OP_CHANGE_TRANSFORM:
             var div = cmd[1];
@@ -1187,6 +1239,16 @@ function handleCommands(cmd, display_commands, new_textures, modified_trees)
             new_textures.push(texture);
             break;
 
+        case BROADWAY_OP_UPLOAD_TEXTURE_DELTA:
+            id = cmd.get_32();
+            var base_id = cmd.get_32();
+            x = cmd.get_16();
+            y = cmd.get_16();
+            var data = cmd.get_data();
+            var texture = new TextureDelta (id, base_id, x, y, data); // Stores a ref in global textures array
+            new_textures.push(texture);
+            break;
+
         case BROADWAY_OP_RELEASE_TEXTURE:
             id = cmd.get_32();
             textures[id].unref();
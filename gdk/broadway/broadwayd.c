@@ -320,12 +320,30 @@ client_handle_request (BroadwayClient *client,
           close (fd);
 
           texture = g_bytes_new_take (data, request->upload_texture.size);
-          global_id = broadway_server_upload_texture (server, texture);
+          if (request->upload_texture.base_id != 0)
+            {
+              guint32 base_id;
+
+              base_id = GPOINTER_TO_INT (g_hash_table_lookup (client->textures,
+                                                              GINT_TO_POINTER (request->upload_texture.base_id)));
+              global_id = broadway_server_upload_texture_delta (server, texture, base_id,
+                                                                request->upload_texture.x,
+                                                                request->upload_texture.y);
+            }
+          else
+            global_id = broadway_server_upload_texture (server, texture);
           g_bytes_unref (texture);
 
-          g_hash_table_replace (client->textures,
-                                GINT_TO_POINTER (request->release_texture.id),
-                                GINT_TO_POINTER (global_id));
+          /* A delta that can't be applied is dropped, so nodes using
+           * it draw nothing instead of a partial texture.
+           */
+          if (global_id != 0)
+            g_hash_table_replace (client->textures,
+                                  GINT_TO_POINTER (request->release_texture.id),
+                                  GINT_TO_POINTER (global_id));
+          else
+            g_hash_table_remove (client->textures,
+                                 GINT_TO_POINTER (request->release_texture.id));
         }
       break;
     case BROADWAY_REQUEST_RELEASE_TEXTURE:
@@ -537,6 +555,10 @@ main (int argc, char *argv[])
     { "key", 'k', 0, G_OPTION_ARG_STRING, &ssl_key, "SSL key path", "PATH" },
     { NULL }
   };
+  enum { DEBUG_RECORD = 1 << 0 };
+  const GDebugKey debug_keys[] = {
+    { "broadway-record", DEBUG_RECORD },
+  };
 
   setlocale (LC_ALL, "");
 
@@ -602,6 +624,20 @@ main (int argc, char *argv[])
       return 1;
     }
 
+  if (g_parse_debug_string (g_getenv ("GDK_DEBUG"), debug_keys, G_N_ELEMENTS (debug_keys)) & DEBUG_RECORD)
+    {
+      char *filename = g_strdup_printf ("broadway%d-input.txt", port);
+
+      if (!broadway_server_record_input (server, filename, &error))
+        {
+          g_printerr ("%s\n", error->message);
+          return 1;
+        }
+
+      g_print ("Recording input to %s\n", filename);
+      g_free (filename);
+    }
+
   listener = g_socket_service_new ();
   if (!g_socket_listener_add_address (G_SOCKET_LISTENER (listener),
                                       address,
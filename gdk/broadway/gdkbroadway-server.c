@@ -12,6 +12,7 @@
 #include "gdkprivate.h"
 
 #include <gdk/gdktextureprivate.h>
+#include "loaders/gdkpngprivate.h"
 
 #include <glib.h>
 #include <glib/gprintf.h>
@@ -613,9 +614,12 @@ open_shared_memory (void)
   return ret;
 }
 
-guint32
-gdk_broadway_server_upload_texture (GdkBroadwayServer *server,
-                                    GdkTexture        *texture)
+static guint32
+gdk_broadway_server_send_texture (GdkBroadwayServer *server,
+                                  GdkTexture        *texture,
+                                  guint32            base_id,
+                                  int                x,
+                                  int                y)
 {
   guint32 id;
   BroadwayRequestUploadTexture msg;
@@ -624,7 +628,10 @@ gdk_broadway_server_upload_texture (GdkBroadwayServer *server,
   gsize size;
   int fd;
 
-  bytes = gdk_texture_save_to_png_bytes (texture);
+  /* The browser decodes PNG natively, so we keep the format,
+   * but we care more about encoding time than about size here.
+   */
+  bytes = gdk_save_png_with_compression (texture, NULL, GDK_PNG_COMPRESSION_FAST);
   fd = open_shared_memory ();
   data = g_bytes_get_data (bytes, &size);
 
@@ -633,6 +640,9 @@ gdk_broadway_server_upload_texture (GdkBroadwayServer *server,
   msg.id = id;
   msg.offset = 0;
   msg.size = 0;
+  msg.base_id = base_id;
+  msg.x = x;
+  msg.y = y;
 
   while (msg.size < size)
     {
@@ -657,6 +667,35 @@ gdk_broadway_server_upload_texture (GdkBroadwayServer *server,
   return id;
 }
 
+guint32
+gdk_broadway_server_upload_texture (GdkBroadwayServer *server,
+                                    GdkTexture        *texture)
+{
+  return gdk_broadway_server_send_texture (server, texture, 0, 0, 0);
+}
+
+/*
+ * gdk_broadway_server_upload_texture_delta:
+ * @server: the server
+ * @patch: the part of the new texture that changed
+ * @base_id: the id of an uploaded texture of the same size as the new texture
+ * @x: the x position of @patch in the new texture
+ * @y: the y position of @patch in the new texture
+ *
+ * Uploads a texture that is equal to the texture @base_id, except
+ * for the area covered by @patch.
+ *
+ * Returns: the id of the new texture
+ */
+guint32
+gdk_broadway_server_upload_texture_delta (GdkBroadwayServer *server,
+                                          GdkTexture        *patch,
+                                          guint32            base_id,
+                                          int                x,
+                                          int                y)
+{
+  return gdk_broadway_server_send_texture (server, patch, base_id, x, y);
+}
 
 void
 gdk_broadway_server_release_texture (GdkBroadwayServer *server,
@@ -58,6 +58,11 @@ void               _gdk_broadway_server_set_show_keyboard        (GdkBroadwaySer
 								  gboolean            show_keyboard);
 guint32             gdk_broadway_server_upload_texture           (GdkBroadwayServer  *server,
                                                                   GdkTexture         *texture);
+guint32             gdk_broadway_server_upload_texture_delta     (GdkBroadwayServer  *server,
+                                                                  GdkTexture         *patch,
+                                                                  guint32             base_id,
+                                                                  int                 x,
+                                                                  int                 y);
 void                gdk_broadway_server_release_texture          (GdkBroadwayServer  *server,
                                                                   guint32             id);
 void               gdk_broadway_server_surface_set_nodes          (GdkBroadwayServer *server,
@@ -29,6 +29,11 @@ G_DEFINE_TYPE (GdkBroadwayCairoContext, gdk_broadway_cairo_context, GDK_TYPE_CAI
 static void
 gdk_broadway_cairo_context_dispose (GObject *object)
 {
+  GdkBroadwayCairoContext *self = GDK_BROADWAY_CAIRO_CONTEXT (object);
+
+  g_clear_pointer (&self->damage, cairo_region_destroy);
+  g_clear_object (&self->last_texture);
+
   G_OBJECT_CLASS (gdk_broadway_cairo_context_parent_class)->dispose (object);
 }
 
@@ -47,6 +52,9 @@ gdk_broadway_cairo_context_begin_frame (GdkDrawContext  *draw_context,
   gdk_draw_context_get_buffer_size (draw_context, &width, &height);
   self->paint_surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32, width, height);
 
+  /* We repaint everything, but only the damage differs from the last frame */
+  self->damage = cairo_region_copy (region);
+
   repaint_region = cairo_region_create_rectangle (&(cairo_rectangle_int_t) { 0, 0, width, height });
   cairo_region_union (region, repaint_region);
   cairo_region_destroy (repaint_region);
@@ -92,8 +100,17 @@ gdk_broadway_cairo_context_end_frame (GdkDrawContext *draw_context,
   node_textures = g_ptr_array_new_with_free_func (g_object_unref);
 
   texture = gdk_texture_new_for_surface ((cairo_surface_t *)self->paint_surface);
-  g_ptr_array_add (node_textures, g_object_ref (texture)); /* Transfers ownership to node_textures */
-  texture_id = gdk_broadway_display_ensure_texture (display, texture);
+  g_ptr_array_add (node_textures, texture); /* Transfers ownership to node_textures */
+
+  if (self->last_texture &&
+      gdk_texture_get_width (self->last_texture) == gdk_texture_get_width (texture) &&
+      gdk_texture_get_height (self->last_texture) == gdk_texture_get_height (texture))
+    gdk_texture_set_diff (texture, self->last_texture, g_steal_pointer (&self->damage));
+  else
+    g_clear_pointer (&self->damage, cairo_region_destroy);
+
+  texture_id = gdk_broadway_display_ensure_texture (display, texture, self->last_texture);
+  g_set_object (&self->last_texture, texture);
 
   add_uint32 (nodes, BROADWAY_NODE_TEXTURE);
   add_float (nodes, 0);
@@ -39,6 +39,8 @@ struct _GdkBroadwayCairoContext
   GdkCairoContext parent_instance;
 
   cairo_surface_t *paint_surface;
+  cairo_region_t *damage;
+  GdkTexture *last_texture;
 };
 
 struct _GdkBroadwayCairoContextClass
@@ -32,6 +32,8 @@
 #include "gdkdevice-broadway.h"
 #include "gdkdeviceprivate.h"
 #include <gdk/gdktextureprivate.h>
+#include "gdkcolorstateprivate.h"
+#include "gdkmemorytextureprivate.h"
 #include "gdkprivate.h"
 
 #include <glib.h>
@@ -433,9 +435,87 @@ broadway_texture_data_free (BroadwayTextureData *data)
   g_free (data);
 }
 
+/* Textures are often redrawn with only small changes, so we send
+ * them as the area that changed since the texture that was uploaded
+ * in their place before, unless most of the texture changed.
+ */
+#define MAX_DELTA_RATIO 0.5
+
+static guint32
+gdk_broadway_display_upload_texture_delta (GdkBroadwayDisplay *self,
+                                           GdkTexture         *texture,
+                                           GdkTexture         *base)
+{
+  BroadwayTextureData *base_data;
+  GdkMemoryTexture *memtex;
+  GdkTexture *patch;
+  cairo_region_t *region;
+  cairo_rectangle_int_t area;
+  int width, height;
+  guint32 id;
+
+  base_data = g_object_get_data (G_OBJECT (base), "broadway-data");
+  if (base_data == NULL)
+    return 0;
+
+  width = gdk_texture_get_width (texture);
+  height = gdk_texture_get_height (texture);
+
+  if (gdk_texture_get_width (base) != width ||
+      gdk_texture_get_height (base) != height ||
+      !gdk_color_state_equal (gdk_texture_get_color_state (texture), GDK_COLOR_STATE_SRGB) ||
+      !gdk_color_state_equal (gdk_texture_get_color_state (base), GDK_COLOR_STATE_SRGB))
+    return 0;
+
+  region = cairo_region_create ();
+  gdk_texture_diff (texture, base, region);
+  cairo_region_intersect_rectangle (region, &(cairo_rectangle_int_t) { 0, 0, width, height });
+  cairo_region_get_extents (region, &area);
+  cairo_region_destroy (region);
+
+  /* Nothing changed, but we still need a new texture */
+  if (area.width == 0 || area.height == 0)
+    area = (cairo_rectangle_int_t) { 0, 0, 1, 1 };
+
+  if ((gsize) area.width * area.height > (gsize) width * height * MAX_DELTA_RATIO)
+    return 0;
+
+  /* Memory textures, like the ones we get from cairo, are cut
+   * without copying, so only the changed area gets encoded.
+   */
+  memtex = gdk_memory_texture_from_texture (texture);
+  patch = gdk_memory_texture_new_subtexture (memtex,
+                                             area.x, area.y,
+                                             area.width, area.height);
+
+  id = gdk_broadway_server_upload_texture_delta (self->server,
+                                                 patch,
+                                                 base_data->id,
+                                                 area.x, area.y);
+
+  g_object_unref (patch);
+  g_object_unref (memtex);
+
+  return id;
+}
+
+/*
+ * gdk_broadway_display_ensure_texture:
+ * @display: the display
+ * @texture: the texture to upload
+ * @base: (nullable): the texture that was uploaded in place of
+ *   @texture before
+ *
+ * Uploads @texture, unless it was uploaded before. If @texture
+ * was set up with gdk_texture_set_diff() to be a change of @base,
+ * only the changed area is sent.
+ *
+ * Returns: the id of the uploaded texture
+ */
 guint32
 gdk_broadway_display_ensure_texture (GdkDisplay *display,
-                                     GdkTexture *texture)
+                                     GdkTexture *texture,
+                                     GdkTexture *base)
 {
   GdkBroadwayDisplay *broadway_display = GDK_BROADWAY_DISPLAY (display);
   BroadwayTextureData *data;
@@ -443,7 +523,12 @@ gdk_broadway_display_ensure_texture (GdkDisplay *display,
   data = g_object_get_data (G_OBJECT (texture), "broadway-data");
   if (data == NULL)
     {
-      guint32 id = gdk_broadway_server_upload_texture (broadway_display->server, texture);
+      guint32 id = 0;
+
+      if (base != NULL && base != texture)
+        id = gdk_broadway_display_upload_texture_delta (broadway_display, texture, base);
+      if (id == 0)
+        id = gdk_broadway_server_upload_texture (broadway_display->server, texture);
 
       data = g_new0 (BroadwayTextureData, 1);
       data->id = id;
@@ -148,6 +148,7 @@ static const GdkDebugKey gdk_debug_keys[] = {
   { "no-vsync",        GDK_DEBUG_NO_VSYNC, "Repaint instantly (uses 100% CPU with animations)" },
   { "color-mgmt",      GDK_DEBUG_COLOR_MANAGEMENT, "Enable color management" },
   { "dcomp",           GDK_DEBUG_DCOMP, "Enable Direct Composition (Windows)" },
+  { "broadway-record", GDK_DEBUG_BROADWAY_RECORD, "Record browser input in gtk4-broadwayd" },
 };
 
 static const GdkDebugKey gdk_feature_keys[] = {
@@ -163,6 +164,7 @@ static const GdkDebugKey gdk_feature_keys[] = {
   { "d3d12",      GDK_FEATURE_D3D12,            "Disable Direct3D 12" },
   { "offload",    GDK_FEATURE_OFFLOAD,          "Disable graphics offload" },
   { "threads",    GDK_FEATURE_THREADS,          "Disable threads where possible" },
+  { "shm",        GDK_FEATURE_SHM,              "Disable shared memory for software rendering" },
 };
 
 static GdkFeatures gdk_features;
@@ -24,11 +24,16 @@
 #include "gdkcontentformatsprivate.h"
 #include "filetransferportalprivate.h"
 #include "gdktexture.h"
+#include "gdkcicpparamsprivate.h"
+#include "gdkcolorstateprivate.h"
+#include "gdkmemorytextureprivate.h"
 #include "gdkrgbaprivate.h"
 #include "gdkprivate.h"
 #include "loaders/gdkpngprivate.h"
 #include "loaders/gdktiffprivate.h"
 
+#include <glib/gi18n-lib.h>
+
 #include <gdk-pixbuf/gdk-pixbuf.h>
 
 
@@ -702,6 +707,235 @@ texture_deserializer (GdkContentDeserializer *deserializer)
   g_object_unref (output);
 }
 
+static GdkTexture *
+memory_texture_read_data (GInputStream          *stream,
+                          const GdkMemoryLayout *layout,
+                          GdkColorState         *color_state,
+                          GCancellable          *cancellable,
+                          GError               **error)
+{
+  GdkTexture *texture;
+  GBytes *bytes;
+  guchar *data;
+  gsize bytes_read;
+
+  data = g_try_malloc (layout->size);
+  if (data == NULL)
+    {
+      g_set_error (error,
+                   G_IO_ERROR, G_IO_ERROR_NO_SPACE,
+                   _("Not enough memory for image size %zux%zu"),
+                   layout->width, layout->height);
+      return NULL;
+    }
+
+  if (!g_input_stream_read_all (stream, data, layout->size, &bytes_read, cancellable, error))
+    {
+      g_free (data);
+      return NULL;
+    }
+
+  if (bytes_read < layout->size)
+    {
+      g_set_error_literal (error,
+                           G_IO_ERROR, G_IO_ERROR_PARTIAL_INPUT,
+                           _("Texture data is truncated"));
+      g_free (data);
+      return NULL;
+    }
+
+  bytes = g_bytes_new_take (data, layout->size);
+  texture = gdk_memory_texture_new_from_layout (bytes, layout, color_state, NULL, NULL);
+  g_bytes_unref (bytes);
+
+  return texture;
+}
+
+static const guchar *
+get_uint32 (const guchar *data,
+            guint32      *value)
+{
+  memcpy (value, data, sizeof (*value));
+  *value = GUINT32_FROM_LE (*value);
+
+  return data + sizeof (*value);
+}
+
+static const guchar *
+get_uint64 (const guchar *data,
+            guint64      *value)
+{
+  memcpy (value, data, sizeof (*value));
+  *value = GUINT64_FROM_LE (*value);
+
+  return data + sizeof (*value);
+}
+
+static gboolean
+memory_texture_read_header (GInputStream  *stream,
+                            guchar        *header,
+                            gsize          size,
+                            GCancellable  *cancellable,
+                            GError       **error)
+{
+  gsize bytes_read;
+
+  if (!g_input_stream_read_all (stream, header, size, &bytes_read, cancellable, error))
+    return FALSE;
+
+  if (bytes_read != size)
+    {
+      g_set_error_literal (error,
+                           G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                           _("Invalid texture data"));
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static void
+deserialize_memory_texture_in_thread (GTask        *task,
+                                      gpointer      source_object,
+                                      gpointer      task_data,
+                                      GCancellable *cancellable)
+{
+  GdkContentDeserializer *deserializer = source_object;
+  GInputStream *stream = gdk_content_deserializer_get_input_stream (deserializer);
+  guchar header[GDK_MEMORY_TEXTURE_HEADER_SIZE + GDK_MEMORY_MAX_PLANES * GDK_MEMORY_TEXTURE_PLANE_SIZE];
+  guint32 version, flags, format, width, height, n_planes;
+  guint64 size, offset, stride;
+  GdkMemoryLayout layout = { 0, };
+  GdkColorState *color_state;
+  const guchar *data;
+  GdkTexture *texture;
+  GError *error = NULL;
+  GdkCicp cicp;
+  gsize p;
+
+  if (!memory_texture_read_header (stream, header, GDK_MEMORY_TEXTURE_HEADER_SIZE, cancellable, &error))
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  data = header + 8;
+  data = get_uint32 (data, &version);
+  data = get_uint32 (data, &flags);
+  data = get_uint32 (data, &format);
+  data = get_uint32 (data, &width);
+  data = get_uint32 (data, &height);
+  data = get_uint32 (data, &n_planes);
+  data = get_uint64 (data, &size);
+
+  if (memcmp (header, GDK_MEMORY_TEXTURE_MAGIC, 8) != 0 ||
+      version != GDK_MEMORY_TEXTURE_VERSION ||
+      flags != (G_BYTE_ORDER == G_BIG_ENDIAN ? GDK_MEMORY_TEXTURE_BIG_ENDIAN : 0) ||
+      format >= GDK_MEMORY_N_FORMATS ||
+      n_planes != gdk_memory_format_get_n_planes (format))
+    {
+      g_task_return_new_error (task,
+                               G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                               _("Invalid texture data"));
+      return;
+    }
+
+  if (size > GDK_MEMORY_TEXTURE_MAX_SIZE)
+    {
+      g_task_return_new_error (task,
+                               G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                               _("Texture data too large"));
+      return;
+    }
+
+  cicp.color_primaries = *data++;
+  cicp.transfer_function = *data++;
+  cicp.matrix_coefficients = *data++;
+  cicp.range = *data++;
+
+  if (!memory_texture_read_header (stream, header + GDK_MEMORY_TEXTURE_HEADER_SIZE,
+                                   n_planes * GDK_MEMORY_TEXTURE_PLANE_SIZE,
+                                   cancellable, &error))
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  layout.format = format;
+  layout.width = width;
+  layout.height = height;
+  layout.size = size;
+  for (p = 0; p < n_planes; p++)
+    {
+      data = get_uint64 (data, &offset);
+      data = get_uint64 (data, &stride);
+      if (offset > size || stride > size)
+        {
+          g_task_return_new_error (task,
+                                   G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                                   _("Invalid texture data"));
+          return;
+        }
+      layout.planes[p].offset = offset;
+      layout.planes[p].stride = stride;
+    }
+
+  if (!gdk_memory_layout_is_valid (&layout, &error))
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  color_state = gdk_color_state_new_for_cicp (&cicp, &error);
+  if (color_state == NULL)
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  texture = memory_texture_read_data (stream, &layout, color_state, cancellable, &error);
+  gdk_color_state_unref (color_state);
+
+  if (texture)
+    g_task_return_pointer (task, texture, g_object_unref);
+  else
+    g_task_return_error (task, error);
+}
+
+static void
+memory_texture_deserializer_finish (GObject      *source,
+                                    GAsyncResult *result,
+                                    gpointer      user_data)
+{
+  GdkContentDeserializer *deserializer = GDK_CONTENT_DESERIALIZER (source);
+  GdkTexture *texture;
+  GError *error = NULL;
+
+  texture = g_task_propagate_pointer (G_TASK (result), &error);
+  if (texture == NULL)
+    {
+      gdk_content_deserializer_return_error (deserializer, error);
+      return;
+    }
+
+  g_value_take_object (gdk_content_deserializer_get_value (deserializer), texture);
+  gdk_content_deserializer_return_success (deserializer);
+}
+
+static void
+memory_texture_deserializer (GdkContentDeserializer *deserializer)
+{
+  GTask *task;
+
+  task = g_task_new (deserializer,
+                     gdk_content_deserializer_get_cancellable (deserializer),
+                     memory_texture_deserializer_finish,
+                     NULL);
+  g_task_set_source_tag (task, memory_texture_deserializer);
+  g_task_run_in_thread (task, deserialize_memory_texture_in_thread);
+  g_object_unref (task);
+}
+
 static void
 string_deserializer_finish (GObject      *source,
                             GAsyncResult *result,
@@ -912,6 +1146,11 @@ gdk_content_init_deserializers (void)
 
   /* Textures */
 
+  gdk_content_register_deserializer (GDK_MEMORY_TEXTURE_MIME_TYPE,
+                                     GDK_TYPE_TEXTURE,
+                                     memory_texture_deserializer,
+                                     NULL,
+                                     NULL);
   gdk_content_register_deserializer ("image/png",
                                      GDK_TYPE_TEXTURE,
                                      texture_deserializer,
@@ -30,6 +30,8 @@
 #include "loaders/gdktiffprivate.h"
 #include "loaders/gdkjpegprivate.h"
 #include "gdkmemorytextureprivate.h"
+#include "gdkcolorstateprivate.h"
+#include "gdktexturedownloaderprivate.h"
 #include "gdkprivate.h"
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
@@ -662,6 +664,91 @@ texture_serializer_finish (GObject      *source,
     gdk_content_serializer_return_success (serializer);
 }
 
+static guchar *
+put_uint32 (guchar  *data,
+            guint32  value)
+{
+  value = GUINT32_TO_LE (value);
+  memcpy (data, &value, sizeof (value));
+
+  return data + sizeof (value);
+}
+
+static guchar *
+put_uint64 (guchar  *data,
+            guint64  value)
+{
+  value = GUINT64_TO_LE (value);
+  memcpy (data, &value, sizeof (value));
+
+  return data + sizeof (value);
+}
+
+static gboolean
+serialize_memory_texture (GdkTexture     *texture,
+                          GOutputStream  *stream,
+                          GCancellable   *cancellable,
+                          GError        **error)
+{
+  guchar header[GDK_MEMORY_TEXTURE_HEADER_SIZE + GDK_MEMORY_MAX_PLANES * GDK_MEMORY_TEXTURE_PLANE_SIZE];
+  GdkTextureDownloader downloader;
+  GdkMemoryLayout layout;
+  GdkColorState *color_state;
+  const GdkCicp *cicp;
+  GBytes *bytes;
+  guchar *data;
+  gsize p, n_planes;
+  gboolean result;
+
+  color_state = gdk_texture_get_color_state (texture);
+  if (gdk_color_state_get_cicp (color_state) == NULL)
+    color_state = GDK_COLOR_STATE_SRGB;
+  cicp = gdk_color_state_get_cicp (color_state);
+
+  /* This will not copy if the texture is a memory texture already */
+  gdk_texture_downloader_init (&downloader, texture);
+  gdk_texture_downloader_set_format (&downloader, gdk_texture_get_format (texture));
+  gdk_texture_downloader_set_color_state (&downloader, color_state);
+  bytes = gdk_texture_downloader_download_bytes_layout (&downloader, &layout);
+  gdk_texture_downloader_finish (&downloader);
+
+  n_planes = gdk_memory_format_get_n_planes (layout.format);
+
+  data = header;
+  memcpy (data, GDK_MEMORY_TEXTURE_MAGIC, 8);
+  data += 8;
+  data = put_uint32 (data, GDK_MEMORY_TEXTURE_VERSION);
+  data = put_uint32 (data, G_BYTE_ORDER == G_BIG_ENDIAN ? GDK_MEMORY_TEXTURE_BIG_ENDIAN : 0);
+  data = put_uint32 (data, layout.format);
+  data = put_uint32 (data, layout.width);
+  data = put_uint32 (data, layout.height);
+  data = put_uint32 (data, n_planes);
+  data = put_uint64 (data, layout.size);
+  *data++ = cicp->color_primaries;
+  *data++ = cicp->transfer_function;
+  *data++ = cicp->matrix_coefficients;
+  *data++ = cicp->range;
+  for (p = 0; p < n_planes; p++)
+    {
+      data = put_uint64 (data, layout.planes[p].offset);
+      data = put_uint64 (data, layout.planes[p].stride);
+    }
+
+  g_assert (data - header == GDK_MEMORY_TEXTURE_HEADER_SIZE + n_planes * GDK_MEMORY_TEXTURE_PLANE_SIZE);
+
+  result = g_output_stream_write_all (stream, header, data - header, NULL, cancellable, error) &&
+           g_output_stream_write_all (stream,
+                                      g_bytes_get_data (bytes, NULL),
+                                      layout.size,
+                                      NULL,
+                                      cancellable,
+                                      error);
+
+  g_bytes_unref (bytes);
+
+  return result;
+}
+
 static void
 serialize_texture_in_thread (GTask        *task,
                              gpointer      source_object,
@@ -680,8 +767,20 @@ serialize_texture_in_thread (GTask        *task,
   value = gdk_content_serializer_get_value (serializer);
   texture = g_value_get_object (value);
 
+  if (strcmp (gdk_content_serializer_get_mime_type (serializer), GDK_MEMORY_TEXTURE_MIME_TYPE) == 0)
+    {
+      if (serialize_memory_texture (texture,
+                                    gdk_content_serializer_get_output_stream (serializer),
+                                    gdk_content_serializer_get_cancellable (serializer),
+                                    &error))
+        g_task_return_boolean (task, TRUE);
+      else
+        g_task_return_error (task, error);
+      return;
+    }
+
   if (strcmp (gdk_content_serializer_get_mime_type (serializer), "image/png") == 0)
-    bytes = gdk_save_png (texture, NULL);
+    bytes = gdk_save_png_with_compression (texture, NULL, GDK_PNG_COMPRESSION_FAST);
   else if (strcmp (gdk_content_serializer_get_mime_type (serializer), "image/tiff") == 0)
     bytes = gdk_save_tiff (texture);
   else if (strcmp (gdk_content_serializer_get_mime_type (serializer), "image/jpeg") == 0)
@@ -992,6 +1091,12 @@ gdk_content_init_serializers (void)
 
   /* Textures */
 
+  /* Registered first, so that GTK receivers prefer it */
+  gdk_content_register_serializer (GDK_TYPE_TEXTURE,
+                                   GDK_MEMORY_TEXTURE_MIME_TYPE,
+                                   texture_serializer,
+                                   NULL, NULL);
+
   gdk_content_register_serializer (GDK_TYPE_TEXTURE,
                                    "image/png",
                                    texture_serializer,
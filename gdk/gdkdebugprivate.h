@@ -51,6 +51,7 @@ typedef enum {
   GDK_DEBUG_NO_VSYNC           = 1 << 23,
   GDK_DEBUG_COLOR_MANAGEMENT   = 1 << 24,
   GDK_DEBUG_DCOMP              = 1 << 25,
+  GDK_DEBUG_BROADWAY_RECORD    = 1 << 26,
 } GdkDebugFlags;
 
 typedef enum {
@@ -66,9 +67,10 @@ typedef enum {
   GDK_FEATURE_D3D12            = 1 << 9,
   GDK_FEATURE_OFFLOAD          = 1 << 10,
   GDK_FEATURE_THREADS          = 1 << 11,
+  GDK_FEATURE_SHM              = 1 << 12,
 } GdkFeatures;
 
-#define GDK_ALL_FEATURES ((1 << 12) - 1)
+#define GDK_ALL_FEATURES ((1 << 13) - 1)
 
 extern guint _gdk_debug_flags;
 
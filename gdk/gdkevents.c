@@ -32,6 +32,7 @@
 #include "gdkkeysprivate.h"
 #include "gdkkeysyms.h"
 #include "gdkprivate.h"
+#include "gdkprofilerprivate.h"
 
 #include <gobject/gvaluecollector.h>
 
@@ -596,6 +597,21 @@ _gdk_event_unqueue (GdkDisplay *display)
   return event;
 }
 
+static guint coalesced_motion_counter;
+static guint coalesced_scroll_counter;
+static guint64 n_coalesced_motions;
+static guint64 n_coalesced_scrolls;
+
+static void
+gdk_event_queue_ensure_counters (void)
+{
+  if (G_LIKELY (coalesced_motion_counter != 0))
+    return;
+
+  coalesced_motion_counter = gdk_profiler_define_int_counter ("coalesced-motions", "Motion events merged into the history of a later one");
+  coalesced_scroll_counter = gdk_profiler_define_int_counter ("coalesced-scrolls", "Scroll events merged into the history of a later one");
+}
+
 /*
  * If the last N events in the event queue are smooth scroll events
  * for the same surface, the same device and the same scroll unit,
@@ -615,6 +631,8 @@ gdk_event_queue_handle_scroll_compression (GdkDisplay *display)
   GdkScrollUnit scroll_unit = GDK_SCROLL_UNIT_WHEEL;
   gboolean scroll_unit_defined = FALSE;
   GdkTimeCoord hist;
+  double total_dx = 0, total_dy = 0;
+  guint n_coalesced = 0;
 
   l = g_queue_peek_tail_link (&display->queued_events);
 
@@ -658,6 +676,11 @@ gdk_event_queue_handle_scroll_compression (GdkDisplay *display)
       double dx, dy;
       gboolean inherited = FALSE;
 
+      /* For an already compressed event, these are the sum over its history */
+      gdk_scroll_event_get_deltas (event, &dx, &dy);
+      total_dx += dx;
+      total_dy += dy;
+
       if (!history && ((GdkScrollEvent *)event)->history)
         {
           history = ((GdkScrollEvent *)event)->history;
@@ -670,8 +693,6 @@ gdk_event_queue_handle_scroll_compression (GdkDisplay *display)
 
       if (!inherited)
         {
-          gdk_scroll_event_get_deltas (event, &dx, &dy);
-
           memset (&hist, 0, sizeof (GdkTimeCoord));
           hist.time = gdk_event_get_time (event);
           hist.flags = GDK_AXIS_FLAG_DELTA_X | GDK_AXIS_FLAG_DELTA_Y;
@@ -684,6 +705,7 @@ gdk_event_queue_handle_scroll_compression (GdkDisplay *display)
       gdk_event_unref (event);
       g_queue_delete_link (&display->queued_events, scrolls);
       scrolls = next;
+      n_coalesced++;
     }
 
   if (scrolls && history)
@@ -702,13 +724,9 @@ gdk_event_queue_handle_scroll_compression (GdkDisplay *display)
       hist.axes[GDK_AXIS_DELTA_Y] = dy;
       g_array_append_val (history, hist);
 
-      dx = dy = 0;
-      for (int i = 0; i < history->len; i++)
-        {
-          GdkTimeCoord *val = &g_array_index (history, GdkTimeCoord, i);
-          dx += val->axes[GDK_AXIS_DELTA_X];
-          dy += val->axes[GDK_AXIS_DELTA_Y];
-        }
+      /* Same as summing up the history, but without walking it */
+      dx += total_dx;
+      dy += total_dy;
 
       event = gdk_scroll_event_new (surface,
                                     device,
@@ -728,6 +746,13 @@ gdk_event_queue_handle_scroll_compression (GdkDisplay *display)
 
       gdk_event_unref (old_event);
     }
+
+  if (n_coalesced > 0)
+    {
+      gdk_event_queue_ensure_counters ();
+      n_coalesced_scrolls += n_coalesced;
+      gdk_profiler_set_int_counter (coalesced_scroll_counter, n_coalesced_scrolls);
+    }
 }
 
 static void
@@ -742,15 +767,29 @@ gdk_motion_event_push_history (GdkEvent *event,
   g_assert (GDK_IS_EVENT_TYPE (event, GDK_MOTION_NOTIFY));
   g_assert (GDK_IS_EVENT_TYPE (history_event, GDK_MOTION_NOTIFY));
 
-  if (G_UNLIKELY (!self->history))
-    self->history = g_array_new (FALSE, TRUE, sizeof (GdkTimeCoord));
-
   if (((GdkMotionEvent *)history_event)->history)
     {
       GArray *history = ((GdkMotionEvent *)history_event)->history;
-      g_array_append_vals (self->history, history->data, history->len);
+
+      /* When motions are compressed as they arrive, the history of the
+       * previous event is moved over each time, so take it over instead
+       * of copying it, unless someone else can still see it.
+       */
+      if (self->history == NULL &&
+          g_ref_count_compare (&history_event->ref_count, 1))
+        self->history = g_steal_pointer (&((GdkMotionEvent *)history_event)->history);
+      else
+        {
+          if (G_UNLIKELY (!self->history))
+            self->history = g_array_new (FALSE, TRUE, sizeof (GdkTimeCoord));
+
+          g_array_append_vals (self->history, history->data, history->len);
+        }
     }
 
+  if (G_UNLIKELY (!self->history))
+    self->history = g_array_new (FALSE, TRUE, sizeof (GdkTimeCoord));
+
   tool = gdk_event_get_device_tool (history_event);
 
   memset (&hist, 0, sizeof (GdkTimeCoord));
@@ -791,6 +830,7 @@ _gdk_event_queue_handle_motion_compression (GdkDisplay *display)
   GdkSurface *pending_motion_surface = NULL;
   GdkDevice *pending_motion_device = NULL;
   GdkEvent *last_motion = NULL;
+  guint n_coalesced = 0;
 
   tmp_list = g_queue_peek_tail_link (&display->queued_events);
 
@@ -832,6 +872,14 @@ _gdk_event_queue_handle_motion_compression (GdkDisplay *display)
       gdk_event_unref (pending_motions->data);
       g_queue_delete_link (&display->queued_events, pending_motions);
       pending_motions = next;
+      n_coalesced++;
+    }
+
+  if (n_coalesced > 0)
+    {
+      gdk_event_queue_ensure_counters ();
+      n_coalesced_motions += n_coalesced;
+      gdk_profiler_set_int_counter (coalesced_motion_counter, n_coalesced_motions);
     }
 }
 
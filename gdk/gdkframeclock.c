@@ -98,6 +98,9 @@ enum {
 static guint signals[LAST_SIGNAL];
 
 static guint fps_counter;
+static guint layout_counter;
+static guint paint_counter;
+static guint latency_counter;
 
 /* 60Hz plus some extra for monotonic time inaccuracy */
 #define FRAME_HISTORY_DEFAULT_LENGTH 64
@@ -111,6 +114,14 @@ static guint fps_counter;
 #define GDK_ARRAY_FREE_FUNC frame_timings_unref
 #include "gdk/gdkarrayimpl.c"
 
+/* Durations are sorted into buckets by their log2 in microseconds,
+ * so bucket n collects durations in [2^(n-1), 2^n) us. The last bucket
+ * collects everything that is longer.
+ */
+#define N_LATENCY_BUCKETS 17
+/* The number of frames considered when predicting the duration of a frame */
+#define FRAME_DURATION_HISTORY 8
+
 typedef struct _GdkFrameClockPrivate GdkFrameClockPrivate;
 struct _GdkFrameClockPrivate
 {
@@ -129,6 +140,9 @@ struct _GdkFrameClockPrivate
   gsize n_started;
   gsize n_updating;
 
+  guint stage_histogram[GDK_FRAME_N_STAGES][N_LATENCY_BUCKETS];
+  guint present_histogram[N_LATENCY_BUCKETS];
+
   guint work_performed : 1;
 };
 
@@ -165,6 +179,8 @@ gdk_frame_clock_default_predict_presentation_time (GdkFrameClock *self,
   return predicted;
 }
 
+static void gdk_frame_clock_debug_print_latency (GdkFrameClock *self);
+
 static void
 gdk_frame_clock_finalize (GObject *object)
 {
@@ -174,6 +190,8 @@ gdk_frame_clock_finalize (GObject *object)
   g_warn_if_fail (priv->n_started == 0);
   g_warn_if_fail (priv->n_updating == 0);
 
+  gdk_frame_clock_debug_print_latency (self);
+
   timings_clear (&priv->timings);
 
   G_OBJECT_CLASS (gdk_frame_clock_parent_class)->finalize (object);
@@ -324,7 +342,12 @@ gdk_frame_clock_init (GdkFrameClock *clock)
   priv->latest_refresh_interval = (G_NSEC_PER_SEC + 30) / 60;
 
   if (fps_counter == 0)
-    fps_counter = gdk_profiler_define_counter ("fps", "Frames per Second");
+    {
+      fps_counter = gdk_profiler_define_counter ("fps", "Frames per Second");
+      layout_counter = gdk_profiler_define_int_counter ("frame-layout", "Time spent in the layout phase (us)");
+      paint_counter = gdk_profiler_define_int_counter ("frame-paint", "Time spent in the paint phase (us)");
+      latency_counter = gdk_profiler_define_int_counter ("frame-latency", "Time from frame start to presentation (us)");
+    }
 }
 
 /*<private>
@@ -880,6 +903,155 @@ gdk_frame_clock_get_fps (GdkFrameClock *frame_clock)
   return ((double) end_counter - start_counter) * G_USEC_PER_SEC / (end_timestamp - start_timestamp);
 }
 
+static inline guint
+latency_bucket (uint64_t duration)
+{
+  return MIN (g_bit_storage (duration / 1000), N_LATENCY_BUCKETS - 1);
+}
+
+static void
+gdk_frame_clock_record_stage_latency (GdkFrameClock   *self,
+                                      GdkFrameTimings *timings)
+{
+  GdkFrameClockPrivate *priv = gdk_frame_clock_get_instance_private (self);
+  GdkFrameStage stage;
+
+  for (stage = GDK_FRAME_STAGE_BEFORE_PAINT; stage < GDK_FRAME_N_STAGES; stage++)
+    {
+      uint64_t start = gdk_frame_timings_get_start_time (timings, stage);
+      uint64_t end = timings->stage_end_time[stage];
+
+      if (start == 0 || end <= start)
+        continue;
+
+      priv->stage_histogram[stage][latency_bucket (end - start)]++;
+    }
+
+  if (GDK_PROFILER_IS_RUNNING)
+    {
+      gdk_profiler_set_int_counter (layout_counter,
+                                    (gdk_frame_timings_get_end_time (timings, GDK_FRAME_STAGE_LAYOUT) -
+                                     gdk_frame_timings_get_start_time (timings, GDK_FRAME_STAGE_LAYOUT)) / 1000);
+      gdk_profiler_set_int_counter (paint_counter,
+                                    (gdk_frame_timings_get_end_time (timings, GDK_FRAME_STAGE_PAINT) -
+                                     gdk_frame_timings_get_start_time (timings, GDK_FRAME_STAGE_PAINT)) / 1000);
+    }
+}
+
+static void
+gdk_frame_clock_record_present_latency (GdkFrameClock   *self,
+                                        GdkFrameTimings *timings)
+{
+  GdkFrameClockPrivate *priv = gdk_frame_clock_get_instance_private (self);
+  uint64_t start, latency;
+
+  start = timings->stage_end_time[GDK_FRAME_STAGE_NONE];
+  if (start == 0 || timings->presentation_time <= start)
+    return;
+
+  latency = timings->presentation_time - start;
+  priv->present_histogram[latency_bucket (latency)]++;
+
+  if (GDK_PROFILER_IS_RUNNING)
+    gdk_profiler_set_int_counter (latency_counter, latency / 1000);
+}
+
+static void
+append_latency_histogram (GString     *str,
+                          const char  *name,
+                          const guint *histogram)
+{
+  guint i, first, last;
+
+  for (first = 0; first < N_LATENCY_BUCKETS && histogram[first] == 0; first++)
+    ;
+  if (first == N_LATENCY_BUCKETS)
+    return;
+  for (last = N_LATENCY_BUCKETS - 1; histogram[last] == 0; last--)
+    ;
+
+  g_string_append_printf (str, "\n  %-14s", name);
+  for (i = first; i <= last; i++)
+    {
+      if (i + 1 == N_LATENCY_BUCKETS)
+        g_string_append_printf (str, " >=%ums:%u", (1u << (i - 1)) / 1000, histogram[i]);
+      else
+        g_string_append_printf (str, " <%uus:%u", 1u << i, histogram[i]);
+    }
+}
+
+static void
+gdk_frame_clock_debug_print_latency (GdkFrameClock *self)
+{
+  GdkFrameClockPrivate *priv = gdk_frame_clock_get_instance_private (self);
+  static const char *stage_names[GDK_FRAME_N_STAGES] = {
+    [GDK_FRAME_STAGE_BEFORE_PAINT] = "before-paint",
+    [GDK_FRAME_STAGE_UPDATE] = "update",
+    [GDK_FRAME_STAGE_LAYOUT] = "layout",
+    [GDK_FRAME_STAGE_PAINT] = "paint",
+    [GDK_FRAME_STAGE_AFTER_PAINT] = "after-paint",
+    [GDK_FRAME_STAGE_RESUME_EVENTS] = "resume-events",
+  };
+  GdkFrameStage stage;
+  GString *str;
+
+  if (!GDK_DEBUG_CHECK (FRAMES) || priv->frame_counter < 0)
+    return;
+
+  str = g_string_new ("");
+  g_string_append_printf (str, "Frame clock latency over %" G_GINT64_FORMAT " frames:",
+                          priv->frame_counter + 1);
+  for (stage = GDK_FRAME_STAGE_BEFORE_PAINT; stage < GDK_FRAME_N_STAGES; stage++)
+    append_latency_histogram (str, stage_names[stage], priv->stage_histogram[stage]);
+  append_latency_histogram (str, "present", priv->present_histogram);
+
+  g_message ("%s", str->str);
+  g_string_free (str, TRUE);
+}
+
+/*<private>
+ * gdk_frame_clock_get_predicted_frame_duration:
+ * @self: the frame clock
+ *
+ * Predicts how long the next frame clock cycle will take, from
+ * flushing events until resuming them, based on the most recent
+ * frames in the history.
+ *
+ * The prediction is deliberately pessimistic, it is the longest
+ * of the recent cycles.
+ *
+ * Returns: The predicted duration in nanoseconds, or 0 if there
+ *   is no history
+ **/
+uint64_t
+gdk_frame_clock_get_predicted_frame_duration (GdkFrameClock *self)
+{
+  GdkFrameClockPrivate *priv = gdk_frame_clock_get_instance_private (self);
+  uint64_t duration = 0;
+  gint64 counter, start;
+
+  start = _gdk_frame_clock_get_history_start (self);
+  for (counter = priv->frame_counter;
+       counter >= start && counter > priv->frame_counter - FRAME_DURATION_HISTORY;
+       counter--)
+    {
+      GdkFrameTimings *timings = _gdk_frame_clock_get_timings (self, counter);
+      uint64_t begin, end;
+
+      if (timings == NULL)
+        break;
+
+      begin = timings->stage_end_time[GDK_FRAME_STAGE_NONE];
+      end = timings->stage_end_time[GDK_FRAME_STAGE_RESUME_EVENTS];
+      if (begin == 0 || end <= begin)
+        continue;
+
+      duration = MAX (duration, end - begin);
+    }
+
+  return duration;
+}
+
 static void
 gdk_frame_clock_add_timings_to_profiler (GdkFrameClock   *clock,
                                          GdkFrameTimings *timings)
@@ -1035,6 +1207,7 @@ gdk_frame_clock_presented (GdkFrameClock *self,
 
   gdk_frame_timings_presented (timings, presentation_time, refresh);
 
+  gdk_frame_clock_record_present_latency (self, timings);
   gdk_frame_clock_debug_print_timings (self, timings);
   gdk_frame_clock_add_timings_to_profiler (self, timings);
 }
@@ -1322,6 +1495,8 @@ gdk_frame_clock_frame (GdkFrameClock *self)
   gdk_frame_clock_run_after_paint (self);
   gdk_frame_clock_run_resume_events (self);
 
+  gdk_frame_clock_record_stage_latency (self, gdk_frame_clock_get_current_timings (self));
+
   gdk_profiler_end_mark (before, "Frameclock cycle", NULL);
 }
 
@@ -34,6 +34,12 @@
 
 #define FRAME_INTERVAL 16667 /* microseconds */
 
+typedef enum {
+  GDK_FRAME_PACING_THROUGHPUT,
+  GDK_FRAME_PACING_LOW_LATENCY,
+  GDK_FRAME_PACING_POWER_SAVE,
+} GdkFramePacing;
+
 typedef enum {
   SMOOTH_PHASE_STATE_VALID = 0,    /* explicit, since we count on zero-init */
   SMOOTH_PHASE_STATE_AWAIT_FIRST,
@@ -62,6 +68,38 @@ struct _GdkFrameClockIdlePrivate
 
 G_DEFINE_TYPE_WITH_PRIVATE (GdkFrameClockIdle, gdk_frame_clock_idle, GDK_TYPE_FRAME_CLOCK)
 
+static GdkFramePacing frame_pacing;
+
+static GdkFramePacing
+parse_frame_pacing (void)
+{
+  const struct {
+    const char *name;
+    GdkFramePacing pacing;
+  } values[] = {
+    { "throughput", GDK_FRAME_PACING_THROUGHPUT },
+    { "low-latency", GDK_FRAME_PACING_LOW_LATENCY },
+    { "power-save", GDK_FRAME_PACING_POWER_SAVE },
+  };
+  const char *string;
+  gsize i;
+
+  string = g_getenv ("GDK_FRAME_PACING");
+  if (string == NULL || *string == '\0')
+    return GDK_FRAME_PACING_THROUGHPUT;
+
+  for (i = 0; i < G_N_ELEMENTS (values); i++)
+    {
+      if (g_ascii_strcasecmp (string, values[i].name) == 0)
+        return values[i].pacing;
+    }
+
+  gdk_help_message ("Unrecognized value \"%s\" for GDK_FRAME_PACING. "
+                    "Supported values are throughput, low-latency and power-save", string);
+
+  return GDK_FRAME_PACING_THROUGHPUT;
+}
+
 static void
 gdk_frame_clock_idle_init (GdkFrameClockIdle *frame_clock_idle)
 {
@@ -178,6 +216,49 @@ get_source_priority (GdkFrameClockIdle *self)
 
 static gboolean gdk_frame_clock_source_cb (void *data);
 
+/* Extra time to wait before starting a cycle that was caused by the
+ * compositor telling us it's ready for the next frame.
+ *
+ * The throughput policy starts right away. The low-latency policy
+ * starts as late as possible so that the frame, using the longest
+ * recent cycle as its predicted duration, is still done in time for
+ * the next refresh; that way it picks up the most recent input. The
+ * power-save policy skips every other refresh.
+ */
+static uint64_t
+compute_pacing_delay (GdkFrameClockIdle *self,
+                      gboolean           caused_by_thaw)
+{
+  GdkFrameClock *clock = GDK_FRAME_CLOCK (self);
+  uint64_t period, duration, margin;
+
+  if (!caused_by_thaw || GDK_DEBUG_CHECK (NO_VSYNC))
+    return 0;
+
+  period = gdk_frame_clock_get_refresh_interval (clock);
+
+  switch (frame_pacing)
+    {
+    case GDK_FRAME_PACING_LOW_LATENCY:
+      duration = gdk_frame_clock_get_predicted_frame_duration (clock);
+      /* Without history, we have no idea how long a frame takes */
+      if (duration == 0)
+        return 0;
+      /* Leave some slack for the compositor and scheduling jitter */
+      margin = period / 4;
+      if (duration + margin >= period)
+        return 0;
+      return period - duration - margin;
+
+    case GDK_FRAME_PACING_POWER_SAVE:
+      return period;
+
+    case GDK_FRAME_PACING_THROUGHPUT:
+    default:
+      return 0;
+    }
+}
+
 static void
 maybe_start_idle (GdkFrameClockIdle *self,
                   gboolean           caused_by_thaw)
@@ -196,6 +277,8 @@ maybe_start_idle (GdkFrameClockIdle *self,
             interval = priv->min_next_frame_time - now;
         }
 
+      interval = MAX (interval, compute_pacing_delay (self, caused_by_thaw));
+
 G_GNUC_BEGIN_IGNORE_DEPRECATIONS
       priv->source = g_timeout_source_new_ns (interval);
 G_GNUC_END_IGNORE_DEPRECATIONS
@@ -379,6 +462,8 @@ gdk_frame_clock_source_cb (void *data)
        */
       uint64_t smooth_cycle_start = priv->smoothed_frame_time_base - priv->smoothed_frame_time_phase;
       priv->min_next_frame_time = smooth_cycle_start + priv->smoothed_frame_time_period;
+      if (frame_pacing == GDK_FRAME_PACING_POWER_SAVE)
+        priv->min_next_frame_time += priv->smoothed_frame_time_period;
 
       maybe_start_idle (self, FALSE);
     }
@@ -464,6 +549,8 @@ gdk_frame_clock_idle_class_init (GdkFrameClockIdleClass *klass)
 
   gobject_class->dispose = gdk_frame_clock_idle_dispose;
 
+  frame_pacing = parse_frame_pacing ();
+
   frame_clock_class->compute_frame_time = gdk_frame_clock_idle_compute_frame_time;
   frame_clock_class->request_phase = gdk_frame_clock_idle_request_phase;
   frame_clock_class->begin_updating = gdk_frame_clock_idle_begin_updating;
@@ -86,6 +86,7 @@ GdkFrameTimings *       gdk_frame_clock_find_timings            (GdkFrameClock
 
 uint64_t        gdk_frame_clock_get_refresh_interval            (GdkFrameClock          *self);
 uint64_t        gdk_frame_clock_get_latest_presentation_time    (GdkFrameClock          *self);
+uint64_t        gdk_frame_clock_get_predicted_frame_duration    (GdkFrameClock          *self);
 
 void            gdk_frame_clock_outstanding                     (GdkFrameClock          *self);
 void            gdk_frame_clock_submitted                       (GdkFrameClock          *self,
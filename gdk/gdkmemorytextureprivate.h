@@ -29,6 +29,32 @@ G_BEGIN_DECLS
 #define GDK_MEMORY_GDK_PIXBUF_OPAQUE GDK_MEMORY_R8G8B8
 #define GDK_MEMORY_GDK_PIXBUF_ALPHA GDK_MEMORY_R8G8B8A8
 
+/* Format for passing memory textures between GTK processes
+ * without encoding them. All header fields are little-endian:
+ *
+ *   0  magic, "GTKMEMTX"
+ *   8  guint32 version
+ *  12  guint32 flags, GDK_MEMORY_TEXTURE_BIG_ENDIAN if the pixel
+ *      data is in big-endian byte order
+ *  16  guint32 format, a GdkMemoryFormat
+ *  20  guint32 width
+ *  24  guint32 height
+ *  28  guint32 number of planes of the format
+ *  32  guint64 size of the pixel data
+ *  40  guint8[4] cicp: primaries, transfer, matrix, range
+ *  44  guint64 offset, guint64 stride for each plane
+ *
+ * The header is followed by the pixel data.
+ */
+#define GDK_MEMORY_TEXTURE_MIME_TYPE "application/x-gtk-memory-texture"
+#define GDK_MEMORY_TEXTURE_MAGIC "GTKMEMTX"
+#define GDK_MEMORY_TEXTURE_VERSION 2
+#define GDK_MEMORY_TEXTURE_BIG_ENDIAN (1 << 0)
+#define GDK_MEMORY_TEXTURE_HEADER_SIZE 44
+#define GDK_MEMORY_TEXTURE_PLANE_SIZE 16
+/* Refuse to allocate more than this for data from another process */
+#define GDK_MEMORY_TEXTURE_MAX_SIZE (G_GUINT64_CONSTANT (1) << 31)
+
 GdkMemoryTexture *      gdk_memory_texture_from_texture         (GdkTexture             *texture);
 GdkTexture *            gdk_memory_texture_new_subtexture       (GdkMemoryTexture       *texture,
                                                                  int                     x,
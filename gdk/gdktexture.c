@@ -649,6 +649,43 @@ gdk_texture_new_from_bytes_internal (GBytes  *bytes,
     }
 }
 
+/*<private>
+ * gdk_texture_new_from_bytes_at_size:
+ * @bytes: a `GBytes` containing the data to load
+ * @min_width: the minimum width needed, or -1
+ * @min_height: the minimum height needed, or -1
+ * @error: Return location for an error
+ *
+ * Like [ctor@Gdk.Texture.new_from_bytes], but allows the loader
+ * to decode the image at a reduced size, as long as the result
+ * is at least @min_width x @min_height.
+ *
+ * This is meant for callers that display large images at a
+ * small size, like thumbnails and icons. The size of the
+ * returned texture can be anything between the requested
+ * size and the full size of the image.
+ *
+ * Return value: A newly-created `GdkTexture`
+ */
+GdkTexture *
+gdk_texture_new_from_bytes_at_size (GBytes  *bytes,
+                                    int      min_width,
+                                    int      min_height,
+                                    GError **error)
+{
+  g_return_val_if_fail (bytes != NULL, NULL);
+  g_return_val_if_fail (error == NULL || *error == NULL, NULL);
+
+  if (gdk_is_png (bytes))
+    return gdk_load_png_at_size (bytes, NULL, min_width, min_height, error);
+  else if (gdk_is_jpeg (bytes))
+    return gdk_load_jpeg_at_size (bytes, min_width, min_height, error);
+  else if (gdk_is_tiff (bytes))
+    return gdk_load_tiff_at_size (bytes, min_width, min_height, error);
+  else
+    return gdk_texture_new_from_bytes (bytes, error);
+}
+
 static GdkTexture *
 gdk_texture_new_from_bytes_pixbuf (GBytes  *bytes,
                                    GError **error)
@@ -853,6 +890,51 @@ gdk_texture_download_bytes (GdkTexture      *self,
     }
 }
 
+/*<private>
+ * gdk_texture_has_tiles:
+ * @self: a texture
+ *
+ * Checks if the texture can produce parts of itself on demand
+ * via gdk_texture_get_tile().
+ *
+ * Textures that do this are usually too large to be kept in memory
+ * in full, so callers should avoid downloading them.
+ *
+ * Returns: %TRUE if the texture supports gdk_texture_get_tile()
+ */
+gboolean
+gdk_texture_has_tiles (GdkTexture *self)
+{
+  return GDK_TEXTURE_GET_CLASS (self)->get_tile != NULL;
+}
+
+/*<private>
+ * gdk_texture_get_tile:
+ * @self: a texture that has tiles
+ * @lod_level: the level of detail
+ * @area: the area of the texture to produce, in texture pixels
+ *
+ * Produces the given area of the texture, reduced in size by
+ * 2^@lod_level in each dimension.
+ *
+ * Returns: (transfer full) (nullable): a texture of size
+ *   @area->width x @area->height, divided by 2^@lod_level and
+ *   rounded up, or %NULL if the area could not be loaded
+ */
+GdkTexture *
+gdk_texture_get_tile (GdkTexture                  *self,
+                      guint                        lod_level,
+                      const cairo_rectangle_int_t *area)
+{
+  g_assert (gdk_texture_has_tiles (self));
+  g_assert (area->x >= 0 && area->y >= 0);
+  g_assert (area->width > 0 && area->height > 0);
+  g_assert (area->x + area->width <= self->width);
+  g_assert (area->y + area->height <= self->height);
+
+  return GDK_TEXTURE_GET_CLASS (self)->get_tile (self, lod_level, area);
+}
+
 static gboolean
 gdk_texture_has_ancestor (GdkTexture *self,
                           GdkTexture *other)
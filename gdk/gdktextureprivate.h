@@ -46,9 +46,19 @@ struct _GdkTextureClass {
                                                          guchar                 *data,
                                                          const GdkMemoryLayout  *layout,
                                                          GdkColorState          *color_state);
+  /* optional: Create a texture for an area at a reduced size,
+   * without producing the rest of the texture */
+  GdkTexture *          (* get_tile)                    (GdkTexture                  *texture,
+                                                         guint                        lod_level,
+                                                         const cairo_rectangle_int_t *area);
 };
 
 gboolean                gdk_texture_can_load            (GBytes                 *bytes);
+GdkTexture *            gdk_texture_new_from_bytes_at_size
+                                                        (GBytes                 *bytes,
+                                                         int                     min_width,
+                                                         int                     min_height,
+                                                         GError                **error);
 
 GdkTexture *            gdk_texture_new_for_surface     (cairo_surface_t        *surface);
 cairo_surface_t *       gdk_texture_download_surface    (GdkTexture             *texture,
@@ -62,6 +72,10 @@ void                    gdk_texture_do_download         (GdkTexture
                                                          GdkColorState          *color_state);
 GBytes *                gdk_texture_download_bytes      (GdkTexture             *self,
                                                          GdkMemoryLayout        *out_layout);
+gboolean                gdk_texture_has_tiles           (GdkTexture             *self);
+GdkTexture *            gdk_texture_get_tile            (GdkTexture             *self,
+                                                         guint                   lod_level,
+                                                         const cairo_rectangle_int_t *area);
 void                    gdk_texture_diff                (GdkTexture             *self,
                                                          GdkTexture             *other,
                                                          cairo_region_t         *region);
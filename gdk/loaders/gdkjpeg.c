@@ -26,6 +26,7 @@
 #include "gdktexturedownloaderprivate.h"
 #include "gdkmemorytexturebuilder.h"
 #include "gdkcolorstateprivate.h"
+#include "gdkloaderscaleprivate.h"
 
 #include "gdkprofilerprivate.h"
 
@@ -120,6 +121,19 @@ convert_cmyk_to_rgba (guchar *data,
 GdkTexture *
 gdk_load_jpeg (GBytes  *input_bytes,
                GError **error)
+{
+  return gdk_load_jpeg_at_size (input_bytes, -1, -1, error);
+}
+
+/* libjpeg can do the scaling as part of the IDCT, for
+ * scale factors down to 1/8. So we get reduced sizes
+ * for free, without ever decoding the full image.
+ */
+GdkTexture *
+gdk_load_jpeg_at_size (GBytes  *input_bytes,
+                       int      min_width,
+                       int      min_height,
+                       GError **error)
 {
   struct jpeg_decompress_struct info;
   struct error_handler_data jerr;
@@ -155,6 +169,14 @@ gdk_load_jpeg (GBytes  *input_bytes,
                 g_bytes_get_size (input_bytes));
 
   jpeg_read_header (&info, TRUE);
+
+  info.scale_num = 1;
+  info.scale_denom = 1 << MIN (gdk_loader_get_lod_level (info.image_width,
+                                                         info.image_height,
+                                                         min_width,
+                                                         min_height),
+                               3);
+
   jpeg_start_decompress (&info);
 
   width = info.output_width;
@@ -0,0 +1,97 @@
+/* GDK - The GIMP Drawing Kit
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include "gdkmemoryformatprivate.h"
+#include "gdkmemorylayoutprivate.h"
+
+/* Helpers for loaders that can decode images at a reduced size.
+ *
+ * Sizes are reduced by powers of 2, so that the result can be
+ * produced by the existing mipmap code. Loaders decode a band of
+ * 2^lod_level rows at a time and immediately reduce it to a single
+ * row of the final image, so the full-size image never exists in
+ * memory.
+ */
+
+/* The band buffer grows with 2^lod_level, so don't go too far */
+#define GDK_LOADER_MAX_LOD_LEVEL 6
+
+/*<private>
+ * gdk_loader_get_lod_level:
+ * @width: width of the encoded image
+ * @height: height of the encoded image
+ * @min_width: the minimum width the caller needs, or -1 for the full width
+ * @min_height: the minimum height the caller needs, or -1 for the full height
+ *
+ * Computes the largest power-of-2 reduction of the image that is still
+ * at least @min_width x @min_height.
+ *
+ * Returns: the lod level to decode at
+ */
+static inline guint
+gdk_loader_get_lod_level (gsize width,
+                          gsize height,
+                          int   min_width,
+                          int   min_height)
+{
+  guint lod_level;
+
+  if (min_width <= 0 && min_height <= 0)
+    return 0;
+
+  for (lod_level = 0; lod_level < GDK_LOADER_MAX_LOD_LEVEL; lod_level++)
+    {
+      gsize n = 2 << lod_level;
+
+      if (min_width > 0 && (width + n - 1) / n < min_width)
+        break;
+      if (min_height > 0 && (height + n - 1) / n < min_height)
+        break;
+    }
+
+  return lod_level;
+}
+
+/*<private>
+ * gdk_loader_reduce_band:
+ * @dest: the data of the reduced image
+ * @dest_layout: the layout of the reduced image
+ * @dest_row: the row in the reduced image to write
+ * @band: a band of up to 2^@lod_level rows of the full-size image
+ * @band_layout: the layout of @band
+ * @lod_level: the lod level
+ *
+ * Reduces a band of decoded rows to a single row of the final image.
+ */
+static inline void
+gdk_loader_reduce_band (guchar                *dest,
+                        const GdkMemoryLayout *dest_layout,
+                        gsize                  dest_row,
+                        const guchar          *band,
+                        const GdkMemoryLayout *band_layout,
+                        guint                  lod_level)
+{
+  GdkMemoryLayout row_layout;
+
+  gdk_memory_layout_init_sublayout (&row_layout,
+                                    dest_layout,
+                                    &(cairo_rectangle_int_t) { 0, dest_row, dest_layout->width, 1 });
+
+  gdk_memory_mipmap (dest, &row_layout, band, band_layout, lod_level, TRUE);
+}
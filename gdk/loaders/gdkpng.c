@@ -21,13 +21,17 @@
 
 #include <glib/gi18n-lib.h>
 #include "gdkcolorstateprivate.h"
+#include "gdkloaderscaleprivate.h"
 #include "gdkmemoryformatprivate.h"
 #include "gdkmemorytextureprivate.h"
+#include "gdkparalleltaskprivate.h"
 #include "gdkprofilerprivate.h"
 #include "gdktexturedownloaderprivate.h"
 
 #include <png.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <zlib.h>
 
 /* The main difference between the png load/save code here and
  * gdk-pixbuf is that we can support loading 16-bit data in the
@@ -293,6 +297,346 @@ gdk_png_set_color_state (png_struct    *png,
   return color_state;
 }
 
+/* }}} */
+/* {{{ Parallel encoding */
+
+/* libpng compresses the image data as a single zlib stream, which
+ * makes saving large images slow. Instead, we do the filtering and
+ * compression ourselves, in chunks of rows. Every chunk is deflated
+ * independently, primed with the last 32kB of the previous chunk as
+ * dictionary, and ended with a sync flush, so the concatenation of
+ * the chunks is a valid deflate stream. This is the same trick that
+ * pigz uses.
+ *
+ * libpng is still used to write all the other chunks.
+ */
+
+#define PNG_CHUNK_SIZE (256 * 1024)
+#define PNG_IDAT_SIZE (1024 * 1024)
+#define PNG_WINDOW_SIZE 32768
+
+typedef struct
+{
+  guchar *data;
+  gsize size;
+  uLong adler;
+} DeflateChunk;
+
+typedef struct
+{
+  const guchar *data;
+  gsize stride;
+  gsize row_bytes;
+  gsize bpp;
+  gsize height;
+  gboolean swap;
+  gboolean filter;
+  int level;
+
+  gsize rows_per_chunk;
+  gsize n_chunks;
+  guchar *filtered;
+  DeflateChunk *chunks;
+
+  int chunks_done;
+  int failed;
+} DeflateData;
+
+static inline guchar
+paeth_predictor (int a,
+                 int b,
+                 int c)
+{
+  int p = a + b - c;
+  int pa = abs (p - a);
+  int pb = abs (p - b);
+  int pc = abs (p - c);
+
+  if (pa <= pb && pa <= pc)
+    return a;
+  else if (pb <= pc)
+    return b;
+  else
+    return c;
+}
+
+static void
+prepare_row (guchar       *dest,
+             const guchar *src,
+             gsize         row_bytes,
+             gboolean      swap)
+{
+  if (swap)
+    {
+      for (gsize i = 0; i + 1 < row_bytes; i += 2)
+        {
+          dest[i] = src[i + 1];
+          dest[i + 1] = src[i];
+        }
+    }
+  else
+    memcpy (dest, src, row_bytes);
+}
+
+/* Apply one of the 5 png filters. Returns the sum of the
+ * absolute values of the result, which is the usual heuristic
+ * for picking a filter.
+ */
+static gsize
+filter_row (guchar       *dest,
+            const guchar *row,
+            const guchar *prev,
+            gsize         row_bytes,
+            gsize         bpp,
+            guint         filter)
+{
+  gsize i, sum = 0;
+
+  for (i = 0; i < row_bytes; i++)
+    {
+      int a = i >= bpp ? row[i - bpp] : 0;
+      int b = prev[i];
+      int c = i >= bpp ? prev[i - bpp] : 0;
+      guchar val;
+
+      switch (filter)
+        {
+        case PNG_FILTER_VALUE_NONE:
+          val = row[i];
+          break;
+        case PNG_FILTER_VALUE_SUB:
+          val = row[i] - a;
+          break;
+        case PNG_FILTER_VALUE_UP:
+          val = row[i] - b;
+          break;
+        case PNG_FILTER_VALUE_AVG:
+          val = row[i] - ((a + b) >> 1);
+          break;
+        case PNG_FILTER_VALUE_PAETH:
+          val = row[i] - paeth_predictor (a, b, c);
+          break;
+        default:
+          g_assert_not_reached ();
+        }
+
+      dest[i] = val;
+      sum += ABS ((signed char) val);
+    }
+
+  return sum;
+}
+
+static void
+gdk_png_filter_thread (gpointer data)
+{
+  DeflateData *deflate_data = data;
+  gsize chunk, y, row_end;
+  guchar *prev, *cur, *scratch;
+
+  prev = g_malloc (deflate_data->row_bytes);
+  cur = g_malloc (deflate_data->row_bytes);
+  scratch = g_malloc (deflate_data->row_bytes);
+
+  for (chunk = g_atomic_int_add (&deflate_data->chunks_done, 1);
+       chunk < deflate_data->n_chunks;
+       chunk = g_atomic_int_add (&deflate_data->chunks_done, 1))
+    {
+      y = chunk * deflate_data->rows_per_chunk;
+      row_end = MIN (y + deflate_data->rows_per_chunk, deflate_data->height);
+
+      if (y > 0)
+        prepare_row (prev, deflate_data->data + (y - 1) * deflate_data->stride, deflate_data->row_bytes, deflate_data->swap);
+      else
+        memset (prev, 0, deflate_data->row_bytes);
+
+      for (; y < row_end; y++)
+        {
+          guchar *dest = deflate_data->filtered + y * (deflate_data->row_bytes + 1);
+          guchar *tmp;
+          guint filter, best_filter;
+          gsize sum, best_sum;
+
+          prepare_row (cur, deflate_data->data + y * deflate_data->stride, deflate_data->row_bytes, deflate_data->swap);
+
+          if (deflate_data->filter)
+            {
+              best_filter = PNG_FILTER_VALUE_NONE;
+              best_sum = filter_row (dest + 1, cur, prev, deflate_data->row_bytes, deflate_data->bpp, PNG_FILTER_VALUE_NONE);
+
+              for (filter = PNG_FILTER_VALUE_SUB; filter < PNG_FILTER_VALUE_LAST; filter++)
+                {
+                  sum = filter_row (scratch, cur, prev, deflate_data->row_bytes, deflate_data->bpp, filter);
+                  if (sum < best_sum)
+                    {
+                      best_sum = sum;
+                      best_filter = filter;
+                      memcpy (dest + 1, scratch, deflate_data->row_bytes);
+                    }
+                }
+            }
+          else
+            {
+              best_filter = PNG_FILTER_VALUE_NONE;
+              memcpy (dest + 1, cur, deflate_data->row_bytes);
+            }
+
+          dest[0] = best_filter;
+
+          tmp = prev;
+          prev = cur;
+          cur = tmp;
+        }
+    }
+
+  g_free (prev);
+  g_free (cur);
+  g_free (scratch);
+}
+
+static void
+gdk_png_deflate_thread (gpointer data)
+{
+  DeflateData *deflate_data = data;
+  gsize chunk, filtered_stride, start, end;
+
+  filtered_stride = deflate_data->row_bytes + 1;
+
+  for (chunk = g_atomic_int_add (&deflate_data->chunks_done, 1);
+       chunk < deflate_data->n_chunks;
+       chunk = g_atomic_int_add (&deflate_data->chunks_done, 1))
+    {
+      DeflateChunk *out = &deflate_data->chunks[chunk];
+      z_stream z = { 0, };
+      gsize out_size;
+      gboolean last;
+      int res;
+
+      start = chunk * deflate_data->rows_per_chunk * filtered_stride;
+      end = MIN ((chunk + 1) * deflate_data->rows_per_chunk, deflate_data->height) * filtered_stride;
+      last = chunk + 1 == deflate_data->n_chunks;
+
+      if (deflateInit2 (&z, deflate_data->level, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+        {
+          g_atomic_int_set (&deflate_data->failed, 1);
+          continue;
+        }
+
+      if (start > 0)
+        {
+          gsize dict_size = MIN (start, PNG_WINDOW_SIZE);
+          deflateSetDictionary (&z, deflate_data->filtered + start - dict_size, dict_size);
+        }
+
+      out_size = deflateBound (&z, end - start) + 16;
+      out->data = g_malloc (out_size);
+
+      z.next_in = deflate_data->filtered + start;
+      z.avail_in = end - start;
+      z.next_out = out->data;
+      z.avail_out = out_size;
+
+      res = deflate (&z, last ? Z_FINISH : Z_SYNC_FLUSH);
+      if (res != (last ? Z_STREAM_END : Z_OK) || z.avail_in > 0 || z.avail_out == 0)
+        g_atomic_int_set (&deflate_data->failed, 1);
+
+      out->size = out_size - z.avail_out;
+      out->adler = adler32 (1, deflate_data->filtered + start, end - start);
+
+      deflateEnd (&z);
+    }
+}
+
+/* Returns the zlib stream for the IDAT chunks, or NULL if the
+ * image is too small to make parallel compression worthwhile.
+ */
+static GBytes *
+gdk_png_deflate_parallel (const guchar      *data,
+                          gsize              stride,
+                          gsize              width,
+                          gsize              height,
+                          GdkMemoryFormat    format,
+                          int                depth,
+                          GdkPngCompression  compression)
+{
+  DeflateData deflate_data;
+  GByteArray *result;
+  uLong adler;
+  guchar header[2], trailer[4];
+  gsize i;
+
+  deflate_data.data = data;
+  deflate_data.stride = stride;
+  deflate_data.bpp = gdk_memory_format_get_plane_block_bytes (format, 0);
+  deflate_data.row_bytes = width * deflate_data.bpp;
+  deflate_data.height = height;
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+  deflate_data.swap = depth == 16;
+#else
+  deflate_data.swap = FALSE;
+#endif
+  deflate_data.filter = compression != GDK_PNG_COMPRESSION_FAST;
+  deflate_data.level = compression == GDK_PNG_COMPRESSION_FAST ? Z_BEST_SPEED : Z_DEFAULT_COMPRESSION;
+  deflate_data.rows_per_chunk = MAX (1, PNG_CHUNK_SIZE / (deflate_data.row_bytes + 1));
+  deflate_data.n_chunks = (height + deflate_data.rows_per_chunk - 1) / deflate_data.rows_per_chunk;
+  deflate_data.failed = 0;
+
+  if (deflate_data.n_chunks < 2)
+    return NULL;
+
+  deflate_data.filtered = g_try_malloc_n (height, deflate_data.row_bytes + 1);
+  if (deflate_data.filtered == NULL)
+    return NULL;
+  deflate_data.chunks = g_new0 (DeflateChunk, deflate_data.n_chunks);
+
+  deflate_data.chunks_done = 0;
+  gdk_parallel_task_run (gdk_png_filter_thread, &deflate_data, deflate_data.n_chunks);
+  deflate_data.chunks_done = 0;
+  gdk_parallel_task_run (gdk_png_deflate_thread, &deflate_data, deflate_data.n_chunks);
+
+  g_free (deflate_data.filtered);
+
+  if (deflate_data.failed)
+    {
+      for (i = 0; i < deflate_data.n_chunks; i++)
+        g_free (deflate_data.chunks[i].data);
+      g_free (deflate_data.chunks);
+      return NULL;
+    }
+
+  /* zlib header, with FLEVEL matching the compression level */
+  header[0] = 0x78;
+  header[1] = compression == GDK_PNG_COMPRESSION_FAST ? 0x01 : 0x9c;
+
+  result = g_byte_array_new ();
+  g_byte_array_append (result, header, sizeof (header));
+
+  adler = deflate_data.chunks[0].adler;
+  for (i = 0; i < deflate_data.n_chunks; i++)
+    {
+      DeflateChunk *chunk = &deflate_data.chunks[i];
+
+      if (i > 0)
+        {
+          gsize start = i * deflate_data.rows_per_chunk;
+          gsize end = MIN (start + deflate_data.rows_per_chunk, height);
+          adler = adler32_combine (adler, chunk->adler, (end - start) * (deflate_data.row_bytes + 1));
+        }
+
+      g_byte_array_append (result, chunk->data, chunk->size);
+      g_free (chunk->data);
+    }
+  g_free (deflate_data.chunks);
+
+  trailer[0] = adler >> 24;
+  trailer[1] = adler >> 16;
+  trailer[2] = adler >> 8;
+  trailer[3] = adler;
+  g_byte_array_append (result, trailer, sizeof (trailer));
+
+  return g_byte_array_free_to_bytes (result);
+}
+
 /* }}} */
 /* {{{ Public API */
 
@@ -300,6 +644,20 @@ GdkTexture *
 gdk_load_png (GBytes      *bytes,
               GHashTable  *options,
               GError     **error)
+{
+  return gdk_load_png_at_size (bytes, options, -1, -1, error);
+}
+
+/* For non-interlaced images, we decode a band of rows at
+ * a time and reduce it right away, so we never need memory
+ * for the full-size image.
+ */
+GdkTexture *
+gdk_load_png_at_size (GBytes      *bytes,
+                      GHashTable  *options,
+                      int          min_width,
+                      int          min_height,
+                      GError     **error)
 {
   png_io io;
   png_struct *png = NULL;
@@ -307,12 +665,14 @@ gdk_load_png (GBytes      *bytes,
   png_textp text;
   int num_texts;
   guint width, height;
-  gsize i;
+  gsize i, y;
   int depth, color_type;
   int interlace;
+  guint lod_level;
   GdkMemoryFormat format;
-  GdkMemoryLayout layout;
+  GdkMemoryLayout layout, band_layout;
   guchar *buffer = NULL;
+  guchar *band = NULL;
   guchar **row_pointers = NULL;
   GBytes *out_bytes;
   GdkColorState *color_state;
@@ -348,6 +708,7 @@ gdk_load_png (GBytes      *bytes,
   if (sigsetjmp (png_jmpbuf (png), 1))
     {
       g_free (buffer);
+      g_free (band);
       g_free (row_pointers);
       png_destroy_read_struct (&png, &info, NULL);
       return NULL;
@@ -445,7 +806,16 @@ gdk_load_png (GBytes      *bytes,
   if (color_state == NULL)
     return NULL;
 
-  if (!gdk_memory_layout_try_init (&layout, format, width, height, 1))
+  if (interlace == PNG_INTERLACE_NONE)
+    lod_level = gdk_loader_get_lod_level (width, height, min_width, min_height);
+  else
+    lod_level = 0;
+
+  if (!gdk_memory_layout_try_init (&layout,
+                                   format,
+                                   (width + (1 << lod_level) - 1) >> lod_level,
+                                   (height + (1 << lod_level) - 1) >> lod_level,
+                                   1))
     {
       g_set_error (error,
                    GDK_TEXTURE_ERROR, GDK_TEXTURE_ERROR_TOO_LARGE,
@@ -454,12 +824,20 @@ gdk_load_png (GBytes      *bytes,
     }
 
   buffer = g_try_malloc (layout.size);
-  row_pointers = g_try_malloc_n (height, sizeof (char *));
+  if (lod_level > 0)
+    {
+      if (gdk_memory_layout_try_init (&band_layout, format, width, 1 << lod_level, 1))
+        band = g_try_malloc (band_layout.size);
+      row_pointers = g_try_malloc_n (1 << lod_level, sizeof (char *));
+    }
+  else
+    row_pointers = g_try_malloc_n (height, sizeof (char *));
 
-  if (!buffer || !row_pointers)
+  if (!buffer || !row_pointers || (lod_level > 0 && !band))
     {
       gdk_color_state_unref (color_state);
       g_free (buffer);
+      g_free (band);
       g_free (row_pointers);
       png_destroy_read_struct (&png, &info, NULL);
       g_set_error (error,
@@ -468,10 +846,34 @@ gdk_load_png (GBytes      *bytes,
       return NULL;
     }
 
-  for (i = 0; i < height; i++)
-    row_pointers[i] = &buffer[gdk_memory_layout_offset (&layout, 0, 0, i)];
+  if (lod_level > 0)
+    {
+      for (i = 0; i < band_layout.height; i++)
+        row_pointers[i] = &band[gdk_memory_layout_offset (&band_layout, 0, 0, i)];
+
+      for (y = 0; y < height; y += band_layout.height)
+        {
+          GdkMemoryLayout rows_layout;
+          gsize n_rows = MIN (band_layout.height, height - y);
+
+          png_read_rows (png, row_pointers, NULL, n_rows);
+
+          gdk_memory_layout_init_sublayout (&rows_layout,
+                                            &band_layout,
+                                            &(cairo_rectangle_int_t) { 0, 0, width, n_rows });
+          gdk_loader_reduce_band (buffer, &layout, y >> lod_level, band, &rows_layout, lod_level);
+        }
+
+      g_clear_pointer (&band, g_free);
+    }
+  else
+    {
+      for (i = 0; i < height; i++)
+        row_pointers[i] = &buffer[gdk_memory_layout_offset (&layout, 0, 0, i)];
+
+      png_read_image (png, row_pointers);
+    }
 
-  png_read_image (png, row_pointers);
   png_read_end (png, info);
 
   out_bytes = g_bytes_new_take (buffer, layout.size);
@@ -506,6 +908,14 @@ gdk_load_png (GBytes      *bytes,
 GBytes *
 gdk_save_png (GdkTexture *texture,
               GHashTable *options)
+{
+  return gdk_save_png_with_compression (texture, options, GDK_PNG_COMPRESSION_DEFAULT);
+}
+
+GBytes *
+gdk_save_png_with_compression (GdkTexture        *texture,
+                               GHashTable        *options,
+                               GdkPngCompression  compression)
 {
   png_struct *png = NULL;
   png_info *info;
@@ -514,7 +924,7 @@ gdk_save_png (GdkTexture *texture,
   int y;
   GdkMemoryFormat format;
   GdkTextureDownloader downloader;
-  GBytes *bytes;
+  GBytes *bytes, *idat;
   gsize stride;
   const guchar *data;
   GdkColorState *color_state;
@@ -669,11 +1079,14 @@ gdk_save_png (GdkTexture *texture,
 
   gdk_color_state_ref (color_state);
   bytes = NULL;
+  idat = NULL;
 
   if (sigsetjmp (png_jmpbuf (png), 1))
     {
       gdk_color_state_unref (color_state);
       g_clear_pointer (&bytes, g_bytes_unref);
+      g_clear_pointer (&idat, g_bytes_unref);
+      g_free (text_ptr);
       g_free (io.data);
       png_destroy_read_struct (&png, &info, NULL);
       return NULL;
@@ -689,8 +1102,6 @@ gdk_save_png (GdkTexture *texture,
 
   color_state = gdk_png_set_color_state (png, info, color_state, chunk_data);
 
-  png_write_info (png, info);
-
   if (options)
     {
       GHashTableIter iter;
@@ -726,6 +1137,14 @@ gdk_save_png (GdkTexture *texture,
       png_set_text (png, info, text_ptr, n_keys);
     }
 
+  if (compression == GDK_PNG_COMPRESSION_FAST)
+    {
+      png_set_compression_level (png, Z_BEST_SPEED);
+      png_set_filter (png, PNG_FILTER_TYPE_BASE, PNG_FILTER_NONE);
+    }
+
+  png_write_info (png, info);
+
 #if G_BYTE_ORDER == G_LITTLE_ENDIAN
   png_set_swap (png);
 #endif
@@ -737,10 +1156,33 @@ gdk_save_png (GdkTexture *texture,
   gdk_texture_downloader_finish (&downloader);
   data = g_bytes_get_data (bytes, NULL);
 
-  for (y = 0; y < height; y++)
-    png_write_row (png, data + y * stride);
+  idat = gdk_png_deflate_parallel (data, stride, width, height, format, depth, compression);
 
-  png_write_end (png, info);
+  if (idat)
+    {
+      const guchar *idat_data;
+      gsize idat_size, offset;
+
+      /* We don't use png_write_end() here, because libpng doesn't
+       * know that we wrote the image data. The only chunks that it
+       * would write are text chunks, and we put those before the
+       * image data.
+       */
+      idat_data = g_bytes_get_data (idat, &idat_size);
+      for (offset = 0; offset < idat_size; offset += PNG_IDAT_SIZE)
+        png_write_chunk (png, (png_const_bytep) "IDAT", idat_data + offset, MIN (PNG_IDAT_SIZE, idat_size - offset));
+
+      png_write_chunk (png, (png_const_bytep) "IEND", NULL, 0);
+
+      g_clear_pointer (&idat, g_bytes_unref);
+    }
+  else
+    {
+      for (y = 0; y < height; y++)
+        png_write_row (png, data + y * stride);
+
+      png_write_end (png, info);
+    }
 
   png_destroy_write_struct (&png, &info);
 
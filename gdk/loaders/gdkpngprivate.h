@@ -25,9 +25,23 @@
 GdkTexture *gdk_load_png        (GBytes         *bytes,
                                  GHashTable     *options,
                                  GError        **error);
+GdkTexture *gdk_load_png_at_size (GBytes        *bytes,
+                                  GHashTable    *options,
+                                  int            min_width,
+                                  int            min_height,
+                                  GError       **error);
+
+typedef enum {
+  GDK_PNG_COMPRESSION_DEFAULT,
+  GDK_PNG_COMPRESSION_FAST,
+} GdkPngCompression;
 
 GBytes     *gdk_save_png        (GdkTexture     *texture,
                                  GHashTable     *options);
+GBytes     *gdk_save_png_with_compression
+                                (GdkTexture        *texture,
+                                 GHashTable        *options,
+                                 GdkPngCompression  compression);
 
 static inline gboolean
 gdk_is_png (GBytes *bytes)
@@ -20,9 +20,11 @@
 #include "gdktiffprivate.h"
 
 #include "gdkcolorstate.h"
+#include "gdkloaderscaleprivate.h"
 #include "gdkmemoryformatprivate.h"
 #include "gdkmemorytextureprivate.h"
 #include "gdkprofilerprivate.h"
+#include "gdktextureprivate.h"
 #include "gdktexturedownloaderprivate.h"
 
 #include <glib/gi18n-lib.h>
@@ -220,6 +222,284 @@ tiff_open_write (GBytes **result)
                          NULL, NULL);
 }
 
+/* }}} */
+/* {{{ Tiled textures */
+
+/* Tiled TIFFs are commonly used for images that are far too
+ * large to be kept in memory in full, like scans or maps.
+ * For those, we keep the encoded data around and only decode
+ * the tiles that the renderer asks for.
+ */
+
+/* Tiled images smaller than this are loaded into a memory texture */
+#define GDK_TIFF_TEXTURE_MIN_SIZE (8192 * 8192)
+
+#define GDK_TYPE_TIFF_TEXTURE (gdk_tiff_texture_get_type ())
+#define GDK_TIFF_TEXTURE(obj) (G_TYPE_CHECK_INSTANCE_CAST ((obj), GDK_TYPE_TIFF_TEXTURE, GdkTiffTexture))
+
+typedef struct _GdkTiffTexture GdkTiffTexture;
+typedef struct _GdkTiffTextureClass GdkTiffTextureClass;
+
+struct _GdkTiffTexture
+{
+  GdkTexture parent_instance;
+
+  GBytes *bytes;
+  guint32 tile_width;
+  guint32 tile_height;
+
+  GMutex lock;
+  TIFF *tif;  /* guarded by lock */
+  guchar *tile_data;  /* guarded by lock */
+};
+
+struct _GdkTiffTextureClass
+{
+  GdkTextureClass parent_class;
+};
+
+static GType gdk_tiff_texture_get_type (void) G_GNUC_CONST;
+
+G_DEFINE_TYPE (GdkTiffTexture, gdk_tiff_texture, GDK_TYPE_TEXTURE)
+
+/* Decodes @area of the full-size image into @data.
+ * Must be called with the lock held.
+ */
+static gboolean
+gdk_tiff_texture_read_area_locked (GdkTiffTexture              *self,
+                                   const cairo_rectangle_int_t *area,
+                                   guchar                      *data,
+                                   gsize                        stride)
+{
+  gsize bpp, tile_stride;
+  int tx, ty;
+
+  bpp = gdk_memory_format_get_plane_block_bytes (GDK_TEXTURE (self)->format, 0);
+  tile_stride = self->tile_width * bpp;
+
+  for (ty = area->y - area->y % self->tile_height; ty < area->y + area->height; ty += self->tile_height)
+    {
+      int y0 = MAX (area->y, ty);
+      int y1 = MIN (area->y + area->height, ty + (int) self->tile_height);
+
+      for (tx = area->x - area->x % self->tile_width; tx < area->x + area->width; tx += self->tile_width)
+        {
+          int x0 = MAX (area->x, tx);
+          int x1 = MIN (area->x + area->width, tx + (int) self->tile_width);
+
+          if (TIFFReadTile (self->tif, self->tile_data, tx, ty, 0, 0) == -1)
+            return FALSE;
+
+          for (int y = y0; y < y1; y++)
+            {
+              memcpy (data + (y - area->y) * stride + (x0 - area->x) * bpp,
+                      self->tile_data + (y - ty) * tile_stride + (x0 - tx) * bpp,
+                      (x1 - x0) * bpp);
+            }
+        }
+    }
+
+  return TRUE;
+}
+
+static void
+gdk_tiff_texture_dispose (GObject *object)
+{
+  GdkTiffTexture *self = GDK_TIFF_TEXTURE (object);
+
+  g_clear_pointer (&self->tif, TIFFClose);
+  g_clear_pointer (&self->tile_data, g_free);
+  g_clear_pointer (&self->bytes, g_bytes_unref);
+
+  G_OBJECT_CLASS (gdk_tiff_texture_parent_class)->dispose (object);
+}
+
+static void
+gdk_tiff_texture_finalize (GObject *object)
+{
+  GdkTiffTexture *self = GDK_TIFF_TEXTURE (object);
+
+  g_mutex_clear (&self->lock);
+
+  G_OBJECT_CLASS (gdk_tiff_texture_parent_class)->finalize (object);
+}
+
+/* Downloading the full texture is what we are trying to avoid,
+ * but we have to support it. At least the decoding happens one
+ * row of tiles at a time.
+ */
+static void
+gdk_tiff_texture_download (GdkTexture            *texture,
+                           guchar                *data,
+                           const GdkMemoryLayout *layout,
+                           GdkColorState         *color_state)
+{
+  GdkTiffTexture *self = GDK_TIFF_TEXTURE (texture);
+  GdkMemoryLayout band_layout;
+  guchar *band;
+
+  gdk_memory_layout_init (&band_layout, texture->format, texture->width, self->tile_height, 1);
+  band = g_malloc (band_layout.size);
+
+  for (int y = 0; y < texture->height; y += self->tile_height)
+    {
+      cairo_rectangle_int_t rows = { 0, y, texture->width, MIN (self->tile_height, texture->height - y) };
+      GdkMemoryLayout rows_layout, dest_layout;
+      gboolean success;
+
+      g_mutex_lock (&self->lock);
+      success = gdk_tiff_texture_read_area_locked (self,
+                                                   &rows,
+                                                   band + band_layout.planes[0].offset,
+                                                   band_layout.planes[0].stride);
+      g_mutex_unlock (&self->lock);
+
+      /* We can't fail here, so corrupt tiles end up transparent */
+      if (!success)
+        memset (band, 0, band_layout.size);
+
+      gdk_memory_layout_init_sublayout (&rows_layout,
+                                        &band_layout,
+                                        &(cairo_rectangle_int_t) { 0, 0, rows.width, rows.height });
+      gdk_memory_layout_init_sublayout (&dest_layout, layout, &rows);
+      gdk_memory_convert (data,
+                          &dest_layout,
+                          color_state,
+                          band,
+                          &rows_layout,
+                          texture->color_state);
+    }
+
+  g_free (band);
+}
+
+static GdkTexture *
+gdk_tiff_texture_get_tile (GdkTexture                  *texture,
+                           guint                        lod_level,
+                           const cairo_rectangle_int_t *area)
+{
+  GdkTiffTexture *self = GDK_TIFF_TEXTURE (texture);
+  GdkMemoryLayout layout, band_layout;
+  guchar *data, *band = NULL;
+  gboolean success;
+  GBytes *bytes;
+  GdkTexture *result;
+  int band_rows;
+
+  if (!gdk_memory_layout_try_init (&layout,
+                                   texture->format,
+                                   (area->width + (1 << lod_level) - 1) >> lod_level,
+                                   (area->height + (1 << lod_level) - 1) >> lod_level,
+                                   1) ||
+      !(data = g_try_malloc (layout.size)))
+    return NULL;
+
+  if (lod_level == 0)
+    {
+      g_mutex_lock (&self->lock);
+      success = gdk_tiff_texture_read_area_locked (self,
+                                                   area,
+                                                   data + layout.planes[0].offset,
+                                                   layout.planes[0].stride);
+      g_mutex_unlock (&self->lock);
+    }
+  else
+    {
+      /* Decode a row of tiles at a time, rounded up so that
+       * it can be reduced without leftover rows.
+       */
+      band_rows = ((self->tile_height + (1 << lod_level) - 1) >> lod_level) << lod_level;
+      success = gdk_memory_layout_try_init (&band_layout, texture->format, area->width, band_rows, 1) &&
+                (band = g_try_malloc (band_layout.size)) != NULL;
+
+      for (int y = 0; success && y < area->height; y += band_rows)
+        {
+          int n_rows = MIN (band_rows, area->height - y);
+
+          g_mutex_lock (&self->lock);
+          success = gdk_tiff_texture_read_area_locked (self,
+                                                       &(cairo_rectangle_int_t) { area->x, area->y + y, area->width, n_rows },
+                                                       band + band_layout.planes[0].offset,
+                                                       band_layout.planes[0].stride);
+          g_mutex_unlock (&self->lock);
+
+          for (int r = 0; success && r < n_rows; r += 1 << lod_level)
+            {
+              GdkMemoryLayout rows_layout;
+
+              gdk_memory_layout_init_sublayout (&rows_layout,
+                                                &band_layout,
+                                                &(cairo_rectangle_int_t) { 0, r, area->width, MIN (1 << lod_level, n_rows - r) });
+              gdk_loader_reduce_band (data, &layout, (y + r) >> lod_level, band, &rows_layout, lod_level);
+            }
+        }
+
+      g_free (band);
+    }
+
+  if (!success)
+    {
+      g_free (data);
+      return NULL;
+    }
+
+  bytes = g_bytes_new_take (data, layout.size);
+  result = gdk_memory_texture_new_from_layout (bytes,
+                                               &layout,
+                                               texture->color_state,
+                                               NULL, NULL);
+  g_bytes_unref (bytes);
+
+  return result;
+}
+
+static void
+gdk_tiff_texture_class_init (GdkTiffTextureClass *klass)
+{
+  GdkTextureClass *texture_class = GDK_TEXTURE_CLASS (klass);
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+
+  texture_class->download = gdk_tiff_texture_download;
+  texture_class->get_tile = gdk_tiff_texture_get_tile;
+
+  gobject_class->dispose = gdk_tiff_texture_dispose;
+  gobject_class->finalize = gdk_tiff_texture_finalize;
+}
+
+static void
+gdk_tiff_texture_init (GdkTiffTexture *self)
+{
+  g_mutex_init (&self->lock);
+}
+
+/* Takes ownership of @tif, which must be reading from @bytes */
+static GdkTexture *
+gdk_tiff_texture_new (TIFF            *tif,
+                      GBytes          *bytes,
+                      GdkMemoryFormat  format,
+                      guint32          width,
+                      guint32          height,
+                      guint32          tile_width,
+                      guint32          tile_height)
+{
+  GdkTiffTexture *self;
+
+  self = g_object_new (GDK_TYPE_TIFF_TEXTURE,
+                       "width", width,
+                       "height", height,
+                       "color-state", gdk_color_state_get_srgb (),
+                       NULL);
+
+  GDK_TEXTURE (self)->format = format;
+  self->bytes = g_bytes_ref (bytes);
+  self->tif = tif;
+  self->tile_width = tile_width;
+  self->tile_height = tile_height;
+  self->tile_data = g_malloc (TIFFTileSize (tif));
+
+  return GDK_TEXTURE (self);
+}
+
 /* }}} */
 /* {{{ Public API */
 
@@ -420,9 +700,19 @@ load_fallback (TIFF    *tif,
   return texture;
 }
 
-GdkTexture *
-gdk_load_tiff (GBytes  *input_bytes,
-               GError **error)
+/* Like png, we read scanlines in bands and reduce them
+ * right away. Tiled images are reduced a row of tiles at a
+ * time. The fallback path always loads the full size.
+ *
+ * Tiled images of at least @min_tiled_size pixels are not decoded
+ * at all, but loaded into a texture that decodes tiles on demand.
+ */
+static GdkTexture *
+load_tiff (GBytes  *input_bytes,
+           int      min_width,
+           int      min_height,
+           gsize    min_tiled_size,
+           GError **error)
 {
   TIFF *tif;
   guint16 samples_per_pixel;
@@ -433,9 +723,10 @@ gdk_load_tiff (GBytes  *input_bytes,
   guint16 orientation;
   guint32 width, height;
   gint16 alpha_samples;
+  guint lod_level;
   GdkMemoryFormat format;
-  GdkMemoryLayout layout;
-  guchar *data, *line;
+  GdkMemoryLayout layout, band_layout;
+  guchar *data, *line, *band = NULL;
   GBytes *bytes;
   GdkTexture *texture;
   G_GNUC_UNUSED gint64 before = GDK_PROFILER_CURRENT_TIME;
@@ -499,7 +790,6 @@ gdk_load_tiff (GBytes  *input_bytes,
   if (format == G_N_ELEMENTS(format_data) ||
       (photometric != PHOTOMETRIC_RGB && photometric != PHOTOMETRIC_MINISBLACK) ||
       planarconfig != PLANARCONFIG_CONTIG ||
-      TIFFIsTiled (tif) ||
       orientation != ORIENTATION_TOPLEFT)
     {
       texture = load_fallback (tif, error);
@@ -507,9 +797,56 @@ gdk_load_tiff (GBytes  *input_bytes,
       return texture;
     }
 
-  if (!gdk_memory_layout_try_init (&layout, format, width, height, 1) ||
+  lod_level = gdk_loader_get_lod_level (width, height, min_width, min_height);
+
+  if (TIFFIsTiled (tif))
+    {
+      guint32 tile_width, tile_height;
+
+      if (!TIFFGetField (tif, TIFFTAG_TILEWIDTH, &tile_width) ||
+          !TIFFGetField (tif, TIFFTAG_TILELENGTH, &tile_height) ||
+          tile_width == 0 || tile_height == 0 ||
+          TIFFTileSize (tif) != (gsize) tile_width * tile_height * gdk_memory_format_get_plane_block_bytes (format, 0))
+        {
+          texture = load_fallback (tif, error);
+          TIFFClose (tif);
+          return texture;
+        }
+
+      texture = gdk_tiff_texture_new (tif, input_bytes, format, width, height, tile_width, tile_height);
+
+      if (lod_level > 0 || (gsize) width * height < min_tiled_size)
+        {
+          GdkTexture *memtex;
+
+          memtex = gdk_texture_get_tile (texture,
+                                         lod_level,
+                                         &(cairo_rectangle_int_t) { 0, 0, width, height });
+          g_object_unref (texture);
+          texture = memtex;
+        }
+
+      if (texture == NULL)
+        g_set_error_literal (error,
+                             GDK_TEXTURE_ERROR, GDK_TEXTURE_ERROR_CORRUPT_IMAGE,
+                             _("Could not load TIFF data"));
+
+      return texture;
+    }
+
+  if (lod_level > 0 &&
+      gdk_memory_layout_try_init (&band_layout, format, width, 1 << lod_level, 1))
+    band = g_try_malloc (band_layout.size);
+
+  if ((lod_level > 0 && !band) ||
+      !gdk_memory_layout_try_init (&layout,
+                                   format,
+                                   (width + (1 << lod_level) - 1) >> lod_level,
+                                   (height + (1 << lod_level) - 1) >> lod_level,
+                                   1) ||
       !(data = g_try_malloc (layout.size)))
     {
+      g_free (band);
       g_set_error (error,
                    GDK_TEXTURE_ERROR, GDK_TEXTURE_ERROR_TOO_LARGE,
                    _("Not enough memory for image size %ux%u"), width, height);
@@ -517,22 +854,59 @@ gdk_load_tiff (GBytes  *input_bytes,
       return NULL;
     }
 
-  g_assert (TIFFScanlineSize (tif) == layout.planes[0].stride);
-
-  line = data + layout.planes[0].offset;
-  for (int y = 0; y < height; y++)
+  if (lod_level > 0)
     {
-      if (TIFFReadScanline (tif, line, y, 0) == -1)
+      g_assert (TIFFScanlineSize (tif) == band_layout.planes[0].stride);
+
+      for (int y = 0; y < height; y += band_layout.height)
         {
-          g_set_error (error,
-                       GDK_TEXTURE_ERROR, GDK_TEXTURE_ERROR_CORRUPT_IMAGE,
-                       _("Reading data failed at row %d"), y);
-          TIFFClose (tif);
-          g_free (data);
-          return NULL;
+          GdkMemoryLayout rows_layout;
+          gsize n_rows = MIN (band_layout.height, height - y);
+
+          line = band + band_layout.planes[0].offset;
+          for (int i = 0; i < n_rows; i++)
+            {
+              if (TIFFReadScanline (tif, line, y + i, 0) == -1)
+                {
+                  g_set_error (error,
+                               GDK_TEXTURE_ERROR, GDK_TEXTURE_ERROR_CORRUPT_IMAGE,
+                               _("Reading data failed at row %d"), y + i);
+                  TIFFClose (tif);
+                  g_free (band);
+                  g_free (data);
+                  return NULL;
+                }
+
+              line += band_layout.planes[0].stride;
+            }
+
+          gdk_memory_layout_init_sublayout (&rows_layout,
+                                            &band_layout,
+                                            &(cairo_rectangle_int_t) { 0, 0, width, n_rows });
+          gdk_loader_reduce_band (data, &layout, y >> lod_level, band, &rows_layout, lod_level);
         }
 
-      line += layout.planes[0].stride;
+      g_free (band);
+    }
+  else
+    {
+      g_assert (TIFFScanlineSize (tif) == layout.planes[0].stride);
+
+      line = data + layout.planes[0].offset;
+      for (int y = 0; y < height; y++)
+        {
+          if (TIFFReadScanline (tif, line, y, 0) == -1)
+            {
+              g_set_error (error,
+                           GDK_TEXTURE_ERROR, GDK_TEXTURE_ERROR_CORRUPT_IMAGE,
+                           _("Reading data failed at row %d"), y);
+              TIFFClose (tif);
+              g_free (data);
+              return NULL;
+            }
+
+          line += layout.planes[0].stride;
+        }
     }
 
   bytes = g_bytes_new_take (data, layout.size);
@@ -554,6 +928,41 @@ gdk_load_tiff (GBytes  *input_bytes,
   return texture;
 }
 
+GdkTexture *
+gdk_load_tiff (GBytes  *input_bytes,
+               GError **error)
+{
+  return gdk_load_tiff_at_size (input_bytes, -1, -1, error);
+}
+
+GdkTexture *
+gdk_load_tiff_at_size (GBytes  *input_bytes,
+                       int      min_width,
+                       int      min_height,
+                       GError **error)
+{
+  return load_tiff (input_bytes, min_width, min_height, GDK_TIFF_TEXTURE_MIN_SIZE, error);
+}
+
+/*<private>
+ * gdk_load_tiff_tiled:
+ * @input_bytes: the TIFF data
+ * @error: return location for an error
+ *
+ * Like gdk_load_tiff(), but tiled images are always loaded into
+ * a texture that decodes its tiles on demand, no matter how small
+ * they are. This allows testing that code without huge images.
+ *
+ * Returns: (nullable): the texture
+ */
+GdkTexture *
+gdk_load_tiff_tiled (GBytes  *input_bytes,
+                     GError **error)
+{
+  return load_tiff (input_bytes, -1, -1, 0, error);
+}
+
+
 /* }}} */
 
 /* vim:set foldmethod=marker: */
@@ -25,6 +25,12 @@
 
 GdkTexture *gdk_load_tiff         (GBytes           *bytes,
                                    GError          **error);
+GdkTexture *gdk_load_tiff_at_size (GBytes           *bytes,
+                                   int               min_width,
+                                   int               min_height,
+                                   GError          **error);
+GdkTexture *gdk_load_tiff_tiled   (GBytes           *bytes,
+                                   GError          **error);
 
 GBytes *    gdk_save_tiff         (GdkTexture       *texture);
 
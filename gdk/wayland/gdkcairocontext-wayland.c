@@ -84,6 +84,8 @@ gdk_wayland_cairo_context_remove_surface (GdkWaylandCairoContext *self,
                                           cairo_surface_t        *surface)
 {
   self->surfaces = g_slist_remove (self->surfaces, surface);
+  if (self->last_surface == surface)
+    self->last_surface = NULL;
 
   cairo_surface_set_user_data (surface, &gdk_wayland_cairo_context_key, NULL, NULL);
   cairo_surface_destroy (surface);
@@ -103,10 +105,13 @@ gdk_wayland_cairo_context_buffer_release (void             *_data,
       return;
     }
 
-  /* Cache one surface for reuse when drawing */
-  if (self->cached_surface == NULL)
+  /* Keep a few surfaces for reuse when drawing. Their contents are
+   * kept up to date except for the region that was painted since,
+   * so reusing them is cheap.
+   */
+  if (g_slist_length (self->released_surfaces) < GDK_WAYLAND_SHM_POOL_MAX_BUFFERS)
     {
-      self->cached_surface = cairo_surface;
+      self->released_surfaces = g_slist_prepend (self->released_surfaces, cairo_surface);
       return;
     }
 
@@ -130,9 +135,11 @@ gdk_wayland_cairo_context_create_surface (GdkWaylandCairoContext *self)
   cairo_region_t *region;
   guint width, height;
 
+  if (self->pool == NULL)
+    self->pool = gdk_wayland_shm_pool_new (display_wayland);
+
   gdk_draw_context_get_buffer_size (draw_context, &width, &height);
-  cairo_surface = gdk_wayland_display_create_shm_surface (display_wayland,
-                                                          width, height);
+  cairo_surface = gdk_wayland_shm_pool_create_surface (self->pool, width, height);
   buffer = _gdk_wayland_shm_surface_get_wl_buffer (cairo_surface);
   wl_buffer_add_listener (buffer, &buffer_listener, cairo_surface);
   gdk_wayland_cairo_context_add_surface (self, cairo_surface);
@@ -144,6 +151,29 @@ gdk_wayland_cairo_context_create_surface (GdkWaylandCairoContext *self)
   return cairo_surface;
 }
 
+/* Picks the released surface that needs the least repainting. That
+ * is the one that was painted most recently, which is the first one
+ * in the list of surfaces.
+ */
+static cairo_surface_t *
+gdk_wayland_cairo_context_steal_released_surface (GdkWaylandCairoContext *self)
+{
+  GSList *l;
+
+  for (l = self->surfaces; l; l = l->next)
+    {
+      if (g_slist_find (self->released_surfaces, l->data))
+        {
+          self->released_surfaces = g_slist_remove (self->released_surfaces, l->data);
+          return l->data;
+        }
+    }
+
+  g_assert (self->released_surfaces == NULL);
+
+  return NULL;
+}
+
 static void
 gdk_wayland_cairo_context_begin_frame (GdkDrawContext  *draw_context,
                                        gpointer         context_data,
@@ -157,14 +187,40 @@ gdk_wayland_cairo_context_begin_frame (GdkDrawContext  *draw_context,
   cairo_t *cr;
   GdkSurface *surface = gdk_draw_context_get_surface (draw_context);
 
-  if (self->cached_surface)
-    self->paint_surface = g_steal_pointer (&self->cached_surface);
-  else
+  self->paint_surface = gdk_wayland_cairo_context_steal_released_surface (self);
+  if (self->paint_surface == NULL)
     self->paint_surface = gdk_wayland_cairo_context_create_surface (self);
 
   surface_region = gdk_wayland_cairo_context_surface_get_region (self->paint_surface);
   if (surface_region)
-    cairo_region_union (region, surface_region);
+    {
+      cairo_region_t *stale;
+
+      stale = cairo_region_copy (surface_region);
+      cairo_region_subtract (stale, region);
+
+      /* The last surface we painted is up to date, so copy the parts
+       * that changed since this one was used from it, and only repaint
+       * what actually needs repainting.
+       */
+      if (self->last_surface != NULL &&
+          self->last_surface != self->paint_surface &&
+          !cairo_region_is_empty (stale))
+        {
+          cr = cairo_create (self->paint_surface);
+          cairo_set_source_surface (cr, self->last_surface, 0, 0);
+          cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+          gdk_cairo_region (cr, stale);
+          cairo_fill (cr);
+          cairo_destroy (cr);
+        }
+      else
+        {
+          cairo_region_union (region, stale);
+        }
+
+      cairo_region_destroy (stale);
+    }
 
   for (l = self->surfaces; l; l = l->next)
     {
@@ -199,6 +255,11 @@ gdk_wayland_cairo_context_end_frame (GdkDrawContext *draw_context,
   gdk_wayland_surface_commit (surface);
   gdk_wayland_surface_notify_committed (surface);
 
+  /* Keep the list of surfaces sorted by when they were painted */
+  self->surfaces = g_slist_remove (self->surfaces, self->paint_surface);
+  self->surfaces = g_slist_prepend (self->surfaces, self->paint_surface);
+  self->last_surface = self->paint_surface;
+
   g_clear_pointer (&self->paint_surface, gdk_wayland_cairo_context_surface_clear_region);
 }
 
@@ -213,7 +274,7 @@ gdk_wayland_cairo_context_empty_frame (GdkDrawContext *draw_context)
 static void
 gdk_wayland_cairo_context_clear_all_cairo_surfaces (GdkWaylandCairoContext *self)
 {
-  g_clear_pointer (&self->cached_surface, cairo_surface_destroy);
+  g_slist_free_full (g_steal_pointer (&self->released_surfaces), (GDestroyNotify) cairo_surface_destroy);
   while (self->surfaces)
     gdk_wayland_cairo_context_remove_surface (self, self->surfaces->data);
 }
@@ -240,8 +301,9 @@ gdk_wayland_cairo_context_dispose (GObject *object)
   GdkWaylandCairoContext *self = GDK_WAYLAND_CAIRO_CONTEXT (object);
 
   gdk_wayland_cairo_context_clear_all_cairo_surfaces (self);
-  g_assert (self->cached_surface == NULL);
+  g_assert (self->released_surfaces == NULL);
   g_assert (self->paint_surface == NULL);
+  g_clear_pointer (&self->pool, gdk_wayland_shm_pool_unref);
 
   G_OBJECT_CLASS (gdk_wayland_cairo_context_parent_class)->dispose (object);
 }
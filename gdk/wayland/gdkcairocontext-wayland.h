@@ -21,6 +21,7 @@
 #include "gdkconfig.h"
 
 #include "gdkcairocontextprivate.h"
+#include "gdkshm-private.h"
 
 G_BEGIN_DECLS
 
@@ -33,9 +34,11 @@ struct _GdkWaylandCairoContext
 {
   GdkCairoContext parent_instance;
 
+  GdkWaylandShmPool *pool;
   GSList *surfaces;
-  cairo_surface_t *cached_surface;
+  GSList *released_surfaces;
   cairo_surface_t *paint_surface;
+  cairo_surface_t *last_surface;
 };
 
 struct _GdkWaylandCairoContextClass
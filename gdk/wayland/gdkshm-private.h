@@ -21,6 +21,11 @@
 #include <cairo.h>
 #include "gdkdisplay-wayland.h"
 
+/* The number of buffers a pool is expected to hold at once */
+#define GDK_WAYLAND_SHM_POOL_MAX_BUFFERS 4
+
+typedef struct _GdkWaylandShmPool GdkWaylandShmPool;
+
 cairo_surface_t * gdk_wayland_display_create_shm_surface  (GdkWaylandDisplay *display,
                                                            uint32_t           width,
                                                            uint32_t           height);
@@ -28,3 +33,10 @@ struct wl_buffer *_gdk_wayland_shm_surface_get_wl_buffer  (cairo_surface_t   *su
 gboolean          _gdk_wayland_is_shm_surface             (cairo_surface_t   *surface);
 struct wl_buffer *_gdk_wayland_shm_texture_get_wl_buffer  (GdkWaylandDisplay *display,
                                                            GdkTexture        *texture);
+
+GdkWaylandShmPool *gdk_wayland_shm_pool_new               (GdkWaylandDisplay *display);
+GdkWaylandShmPool *gdk_wayland_shm_pool_ref               (GdkWaylandShmPool *self);
+void               gdk_wayland_shm_pool_unref             (GdkWaylandShmPool *self);
+cairo_surface_t *  gdk_wayland_shm_pool_create_surface    (GdkWaylandShmPool *self,
+                                                           uint32_t           width,
+                                                           uint32_t           height);
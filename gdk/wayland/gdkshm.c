@@ -39,6 +39,10 @@ typedef struct _GdkWaylandCairoSurfaceData {
   struct wl_shm_pool *pool;
   struct wl_buffer *buffer;
   GdkWaylandDisplay *display;
+
+  /* Set for buffers carved out of a GdkWaylandShmPool */
+  GdkWaylandShmPool *shm_pool;
+  size_t offset;
 } GdkWaylandCairoSurfaceData;
 
 static int
@@ -147,6 +151,9 @@ fail:
   return NULL;
 }
 
+static void gdk_wayland_shm_pool_release (GdkWaylandShmPool *self,
+                                          size_t             offset);
+
 static void
 gdk_wayland_cairo_surface_destroy (void *p)
 {
@@ -155,6 +162,14 @@ gdk_wayland_cairo_surface_destroy (void *p)
   if (data->buffer)
     wl_buffer_destroy (data->buffer);
 
+  if (data->shm_pool)
+    {
+      gdk_wayland_shm_pool_release (data->shm_pool, data->offset);
+      gdk_wayland_shm_pool_unref (data->shm_pool);
+      g_free (data);
+      return;
+    }
+
   if (data->pool)
     wl_shm_pool_destroy (data->pool);
 
@@ -172,9 +187,8 @@ gdk_wayland_display_create_shm_surface (GdkWaylandDisplay *display,
   cairo_status_t status;
   int stride;
 
-  data = g_new (GdkWaylandCairoSurfaceData, 1);
+  data = g_new0 (GdkWaylandCairoSurfaceData, 1);
   data->display = display;
-  data->buffer = NULL;
 
   stride = cairo_format_stride_for_width (CAIRO_FORMAT_ARGB32, width);
 
@@ -221,6 +235,284 @@ _gdk_wayland_is_shm_surface (cairo_surface_t *surface)
   return cairo_surface_get_user_data (surface, &gdk_wayland_shm_surface_cairo_key) != NULL;
 }
 
+/* {{{2 Shm pool */
+
+/* A pool that many buffers are carved out of, so that they don't
+ * each need their own file, mapping and wl_shm_pool.
+ *
+ * The pool only ever grows, since wl_shm_pool can't shrink. When
+ * the pool grows, the old mapping is kept around until the pool is
+ * freed, because buffers that are still in use point into it.
+ */
+struct _GdkWaylandShmPool {
+  grefcount ref_count;
+
+  GdkWaylandDisplay *display;
+  int fd;
+  struct wl_shm_pool *pool;
+  guchar *data;
+  size_t size;
+  GSList *old_mappings;
+
+  /* sorted by offset */
+  GArray *ranges;
+};
+
+typedef struct {
+  size_t offset;
+  size_t size;
+} ShmRange;
+
+typedef struct {
+  gpointer data;
+  size_t size;
+} ShmMapping;
+
+GdkWaylandShmPool *
+gdk_wayland_shm_pool_new (GdkWaylandDisplay *display)
+{
+  GdkWaylandShmPool *self;
+
+  self = g_new0 (GdkWaylandShmPool, 1);
+  g_ref_count_init (&self->ref_count);
+  self->display = display;
+  self->fd = -1;
+  self->ranges = g_array_new (FALSE, FALSE, sizeof (ShmRange));
+
+  return self;
+}
+
+GdkWaylandShmPool *
+gdk_wayland_shm_pool_ref (GdkWaylandShmPool *self)
+{
+  g_ref_count_inc (&self->ref_count);
+
+  return self;
+}
+
+static void
+gdk_wayland_shm_pool_clear (GdkWaylandShmPool *self)
+{
+  GSList *l;
+
+  for (l = self->old_mappings; l; l = l->next)
+    {
+      ShmMapping *mapping = l->data;
+
+      munmap (mapping->data, mapping->size);
+      g_free (mapping);
+    }
+  g_clear_pointer (&self->old_mappings, g_slist_free);
+
+  if (self->data)
+    munmap (self->data, self->size);
+  self->data = NULL;
+  self->size = 0;
+
+  g_clear_pointer (&self->pool, wl_shm_pool_destroy);
+
+  if (self->fd >= 0)
+    close (self->fd);
+  self->fd = -1;
+}
+
+void
+gdk_wayland_shm_pool_unref (GdkWaylandShmPool *self)
+{
+  if (!g_ref_count_dec (&self->ref_count))
+    return;
+
+  g_assert (self->ranges->len == 0);
+
+  gdk_wayland_shm_pool_clear (self);
+  g_array_unref (self->ranges);
+  g_free (self);
+}
+
+static gboolean
+gdk_wayland_shm_pool_grow (GdkWaylandShmPool *self,
+                           size_t             size)
+{
+  guchar *data;
+  int res;
+
+  if (self->fd < 0)
+    {
+      self->fd = open_shared_memory ();
+      if (self->fd < 0)
+        return FALSE;
+    }
+
+#ifdef HAVE_POSIX_FALLOCATE
+  /* Unlike ftruncate(), this makes sure the memory is actually there,
+   * so we don't get SIGBUS when writing to it later.
+   */
+  do
+    res = posix_fallocate (self->fd, self->size, size - self->size);
+  while (res == EINTR);
+
+  if (res == EINVAL || res == EOPNOTSUPP)
+#else
+  res = -1;
+#endif
+    {
+      res = ftruncate (self->fd, size);
+      if (res < 0)
+        res = errno;
+    }
+
+  if (res != 0)
+    {
+      g_critical (G_STRLOC ": Growing shared memory file failed: %s", g_strerror (res));
+      return FALSE;
+    }
+
+  data = mmap (NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, self->fd, 0);
+  if (data == MAP_FAILED)
+    {
+      g_critical (G_STRLOC ": mmap'ping shared memory file failed: %m");
+      return FALSE;
+    }
+
+  if (self->data)
+    {
+      ShmMapping *mapping = g_new (ShmMapping, 1);
+
+      mapping->data = self->data;
+      mapping->size = self->size;
+      self->old_mappings = g_slist_prepend (self->old_mappings, mapping);
+    }
+
+  if (self->pool)
+    wl_shm_pool_resize (self->pool, size);
+  else
+    self->pool = wl_shm_create_pool (self->display->shm, self->fd, size);
+
+  self->data = data;
+  self->size = size;
+
+  return TRUE;
+}
+
+static size_t
+gdk_wayland_shm_pool_allocate (GdkWaylandShmPool *self,
+                               size_t             size)
+{
+  size_t offset;
+  guint i;
+
+  /* When the pool is unused and much larger than what is needed
+   * (e.g. after the window got smaller), start over with a new one.
+   */
+  if (self->ranges->len == 0 && self->size > size * GDK_WAYLAND_SHM_POOL_MAX_BUFFERS * 2)
+    gdk_wayland_shm_pool_clear (self);
+
+  /* First fit */
+  offset = 0;
+  for (i = 0; i < self->ranges->len; i++)
+    {
+      ShmRange *range = &g_array_index (self->ranges, ShmRange, i);
+
+      if (range->offset - offset >= size)
+        break;
+
+      offset = range->offset + range->size;
+    }
+
+  if (offset + size > self->size)
+    {
+      /* Leave room for another buffer of the same size, since
+       * there's usually more than one in flight.
+       */
+      if (!gdk_wayland_shm_pool_grow (self, MAX (offset + size, self->size + 2 * size)))
+        return (size_t) -1;
+    }
+
+  g_array_insert_val (self->ranges, i, ((ShmRange) { offset, size }));
+
+  return offset;
+}
+
+static void
+gdk_wayland_shm_pool_release (GdkWaylandShmPool *self,
+                              size_t             offset)
+{
+  guint i;
+
+  for (i = 0; i < self->ranges->len; i++)
+    {
+      if (g_array_index (self->ranges, ShmRange, i).offset == offset)
+        {
+          g_array_remove_index (self->ranges, i);
+          return;
+        }
+    }
+
+  g_assert_not_reached ();
+}
+
+/*<private>
+ * gdk_wayland_shm_pool_create_surface:
+ * @self: the pool
+ * @width: the width
+ * @height: the height
+ *
+ * Creates a shm surface like gdk_wayland_display_create_shm_surface(),
+ * but uses memory from the pool.
+ *
+ * The surface keeps a reference on the pool, and its memory is returned
+ * to the pool when it is destroyed.
+ *
+ * Returns: a new cairo surface
+ */
+cairo_surface_t *
+gdk_wayland_shm_pool_create_surface (GdkWaylandShmPool *self,
+                                     uint32_t           width,
+                                     uint32_t           height)
+{
+  GdkWaylandCairoSurfaceData *data;
+  cairo_surface_t *surface;
+  cairo_status_t status;
+  size_t offset;
+  int stride;
+
+  stride = cairo_format_stride_for_width (CAIRO_FORMAT_ARGB32, width);
+
+  offset = gdk_wayland_shm_pool_allocate (self, (size_t) height * stride);
+  if (G_UNLIKELY (offset == (size_t) -1))
+    g_error ("Unable to create shared memory pool");
+
+  data = g_new0 (GdkWaylandCairoSurfaceData, 1);
+  data->display = self->display;
+  data->shm_pool = gdk_wayland_shm_pool_ref (self);
+  data->offset = offset;
+  data->buf = self->data + offset;
+  data->buf_length = (size_t) height * stride;
+
+  surface = cairo_image_surface_create_for_data (data->buf,
+                                                 CAIRO_FORMAT_ARGB32,
+                                                 width,
+                                                 height,
+                                                 stride);
+
+  data->buffer = wl_shm_pool_create_buffer (self->pool, offset,
+                                            width, height,
+                                            stride, WL_SHM_FORMAT_ARGB8888);
+
+  cairo_surface_set_user_data (surface, &gdk_wayland_shm_surface_cairo_key,
+                               data, gdk_wayland_cairo_surface_destroy);
+
+  status = cairo_surface_status (surface);
+  if (status != CAIRO_STATUS_SUCCESS)
+    {
+      g_critical (G_STRLOC ": Unable to create Cairo image surface: %s",
+                  cairo_status_to_string (status));
+    }
+
+  return surface;
+}
+
+/* }}} */
 /* {{{2 wl_shm_buffer listener */
 
 static void
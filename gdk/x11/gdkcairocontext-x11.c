@@ -25,14 +25,308 @@
 #include "gdkprivate-x11.h"
 
 #include "gdkcairoprivate.h"
+#include "gdkdebugprivate.h"
 #include "gdksurfaceprivate.h"
 
 #include <X11/Xlib.h>
 
+#ifdef HAVE_XSHM
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/extensions/XShm.h>
+#endif
+
 G_GNUC_BEGIN_IGNORE_DEPRECATIONS
 
 G_DEFINE_TYPE (GdkX11CairoContext, gdk_x11_cairo_context, GDK_TYPE_CAIRO_CONTEXT)
 
+#ifdef HAVE_XSHM
+
+/* {{{ MIT-SHM */
+
+/* When the X server is local, we paint into images in shared memory
+ * and copy them to the window with XShmPutImage(), so the pixels don't
+ * have to go through the X connection.
+ *
+ * The server is done with an image once it has processed the request
+ * that uses it, so a buffer can be reused as soon as a later request
+ * is known to be processed. We keep a few buffers around to avoid
+ * waiting for that.
+ */
+
+#define N_SHM_BUFFERS 3
+
+typedef struct {
+  XShmSegmentInfo info;
+  XImage *image;
+  cairo_surface_t *surface;
+  gboolean attached;
+  /* Serial of the last request that used this buffer */
+  unsigned long serial;
+} GdkX11ShmBuffer;
+
+struct _GdkX11CairoShm {
+  GC gc;
+  int width;
+  int height;
+  GdkX11ShmBuffer *buffers[N_SHM_BUFFERS];
+  GdkX11ShmBuffer *paint_buffer;
+};
+
+static void
+gdk_x11_shm_buffer_free (Display         *xdisplay,
+                         GdkX11ShmBuffer *buffer)
+{
+  if (buffer->attached)
+    XShmDetach (xdisplay, &buffer->info);
+
+  if (buffer->image)
+    {
+      /* The data is not owned by the image */
+      buffer->image->data = NULL;
+      XDestroyImage (buffer->image);
+    }
+
+  if (buffer->info.shmaddr != (char *) -1)
+    shmdt (buffer->info.shmaddr);
+
+  /* Only happens if attaching failed */
+  if (buffer->info.shmid != -1)
+    shmctl (buffer->info.shmid, IPC_RMID, NULL);
+
+  g_clear_pointer (&buffer->surface, cairo_surface_destroy);
+  g_free (buffer);
+}
+
+static GdkX11ShmBuffer *
+gdk_x11_shm_buffer_new (GdkDisplay *display,
+                        int         width,
+                        int         height)
+{
+  Display *xdisplay = gdk_x11_display_get_xdisplay (display);
+  Visual *visual = gdk_x11_display_get_window_visual (GDK_X11_DISPLAY (display));
+  int depth = gdk_x11_display_get_window_depth (GDK_X11_DISPLAY (display));
+  GdkX11ShmBuffer *buffer;
+
+  buffer = g_new0 (GdkX11ShmBuffer, 1);
+  buffer->info.shmid = -1;
+  buffer->info.shmaddr = (char *) -1;
+
+  if (depth != 24 && depth != 32)
+    goto fail;
+
+  buffer->image = XShmCreateImage (xdisplay, visual, depth, ZPixmap, NULL,
+                                   &buffer->info, width, height);
+  if (buffer->image == NULL)
+    goto fail;
+
+  /* Make sure the image has the memory layout cairo expects */
+  if (buffer->image->bits_per_pixel != 32 ||
+      buffer->image->byte_order != (G_BYTE_ORDER == G_LITTLE_ENDIAN ? LSBFirst : MSBFirst) ||
+      buffer->image->red_mask != 0xff0000 ||
+      buffer->image->green_mask != 0xff00 ||
+      buffer->image->blue_mask != 0xff)
+    goto fail;
+
+  buffer->info.shmid = shmget (IPC_PRIVATE,
+                               (size_t) buffer->image->bytes_per_line * height,
+                               IPC_CREAT | 0600);
+  if (buffer->info.shmid == -1)
+    goto fail;
+
+  buffer->info.shmaddr = shmat (buffer->info.shmid, NULL, 0);
+  if (buffer->info.shmaddr == (char *) -1)
+    goto fail;
+
+  buffer->image->data = buffer->info.shmaddr;
+  buffer->info.readOnly = True;
+
+  /* This fails if the server is not on the same machine */
+  gdk_x11_display_error_trap_push (display);
+  XShmAttach (xdisplay, &buffer->info);
+  XSync (xdisplay, False);
+  if (gdk_x11_display_error_trap_pop (display))
+    goto fail;
+
+  buffer->attached = TRUE;
+
+  /* The segment is destroyed once both sides have detached */
+  shmctl (buffer->info.shmid, IPC_RMID, NULL);
+  buffer->info.shmid = -1;
+
+  buffer->surface = cairo_image_surface_create_for_data ((guchar *) buffer->image->data,
+                                                         depth == 32 ? CAIRO_FORMAT_ARGB32
+                                                                     : CAIRO_FORMAT_RGB24,
+                                                         width, height,
+                                                         buffer->image->bytes_per_line);
+  if (cairo_surface_status (buffer->surface) != CAIRO_STATUS_SUCCESS)
+    goto fail;
+
+  return buffer;
+
+fail:
+  gdk_x11_shm_buffer_free (xdisplay, buffer);
+  return NULL;
+}
+
+static gboolean
+gdk_x11_shm_buffer_is_idle (Display         *xdisplay,
+                            GdkX11ShmBuffer *buffer)
+{
+  return (long) (LastKnownRequestProcessed (xdisplay) - buffer->serial) >= 0;
+}
+
+static void
+gdk_x11_cairo_context_free_shm (GdkX11CairoContext *self)
+{
+  GdkDisplay *display = gdk_draw_context_get_display (GDK_DRAW_CONTEXT (self));
+  Display *xdisplay = gdk_x11_display_get_xdisplay (display);
+  GdkX11CairoShm *shm = self->shm;
+  guint i;
+
+  if (shm == NULL)
+    return;
+
+  for (i = 0; i < N_SHM_BUFFERS; i++)
+    {
+      if (shm->buffers[i])
+        gdk_x11_shm_buffer_free (xdisplay, shm->buffers[i]);
+    }
+
+  if (shm->gc)
+    XFreeGC (xdisplay, shm->gc);
+
+  g_clear_pointer (&self->shm, g_free);
+}
+
+static GdkX11ShmBuffer *
+gdk_x11_cairo_context_get_shm_buffer (GdkX11CairoContext *self,
+                                      int                 width,
+                                      int                 height)
+{
+  GdkDrawContext *draw_context = GDK_DRAW_CONTEXT (self);
+  GdkDisplay *display = gdk_draw_context_get_display (draw_context);
+  GdkSurface *surface = gdk_draw_context_get_surface (draw_context);
+  Display *xdisplay = gdk_x11_display_get_xdisplay (display);
+  GdkX11CairoShm *shm;
+  guint i;
+
+  if (self->shm && (self->shm->width != width || self->shm->height != height))
+    gdk_x11_cairo_context_free_shm (self);
+
+  if (self->shm == NULL)
+    {
+      self->shm = g_new0 (GdkX11CairoShm, 1);
+      self->shm->width = width;
+      self->shm->height = height;
+      self->shm->gc = XCreateGC (xdisplay, GDK_SURFACE_XID (surface), 0, NULL);
+    }
+
+  shm = self->shm;
+
+  for (i = 0; i < N_SHM_BUFFERS; i++)
+    {
+      if (shm->buffers[i] == NULL)
+        {
+          shm->buffers[i] = gdk_x11_shm_buffer_new (display, width, height);
+          return shm->buffers[i];
+        }
+
+      if (gdk_x11_shm_buffer_is_idle (xdisplay, shm->buffers[i]))
+        return shm->buffers[i];
+    }
+
+  /* All buffers are in use, wait for the server to catch up */
+  XSync (xdisplay, False);
+
+  return shm->buffers[0];
+}
+
+static gboolean
+gdk_x11_cairo_context_begin_shm_frame (GdkX11CairoContext *self,
+                                       cairo_region_t     *region)
+{
+  GdkDrawContext *draw_context = GDK_DRAW_CONTEXT (self);
+  GdkDisplay *display = gdk_draw_context_get_display (draw_context);
+  GdkSurface *surface = gdk_draw_context_get_surface (draw_context);
+  GdkX11ShmBuffer *buffer;
+  int scale;
+  cairo_t *cr;
+
+  if (self->shm_disabled)
+    return FALSE;
+
+  if (!gdk_has_feature (GDK_FEATURE_SHM) ||
+      !XShmQueryExtension (gdk_x11_display_get_xdisplay (display)))
+    {
+      self->shm_disabled = TRUE;
+      return FALSE;
+    }
+
+  scale = gdk_surface_get_scale_factor (surface);
+  buffer = gdk_x11_cairo_context_get_shm_buffer (self,
+                                                 gdk_surface_get_width (surface) * scale,
+                                                 gdk_surface_get_height (surface) * scale);
+  if (buffer == NULL)
+    {
+      GDK_DISPLAY_DEBUG (display, MISC, "Can't use MIT-SHM for drawing, falling back to Xlib");
+      gdk_x11_cairo_context_free_shm (self);
+      self->shm_disabled = TRUE;
+      return FALSE;
+    }
+
+  self->shm->paint_buffer = buffer;
+  self->paint_surface = cairo_surface_reference (buffer->surface);
+
+  /* The buffer still contains an old frame */
+  cr = cairo_create (self->paint_surface);
+  cairo_set_operator (cr, CAIRO_OPERATOR_CLEAR);
+  gdk_cairo_region (cr, region);
+  cairo_fill (cr);
+  cairo_destroy (cr);
+
+  return TRUE;
+}
+
+static void
+gdk_x11_cairo_context_end_shm_frame (GdkX11CairoContext *self,
+                                     cairo_region_t     *painted)
+{
+  GdkDrawContext *draw_context = GDK_DRAW_CONTEXT (self);
+  GdkDisplay *display = gdk_draw_context_get_display (draw_context);
+  GdkSurface *surface = gdk_draw_context_get_surface (draw_context);
+  Display *xdisplay = gdk_x11_display_get_xdisplay (display);
+  GdkX11ShmBuffer *buffer = self->shm->paint_buffer;
+  int i, n;
+
+  cairo_surface_flush (self->paint_surface);
+
+  n = cairo_region_num_rectangles (painted);
+  for (i = 0; i < n; i++)
+    {
+      cairo_rectangle_int_t rect;
+
+      cairo_region_get_rectangle (painted, i, &rect);
+      if (!gdk_rectangle_intersect (&rect,
+                                    &(cairo_rectangle_int_t) { 0, 0, self->shm->width, self->shm->height },
+                                    &rect))
+        continue;
+
+      XShmPutImage (xdisplay, GDK_SURFACE_XID (surface), self->shm->gc, buffer->image,
+                    rect.x, rect.y, rect.x, rect.y, rect.width, rect.height,
+                    False);
+    }
+
+  buffer->serial = NextRequest (xdisplay) - 1;
+  self->shm->paint_buffer = NULL;
+
+  g_clear_pointer (&self->paint_surface, cairo_surface_destroy);
+}
+
+/* }}} */
+
+#endif
+
 static cairo_surface_t *
 create_cairo_surface_for_surface (GdkSurface *surface)
 {
@@ -67,6 +361,15 @@ gdk_x11_cairo_context_begin_frame (GdkDrawContext  *draw_context,
   cairo_format_t format;
 
   surface = gdk_draw_context_get_surface (draw_context);
+
+  *out_color_state = GDK_COLOR_STATE_SRGB;
+  *out_depth = gdk_color_state_get_depth (GDK_COLOR_STATE_SRGB);
+
+#ifdef HAVE_XSHM
+  if (gdk_x11_cairo_context_begin_shm_frame (self, region))
+    return;
+#endif
+
   cairo_region_get_extents (region, &clip_box);
 
   self->window_surface = create_cairo_surface_for_surface (surface);
@@ -78,9 +381,6 @@ gdk_x11_cairo_context_begin_frame (GdkDrawContext  *draw_context,
 
   cairo_surface_set_device_scale (self->paint_surface, 1.0, 1.0);
   cairo_surface_set_device_offset (self->paint_surface, -clip_box.x, -clip_box.y);
-
-  *out_color_state = GDK_COLOR_STATE_SRGB;
-  *out_depth = gdk_color_state_get_depth (GDK_COLOR_STATE_SRGB);
 }
 
 static void
@@ -91,6 +391,14 @@ gdk_x11_cairo_context_end_frame (GdkDrawContext *draw_context,
   GdkX11CairoContext *self = GDK_X11_CAIRO_CONTEXT (draw_context);
   cairo_t *cr;
 
+#ifdef HAVE_XSHM
+  if (self->shm && self->shm->paint_buffer)
+    {
+      gdk_x11_cairo_context_end_shm_frame (self, painted);
+      return;
+    }
+#endif
+
   cr = cairo_create (self->window_surface);
 
   cairo_set_source_surface (cr, self->paint_surface, 0, 0);
@@ -116,12 +424,27 @@ gdk_x11_cairo_context_cairo_create (GdkCairoContext *context)
   return cairo_create (self->paint_surface);
 }
 
+static void
+gdk_x11_cairo_context_dispose (GObject *object)
+{
+#ifdef HAVE_XSHM
+  GdkX11CairoContext *self = GDK_X11_CAIRO_CONTEXT (object);
+
+  gdk_x11_cairo_context_free_shm (self);
+#endif
+
+  G_OBJECT_CLASS (gdk_x11_cairo_context_parent_class)->dispose (object);
+}
+
 static void
 gdk_x11_cairo_context_class_init (GdkX11CairoContextClass *klass)
 {
+  GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
   GdkDrawContextClass *draw_context_class = GDK_DRAW_CONTEXT_CLASS (klass);
   GdkCairoContextClass *cairo_context_class = GDK_CAIRO_CONTEXT_CLASS (klass);
 
+  gobject_class->dispose = gdk_x11_cairo_context_dispose;
+
   draw_context_class->begin_frame = gdk_x11_cairo_context_begin_frame;
   draw_context_class->end_frame = gdk_x11_cairo_context_end_frame;
 
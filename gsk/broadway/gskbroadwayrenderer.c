@@ -48,10 +48,12 @@ struct _GskBroadwayRenderer
   GArray *nodes;              /* Owned by draw_contex */
   GPtrArray *node_textures;   /* Owned by draw_contex */
   GHashTable *node_lookup;
+  GPtrArray *textures;        /* Textures of texture nodes */
 
   /* Kept from last frame */
   GHashTable *last_node_lookup;
   GskRenderNode *last_root; /* Owning refs to the things in last_node_lookup */
+  GPtrArray *last_textures;
 };
 
 struct _GskBroadwayRendererClass
@@ -94,6 +96,7 @@ gsk_broadway_renderer_unrealize (GskRenderer *renderer)
 
   gdk_draw_context_detach (GDK_DRAW_CONTEXT (self->draw_context));
 
+  g_clear_pointer (&self->last_textures, g_ptr_array_unref);
   g_clear_object (&self->draw_context);
 }
 
@@ -589,6 +592,47 @@ get_colorized_texture (GdkTexture *texture,
   return colorized_texture;
 }
 
+/* Textures that are updated in place, like video frames, are diffed
+ * against the last frame's texture they were updated from, so that
+ * only the changed area needs to be sent.
+ */
+static GdkTexture *
+find_texture_base (GskBroadwayRenderer *self,
+                   GdkTexture          *texture)
+{
+  cairo_rectangle_int_t full = {
+    0, 0,
+    gdk_texture_get_width (texture),
+    gdk_texture_get_height (texture)
+  };
+  guint i;
+
+  if (self->last_textures == NULL)
+    return NULL;
+
+  for (i = 0; i < self->last_textures->len; i++)
+    {
+      GdkTexture *last = g_ptr_array_index (self->last_textures, i);
+      cairo_region_t *region;
+      gboolean related;
+
+      if (last == texture ||
+          gdk_texture_get_width (last) != full.width ||
+          gdk_texture_get_height (last) != full.height)
+        continue;
+
+      /* Unrelated textures differ everywhere */
+      region = cairo_region_create ();
+      gdk_texture_diff (texture, last, region);
+      related = cairo_region_contains_rectangle (region, &full) != CAIRO_REGION_OVERLAP_IN;
+      cairo_region_destroy (region);
+
+      if (related)
+        return last;
+    }
+
+  return NULL;
+}
 
 /* Note: This tracks the offset so that we can convert
  * the absolute coordinates of the GskRenderNodes to
@@ -628,7 +672,9 @@ gsk_broadway_renderer_add_node (GskRenderer *renderer,
 
           /* No need to add to self->node_textures here, the node will keep it alive until end of frame. */
 
-          texture_id = gdk_broadway_display_ensure_texture (display, texture);
+          texture_id = gdk_broadway_display_ensure_texture (display, texture,
+                                                            find_texture_base (self, texture));
+          g_ptr_array_add (self->textures, g_object_ref (texture));
 
           add_rect (nodes, &node->bounds, offset_x, offset_y);
           add_uint32 (nodes, texture_id);
@@ -662,7 +708,7 @@ gsk_broadway_renderer_add_node (GskRenderer *renderer,
 
           texture = gdk_texture_new_for_surface (image_surface);
           g_ptr_array_add (self->node_textures, texture); /* Transfers ownership to node_textures */
-          texture_id = gdk_broadway_display_ensure_texture (display, texture);
+          texture_id = gdk_broadway_display_ensure_texture (display, texture, NULL);
 
           add_rect (nodes, &node->bounds, offset_x, offset_y);
           add_uint32 (nodes, texture_id);
@@ -894,7 +940,7 @@ gsk_broadway_renderer_add_node (GskRenderer *renderer,
             GdkTexture *colorized_texture = get_colorized_texture (texture, color_matrix, color_offset);
             if (add_new_node (renderer, node, BROADWAY_NODE_TEXTURE, clip_bounds))
               {
-                guint32 texture_id = gdk_broadway_display_ensure_texture (display, colorized_texture);
+                guint32 texture_id = gdk_broadway_display_ensure_texture (display, colorized_texture, NULL);
                 add_rect (nodes, &child->bounds, offset_x, offset_y);
                 add_uint32 (nodes, texture_id);
               }
@@ -959,7 +1005,7 @@ gsk_broadway_renderer_add_node (GskRenderer *renderer,
       texture = gdk_texture_new_for_surface (surface);
       g_ptr_array_add (self->node_textures, texture); /* Transfers ownership to node_textures */
 
-      texture_id = gdk_broadway_display_ensure_texture (display, texture);
+      texture_id = gdk_broadway_display_ensure_texture (display, texture, NULL);
       add_float (nodes, x - offset_x);
       add_float (nodes, y - offset_y);
       add_float (nodes, width);
@@ -978,6 +1024,7 @@ gsk_broadway_renderer_render (GskRenderer          *renderer,
   GskBroadwayRenderer *self = GSK_BROADWAY_RENDERER (renderer);
 
   self->node_lookup = g_hash_table_new (g_direct_hash, g_direct_equal);
+  self->textures = g_ptr_array_new_with_free_func (g_object_unref);
 
   gdk_draw_context_begin_frame_full (GDK_DRAW_CONTEXT (self->draw_context), NULL, root, update_area);
 
@@ -998,6 +1045,9 @@ gsk_broadway_renderer_render (GskRenderer          *renderer,
   self->last_node_lookup = self->node_lookup;
   self->node_lookup = NULL;
 
+  g_clear_pointer (&self->last_textures, g_ptr_array_unref);
+  self->last_textures = g_steal_pointer (&self->textures);
+
   if (self->last_root)
     gsk_render_node_unref (self->last_root);
   self->last_root = gsk_render_node_ref (root);
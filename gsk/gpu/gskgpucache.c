@@ -7,6 +7,7 @@
 #include "gskgpucachedatlasprivate.h"
 #include "gskgpucachedglyphprivate.h"
 #include "gskgpucachedfillprivate.h"
+#include "gskgpucachednodeprivate.h"
 #include "gskgpucachedstrokeprivate.h"
 #include "gskgpucachedtileprivate.h"
 #include "gskgpucachedprivate.h"
@@ -502,6 +503,7 @@ gsk_gpu_cache_dispose (GObject *object)
 
   gsk_gpu_cache_clear_cache (self);
 
+  gsk_gpu_cached_node_finish_cache (self);
   gsk_gpu_cached_stroke_finish_cache (self);
   gsk_gpu_cached_fill_finish_cache (self);
 
@@ -616,6 +618,7 @@ gsk_gpu_cache_init_caches (GskGpuCache *self)
     }
   gsk_gpu_cached_fill_init_cache (self);
   gsk_gpu_cached_stroke_init_cache (self);
+  gsk_gpu_cached_node_init_cache (self);
 }
 
 GskGpuCache *
@@ -0,0 +1,240 @@
+#include "config.h"
+
+#include "gskgpucachednodeprivate.h"
+
+#include "gskgpucacheprivate.h"
+#include "gskgpucachedprivate.h"
+#include "gskgpuimageprivate.h"
+
+#include "gsk/gskrendernodeprivate.h"
+
+/* Renderings of render boundaries that are reused across frames.
+ *
+ * There is one entry per boundary. It remembers the node that was
+ * last drawn for it, and only keeps a rendering once the same node
+ * was drawn in MIN_FRAMES frames, so animated subtrees, which get a
+ * new node every frame, are never rendered offscreen. When the node
+ * changes, the rendering of the previous one is dropped right away.
+ *
+ * We keep a reference to the node, so its address can't be
+ * reused for a different node while the entry is alive.
+ */
+
+#define MIN_FRAMES 2
+
+typedef struct _GskGpuCachedNode GskGpuCachedNode;
+
+struct _GskGpuCachedNode
+{
+  GskGpuCached parent;
+
+  gconstpointer boundary;
+  graphene_size_t scale;
+  GdkColorState *color_state;
+
+  GskRenderNode *node;
+  guint n_frames;
+
+  GskGpuImage *image;
+  graphene_rect_t bounds;
+};
+
+static void
+gsk_gpu_cached_node_finalize (GskGpuCached *cached)
+{
+  GskGpuCachedNode *self = (GskGpuCachedNode *) cached;
+  GskGpuCachePrivate *priv = gsk_gpu_cache_get_private (cached->cache);
+
+  g_hash_table_remove (priv->node_cache, self);
+
+  gsk_render_node_unref (self->node);
+  gdk_color_state_unref (self->color_state);
+  g_clear_object (&self->image);
+}
+
+static gboolean
+gsk_gpu_cached_node_should_collect (GskGpuCached *cached,
+                                    gint64        cache_timeout,
+                                    gint64        timestamp)
+{
+  return gsk_gpu_cached_is_old (cached, cache_timeout, timestamp);
+}
+
+static void
+gsk_gpu_cached_node_print_stats (GskGpuCache *cache,
+                                 GString     *string)
+{
+  GskGpuCachePrivate *priv = gsk_gpu_cache_get_private (cache);
+
+  g_string_append_printf (string, "%u nodes, ", g_hash_table_size (priv->node_cache));
+}
+
+static const GskGpuCachedClass GSK_GPU_CACHED_NODE_CLASS =
+{
+  sizeof (GskGpuCachedNode),
+  "Node",
+  FALSE,
+  gsk_gpu_cached_node_print_stats,
+  gsk_gpu_cached_node_finalize,
+  gsk_gpu_cached_node_should_collect
+};
+
+static guint
+gsk_gpu_cached_node_hash (gconstpointer data)
+{
+  const GskGpuCachedNode *self = data;
+
+  return g_direct_hash (self->boundary) ^
+         (((guint) (self->scale.width * 16)) << 16) ^
+         ((guint) (self->scale.height * 16) << 8) ^
+         g_direct_hash (self->color_state);
+}
+
+static gboolean
+gsk_gpu_cached_node_equal (gconstpointer data_a,
+                           gconstpointer data_b)
+{
+  const GskGpuCachedNode *a = data_a;
+  const GskGpuCachedNode *b = data_b;
+
+  return a->boundary == b->boundary &&
+         a->scale.width == b->scale.width &&
+         a->scale.height == b->scale.height &&
+         gdk_color_state_equal (a->color_state, b->color_state);
+}
+
+/*
+ * gsk_gpu_cache_lookup_node:
+ * @self: the cache
+ * @boundary: the boundary that @node is drawn for
+ * @node: the node to draw
+ * @scale: the scale to draw at
+ * @color_state: the color state to draw in
+ * @out_bounds: (out): the area the returned image covers
+ * @out_should_cache: (out): set to %TRUE if there is no image yet,
+ *   but one should be made with gsk_gpu_cache_cache_node()
+ *
+ * Looks up the rendering of @node and records that @node was
+ * drawn for @boundary in the current frame.
+ *
+ * Returns: (nullable) (transfer full): the image
+ */
+GskGpuImage *
+gsk_gpu_cache_lookup_node (GskGpuCache           *self,
+                           gconstpointer          boundary,
+                           GskRenderNode         *node,
+                           const graphene_size_t *scale,
+                           GdkColorState         *color_state,
+                           graphene_rect_t       *out_bounds,
+                           gboolean              *out_should_cache)
+{
+  GskGpuCachePrivate *priv = gsk_gpu_cache_get_private (self);
+  GskGpuCachedNode *cached;
+  gint64 last_used;
+
+  *out_should_cache = FALSE;
+
+  cached = g_hash_table_lookup (priv->node_cache,
+                                &(GskGpuCachedNode) {
+                                  .boundary = boundary,
+                                  .scale = *scale,
+                                  .color_state = color_state,
+                                });
+  if (cached == NULL)
+    {
+      cached = gsk_gpu_cached_new (self, &GSK_GPU_CACHED_NODE_CLASS);
+      cached->boundary = boundary;
+      cached->scale = *scale;
+      cached->color_state = gdk_color_state_ref (color_state);
+      cached->node = gsk_render_node_ref (node);
+      cached->n_frames = 1;
+
+      g_hash_table_add (priv->node_cache, cached);
+      gsk_gpu_cached_use ((GskGpuCached *) cached);
+
+      return NULL;
+    }
+
+  last_used = ((GskGpuCached *) cached)->timestamp;
+  gsk_gpu_cached_use ((GskGpuCached *) cached);
+
+  if (cached->node != node)
+    {
+      gsk_render_node_unref (cached->node);
+      cached->node = gsk_render_node_ref (node);
+      cached->n_frames = 1;
+      g_clear_object (&cached->image);
+      ((GskGpuCached *) cached)->pixels = 0;
+
+      return NULL;
+    }
+
+  if (cached->image)
+    {
+      *out_bounds = cached->bounds;
+      return g_object_ref (cached->image);
+    }
+
+  /* Count every frame only once */
+  if (((GskGpuCached *) cached)->timestamp != last_used)
+    cached->n_frames++;
+
+  *out_should_cache = cached->n_frames >= MIN_FRAMES;
+
+  return NULL;
+}
+
+/*
+ * gsk_gpu_cache_cache_node:
+ * @self: the cache
+ * @boundary: the boundary that @node is drawn for
+ * @node: the node that was drawn
+ * @scale: the scale it was drawn at
+ * @color_state: the color state it was drawn in
+ * @image: the rendering of @node
+ * @bounds: the area @image covers
+ *
+ * Keeps @image as the rendering of @node after
+ * gsk_gpu_cache_lookup_node() asked for it.
+ */
+void
+gsk_gpu_cache_cache_node (GskGpuCache           *self,
+                          gconstpointer          boundary,
+                          GskRenderNode         *node,
+                          const graphene_size_t *scale,
+                          GdkColorState         *color_state,
+                          GskGpuImage           *image,
+                          const graphene_rect_t *bounds)
+{
+  GskGpuCachePrivate *priv = gsk_gpu_cache_get_private (self);
+  GskGpuCachedNode *cached;
+
+  cached = g_hash_table_lookup (priv->node_cache,
+                                &(GskGpuCachedNode) {
+                                  .boundary = boundary,
+                                  .scale = *scale,
+                                  .color_state = color_state,
+                                });
+  g_return_if_fail (cached != NULL && cached->node == node);
+
+  g_set_object (&cached->image, image);
+  cached->bounds = *bounds;
+  ((GskGpuCached *) cached)->pixels = gsk_gpu_image_get_width (image) * gsk_gpu_image_get_height (image);
+}
+
+void
+gsk_gpu_cached_node_init_cache (GskGpuCache *cache)
+{
+  GskGpuCachePrivate *priv = gsk_gpu_cache_get_private (cache);
+
+  priv->node_cache = g_hash_table_new (gsk_gpu_cached_node_hash,
+                                       gsk_gpu_cached_node_equal);
+}
+
+void
+gsk_gpu_cached_node_finish_cache (GskGpuCache *cache)
+{
+  GskGpuCachePrivate *priv = gsk_gpu_cache_get_private (cache);
+
+  g_hash_table_unref (priv->node_cache);
+}
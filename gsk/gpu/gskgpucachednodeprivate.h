@@ -0,0 +1,27 @@
+#pragma once
+
+#include "gskgpucachedprivate.h"
+
+#include <graphene.h>
+
+G_BEGIN_DECLS
+
+void                    gsk_gpu_cached_node_init_cache                  (GskGpuCache            *cache);
+void                    gsk_gpu_cached_node_finish_cache                (GskGpuCache            *cache);
+
+GskGpuImage *           gsk_gpu_cache_lookup_node                       (GskGpuCache            *self,
+                                                                         gconstpointer           boundary,
+                                                                         GskRenderNode          *node,
+                                                                         const graphene_size_t  *scale,
+                                                                         GdkColorState          *color_state,
+                                                                         graphene_rect_t        *out_bounds,
+                                                                         gboolean               *out_should_cache);
+void                    gsk_gpu_cache_cache_node                        (GskGpuCache            *self,
+                                                                         gconstpointer           boundary,
+                                                                         GskRenderNode          *node,
+                                                                         const graphene_size_t  *scale,
+                                                                         GdkColorState          *color_state,
+                                                                         GskGpuImage            *image,
+                                                                         const graphene_rect_t  *bounds);
+
+G_END_DECLS
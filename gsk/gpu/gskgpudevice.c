@@ -4,6 +4,7 @@
 
 #include "gskgpucacheprivate.h"
 #include "gskgpuglobalsopprivate.h"
+#include "gskgpuimageprivate.h"
 
 #include "gdk/gdkprofilerprivate.h"
 
@@ -11,6 +12,44 @@
 
 #define CACHE_TIMEOUT 15  /* seconds */
 
+/* Offscreens that are small enough get put into a pool, so that
+ * the next frame can render into them again instead of allocating
+ * a new image. The frames in flight still hold on to the offscreens
+ * they used, so the pool grows to the offscreens of a frame times
+ * the number of frames. It is trimmed every frame. */
+#define MIN_POOLED_OFFSCREENS 32
+#define MAX_POOLED_OFFSCREENS 256
+#define MAX_POOLED_OFFSCREEN_PIXELS (256 * 256)
+#define POOLED_OFFSCREEN_TIMEOUT G_TIME_SPAN_SECOND
+
+typedef struct _GskGpuPooledImage GskGpuPooledImage;
+
+struct _GskGpuPooledImage
+{
+  GskGpuImage *image;
+  GdkMemoryFormat format;
+  gboolean is_srgb;
+  gsize width;
+  gsize height;
+  gint64 last_used;
+};
+
+static void
+gsk_gpu_pooled_image_clear (gpointer data)
+{
+  GskGpuPooledImage *pooled = data;
+
+  g_object_unref (pooled->image);
+}
+
+#define GDK_ARRAY_NAME gsk_gpu_image_pool
+#define GDK_ARRAY_TYPE_NAME GskGpuImagePool
+#define GDK_ARRAY_ELEMENT_TYPE GskGpuPooledImage
+#define GDK_ARRAY_FREE_FUNC gsk_gpu_pooled_image_clear
+#define GDK_ARRAY_BY_VALUE 1
+#define GDK_ARRAY_NO_MEMSET 1
+#include "gdk/gdkarrayimpl.c"
+
 typedef struct _GskGpuDevicePrivate GskGpuDevicePrivate;
 
 struct _GskGpuDevicePrivate
@@ -23,10 +62,21 @@ struct _GskGpuDevicePrivate
   GskGpuCache *cache; /* we don't own a ref, but manage the cache */
   guint cache_gc_source;
   int cache_timeout;  /* in seconds, or -1 to disable gc */
+
+  GskGpuImagePool offscreen_pool;
+  gsize max_pooled_offscreens;
+  gsize n_frame_offscreens;  /* requested from the pool since the last frame */
+  gsize n_frame_hits;
+  gint64 timestamp;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (GskGpuDevice, gsk_gpu_device, G_TYPE_OBJECT)
 
+static guint profiler_pool_hits_id;
+static guint profiler_pool_misses_id;
+static gint64 profiler_pool_hits;
+static gint64 profiler_pool_misses;
+
 /* Returns TRUE if everything was GC'ed */
 static gboolean
 gsk_gpu_device_gc (GskGpuDevice *self,
@@ -76,6 +126,31 @@ cache_gc_cb (gpointer data)
   return result;
 }
 
+static void
+gsk_gpu_device_trim_offscreen_pool (GskGpuDevice *self,
+                                    gint64        timestamp)
+{
+  GskGpuDevicePrivate *priv = gsk_gpu_device_get_instance_private (self);
+  gsize i;
+  gboolean made_current = FALSE;
+
+  for (i = gsk_gpu_image_pool_get_size (&priv->offscreen_pool); i-- > 0; )
+    {
+      GskGpuPooledImage *pooled = gsk_gpu_image_pool_index (&priv->offscreen_pool, i);
+
+      if (timestamp - pooled->last_used < POOLED_OFFSCREEN_TIMEOUT)
+        continue;
+
+      if (!made_current)
+        {
+          gsk_gpu_device_make_current (self);
+          made_current = TRUE;
+        }
+
+      gsk_gpu_image_pool_splice (&priv->offscreen_pool, i, 1, FALSE, NULL, 0);
+    }
+}
+
 void
 gsk_gpu_device_maybe_gc (GskGpuDevice *self,
                          gint64        timestamp)
@@ -83,6 +158,19 @@ gsk_gpu_device_maybe_gc (GskGpuDevice *self,
   GskGpuDevicePrivate *priv = gsk_gpu_device_get_instance_private (self);
   gsize dead_texture_pixels, dead_textures;
 
+  if (priv->n_frame_offscreens > 0)
+    GSK_DEBUG (CACHE, "Offscreen pool: reused %" G_GSIZE_FORMAT " of %" G_GSIZE_FORMAT " offscreens, %" G_GSIZE_FORMAT " pooled",
+               priv->n_frame_hits, priv->n_frame_offscreens,
+               gsk_gpu_image_pool_get_size (&priv->offscreen_pool));
+
+  priv->timestamp = timestamp;
+  priv->max_pooled_offscreens = CLAMP (priv->n_frame_offscreens * GSK_GPU_MAX_FRAMES,
+                                       priv->max_pooled_offscreens,
+                                       MAX_POOLED_OFFSCREENS);
+  priv->n_frame_offscreens = 0;
+  priv->n_frame_hits = 0;
+  gsk_gpu_device_trim_offscreen_pool (self, timestamp);
+
   if (priv->cache_timeout < 0)
     return;
 
@@ -118,6 +206,12 @@ gsk_gpu_device_dispose (GObject *object)
 
   g_clear_handle_id (&priv->cache_gc_source, g_source_remove);
 
+  if (gsk_gpu_image_pool_get_size (&priv->offscreen_pool) > 0)
+    {
+      gsk_gpu_device_make_current (self);
+      gsk_gpu_image_pool_clear (&priv->offscreen_pool);
+    }
+
   G_OBJECT_CLASS (gsk_gpu_device_parent_class)->dispose (object);
 }
 
@@ -127,6 +221,7 @@ gsk_gpu_device_finalize (GObject *object)
   GskGpuDevice *self = GSK_GPU_DEVICE (object);
   GskGpuDevicePrivate *priv = gsk_gpu_device_get_instance_private (self);
 
+  gsk_gpu_image_pool_clear (&priv->offscreen_pool);
   g_object_unref (priv->display);
 
   G_OBJECT_CLASS (gsk_gpu_device_parent_class)->finalize (object);
@@ -139,11 +234,18 @@ gsk_gpu_device_class_init (GskGpuDeviceClass *klass)
 
   object_class->dispose = gsk_gpu_device_dispose;
   object_class->finalize = gsk_gpu_device_finalize;
+
+  profiler_pool_hits_id = gdk_profiler_define_int_counter ("offscreen-pool-hits", "Offscreens reused from the pool");
+  profiler_pool_misses_id = gdk_profiler_define_int_counter ("offscreen-pool-misses", "Offscreens the pool had to allocate");
 }
 
 static void
 gsk_gpu_device_init (GskGpuDevice *self)
 {
+  GskGpuDevicePrivate *priv = gsk_gpu_device_get_instance_private (self);
+
+  gsk_gpu_image_pool_init (&priv->offscreen_pool);
+  priv->max_pooled_offscreens = MIN_POOLED_OFFSCREENS;
 }
 
 static inline gsize
@@ -309,6 +411,100 @@ gsk_gpu_device_create_offscreen_image (GskGpuDevice    *self,
   return GSK_GPU_DEVICE_GET_CLASS (self)->create_offscreen_image (self, with_mipmap, format, is_srgb, width, height);
 }
 
+/*<private>
+ * gsk_gpu_device_acquire_offscreen_image:
+ * @self: a `GskGpuDevice`
+ * @format: The format of the image
+ * @is_srgb: If the image should be in the sRGB colorstate
+ * @width: The width of the image
+ * @height: The height of the image
+ *
+ * Like gsk_gpu_device_create_offscreen_image(), but for transient
+ * offscreens without mipmaps.
+ *
+ * Small images are taken from a pool of images that were used in
+ * previous frames and are not referenced by anything anymore. When
+ * the pool is full, the least recently used image is dropped from it,
+ * even if a frame still uses it. The contents of the returned image
+ * are undefined.
+ *
+ * Returns: (nullable): The image or `NULL` on error.
+ **/
+GskGpuImage *
+gsk_gpu_device_acquire_offscreen_image (GskGpuDevice    *self,
+                                        GdkMemoryFormat  format,
+                                        gboolean         is_srgb,
+                                        gsize            width,
+                                        gsize            height)
+{
+  GskGpuDevicePrivate *priv = gsk_gpu_device_get_instance_private (self);
+  GskGpuPooledImage entry, *pooled, *oldest;
+  GskGpuImage *image;
+  gsize i;
+
+  if (width * height > MAX_POOLED_OFFSCREEN_PIXELS)
+    return gsk_gpu_device_create_offscreen_image (self, FALSE, format, is_srgb, width, height);
+
+  priv->n_frame_offscreens++;
+  oldest = NULL;
+
+  for (i = 0; i < gsk_gpu_image_pool_get_size (&priv->offscreen_pool); i++)
+    {
+      pooled = gsk_gpu_image_pool_index (&priv->offscreen_pool, i);
+
+      if (oldest == NULL || pooled->last_used < oldest->last_used)
+        oldest = pooled;
+
+      if (pooled->format != format ||
+          pooled->is_srgb != is_srgb ||
+          pooled->width != width ||
+          pooled->height != height)
+        continue;
+
+      /* still in use by a frame or a cache */
+      if (G_OBJECT (pooled->image)->ref_count != 1 ||
+          (gsk_gpu_image_get_flags (pooled->image) & GSK_GPU_IMAGE_TOGGLE_REF))
+        continue;
+
+      pooled->last_used = priv->timestamp;
+
+      priv->n_frame_hits++;
+      profiler_pool_hits++;
+      gdk_profiler_set_int_counter (profiler_pool_hits_id, profiler_pool_hits);
+
+      return g_object_ref (pooled->image);
+    }
+
+  profiler_pool_misses++;
+  gdk_profiler_set_int_counter (profiler_pool_misses_id, profiler_pool_misses);
+
+  image = gsk_gpu_device_create_offscreen_image (self, FALSE, format, is_srgb, width, height);
+  if (image == NULL)
+    return NULL;
+
+  entry = (GskGpuPooledImage) {
+    .image = g_object_ref (image),
+    .format = format,
+    .is_srgb = is_srgb,
+    .width = width,
+    .height = height,
+    .last_used = priv->timestamp,
+  };
+
+  if (gsk_gpu_image_pool_get_size (&priv->offscreen_pool) < priv->max_pooled_offscreens)
+    {
+      gsk_gpu_image_pool_append (&priv->offscreen_pool, &entry);
+    }
+  else
+    {
+      /* Whoever still uses the image keeps their reference */
+      gsk_gpu_pooled_image_clear (oldest);
+      *oldest = entry;
+    }
+
+  return image;
+}
+
 GskGpuImage *
 gsk_gpu_device_create_atlas_image (GskGpuDevice *self,
                                    gsize         width,
@@ -69,6 +69,11 @@ GskGpuImage *           gsk_gpu_device_create_offscreen_image           (GskGpuD
                                                                          gboolean                is_srgb,
                                                                          gsize                   width,
                                                                          gsize                   height);
+GskGpuImage *           gsk_gpu_device_acquire_offscreen_image          (GskGpuDevice           *self,
+                                                                         GdkMemoryFormat         format,
+                                                                         gboolean                is_srgb,
+                                                                         gsize                   width,
+                                                                         gsize                   height);
 GskGpuImage *           gsk_gpu_device_create_atlas_image               (GskGpuDevice           *self,
                                                                          gsize                   width,
                                                                          gsize                   height);
@@ -14,15 +14,28 @@
 #include "gskgpuuploadopprivate.h"
 #include "gskgpuutilsprivate.h"
 
+#include "gskbordernodeprivate.h"
+#include "gskclipnode.h"
+#include "gskcolornodeprivate.h"
 #include "gskcopypasteutilsprivate.h"
 #include "gskdebugprivate.h"
+#include "gskopacitynode.h"
+#include "gskrectprivate.h"
 #include "gskrendererprivate.h"
+#include "gskrendernodeprivate.h"
+#include "gskroundedclipnode.h"
+#include "gskroundedrectprivate.h"
+#include "gsktextnodeprivate.h"
+#include "gsktexturenode.h"
+#include "gsktransformnode.h"
 
 #include "gdk/gdkdmabufdownloaderprivate.h"
 #include "gdk/gdkdmabuftextureprivate.h"
 #include "gdk/gdkdrawcontextprivate.h"
 #include "gdk/gdktexturedownloaderprivate.h"
 
+#include <string.h>
+
 #define DEFAULT_VERTEX_BUFFER_SIZE 128 * 1024
 
 /* GL_MAX_UNIFORM_BLOCK_SIZE is at 16384 */
@@ -73,6 +86,9 @@ struct _GskGpuFramePrivate
   gsize storage_buffer_used;
 
   GskNodeStack node_stack;
+
+  /* HashTable<GskGpuInstance>; subtrees drawn in this frame */
+  GHashTable *instances;
 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (GskGpuFrame, gsk_gpu_frame, G_TYPE_OBJECT)
@@ -200,6 +216,297 @@ gsk_gpu_frame_default_get_profile (GskGpuFrame *self)
   return NULL;
 }
 
+/* How many nodes of a subtree are looked at when matching instances.
+ * Bigger subtrees only match if they are the same nodes.
+ */
+#define MAX_INSTANCE_NODES 64
+/* How many different subtrees with the same hash are compared
+ * against before giving up on instancing the new one
+ */
+#define MAX_INSTANCE_COMPARES 4
+
+static guint
+gsk_gpu_instance_hash_float (guint hash,
+                             float value)
+{
+  guint32 bits;
+
+  /* Make 0 and -0 hash the same */
+  value += 0.0f;
+  memcpy (&bits, &value, sizeof (bits));
+
+  return hash * 31 + bits;
+}
+
+static guint
+gsk_gpu_instance_hash_rect (guint                  hash,
+                            const graphene_rect_t *rect)
+{
+  hash = gsk_gpu_instance_hash_float (hash, rect->origin.x);
+  hash = gsk_gpu_instance_hash_float (hash, rect->origin.y);
+  hash = gsk_gpu_instance_hash_float (hash, rect->size.width);
+  hash = gsk_gpu_instance_hash_float (hash, rect->size.height);
+
+  return hash;
+}
+
+static guint
+gsk_gpu_instance_hash_color (guint           hash,
+                             const GdkColor *color)
+{
+  gsize i;
+
+  for (i = 0; i < 4; i++)
+    hash = gsk_gpu_instance_hash_float (hash, color->values[i]);
+
+  return hash;
+}
+
+/* Hashes what the first MAX_INSTANCE_NODES nodes of the subtree
+ * draw, so that rows with the same layout but different content
+ * don't end up with the same hash.
+ */
+static guint
+gsk_gpu_instance_hash_node (guint          hash,
+                            GskRenderNode *node,
+                            guint         *budget)
+{
+  GskRenderNode **children;
+  gsize i, n_children;
+
+  if (*budget == 0)
+    return hash;
+  (*budget)--;
+
+  hash = hash * 31 + gsk_render_node_get_node_type (node);
+  hash = gsk_gpu_instance_hash_rect (hash, &node->bounds);
+
+  switch (gsk_render_node_get_node_type (node))
+    {
+    case GSK_COLOR_NODE:
+      hash = gsk_gpu_instance_hash_color (hash, gsk_color_node_get_gdk_color (node));
+      break;
+
+    case GSK_TEXTURE_NODE:
+      hash = hash * 31 + g_direct_hash (gsk_texture_node_get_texture (node));
+      break;
+
+    case GSK_TEXT_NODE:
+      {
+        const PangoGlyphInfo *glyphs;
+        guint n_glyphs;
+
+        hash = hash * 31 + g_direct_hash (gsk_text_node_get_font (node));
+        hash = gsk_gpu_instance_hash_color (hash, gsk_text_node_get_gdk_color (node));
+        glyphs = gsk_text_node_get_glyphs (node, &n_glyphs);
+        hash = hash * 31 + n_glyphs;
+        for (i = 0; i < n_glyphs; i++)
+          hash = hash * 31 + glyphs[i].glyph;
+      }
+      break;
+
+    case GSK_BORDER_NODE:
+      {
+        const GdkColor *colors = gsk_border_node_get_gdk_colors (node);
+
+        for (i = 0; i < 4; i++)
+          hash = gsk_gpu_instance_hash_color (hash, &colors[i]);
+      }
+      break;
+
+    case GSK_OPACITY_NODE:
+      hash = gsk_gpu_instance_hash_float (hash, gsk_opacity_node_get_opacity (node));
+      break;
+
+    default:
+      break;
+    }
+
+  children = gsk_render_node_get_children (node, &n_children);
+  hash = hash * 31 + n_children;
+  for (i = 0; i < n_children; i++)
+    hash = gsk_gpu_instance_hash_node (hash, children[i], budget);
+
+  return hash;
+}
+
+/* Compares what two subtrees draw, without allocating anything.
+ *
+ * Only the node types that make up typical list rows are compared,
+ * any other node only matches itself. That is never wrong, it just
+ * means the subtree is drawn directly.
+ */
+static gboolean
+gsk_gpu_instance_node_equal (GskRenderNode *node1,
+                             GskRenderNode *node2,
+                             guint         *budget)
+{
+  GskRenderNode **children1, **children2;
+  gsize i, n_children1, n_children2;
+
+  if (node1 == node2)
+    return TRUE;
+
+  if (*budget == 0)
+    return FALSE;
+  (*budget)--;
+
+  if (gsk_render_node_get_node_type (node1) != gsk_render_node_get_node_type (node2) ||
+      !gsk_rect_equal (&node1->bounds, &node2->bounds))
+    return FALSE;
+
+  switch (gsk_render_node_get_node_type (node1))
+    {
+    case GSK_CONTAINER_NODE:
+    case GSK_DEBUG_NODE:
+      break;
+
+    case GSK_TRANSFORM_NODE:
+      if (!gsk_transform_equal (gsk_transform_node_get_transform (node1),
+                                gsk_transform_node_get_transform (node2)))
+        return FALSE;
+      break;
+
+    case GSK_OPACITY_NODE:
+      if (gsk_opacity_node_get_opacity (node1) != gsk_opacity_node_get_opacity (node2))
+        return FALSE;
+      break;
+
+    case GSK_CLIP_NODE:
+      if (!gsk_rect_equal (gsk_clip_node_get_clip (node1), gsk_clip_node_get_clip (node2)) ||
+          gsk_clip_node_get_snap (node1) != gsk_clip_node_get_snap (node2))
+        return FALSE;
+      break;
+
+    case GSK_ROUNDED_CLIP_NODE:
+      if (!gsk_rounded_rect_equal (gsk_rounded_clip_node_get_clip (node1),
+                                   gsk_rounded_clip_node_get_clip (node2)) ||
+          gsk_rounded_clip_node_get_snap (node1) != gsk_rounded_clip_node_get_snap (node2))
+        return FALSE;
+      break;
+
+    case GSK_COLOR_NODE:
+      return gdk_color_equal (gsk_color_node_get_gdk_color (node1), gsk_color_node_get_gdk_color (node2)) &&
+             gsk_color_node_get_snap (node1) == gsk_color_node_get_snap (node2);
+
+    case GSK_TEXTURE_NODE:
+      return gsk_texture_node_get_texture (node1) == gsk_texture_node_get_texture (node2) &&
+             gsk_texture_node_get_snap (node1) == gsk_texture_node_get_snap (node2);
+
+    case GSK_TEXT_NODE:
+      {
+        const PangoGlyphInfo *glyphs1, *glyphs2;
+        guint n_glyphs1, n_glyphs2;
+
+        glyphs1 = gsk_text_node_get_glyphs (node1, &n_glyphs1);
+        glyphs2 = gsk_text_node_get_glyphs (node2, &n_glyphs2);
+
+        return gsk_text_node_get_font (node1) == gsk_text_node_get_font (node2) &&
+               gsk_text_node_get_font_hint_style (node1) == gsk_text_node_get_font_hint_style (node2) &&
+               gdk_color_equal (gsk_text_node_get_gdk_color (node1), gsk_text_node_get_gdk_color (node2)) &&
+               graphene_point_equal (gsk_text_node_get_offset (node1), gsk_text_node_get_offset (node2)) &&
+               n_glyphs1 == n_glyphs2 &&
+               memcmp (glyphs1, glyphs2, n_glyphs1 * sizeof (PangoGlyphInfo)) == 0;
+      }
+
+    case GSK_BORDER_NODE:
+      {
+        const GdkColor *colors1 = gsk_border_node_get_gdk_colors (node1);
+        const GdkColor *colors2 = gsk_border_node_get_gdk_colors (node2);
+
+        for (i = 0; i < 4; i++)
+          {
+            if (!gdk_color_equal (&colors1[i], &colors2[i]))
+              return FALSE;
+          }
+
+        return gsk_rounded_rect_equal (gsk_border_node_get_outline (node1), gsk_border_node_get_outline (node2)) &&
+               memcmp (gsk_border_node_get_widths (node1), gsk_border_node_get_widths (node2), 4 * sizeof (float)) == 0 &&
+               gsk_border_node_get_snap (node1) == gsk_border_node_get_snap (node2);
+      }
+
+    default:
+      return FALSE;
+    }
+
+  children1 = gsk_render_node_get_children (node1, &n_children1);
+  children2 = gsk_render_node_get_children (node2, &n_children2);
+  if (n_children1 != n_children2)
+    return FALSE;
+
+  for (i = 0; i < n_children1; i++)
+    {
+      if (!gsk_gpu_instance_node_equal (children1[i], children2[i], budget))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+gsk_gpu_instance_matches (const GskGpuInstance  *instance,
+                          GskRenderNode         *node,
+                          const graphene_size_t *scale,
+                          GdkColorState         *ccs)
+{
+  guint budget = MAX_INSTANCE_NODES;
+
+  return graphene_size_equal (&instance->scale, scale) &&
+         gdk_color_state_equal (instance->ccs, ccs) &&
+         gsk_gpu_instance_node_equal (instance->node, node, &budget);
+}
+
+static void
+gsk_gpu_instance_free (gpointer data)
+{
+  GskGpuInstance *instance = data;
+
+  while (instance)
+    {
+      GskGpuInstance *next = instance->next;
+
+      g_clear_object (&instance->image);
+      gdk_color_state_unref (instance->ccs);
+      gsk_render_node_unref (instance->node);
+      g_free (instance);
+
+      instance = next;
+    }
+}
+
+/* The offscreens are only used for one frame, so that they
+ * don't take up space in the cache.
+ */
+static void
+gsk_gpu_frame_clear_instances (GskGpuFrame *self)
+{
+  GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
+
+  if (GSK_DEBUG_CHECK (CACHE))
+    {
+      GHashTableIter iter;
+      gpointer instance;
+      guint n_offscreens = 0;
+
+      g_hash_table_iter_init (&iter, priv->instances);
+      while (g_hash_table_iter_next (&iter, NULL, &instance))
+        {
+          GskGpuInstance *i;
+
+          for (i = instance; i; i = i->next)
+            {
+              if (i->image)
+                n_offscreens++;
+            }
+        }
+
+      if (n_offscreens > 0)
+        GSK_DEBUG (CACHE, "Offscreens used for instanced subtrees: %u", n_offscreens);
+    }
+
+  g_hash_table_remove_all (priv->instances);
+}
+
 static void
 gsk_gpu_frame_dispose (GObject *object)
 {
@@ -218,6 +525,7 @@ gsk_gpu_frame_finalize (GObject *object)
 
   gsk_gpu_ops_clear (&priv->ops);
   gsk_node_stack_clear (&priv->node_stack);
+  g_hash_table_unref (priv->instances);
 
   g_clear_object (&priv->vertex_buffer);
   g_clear_object (&priv->globals_buffer);
@@ -255,6 +563,9 @@ gsk_gpu_frame_init (GskGpuFrame *self)
 
   gsk_gpu_ops_init (&priv->ops);
   gsk_node_stack_init (&priv->node_stack);
+  priv->instances = g_hash_table_new_full (NULL, NULL,
+                                           NULL,
+                                           gsk_gpu_instance_free);
 }
 
 void
@@ -818,6 +1129,8 @@ gsk_gpu_frame_record (GskGpuFrame            *self,
 
   gsk_gpu_frame_end_node (self);
 
+  gsk_gpu_frame_clear_instances (self);
+
   if (texture)
     gsk_gpu_download_op (self, target, target_color_state, texture);
 }
@@ -1024,6 +1337,64 @@ gsk_gpu_frame_end_node (GskGpuFrame *self)
   GSK_GPU_FRAME_GET_CLASS (self)->end_node (self);
 }
 
+/*
+ * gsk_gpu_frame_add_instance:
+ * @self: a frame
+ * @node: a node that is about to be drawn
+ * @scale: the scale it is drawn with
+ * @ccs: the color state it is drawn in
+ *
+ * Looks up the subtree drawn before in this frame that draws the
+ * same as @node and counts @node as one more instance of it, so
+ * that repeated subtrees can be drawn from a single rendering.
+ *
+ * Returns: (transfer none) (nullable): the instance of @node, valid
+ *   until the end of gsk_gpu_frame_record(), or %NULL if too many
+ *   different subtrees look like @node
+ */
+GskGpuInstance *
+gsk_gpu_frame_add_instance (GskGpuFrame           *self,
+                            GskRenderNode         *node,
+                            const graphene_size_t *scale,
+                            GdkColorState         *ccs)
+{
+  GskGpuFramePrivate *priv = gsk_gpu_frame_get_instance_private (self);
+  GskGpuInstance *first, *instance;
+  guint hash, budget, n_compares;
+
+  budget = MAX_INSTANCE_NODES;
+  hash = gsk_gpu_instance_hash_node (0, node, &budget);
+  hash = gsk_gpu_instance_hash_float (hash, scale->width);
+  hash = gsk_gpu_instance_hash_float (hash, scale->height);
+
+  first = g_hash_table_lookup (priv->instances, GUINT_TO_POINTER (hash));
+
+  n_compares = 0;
+  for (instance = first; instance; instance = instance->next)
+    {
+      if (gsk_gpu_instance_matches (instance, node, scale, ccs))
+        break;
+
+      if (++n_compares >= MAX_INSTANCE_COMPARES)
+        return NULL;
+    }
+
+  if (instance == NULL)
+    {
+      instance = g_new0 (GskGpuInstance, 1);
+      instance->node = gsk_render_node_ref (node);
+      instance->scale = *scale;
+      instance->ccs = gdk_color_state_ref (ccs);
+      instance->next = first;
+      g_hash_table_steal (priv->instances, GUINT_TO_POINTER (hash));
+      g_hash_table_insert (priv->instances, GUINT_TO_POINTER (hash), instance);
+    }
+
+  instance->n_instances++;
+
+  return instance;
+}
+
 GskDebugProfile *
 gsk_gpu_frame_get_profile (GskGpuFrame *self)
 {
@@ -15,12 +15,30 @@ G_BEGIN_DECLS
 #define GSK_GPU_FRAME_GET_CLASS(o) (G_TYPE_INSTANCE_GET_CLASS ((o), GSK_TYPE_GPU_FRAME, GskGpuFrameClass))
 
 typedef struct _GskGpuFrameClass GskGpuFrameClass;
+typedef struct _GskGpuInstance GskGpuInstance;
 
 struct _GskGpuFrame
 {
   GObject parent_instance;
 };
 
+/* Subtrees that draw the same, recorded while processing a frame */
+struct _GskGpuInstance
+{
+  /* the first instance */
+  GskRenderNode *node;
+  graphene_size_t scale;
+  GdkColorState *ccs;
+  /* the next subtree with the same hash */
+  GskGpuInstance *next;
+
+  /* how often it was drawn, including the current instance */
+  guint n_instances;
+  /* an offscreen of it, set by the node processor */
+  GskGpuImage *image;
+  graphene_rect_t bounds;
+};
+
 struct _GskGpuFrameClass
 {
   GObjectClass parent_class;
@@ -134,6 +152,10 @@ void                    gsk_gpu_frame_start_node                        (GskGpuF
                                                                          GskRenderNode          *node,
                                                                          gsize                   pos);
 void                    gsk_gpu_frame_end_node                          (GskGpuFrame            *self);
+GskGpuInstance *        gsk_gpu_frame_add_instance                      (GskGpuFrame            *self,
+                                                                         GskRenderNode          *node,
+                                                                         const graphene_size_t  *scale,
+                                                                         GdkColorState          *ccs);
 GskDebugProfile *       gsk_gpu_frame_get_profile                       (GskGpuFrame            *self);
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GskGpuFrame, g_object_unref)
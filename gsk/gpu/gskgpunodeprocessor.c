@@ -12,6 +12,7 @@
 #include "gskgpucacheprivate.h"
 #include "gskgpucachedglyphprivate.h"
 #include "gskgpucachedfillprivate.h"
+#include "gskgpucachednodeprivate.h"
 #include "gskgpucachedstrokeprivate.h"
 #include "gskgpucachedtileprivate.h"
 #include "gskgpuclearopprivate.h"
@@ -58,7 +59,7 @@
 #include "gskcontainernodeprivate.h"
 #include "gskcrossfadenode.h"
 #include "gskdebugprivate.h"
-#include "gskdebugnode.h"
+#include "gskdebugnodeprivate.h"
 #include "gskdisplacementnodeprivate.h"
 #include "gskfillnode.h"
 #include "gskinsetshadownodeprivate.h"
@@ -169,6 +170,8 @@ typedef enum {
 
 static void             gsk_gpu_node_processor_add_node_untracked       (GskGpuRenderPass            *self,
                                                                          GskRenderNode                  *node);
+static gboolean         gsk_gpu_node_processor_add_instanced_node       (GskGpuRenderPass            *self,
+                                                                         GskRenderNode                  *node);
 static GskGpuImage *    gsk_gpu_get_node_as_image                       (GskGpuFrame                    *frame,
                                                                          GskGpuAsImageFlags              flags,
                                                                          GdkColorState                  *ccs,
@@ -188,12 +191,19 @@ create_offscreen_image (GskGpuFrame     *frame,
   GskGpuImage *result;
   GskDebugProfile *profile;
 
-  result = gsk_gpu_device_create_offscreen_image (gsk_gpu_frame_get_device (frame),
-                                                  with_mipmap,
-                                                  format,
-                                                  is_srgb,
-                                                  width,
-                                                  height);
+  if (!with_mipmap && gsk_gpu_frame_should_optimize (frame, GSK_GPU_OPTIMIZE_POOL))
+    result = gsk_gpu_device_acquire_offscreen_image (gsk_gpu_frame_get_device (frame),
+                                                     format,
+                                                     is_srgb,
+                                                     width,
+                                                     height);
+  else
+    result = gsk_gpu_device_create_offscreen_image (gsk_gpu_frame_get_device (frame),
+                                                    with_mipmap,
+                                                    format,
+                                                    is_srgb,
+                                                    width,
+                                                    height);
   if (result == NULL)
     return NULL;
 
@@ -871,7 +881,8 @@ gsk_gpu_node_processor_add_transform_node (GskGpuRenderPass *self,
 
         gsk_transform_to_translate (transform, &dx, &dy);
         gsk_gpu_render_pass_push_translate (self, &GRAPHENE_POINT_INIT (dx, dy), &storage);
-        gsk_gpu_node_processor_add_node (self, child, 0);
+        if (!gsk_gpu_node_processor_add_instanced_node (self, child))
+          gsk_gpu_node_processor_add_node (self, child, 0);
         gsk_gpu_render_pass_pop_translate (self, &storage);
       }
       break;
@@ -1195,15 +1206,31 @@ gsk_gpu_node_processor_draw_texture_tiles (GskGpuRenderPass    *self,
 
           if (tile == NULL)
             {
-              if (memtex == NULL)
-                memtex = gdk_memory_texture_from_texture (texture);
-              subtex = gdk_memory_texture_new_subtexture (memtex,
-                                                          x * tile_size,
-                                                          y * tile_size,
-                                                          MIN (tile_size, width - x * tile_size),
-                                                          MIN (tile_size, height - y * tile_size));
-              tile = gsk_gpu_upload_texture_op_try (self->frame, need_mipmap, lod_level, scaling_filter, subtex);
-              g_object_unref (subtex);
+              cairo_rectangle_int_t area = { x * tile_size,
+                                             y * tile_size,
+                                             MIN (tile_size, width - x * tile_size),
+                                             MIN (tile_size, height - y * tile_size) };
+
+              if (gdk_texture_has_tiles (texture))
+                {
+                  /* Only load the visible tiles, and load them already reduced */
+                  subtex = gdk_texture_get_tile (texture, lod_level, &area);
+                  if (subtex)
+                    {
+                      tile = gsk_gpu_upload_texture_op_try (self->frame, need_mipmap, 0, scaling_filter, subtex);
+                      g_object_unref (subtex);
+                    }
+                  else
+                    tile = NULL;
+                }
+              else
+                {
+                  if (memtex == NULL)
+                    memtex = gdk_memory_texture_from_texture (texture);
+                  subtex = gdk_memory_texture_new_subtexture (memtex, area.x, area.y, area.width, area.height);
+                  tile = gsk_gpu_upload_texture_op_try (self->frame, need_mipmap, lod_level, scaling_filter, subtex);
+                  g_object_unref (subtex);
+                }
               if (tile == NULL)
                 {
                   g_warning ("failed to create %zux%zu tile for %zux%zu texture. Out of memory?",
@@ -3588,6 +3615,203 @@ gsk_gpu_node_processor_add_isolation_node (GskGpuRenderPass *self,
   gsk_gpu_node_processor_add_node (self, child, 0);
 }
 
+#define GDK_ARRAY_NAME gsk_visible_rects
+#define GDK_ARRAY_TYPE_NAME GskVisibleRects
+#define GDK_ARRAY_ELEMENT_TYPE graphene_rect_t
+#define GDK_ARRAY_BY_VALUE 1
+#define GDK_ARRAY_PREALLOC 16
+#include "gdk/gdkarrayimpl.c"
+
+/* Only clip partially covered nodes if that saves at least this
+ * fraction of their visible area, to not add clips for slivers
+ */
+#define MIN_FRACTION_FOR_OCCLUSION_CLIP 0.5
+
+/*
+ * rect_subtract_exact:
+ * @rect: the rectangle to subtract from
+ * @covered: the rectangle to subtract
+ * @result: the remaining part of @rect
+ *
+ * Unlike gsk_rect_subtract(), this only succeeds if the remaining
+ * part of @rect is itself a rectangle, so that nothing visible is
+ * lost by only drawing that part.
+ *
+ * Returns: %TRUE if @result was set
+ */
+static gboolean
+rect_subtract_exact (const graphene_rect_t *rect,
+                     const graphene_rect_t *covered,
+                     graphene_rect_t       *result)
+{
+  graphene_rect_t i;
+
+  if (!gsk_rect_intersection (rect, covered, &i))
+    return FALSE;
+
+  if (i.origin.x <= rect->origin.x &&
+      i.origin.x + i.size.width >= rect->origin.x + rect->size.width)
+    {
+      if (i.origin.y <= rect->origin.y)
+        {
+          *result = GRAPHENE_RECT_INIT (rect->origin.x,
+                                        i.origin.y + i.size.height,
+                                        rect->size.width,
+                                        rect->origin.y + rect->size.height - (i.origin.y + i.size.height));
+          return TRUE;
+        }
+      else if (i.origin.y + i.size.height >= rect->origin.y + rect->size.height)
+        {
+          *result = GRAPHENE_RECT_INIT (rect->origin.x,
+                                        rect->origin.y,
+                                        rect->size.width,
+                                        i.origin.y - rect->origin.y);
+          return TRUE;
+        }
+    }
+  else if (i.origin.y <= rect->origin.y &&
+           i.origin.y + i.size.height >= rect->origin.y + rect->size.height)
+    {
+      if (i.origin.x <= rect->origin.x)
+        {
+          *result = GRAPHENE_RECT_INIT (i.origin.x + i.size.width,
+                                        rect->origin.y,
+                                        rect->origin.x + rect->size.width - (i.origin.x + i.size.width),
+                                        rect->size.height);
+          return TRUE;
+        }
+      else if (i.origin.x + i.size.width >= rect->origin.x + rect->size.width)
+        {
+          *result = GRAPHENE_RECT_INIT (rect->origin.x,
+                                        rect->origin.y,
+                                        i.origin.x - rect->origin.x,
+                                        rect->size.height);
+          return TRUE;
+        }
+    }
+
+  return FALSE;
+}
+
+/*
+ * gsk_gpu_node_processor_add_children_culled:
+ * @self: the render pass
+ * @children: the children of a container, back to front
+ * @n_children: the number of children
+ * @pos: the position of the first child in the container
+ *
+ * Walks the children front to back to find out how much of each is
+ * hidden by the opaque parts of the ones drawn after it. Children that
+ * are fully hidden are skipped, and children where the visible part is
+ * a rectangle are clipped to it.
+ *
+ * Only the largest rectangle inside the union of the opaque areas is
+ * tracked, so some hidden children may still get drawn.
+ */
+static void
+gsk_gpu_node_processor_add_children_culled (GskGpuRenderPass  *self,
+                                            GskRenderNode    **children,
+                                            gsize              n_children,
+                                            gsize              pos)
+{
+  GskVisibleRects rects;
+  graphene_rect_t clip_bounds, covered, opaque;
+  graphene_rect_t *visible;
+  GskDebugProfile *profile;
+  float pixel_scale;
+  gsize i;
+
+  if (!gsk_gpu_render_pass_get_clip_bounds (self, &clip_bounds))
+    return;
+
+  gsk_visible_rects_init (&rects);
+  gsk_visible_rects_set_size (&rects, n_children);
+  visible = gsk_visible_rects_get_data (&rects);
+  covered = GRAPHENE_RECT_INIT (0, 0, 0, 0);
+  profile = gsk_gpu_frame_get_profile (self->frame);
+  pixel_scale = self->scale.width * self->scale.height;
+
+  for (i = n_children; i-- > 0; )
+    {
+      graphene_rect_t tmp;
+      cairo_rectangle_int_t device;
+      gboolean skipped = FALSE;
+
+      if (!gsk_rect_intersection (&children[i]->bounds, &clip_bounds, &visible[i]))
+        {
+          /* clipped away, no need to bother */
+          visible[i] = children[i]->bounds;
+          continue;
+        }
+
+      if (!gsk_rect_is_empty (&covered))
+        {
+          if (gsk_rect_contains_rect (&covered, &visible[i]))
+            {
+              skipped = TRUE;
+            }
+          else if (rect_subtract_exact (&visible[i], &covered, &tmp) &&
+                   tmp.size.width * tmp.size.height <= (1 - MIN_FRACTION_FOR_OCCLUSION_CLIP) * visible[i].size.width * visible[i].size.height &&
+                   gsk_gpu_render_pass_user_to_device_exact (self, &tmp, &device))
+            {
+              /* The clip must be pixel-aligned, or its antialiased edge
+               * would show through next to the covering node */
+              if (profile)
+                profile->self.culled_pixels += (visible[i].size.width * visible[i].size.height - tmp.size.width * tmp.size.height) * pixel_scale;
+              visible[i] = tmp;
+            }
+          else
+            {
+              /* draw everything that's not clipped */
+              visible[i] = children[i]->bounds;
+            }
+        }
+      else
+        visible[i] = children[i]->bounds;
+
+      if (skipped)
+        {
+          if (profile)
+            {
+              profile->self.n_culled++;
+              profile->self.culled_pixels += visible[i].size.width * visible[i].size.height * pixel_scale;
+            }
+          visible[i] = GRAPHENE_RECT_INIT (0, 0, 0, 0);
+          continue;
+        }
+
+      if (gsk_render_node_get_opaque_rect (children[i], &opaque) &&
+          gsk_rect_intersection (&opaque, &clip_bounds, &opaque))
+        {
+          if (gsk_rect_is_empty (&covered))
+            covered = opaque;
+          else
+            gsk_rect_coverage (&covered, &opaque, &covered);
+        }
+    }
+
+  for (i = 0; i < n_children; i++)
+    {
+      if (gsk_rect_is_empty (&visible[i]))
+        continue;
+
+      if (gsk_rect_contains_rect (&visible[i], &children[i]->bounds))
+        {
+          gsk_gpu_node_processor_add_node (self, children[i], pos + i);
+        }
+      else
+        {
+          GskGpuRenderPassClipStorage storage;
+
+          gsk_gpu_render_pass_push_clip_rect (self, &visible[i], &storage);
+          gsk_gpu_node_processor_add_node (self, children[i], pos + i);
+          gsk_gpu_render_pass_pop_clip_rect (self, &storage);
+        }
+    }
+
+  gsk_visible_rects_clear (&rects);
+}
+
 static void
 gsk_gpu_node_processor_add_container_node (GskGpuRenderPass *self,
                                            GskRenderNode       *node)
@@ -3619,14 +3843,205 @@ gsk_gpu_node_processor_add_container_node (GskGpuRenderPass *self,
   else
     i = 0;
 
+  if (n_children - i > 1 &&
+      !gsk_container_node_is_disjoint (node) &&
+      (self->blend == GSK_GPU_BLEND_OVER || self->blend == GSK_GPU_BLEND_NONE) &&
+      gsk_gpu_frame_should_optimize (self->frame, GSK_GPU_OPTIMIZE_OCCLUSION_CULLING))
+    {
+      gsk_gpu_node_processor_add_children_culled (self, children + i, n_children - i, i);
+      return;
+    }
+
   for (; i < n_children; i++)
     gsk_gpu_node_processor_add_node (self, children[i], i);
 }
 
+/* Offscreens of a node are snapped to the pixel grid without the
+ * offset, so they can only be drawn without resampling when there
+ * is no transform and the offset is aligned to the pixel grid.
+ */
+static gboolean
+gsk_gpu_node_processor_is_pixel_aligned (GskGpuRenderPass *self)
+{
+  float x, y;
+
+  if (self->modelview != NULL)
+    return FALSE;
+
+  x = self->offset.x * self->scale.width;
+  y = self->offset.y * self->scale.height;
+
+  return x == floorf (x) && y == floorf (y);
+}
+
+/* These depend on what is drawn around the node, so their
+ * rendering can't be reused.
+ */
+static gboolean
+gsk_gpu_node_processor_can_reuse_node (GskRenderNode *node)
+{
+  return !gsk_render_node_contains_subsurface_node (node) &&
+         !gsk_render_node_contains_paste_node (node) &&
+         gsk_render_node_get_copy_mode (node) == GSK_COPY_NONE;
+}
+
+/*
+ * gsk_gpu_node_processor_create_node_image:
+ * @self: the render pass
+ * @node: the node to render
+ * @out_bounds: the bounds of the result
+ *
+ * Draws @node into an offscreen that can be drawn at any offset
+ * for which gsk_gpu_node_processor_is_pixel_aligned() is true.
+ *
+ * Returns: (nullable): the offscreen
+ */
+static GskGpuImage *
+gsk_gpu_node_processor_create_node_image (GskGpuRenderPass *self,
+                                          GskRenderNode    *node,
+                                          graphene_rect_t  *out_bounds)
+{
+  gsize max_size;
+
+  /* Snap without the offset, so the image can be reused when the node moves */
+  if (!gsk_rect_snap_to_grid_grow (&node->bounds, &self->scale, graphene_point_zero (), out_bounds))
+    return NULL;
+
+  max_size = gsk_gpu_device_get_max_image_size (gsk_gpu_frame_get_device (self->frame));
+  if (out_bounds->size.width * self->scale.width > max_size ||
+      out_bounds->size.height * self->scale.height > max_size)
+    return NULL;
+
+  return gsk_gpu_node_processor_create_offscreen (self->frame,
+                                                  self->ccs,
+                                                  &self->scale,
+                                                  out_bounds,
+                                                  node);
+}
+
+/*
+ * gsk_gpu_node_processor_add_node_from_cache:
+ * @self: the render pass
+ * @boundary: the boundary that @key is drawn for
+ * @key: the node to cache the rendering for
+ * @child: the node to render
+ *
+ * Draws @child from an offscreen that is cached for @key, creating
+ * it once @key was drawn unchanged for a few frames.
+ *
+ * Returns: %FALSE if @child can't be drawn from a cached offscreen
+ */
+static gboolean
+gsk_gpu_node_processor_add_node_from_cache (GskGpuRenderPass *self,
+                                            gconstpointer     boundary,
+                                            GskRenderNode    *key,
+                                            GskRenderNode    *child)
+{
+  GskGpuCache *cache;
+  GskGpuImage *image;
+  graphene_rect_t bounds;
+  gboolean should_cache;
+
+  if (!gsk_gpu_node_processor_is_pixel_aligned (self) ||
+      !gsk_gpu_node_processor_can_reuse_node (child))
+    return FALSE;
+
+  cache = gsk_gpu_device_get_cache (gsk_gpu_frame_get_device (self->frame));
+
+  image = gsk_gpu_cache_lookup_node (cache, boundary, key, &self->scale, self->ccs, &bounds, &should_cache);
+  if (image == NULL)
+    {
+      if (!should_cache)
+        return FALSE;
+
+      image = gsk_gpu_node_processor_create_node_image (self, child, &bounds);
+      if (image == NULL)
+        return FALSE;
+
+      gsk_gpu_cache_cache_node (cache, boundary, key, &self->scale, self->ccs, image, &bounds);
+    }
+
+  gsk_gpu_node_processor_image_op (self,
+                                   image,
+                                   self->ccs,
+                                   GSK_GPU_SAMPLER_DEFAULT,
+                                   &bounds,
+                                   &bounds);
+
+  g_object_unref (image);
+
+  return TRUE;
+}
+
+/* Subtrees that are drawn multiple times in a frame, like identical
+ * items of a list or grid, are drawn into an offscreen once and that
+ * offscreen is drawn for the further instances. Every item has its
+ * own nodes, so instances are matched by what they draw.
+ *
+ * Drawing the offscreen costs about as much as drawing the subtree
+ * once more, so it is only used once a subtree was drawn directly
+ * this often.
+ */
+#define MIN_INSTANCES 3
+#define MIN_INSTANCE_CHILDREN 2
+
+static gboolean
+gsk_gpu_node_processor_add_instanced_node (GskGpuRenderPass *self,
+                                           GskRenderNode    *node)
+{
+  GskGpuInstance *instance;
+  gsize n_children;
+
+  if (!gsk_gpu_frame_should_optimize (self->frame, GSK_GPU_OPTIMIZE_INSTANCE))
+    return FALSE;
+
+  /* Drawing a single node again is as cheap as drawing an offscreen */
+  if (gsk_render_node_get_node_type (node) != GSK_CONTAINER_NODE)
+    return FALSE;
+
+  gsk_render_node_get_children (node, &n_children);
+  if (n_children < MIN_INSTANCE_CHILDREN)
+    return FALSE;
+
+  if (!gsk_gpu_node_processor_is_pixel_aligned (self) ||
+      !gsk_gpu_node_processor_can_reuse_node (node))
+    return FALSE;
+
+  instance = gsk_gpu_frame_add_instance (self->frame, node, &self->scale, self->ccs);
+  if (instance == NULL || instance->n_instances <= MIN_INSTANCES)
+    return FALSE;
+
+  if (instance->image == NULL)
+    {
+      instance->image = gsk_gpu_node_processor_create_node_image (self, node, &instance->bounds);
+      if (instance->image == NULL)
+        return FALSE;
+    }
+
+  gsk_gpu_frame_start_node (self->frame, node, 0);
+
+  gsk_gpu_node_processor_image_op (self,
+                                   instance->image,
+                                   self->ccs,
+                                   GSK_GPU_SAMPLER_DEFAULT,
+                                   &instance->bounds,
+                                   &instance->bounds);
+
+  gsk_gpu_frame_end_node (self->frame);
+
+  return TRUE;
+}
+
 static void
 gsk_gpu_node_processor_add_debug_node (GskGpuRenderPass *self,
                                        GskRenderNode       *node)
 {
+  gconstpointer boundary = gsk_debug_node_get_boundary (node);
+
+  if (boundary &&
+      gsk_gpu_node_processor_add_node_from_cache (self, boundary, node, gsk_debug_node_get_child (node)))
+    return;
+
   gsk_gpu_node_processor_add_node (self, gsk_debug_node_get_child (node), 0);
 }
 
@@ -22,8 +22,6 @@
 
 #include <graphene.h>
 
-#define GSK_GPU_MAX_FRAMES 4
-
 static const GdkDebugKey gsk_gpu_optimization_keys[] = {
   { "clear",     GSK_GPU_OPTIMIZE_CLEAR,             "Use shaders instead of vkCmdClearAttachment()/glClear()" },
   { "merge",     GSK_GPU_OPTIMIZE_MERGE,             "Use one vkCmdDraw()/glDrawArrays() per operation" },
@@ -35,6 +33,8 @@ static const GdkDebugKey gsk_gpu_optimization_keys[] = {
   { "repeat",    GSK_GPU_OPTIMIZE_REPEAT,            "Repeat drawing operations instead of using offscreen and GL_REPEAT" },
   { "damage",    GSK_GPU_OPTIMIZE_DAMAGE,            "Redraw the whole bounding box instead of doing fine grained damage tracking" },
   { "profile",   GSK_GPU_OPTIMIZE_PROFILE,           "Disable profiling support" },
+  { "instance",  GSK_GPU_OPTIMIZE_INSTANCE,          "Draw repeated subtrees every time instead of reusing a single rendering" },
+  { "pool",      GSK_GPU_OPTIMIZE_POOL,              "Allocate new offscreens every frame instead of reusing them" },
 };
 
 typedef struct _GskGpuRendererPrivate GskGpuRendererPrivate;
@@ -23,6 +23,9 @@ typedef struct _GskGpuShaderOp          GskGpuShaderOp;
 typedef struct _GskGpuShaderOpClass     GskGpuShaderOpClass;
 typedef struct _GskVulkanSemaphores     GskVulkanSemaphores;
 
+/* The number of frames a renderer can have in flight */
+#define GSK_GPU_MAX_FRAMES 4
+
 #define GSK_GPU_SHADER_OP_SHIFT 4
 #define GSK_GPU_SHADER_OP_MASK ((1 << GSK_GPU_SHADER_OP_SHIFT) - 1)
 
@@ -165,5 +168,7 @@ typedef enum {
   GSK_GPU_OPTIMIZE_DUAL_BLEND           = 1 <<  8,
   GSK_GPU_OPTIMIZE_DAMAGE               = 1 <<  9,
   GSK_GPU_OPTIMIZE_PROFILE              = 1 << 10,
+  GSK_GPU_OPTIMIZE_INSTANCE             = 1 << 11,
+  GSK_GPU_OPTIMIZE_POOL                 = 1 << 12,
 } GskGpuOptimizations;
 
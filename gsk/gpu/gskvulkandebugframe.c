@@ -190,6 +190,8 @@ gsk_vulkan_debug_frame_filter_node (GskRenderReplay *replay,
   entry->profile.total.upload_pixels = entry->profile.self.upload_pixels;
   entry->profile.total.n_bases = entry->profile.self.n_bases;
   entry->profile.total.base_pixels = entry->profile.self.base_pixels;
+  entry->profile.total.n_culled = entry->profile.self.n_culled;
+  entry->profile.total.culled_pixels = entry->profile.self.culled_pixels;
   if (entry->first_child != NO_ITEM)
     {
       gsize i, n_children;
@@ -208,6 +210,8 @@ gsk_vulkan_debug_frame_filter_node (GskRenderReplay *replay,
           entry->profile.total.upload_pixels += child_entry->profile.total.upload_pixels;
           entry->profile.total.n_bases += child_entry->profile.total.n_bases;
           entry->profile.total.base_pixels += child_entry->profile.total.base_pixels;
+          entry->profile.total.n_culled += child_entry->profile.total.n_culled;
+          entry->profile.total.culled_pixels += child_entry->profile.total.culled_pixels;
         }
     }
   entry->profile.self.cpu_ns = entry->profile.self.cpu_record_ns + entry->profile.self.cpu_submit_ns;
@@ -228,7 +232,9 @@ gsk_vulkan_debug_frame_filter_node (GskRenderReplay *replay,
                                                         "upload total   : %zu @ %llu\n"
                                                         "upload self    : %zu @ %llu\n"
                                                         "base total     : %zu @ %llu\n"
-                                                        "base self      : %zu @ %llu",
+                                                        "base self      : %zu @ %llu\n"
+                                                        "culled total   : %zu @ %llu\n"
+                                                        "culled self    : %zu @ %llu",
                                                         (long long unsigned) entry->profile.total.cpu_record_ns,
                                                         (long long unsigned) entry->profile.self.cpu_record_ns,
                                                         (long long unsigned) entry->profile.total.cpu_submit_ns,
@@ -248,7 +254,11 @@ gsk_vulkan_debug_frame_filter_node (GskRenderReplay *replay,
                                                         entry->profile.total.n_bases,
                                                         (long long unsigned) entry->profile.total.base_pixels,
                                                         entry->profile.self.n_bases,
-                                                        (long long unsigned) entry->profile.self.base_pixels));
+                                                        (long long unsigned) entry->profile.self.base_pixels,
+                                                        entry->profile.total.n_culled,
+                                                        (long long unsigned) entry->profile.total.culled_pixels,
+                                                        entry->profile.self.n_culled,
+                                                        (long long unsigned) entry->profile.self.culled_pixels));
   gsk_render_node_unref (child);
 
   self->debug_current = pos + 1;
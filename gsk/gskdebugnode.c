@@ -38,6 +38,7 @@ struct _GskDebugNode
   GskRenderNode *child;
   GskDebugProfile *profile;
   char *message;
+  gconstpointer boundary;
 };
 
 static void
@@ -206,6 +207,40 @@ gsk_debug_node_new (GskRenderNode *child,
   return gsk_debug_node_new_profile (child, NULL, message);
 }
 
+/*<private>
+ * gsk_debug_node_new_cached:
+ * @child: The child to cache
+ * @boundary: an identifier for the part of the scene that @child draws
+ * @message: (transfer full): The debug message
+ *
+ * Creates a debug node that asks renderers to keep the rendering
+ * of @child around between frames.
+ *
+ * This is meant for subtrees that are reused unchanged over many
+ * frames while what is around them changes, so renderers can just
+ * composite their previous result.
+ *
+ * Nodes with the same @boundary replace each other, so renderers
+ * can drop the rendering of the previous node when it changes.
+ * @boundary is never dereferenced.
+ *
+ * Returns: (transfer full) (type GskDebugNode): A new `GskRenderNode`
+ */
+GskRenderNode *
+gsk_debug_node_new_cached (GskRenderNode *child,
+                           gconstpointer  boundary,
+                           char          *message)
+{
+  GskRenderNode *node;
+
+  g_return_val_if_fail (boundary != NULL, NULL);
+
+  node = gsk_debug_node_new_profile (child, NULL, message);
+  ((GskDebugNode *) node)->boundary = boundary;
+
+  return node;
+}
+
 /**
  * gsk_debug_node_get_child:
  * @node: (type GskDebugNode): a debug `GskRenderNode`
@@ -253,3 +288,21 @@ gsk_debug_node_get_profile (GskRenderNode *node)
 
   return self->profile;
 }
+
+/*<private>
+ * gsk_debug_node_get_boundary:
+ * @node: the node
+ *
+ * Gets the boundary the node was created with in
+ * gsk_debug_node_new_cached().
+ *
+ * Returns: (nullable): the boundary or %NULL if renderers
+ *   should not cache the child
+ **/
+gconstpointer
+gsk_debug_node_get_boundary (GskRenderNode *node)
+{
+  const GskDebugNode *self = (const GskDebugNode *) node;
+
+  return self->boundary;
+}
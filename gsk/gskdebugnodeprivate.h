@@ -21,6 +21,8 @@ struct _GskDebugProfile {
     guint64 upload_pixels;
     gsize n_bases;
     guint64 base_pixels;
+    gsize n_culled;
+    guint64 culled_pixels;
   } total, self;
 };
 
@@ -30,5 +32,10 @@ GskRenderNode *         gsk_debug_node_new_profile              (GskRenderNode
 
 const GskDebugProfile * gsk_debug_node_get_profile              (GskRenderNode                  *node) G_GNUC_PURE;
 
+GskRenderNode *         gsk_debug_node_new_cached               (GskRenderNode                  *child,
+                                                                 gconstpointer                   boundary,
+                                                                 char                           *message);
+gconstpointer           gsk_debug_node_get_boundary             (GskRenderNode                  *node) G_GNUC_PURE;
+
 
 G_END_DECLS
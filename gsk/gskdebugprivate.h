@@ -19,9 +19,10 @@ typedef enum {
   GSK_DEBUG_STAGING               = 1 <<  9,
   GSK_DEBUG_CAIRO                 = 1 << 10,
   GSK_DEBUG_PROFILE               = 1 << 11,
+  GSK_DEBUG_NO_RECYCLE            = 1 << 12,
 } GskDebugFlags;
 
-#define GSK_DEBUG_ANY ((1 << 12) - 1)
+#define GSK_DEBUG_ANY ((1 << 13) - 1)
 
 GskDebugFlags gsk_get_debug_flags (void);
 void          gsk_set_debug_flags (GskDebugFlags flags);
@@ -36,6 +36,7 @@
 #include "gskroundedrectprivate.h"
 #include "gsksubsurfacenode.h"
 #include "gsktexturenode.h"
+#include "gsktexturescalenode.h"
 #include "gsktransformnode.h"
 #include "gsktransformprivate.h"
 
@@ -90,6 +91,80 @@ color_is_black (const GdkColor *color)
          color->alpha > 65280.f / 65535.f;
 }
 
+/* Checks whether the last child of a container hides all the others,
+ * so that they don't need to be part of the offloaded content. The
+ * first child may also be a black background.
+ */
+static gboolean
+container_is_covered_by_last_child (const GskRenderNode   *container,
+                                    const graphene_rect_t *background_bounds,
+                                    GskTransform          *transform,
+                                    gboolean              *has_background)
+{
+  GskRenderNode *last, *child;
+  graphene_rect_t opaque, bounds;
+  guint i, n_children;
+
+  n_children = gsk_container_node_get_n_children (container);
+  last = gsk_container_node_get_child (container, n_children - 1);
+
+  if (!gsk_render_node_get_opaque_rect (last, &opaque))
+    return FALSE;
+
+  i = 0;
+  child = gsk_container_node_get_child (container, 0);
+  gsk_transform_transform_bounds (transform, &child->bounds, &bounds);
+  if (GSK_RENDER_NODE_TYPE (child) == GSK_COLOR_NODE &&
+      gsk_rect_equal (&bounds, background_bounds) &&
+      color_is_black (gsk_color_node_get_gdk_color (child)))
+    {
+      *has_background = TRUE;
+      i = 1;
+    }
+
+  for (; i < n_children - 1; i++)
+    {
+      child = gsk_container_node_get_child (container, i);
+
+      if (!gsk_rect_contains_rect (&opaque, &child->bounds))
+        {
+          *has_background = FALSE;
+          return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+static gboolean
+intersect_clip (GskOffload            *self,
+                GdkSubsurface         *subsurface,
+                const GskRenderNode   *clip_node,
+                const graphene_rect_t *c,
+                GskTransform          *transform,
+                gboolean              *has_clip,
+                graphene_rect_t       *clip,
+                graphene_rect_t       *out_texture_rect)
+{
+  if (*has_clip)
+    {
+      if (!gsk_rect_intersection (c, clip, clip))
+        {
+          GDK_DISPLAY_DEBUG (gdk_surface_get_display (self->surface), OFFLOAD,
+                             "[%p] 🗙 Empty clip", subsurface);
+          return FALSE;
+        }
+    }
+  else
+    {
+      gsk_transform_transform_bounds (transform, &clip_node->bounds, out_texture_rect);
+      *clip = *c;
+      *has_clip = TRUE;
+    }
+
+  return TRUE;
+}
+
 static GdkTexture *
 find_texture_to_attach (GskOffload          *self,
                         const GskRenderNode *subsurface_node,
@@ -155,6 +230,13 @@ find_texture_to_attach (GskOffload          *self,
                 }
             }
 
+          if (gsk_container_node_get_n_children (node) > 1 &&
+              container_is_covered_by_last_child (node, &subsurface_node->bounds, transform, has_background))
+            {
+              node = gsk_container_node_get_child (node, gsk_container_node_get_n_children (node) - 1);
+              break;
+            }
+
           GDK_DISPLAY_DEBUG (gdk_surface_get_display (self->surface), OFFLOAD,
                              "[%p] 🗙 Too much content, container with %d children",
                              subsurface, gsk_container_node_get_n_children (node));
@@ -188,34 +270,60 @@ find_texture_to_attach (GskOffload          *self,
           break;
 
         case GSK_CLIP_NODE:
+          if (!intersect_clip (self, subsurface, node, gsk_clip_node_get_clip (node),
+                               transform, &has_clip, &clip, out_texture_rect))
+            goto out;
+
+          node = gsk_clip_node_get_child (node);
+          break;
+
+        case GSK_ROUNDED_CLIP_NODE:
           {
-            const graphene_rect_t *c = gsk_clip_node_get_clip (node);
+            const GskRoundedRect *c = gsk_rounded_clip_node_get_clip (node);
+            GskRenderNode *child = gsk_rounded_clip_node_get_child (node);
 
-            if (has_clip)
+            if (gsk_rounded_rect_contains_rect (c, &child->bounds))
               {
-                if (!gsk_rect_intersection (c, &clip, &clip))
-                  {
-                    GDK_DISPLAY_DEBUG (gdk_surface_get_display (self->surface), OFFLOAD,
-                                       "[%p] 🗙 Empty clip", subsurface);
-                    goto out;
-                  }
+                /* The corners don't cut into the content */
+                node = child;
+                break;
               }
-            else
+
+            if (!gsk_rounded_rect_is_rectilinear (c))
               {
-                gsk_transform_transform_bounds (transform, &node->bounds, out_texture_rect);
-                clip = *c;
-                has_clip = TRUE;
+                GDK_DISPLAY_DEBUG (gdk_surface_get_display (self->surface), OFFLOAD,
+                                   "[%p] 🗙 Rounded clip", subsurface);
+                goto out;
               }
 
-            node = gsk_clip_node_get_child (node);
+            if (!intersect_clip (self, subsurface, node, &c->bounds,
+                                 transform, &has_clip, &clip, out_texture_rect))
+              goto out;
+
+            node = child;
           }
           break;
 
+        case GSK_TEXTURE_SCALE_NODE:
+          /* The compositor will not scale with nearest filtering */
+          if (gsk_texture_scale_node_get_filter (node) == GSK_SCALING_FILTER_NEAREST)
+            {
+              GDK_DISPLAY_DEBUG (gdk_surface_get_display (self->surface), OFFLOAD,
+                                 "[%p] 🗙 Nearest filter", subsurface);
+              goto out;
+            }
+          G_GNUC_FALLTHROUGH;
+
         case GSK_TEXTURE_NODE:
           {
-            GdkTexture *texture = gsk_texture_node_get_texture (node);
+            GdkTexture *texture;
             int width, height;
 
+            if (GSK_RENDER_NODE_TYPE (node) == GSK_TEXTURE_SCALE_NODE)
+              texture = gsk_texture_scale_node_get_texture (node);
+            else
+              texture = gsk_texture_node_get_texture (node);
+
             if (GDK_IS_MEMORY_TEXTURE (texture) &&
                 !GDK_DISPLAY_DEBUG_CHECK (gdk_surface_get_display (self->surface),
                                           FORCE_OFFLOAD))
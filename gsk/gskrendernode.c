@@ -55,6 +55,10 @@
 
 #include <gobject/gvaluecollector.h>
 
+#ifdef WITH_VALGRIND
+#include <valgrind/valgrind.h>
+#endif
+
 /**
  * gsk_serialization_error_quark:
  *
@@ -144,10 +148,109 @@ value_render_node_lcopy_value (const GValue *value,
   return NULL;
 }
 
+/* Nodes are created and destroyed by the thousands every frame,
+ * so instead of going through g_type_create_instance() and
+ * g_type_free_instance() for every one of them, we keep the
+ * memory of freed nodes around per thread and node type, and
+ * reuse it for the next node of the same type.
+ */
+#define MAX_CACHED_NODES 256
+
+typedef struct _GskRenderNodeCache GskRenderNodeCache;
+
+struct _GskRenderNodeCache
+{
+  gpointer nodes[GSK_N_RENDER_NODE_TYPES][MAX_CACHED_NODES];
+  guint n_nodes[GSK_N_RENDER_NODE_TYPES];
+};
+
+static void
+gsk_render_node_cache_free (gpointer data)
+{
+  GskRenderNodeCache *cache = data;
+  gsize i, j;
+
+  for (i = 0; i < GSK_N_RENDER_NODE_TYPES; i++)
+    {
+      for (j = 0; j < cache->n_nodes[i]; j++)
+        g_free (cache->nodes[i][j]);
+    }
+
+  g_free (cache);
+}
+
+static GPrivate node_cache = G_PRIVATE_INIT (gsk_render_node_cache_free);
+
+/*<private>
+ * gsk_render_node_can_recycle:
+ *
+ * Checks if the memory of freed nodes is reused.
+ *
+ * Recycled nodes hide use-after-free errors from memory checkers,
+ * so this is turned off when running under one of them, and can be
+ * turned off with GSK_DEBUG=no-recycle.
+ *
+ * Returns: %TRUE if freed nodes are recycled
+ */
+gboolean
+gsk_render_node_can_recycle (void)
+{
+  static int can_recycle = -1;
+
+  if (G_UNLIKELY (can_recycle < 0))
+    {
+      gboolean result = !GSK_DEBUG_CHECK (NO_RECYCLE);
+
+#if defined (__SANITIZE_ADDRESS__)
+      result = FALSE;
+#elif defined (__has_feature)
+#if __has_feature (address_sanitizer)
+      result = FALSE;
+#endif
+#endif
+#ifdef WITH_VALGRIND
+      if (RUNNING_ON_VALGRIND)
+        result = FALSE;
+#endif
+
+      g_atomic_int_set (&can_recycle, result);
+    }
+
+  return g_atomic_int_get (&can_recycle);
+}
+
+static GskRenderNodeCache *
+gsk_render_node_cache_get (void)
+{
+  GskRenderNodeCache *cache;
+
+  cache = g_private_get (&node_cache);
+  if (G_UNLIKELY (cache == NULL))
+    {
+      cache = g_new0 (GskRenderNodeCache, 1);
+      g_private_set (&node_cache, cache);
+    }
+
+  return cache;
+}
+
 static void
 gsk_render_node_finalize (GskRenderNode *self)
 {
-  g_type_free_instance ((GTypeInstance *) self);
+  GskRenderNodeType node_type = GSK_RENDER_NODE_TYPE (self);
+  GskRenderNodeCache *cache;
+
+  if (gsk_render_node_can_recycle ())
+    {
+      cache = gsk_render_node_cache_get ();
+      if (cache->n_nodes[node_type] < MAX_CACHED_NODES)
+        {
+          cache->nodes[node_type][cache->n_nodes[node_type]++] = self;
+          return;
+        }
+    }
+
+  g_free (self);
 }
 
 static gboolean
@@ -274,18 +377,46 @@ gsk_render_node_get_type (void)
  *
  * Returns: the newly registered GType
  */
+typedef struct
+{
+  GClassInitFunc class_init;
+  gsize instance_size;
+} GskRenderNodeTypeInfo;
+
+static void
+gsk_render_node_type_class_init (gpointer g_class,
+                                 gpointer class_data)
+{
+  GskRenderNodeClass *klass = g_class;
+  const GskRenderNodeTypeInfo *type_info = class_data;
+
+  klass->instance_size = type_info->instance_size;
+
+  type_info->class_init (g_class, NULL);
+
+  /* GSK_N_RENDER_NODE_TYPES needs to be updated */
+  g_assert (klass->node_type < GSK_N_RENDER_NODE_TYPES);
+}
+
 GType
 gsk_render_node_type_register_static (const char     *node_name,
                                       gsize           instance_size,
                                       GClassInitFunc  class_init)
 {
+  GskRenderNodeTypeInfo *type_info;
   GTypeInfo info;
 
+  /* Node types are static, so this is never freed */
+  type_info = g_new (GskRenderNodeTypeInfo, 1);
+  type_info->class_init = class_init;
+  type_info->instance_size = instance_size;
+
   info.class_size = sizeof (GskRenderNodeClass);
   info.base_init = NULL;
   info.base_finalize = NULL;
-  info.class_init = class_init;
+  info.class_init = gsk_render_node_type_class_init;
   info.class_finalize = NULL;
+  info.class_data = type_info;
   info.instance_size = instance_size;
   info.n_preallocs = 0;
   info.instance_init = NULL;
@@ -305,7 +436,29 @@ gsk_render_node_type_register_static (const char     *node_name,
 gpointer
 gsk_render_node_alloc (GType node_type)
 {
-  return g_type_create_instance (node_type);
+  GskRenderNodeClass *klass;
+  GskRenderNodeCache *cache;
+  GskRenderNode *self;
+
+  /* Node types are static, so the class never goes away */
+  klass = g_type_class_get (node_type);
+
+  cache = gsk_render_node_cache_get ();
+  if (cache->n_nodes[klass->node_type] > 0)
+    {
+      self = cache->nodes[klass->node_type][--cache->n_nodes[klass->node_type]];
+      memset (self, 0, klass->instance_size);
+    }
+  else
+    {
+      self = g_malloc0 (klass->instance_size);
+    }
+
+  /* This is what g_type_create_instance() would do */
+  self->parent_instance.g_class = (GTypeClass *) klass;
+  gsk_render_node_init (self);
+
+  return self;
 }
 
 /**
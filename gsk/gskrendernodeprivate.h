@@ -69,11 +69,18 @@ typedef struct
   GdkColorState *ccs;
 } GskCairoData;
 
+/* The number of node types. GskRenderNodeType is public and we build
+ * with -Wswitch-enum, so it can't have a sentinel value. Registering
+ * a node type checks that this is up to date.
+ */
+#define GSK_N_RENDER_NODE_TYPES (GSK_TURBULENCE_NODE + 1)
+
 struct _GskRenderNodeClass
 {
   GTypeClass parent_class;
 
   GskRenderNodeType node_type;
+  gsize instance_size;
 
   void          (* finalize)                            (GskRenderNode               *node);
   void          (* draw)                                (GskRenderNode               *node,
@@ -119,6 +126,7 @@ GType           gsk_render_node_type_register_static    (const char
                                                          GClassInitFunc               class_init);
 
 gpointer        gsk_render_node_alloc                   (GType                        node_type);
+gboolean        gsk_render_node_can_recycle             (void);
 
 void            _gsk_render_node_unref                  (GskRenderNode               *node);
 
@@ -383,6 +383,13 @@ gdk_texture_new_from_filename_at_scale (const char  *filename,
   if (!bytes)
     return NULL;
 
+  if (gdk_texture_can_load (bytes))
+    {
+      texture = gdk_texture_new_from_bytes_at_size (bytes, width, height, error);
+      g_bytes_unref (bytes);
+      return texture;
+    }
+
   svg = svg_from_bytes (bytes, FALSE, &unsupported);
   g_bytes_unref (bytes);
   if (unsupported)
@@ -409,15 +416,20 @@ is_symbolic (const char *path)
          g_str_has_suffix (path, "-symbolic-rtl.svg");
 }
 
+/* If @size is positive, raster images may be decoded at a reduced
+ * size that is still at least @size pixels wide and high. This is
+ * meant for images that are never drawn bigger than @size, like icons.
+ */
 static GdkPaintable *
 gdk_paintable_new_from_bytes (GBytes     *bytes,
                               const char *path,
-                              gboolean    is_symbolic)
+                              gboolean    is_symbolic,
+                              int         size)
 {
   GdkPaintable *paintable;
 
   if (gdk_texture_can_load (bytes))
-    paintable = GDK_PAINTABLE (gdk_texture_new_from_bytes (bytes, NULL));
+    paintable = GDK_PAINTABLE (gdk_texture_new_from_bytes_at_size (bytes, size, size, NULL));
   else
     {
       GtkSvg *svg;
@@ -454,6 +466,7 @@ gdk_paintable_new_from_bytes (GBytes     *bytes,
 
 GdkPaintable *
 gdk_paintable_new_from_filename (const char  *filename,
+                                 int          size,
                                  GError     **error)
 {
   char *contents;
@@ -465,14 +478,15 @@ gdk_paintable_new_from_filename (const char  *filename,
     return NULL;
 
   bytes = g_bytes_new_take (contents, length);
-  paintable = gdk_paintable_new_from_bytes (bytes, filename, is_symbolic (filename));
+  paintable = gdk_paintable_new_from_bytes (bytes, filename, is_symbolic (filename), size);
   g_bytes_unref (bytes);
 
   return paintable;
 }
 
 GdkPaintable *
-gdk_paintable_new_from_resource (const char *path)
+gdk_paintable_new_from_resource (const char *path,
+                                 int         size)
 {
   GBytes *bytes;
   GdkPaintable *paintable;
@@ -481,7 +495,7 @@ gdk_paintable_new_from_resource (const char *path)
   if (!bytes)
     return NULL;
 
-  paintable = gdk_paintable_new_from_bytes (bytes, path, is_symbolic (path));
+  paintable = gdk_paintable_new_from_bytes (bytes, path, is_symbolic (path), size);
   g_bytes_unref (bytes);
 
   return paintable;
@@ -500,7 +514,7 @@ gdk_paintable_new_from_file (GFile   *file,
     return NULL;
 
   uri = g_file_get_uri (file);
-  paintable = gdk_paintable_new_from_bytes (bytes, uri, is_symbolic (uri));
+  paintable = gdk_paintable_new_from_bytes (bytes, uri, is_symbolic (uri), -1);
   g_bytes_unref (bytes);
   g_free (uri);
 
@@ -509,6 +523,7 @@ gdk_paintable_new_from_file (GFile   *file,
 
 GdkPaintable *
 gdk_paintable_new_from_stream (GInputStream  *stream,
+                               int            size,
                                GCancellable  *cancellable,
                                GError       **error)
 {
@@ -519,7 +534,7 @@ gdk_paintable_new_from_stream (GInputStream  *stream,
   if (!bytes)
     return NULL;
 
-  paintable = gdk_paintable_new_from_bytes (bytes, "?", FALSE);
+  paintable = gdk_paintable_new_from_bytes (bytes, "?", FALSE, size);
   g_bytes_unref (bytes);
 
   return paintable;
@@ -28,12 +28,16 @@ GdkTexture *gdk_texture_new_from_filename_at_scale  (const char    *filename,
                                                      int            height,
                                                      GError       **error);
 
+/* size is the size the image is drawn at, or -1 for the full size */
 GdkPaintable *gdk_paintable_new_from_filename       (const char    *filename,
+                                                     int            size,
                                                      GError       **error);
-GdkPaintable *gdk_paintable_new_from_resource       (const char    *path);
+GdkPaintable *gdk_paintable_new_from_resource       (const char    *path,
+                                                     int            size);
 GdkPaintable *gdk_paintable_new_from_file           (GFile         *file,
                                                      GError       **error);
 GdkPaintable *gdk_paintable_new_from_stream         (GInputStream  *stream,
+                                                     int            size,
                                                      GCancellable  *cancellable,
                                                      GError       **error);
 
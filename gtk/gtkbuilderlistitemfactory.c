@@ -178,6 +178,7 @@ gtk_builder_list_item_factory_set_bytes (GtkBuilderListItemFactory *self,
 
       data = _gtk_buildable_parser_precompile (g_bytes_get_data (bytes, NULL),
                                                g_bytes_get_size (bytes),
+                                               NULL,
                                                &error);
       if (data == NULL)
         {
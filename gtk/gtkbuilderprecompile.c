@@ -23,6 +23,14 @@
 #include "gtkbuilder.h"
 #include "gtkbuildableprivate.h"
 
+/* Version of the binary format. This must be bumped whenever the
+ * format changes or the data in it is interpreted differently,
+ * since precompiled files can be shipped with applications.
+ *
+ * Version 0 did not resolve enum, flags and property names.
+ */
+#define PRECOMPILE_VERSION 1
+
 /*****************************************  Record a GMarkup parser call ***************************/
 
 typedef enum
@@ -331,6 +339,128 @@ static const GMarkupParser record_parser =
   NULL, // error, fails immediately
 };
 
+/* With a builder, we can look up the types of objects and
+ * replace enum and flags values by their numeric values, and
+ * property names by their canonical names, so GtkBuilder does
+ * not need to do that at runtime.
+ */
+static GType
+record_data_element_get_object_type (RecordDataElement *element,
+                                     GtkBuilder        *builder)
+{
+  RecordDataString **attr_names, **attr_values;
+  const char *class_name = NULL;
+  const char *parent_name = NULL;
+  GType type = G_TYPE_INVALID;
+  int i;
+
+  attr_names = &element->attributes[0];
+  attr_values = &element->attributes[element->n_attributes];
+  for (i = 0; i < element->n_attributes; i++)
+    {
+      if (strcmp (attr_names[i]->string, "class") == 0)
+        class_name = attr_values[i]->string;
+      else if (strcmp (attr_names[i]->string, "parent") == 0)
+        parent_name = attr_values[i]->string;
+    }
+
+  if (class_name)
+    type = gtk_builder_get_type_from_name (builder, class_name);
+
+  /* Template classes are usually not known to the precompiler */
+  if (type == G_TYPE_INVALID && parent_name && strcmp (element->name->string, "template") == 0)
+    type = gtk_builder_get_type_from_name (builder, parent_name);
+
+  return type;
+}
+
+static void
+record_data_resolve_property (RecordData        *data,
+                              RecordDataElement *element,
+                              GType              type)
+{
+  RecordDataString **attr_names, **attr_values;
+  RecordDataText *text;
+  GObjectClass *oclass;
+  GParamSpec *pspec;
+  char *resolved = NULL;
+
+  attr_names = &element->attributes[0];
+  attr_values = &element->attributes[element->n_attributes];
+
+  /* Leave translatable and bound properties alone */
+  if (element->n_attributes != 1 ||
+      strcmp (attr_names[0]->string, "name") != 0 ||
+      element->children.length != 1)
+    return;
+
+  text = element->children.head->data;
+  if (text->base.type != RECORD_TYPE_TEXT)
+    return;
+
+  oclass = g_type_class_ref (type);
+  pspec = g_object_class_find_property (oclass, attr_values[0]->string);
+  g_type_class_unref (oclass);
+
+  if (pspec == NULL)
+    return;
+
+  if (strcmp (pspec->name, attr_values[0]->string) != 0)
+    {
+      attr_values[0]->count--;
+      attr_values[0] = record_data_string_lookup (data, pspec->name, -1);
+    }
+
+  if (G_IS_PARAM_SPEC_ENUM (pspec))
+    {
+      int value;
+
+      if (_gtk_builder_enum_from_string (pspec->value_type, text->string->string, &value, NULL))
+        resolved = g_strdup_printf ("%d", value);
+    }
+  else if (G_IS_PARAM_SPEC_FLAGS (pspec))
+    {
+      guint value;
+
+      if (_gtk_builder_flags_from_string (pspec->value_type, text->string->string, &value, NULL))
+        resolved = g_strdup_printf ("%u", value);
+    }
+
+  if (resolved)
+    {
+      text->string->count--;
+      text->string = record_data_string_lookup (data, resolved, strlen (resolved));
+      g_free (resolved);
+    }
+}
+
+static void
+record_data_resolve (RecordData        *data,
+                     GtkBuilder        *builder,
+                     RecordDataElement *element)
+{
+  GType type = G_TYPE_INVALID;
+  GList *l;
+
+  if (element->name &&
+      (strcmp (element->name->string, "object") == 0 ||
+       strcmp (element->name->string, "template") == 0))
+    type = record_data_element_get_object_type (element, builder);
+
+  for (l = element->children.head; l != NULL; l = l->next)
+    {
+      RecordDataElement *child = l->data;
+
+      if (child->base.type != RECORD_TYPE_ELEMENT)
+        continue;
+
+      if (G_TYPE_IS_OBJECT (type) && strcmp (child->name->string, "property") == 0)
+        record_data_resolve_property (data, child, type);
+
+      record_data_resolve (data, builder, child);
+    }
+}
+
 static void
 marshal_uint32 (GString *str,
                 guint32  v)
@@ -455,16 +585,22 @@ marshal_root (GString        *marshaled,
  * _gtk_buildable_parser_precompile:
  * @text: chunk of text to parse
  * @text_len: length of @text in bytes
+ * @builder: (nullable): a builder to look up types with
  *
  * Converts the xml format typically used by GtkBuilder to a
  * binary form that is more efficient to parse. This is a custom
  * format that is only supported by GtkBuilder.
  *
+ * If @builder is given, the values of enum and flags properties
+ * are resolved ahead of time. This is meant for precompiling
+ * ui files at build time.
+ *
  * returns: A `GBytes` with the precompiled data
  **/
 GBytes *
 _gtk_buildable_parser_precompile (const char  *text,
                                   gssize       text_len,
+                                  GtkBuilder  *builder,
                                   GError     **error)
 {
   GMarkupParseContext *ctx;
@@ -493,6 +629,9 @@ _gtk_buildable_parser_precompile (const char  *text,
 
   g_markup_parse_context_free (ctx);
 
+  if (builder)
+    record_data_resolve (&data, builder, data.root);
+
   g_queue_sort (&data.string_list, record_data_string_compare, NULL);
 
   offset = 0;
@@ -500,6 +639,10 @@ _gtk_buildable_parser_precompile (const char  *text,
     {
       RecordDataString *s = l->data;
 
+      /* Replaced while resolving values */
+      if (s->count == 0)
+        continue;
+
       if (s->include_len)
         {
           s->text_offset = offset;
@@ -511,14 +654,18 @@ _gtk_buildable_parser_precompile (const char  *text,
     }
 
   marshaled = g_string_sized_new (4 + offset + 32);
-  /* Magic marker */
-  g_string_append_len (marshaled, "GBU\0", 4);
+  /* Magic marker, followed by the format version */
+  g_string_append_len (marshaled, "GBU", 3);
+  g_string_append_c (marshaled, PRECOMPILE_VERSION);
   marshal_uint32 (marshaled, offset);
 
   for (l = data.string_list.head; l != NULL; l = l->next)
     {
       RecordDataString *s = l->data;
 
+      if (s->count == 0)
+        continue;
+
       if (s->include_len)
         marshal_uint32 (marshaled, s->len);
 
@@ -697,6 +844,10 @@ replay_text (GtkBuildableParseContext  *context,
   return TRUE;
 }
 
+/* Files of any version are considered precompiled, so that
+ * replaying them can report a useful error when the version
+ * doesn't match.
+ */
 gboolean
 _gtk_buildable_parser_is_precompiled (const char *data,
                                       gssize      data_len)
@@ -705,8 +856,7 @@ _gtk_buildable_parser_is_precompiled (const char *data,
     data_len > 4 &&
     data[0] == 'G' &&
     data[1] == 'B' &&
-    data[2] == 'U' &&
-    data[3] == 0;
+    data[2] == 'U';
 }
 
 gboolean
@@ -720,6 +870,17 @@ _gtk_buildable_parser_replay_precompiled (GtkBuildableParseContext  *context,
   const char *strings;
   const char *tree;
 
+  if (data[3] != PRECOMPILE_VERSION)
+    {
+      propagate_error (context, error,
+                       g_error_new (GTK_BUILDER_ERROR,
+                                    GTK_BUILDER_ERROR_VERSION_MISMATCH,
+                                    "Precompiled data has format version %d, but version %d is required. "
+                                    "It needs to be precompiled again for this version of GTK",
+                                    (guchar) data[3], PRECOMPILE_VERSION));
+      return FALSE;
+    }
+
   data = data + 4; /* Skip header */
 
   len = demarshal_uint32 (&data);
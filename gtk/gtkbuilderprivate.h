@@ -202,6 +202,7 @@ typedef struct {
 /* Things only GtkBuilder should use */
 GBytes * _gtk_buildable_parser_precompile (const char               *text,
                                            gssize                    text_len,
+                                           GtkBuilder               *builder,
                                            GError                  **error);
 gboolean _gtk_buildable_parser_is_precompiled (const char           *data,
                                                gssize                data_len);
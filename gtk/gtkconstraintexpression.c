@@ -671,18 +671,31 @@ term_free (gpointer data)
   g_free (term);
 }
 
+/* Most rows of the tableau only have a handful of terms, so we
+ * only build an index for looking up terms by variable once an
+ * expression grows beyond this many terms
+ */
+#define TERMS_INDEX_THRESHOLD 8
+
 struct _GtkConstraintExpression
 {
   double constant;
 
-  /* HashTable<Variable, Term>; the key is the term's variable,
-   * and the value is owned by the hash table
-   */
-  GHashTable *terms;
-
-  /* List of terms, in insertion order */
+  /* List of terms, in insertion order; owns the terms */
   Term *first_term;
   Term *last_term;
+  guint n_terms;
+
+  /* HashTable<Variable, Term>, or NULL for short expressions;
+   * the key is the term's variable, and the value is owned by
+   * the list of terms
+   */
+  GHashTable *terms_index;
+
+  /* Set once a term has been added, even if it has been removed
+   * since then
+   */
+  gboolean has_terms;
 
   /* Used by GtkConstraintExpressionIter to guard against changes
    * in the expression while iterating
@@ -690,6 +703,24 @@ struct _GtkConstraintExpression
   gint64 age;
 };
 
+static Term *
+gtk_constraint_expression_find_term (const GtkConstraintExpression *self,
+                                     GtkConstraintVariable         *variable)
+{
+  Term *iter;
+
+  if (self->terms_index != NULL)
+    return g_hash_table_lookup (self->terms_index, variable);
+
+  for (iter = self->first_term; iter != NULL; iter = iter->next)
+    {
+      if (iter->variable == variable)
+        return iter;
+    }
+
+  return NULL;
+}
+
 /*< private >
  * gtk_constraint_expression_add_term:
  * @self: a `GtkConstraintExpression`
@@ -708,17 +739,25 @@ gtk_constraint_expression_add_term (GtkConstraintExpression *self,
 {
   Term *term;
 
-  if (self->terms == NULL)
+  term = term_new (variable, coefficient);
+
+  self->has_terms = TRUE;
+  self->n_terms += 1;
+
+  if (self->terms_index != NULL)
     {
-      g_assert (self->first_term == NULL && self->last_term == NULL);
-      self->terms = g_hash_table_new_full (NULL, NULL,
-                                           NULL,
-                                           term_free);
+      g_hash_table_insert (self->terms_index, term->variable, term);
     }
+  else if (self->n_terms > TERMS_INDEX_THRESHOLD)
+    {
+      Term *iter;
 
-  term = term_new (variable, coefficient);
+      self->terms_index = g_hash_table_new (NULL, NULL);
 
-  g_hash_table_insert (self->terms, term->variable, term);
+      for (iter = self->first_term; iter != NULL; iter = iter->next)
+        g_hash_table_insert (self->terms_index, iter->variable, iter);
+      g_hash_table_insert (self->terms_index, term->variable, term);
+    }
 
   if (self->first_term == NULL)
     self->first_term = term;
@@ -740,48 +779,28 @@ static void
 gtk_constraint_expression_remove_term (GtkConstraintExpression *self,
                                        GtkConstraintVariable *variable)
 {
-  Term *term, *iter;
-
-  if (self->terms == NULL)
-    return;
+  Term *term;
 
-  term = g_hash_table_lookup (self->terms, variable);
+  term = gtk_constraint_expression_find_term (self, variable);
   if (term == NULL)
     return;
 
-  /* Keep the variable alive for the duration of the function */
-  gtk_constraint_variable_ref (variable);
-
-  iter = self->first_term;
-  while (iter != NULL)
-    {
-      Term *next = iter->next;
-      Term *prev = iter->prev;
-
-      if (iter == term)
-        {
-          if (prev != NULL)
-            prev->next = next;
-          if (next != NULL)
-            next->prev = prev;
-
-          if (iter == self->first_term)
-            self->first_term = next;
-          if (iter == self->last_term)
-            self->last_term = prev;
-
-          iter->next = NULL;
-          iter->prev = NULL;
+  if (term->prev != NULL)
+    term->prev->next = term->next;
+  else
+    self->first_term = term->next;
 
-          break;
-        }
+  if (term->next != NULL)
+    term->next->prev = term->prev;
+  else
+    self->last_term = term->prev;
 
-      iter = next;
-    }
+  if (self->terms_index != NULL)
+    g_hash_table_remove (self->terms_index, variable);
 
-  g_hash_table_remove (self->terms, variable);
+  self->n_terms -= 1;
 
-  gtk_constraint_variable_unref (variable);
+  term_free (term);
 
   self->age += 1;
 }
@@ -800,9 +819,11 @@ gtk_constraint_expression_new (double constant)
   GtkConstraintExpression *res = g_rc_box_new (GtkConstraintExpression);
 
   res->age = 0;
-  res->terms = NULL;
   res->first_term = NULL;
   res->last_term = NULL;
+  res->n_terms = 0;
+  res->terms_index = NULL;
+  res->has_terms = FALSE;
   res->constant = constant;
 
   return res;
@@ -847,13 +868,25 @@ static void
 gtk_constraint_expression_clear (gpointer data)
 {
   GtkConstraintExpression *self = data;
+  Term *iter;
 
-  g_clear_pointer (&self->terms, g_hash_table_unref);
+  g_clear_pointer (&self->terms_index, g_hash_table_unref);
+
+  iter = self->first_term;
+  while (iter != NULL)
+    {
+      Term *next = iter->next;
+
+      term_free (iter);
+      iter = next;
+    }
 
   self->age = 0;
   self->constant = 0.0;
   self->first_term = NULL;
   self->last_term = NULL;
+  self->n_terms = 0;
+  self->has_terms = FALSE;
 }
 
 /*< private >
@@ -879,7 +912,7 @@ gtk_constraint_expression_unref (GtkConstraintExpression *expression)
 gboolean
 gtk_constraint_expression_is_constant (const GtkConstraintExpression *expression)
 {
-  return expression->terms == NULL;
+  return !expression->has_terms;
 }
 
 /*< private >
@@ -960,9 +993,9 @@ gtk_constraint_expression_add_variable (GtkConstraintExpression *expression,
                                         GtkConstraintSolver *solver)
 {
   /* If the expression already contains the variable, update the coefficient */
-  if (expression->terms != NULL)
+  if (expression->has_terms)
     {
-      Term *t = g_hash_table_lookup (expression->terms, variable);
+      Term *t = gtk_constraint_expression_find_term (expression, variable);
 
       if (t != NULL)
         {
@@ -1029,9 +1062,9 @@ gtk_constraint_expression_set_variable (GtkConstraintExpression *expression,
                                         GtkConstraintVariable *variable,
                                         double coefficient)
 {
-  if (expression->terms != NULL)
+  if (expression->has_terms)
     {
-      Term *t = g_hash_table_lookup (expression->terms, variable);
+      Term *t = gtk_constraint_expression_find_term (expression, variable);
 
       if (t != NULL)
         {
@@ -1196,21 +1229,12 @@ GtkConstraintExpression *
 gtk_constraint_expression_multiply_by (GtkConstraintExpression *expression,
                                        double factor)
 {
-  GHashTableIter iter;
-  gpointer value_p;
+  Term *t;
 
   expression->constant *= factor;
 
-  if (expression->terms == NULL)
-    return expression;
-
-  g_hash_table_iter_init (&iter, expression->terms);
-  while (g_hash_table_iter_next (&iter, NULL, &value_p))
-    {
-      Term *t = value_p;
-
-      t->coefficient *= factor;
-    }
+  for (t = expression->first_term; t != NULL; t = t->next)
+    t->coefficient *= factor;
 
   return expression;
 }
@@ -1269,7 +1293,7 @@ gtk_constraint_expression_new_subject (GtkConstraintExpression *expression,
 
   g_assert (!gtk_constraint_expression_is_constant (expression));
 
-  term = g_hash_table_lookup (expression->terms, subject);
+  term = gtk_constraint_expression_find_term (expression, subject);
   g_assert (term != NULL);
   g_assert (!G_APPROX_VALUE (term->coefficient, 0.0, 0.001));
 
@@ -1334,10 +1358,7 @@ gtk_constraint_expression_get_coefficient (GtkConstraintExpression *expression,
   g_return_val_if_fail (expression != NULL, 0.0);
   g_return_val_if_fail (variable != NULL, 0.0);
 
-  if (expression->terms == NULL)
-    return 0.0;
-
-  term = g_hash_table_lookup (expression->terms, variable);
+  term = gtk_constraint_expression_find_term (expression, variable);
   if (term == NULL)
     return 0.0;
 
@@ -1367,7 +1388,7 @@ gtk_constraint_expression_substitute_out (GtkConstraintExpression *expression,
   double multiplier;
   Term *iter;
 
-  if (expression->terms == NULL)
+  if (!expression->has_terms)
     return;
 
   multiplier = gtk_constraint_expression_get_coefficient (expression, out_var);
@@ -1382,8 +1403,7 @@ gtk_constraint_expression_substitute_out (GtkConstraintExpression *expression,
       double coeff = iter->coefficient;
       Term *next = iter->next;
 
-      if (expression->terms != NULL &&
-          g_hash_table_contains (expression->terms, clv))
+      if (gtk_constraint_expression_find_term (expression, clv) != NULL)
         {
           double old_coefficient = gtk_constraint_expression_get_coefficient (expression, clv);
           double new_coefficient = old_coefficient + multiplier * coeff;
@@ -1424,7 +1444,7 @@ gtk_constraint_expression_get_pivotable_variable (GtkConstraintExpression *expre
 {
   Term *iter;
 
-  if (expression->terms == NULL)
+  if (!expression->has_terms)
     {
       g_critical ("Expression %p is a constant", expression);
       return NULL;
@@ -1470,11 +1490,11 @@ gtk_constraint_expression_to_string (const GtkConstraintExpression *expression)
     {
       g_string_append_printf (buf, "%g", expression->constant);
 
-      if (expression->terms != NULL)
+      if (expression->has_terms)
         needs_plus = TRUE;
     }
 
-  if (expression->terms == NULL)
+  if (!expression->has_terms)
     return g_string_free (buf, FALSE);
 
   iter = expression->first_term;
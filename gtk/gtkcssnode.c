@@ -21,6 +21,7 @@
 
 #include "gtkcssstaticstyleprivate.h"
 #include "gtkcssanimatedstyleprivate.h"
+#include "gtkcssproviderprivate.h"
 #include "gtkcssstylepropertyprivate.h"
 #include "gtkmarshalers.h"
 #include "gtksettingsprivate.h"
@@ -1377,6 +1378,7 @@ gtk_css_node_validate (GtkCssNode *cssnode)
       gdk_profiler_set_int_counter (created_styles_counter, created_styles);
       invalidated_nodes = 0;
       created_styles = 0;
+      gtk_css_provider_report_match_stats ();
     }
 }
 
@@ -28,6 +28,7 @@
 #include "gtkcsscolorvalueprivate.h"
 #include "gtkcsscustompropertypoolprivate.h"
 #include "gtkcsskeyframesprivate.h"
+#include "gtkcssnodeprivate.h"
 #include "gtkcssmediaqueryprivate.h"
 #include "gtkcssreferencevalueprivate.h"
 #include "gtkcssselectorprivate.h"
@@ -101,6 +102,7 @@ struct _GtkCssProviderClass
 };
 
 typedef struct GtkCssRuleset GtkCssRuleset;
+typedef struct _GtkCssStylesheet GtkCssStylesheet;
 typedef struct _GtkCssScanner GtkCssScanner;
 typedef struct _PropertyValue PropertyValue;
 typedef enum ParserScope ParserScope;
@@ -122,6 +124,80 @@ struct GtkCssRuleset
   GHashTable *custom_properties;
 };
 
+/* The result of parsing a stylesheet.
+ *
+ * Stylesheets are immutable once parsed, so providers that load
+ * the same data with the same media features can share them.
+ */
+struct _GtkCssStylesheet
+{
+  guint ref_count;
+
+  /* The key in the stylesheet cache */
+  GBytes *bytes;
+  GFile *file;
+  GtkInterfaceColorScheme prefers_color_scheme;
+  GtkInterfaceContrast prefers_contrast;
+  GtkReducedMotion prefers_reduced_motion;
+
+  GHashTable *symbolic_colors;
+  GHashTable *keyframes;
+
+  GArray *rulesets;
+  GtkCssSelectorTree *tree;
+  /* The union of the changes of all selectors */
+  GtkCssChange change;
+
+  /* GtkCssMatch => itself */
+  GHashTable *matches;
+};
+
+/* Matching the selector tree is the expensive part of a lookup, and
+ * lists tend to contain lots of nodes that match the same rules.
+ * So we remember the matched rules, keyed by the declarations of the
+ * node and all its ancestors and whether they are the first or last
+ * child. The position is only looked at when the stylesheet has
+ * selectors that depend on it.
+ *
+ * Matches that depend on anything else, like siblings or positions
+ * other than first and last, are not cached.
+ */
+#define GTK_CSS_MATCH_MAX_DEPTH 32
+#define GTK_CSS_MATCH_CACHE_SIZE 4096
+
+#define GTK_CSS_MATCH_UNCACHEABLE (GTK_CSS_CHANGE_ANY_SIBLING | \
+                                   GTK_CSS_CHANGE_ANY_PARENT_SIBLING | \
+                                   GTK_CSS_CHANGE_NTH_CHILD | \
+                                   GTK_CSS_CHANGE_NTH_LAST_CHILD | \
+                                   GTK_CSS_CHANGE_PARENT_NTH_CHILD | \
+                                   GTK_CSS_CHANGE_PARENT_NTH_LAST_CHILD)
+
+typedef struct _GtkCssMatch GtkCssMatch;
+typedef struct _GtkCssMatchNode GtkCssMatchNode;
+
+struct _GtkCssMatchNode
+{
+  GtkCssNodeDeclaration *decl;
+  guint is_first : 1;
+  guint is_last : 1;
+};
+
+struct _GtkCssMatch
+{
+  guint hash;
+  guint n_nodes;
+  GtkCssMatchNode *nodes;
+
+  GtkCssChange change;
+  guint n_rulesets;
+  GtkCssRuleset **rulesets;
+};
+
+static guint match_hits;
+static guint match_misses;
+static guint match_hits_counter;
+static guint match_misses_counter;
+
 struct _GtkCssScanner
 {
   GtkCssProvider *provider;
@@ -139,11 +215,8 @@ struct _GtkCssProviderPrivate
   GtkInterfaceContrast prefers_contrast;
   GtkReducedMotion prefers_reduced_motion;
 
-  GHashTable *symbolic_colors;
-  GHashTable *keyframes;
-
-  GArray *rulesets;
-  GtkCssSelectorTree *tree;
+  GtkCssStylesheet *sheet;
+  gboolean cacheable;
 
   GBytes *source;
   GFile *source_file;
@@ -195,6 +268,7 @@ static void gtk_css_provider_load_internal (GtkCssProvider *css_provider,
                                             GFile          *file,
                                             GBytes         *bytes);
 static void parse_statement                (GtkCssScanner  *scanner);
+static void gtk_css_stylesheet_cache_clear (void);
 
 G_DEFINE_TYPE_EXTENDED (GtkCssProvider, gtk_css_provider, G_TYPE_OBJECT, 0,
                         G_ADD_PRIVATE (GtkCssProvider)
@@ -237,6 +311,21 @@ void
 gtk_css_provider_set_keep_css_sections (void)
 {
   gtk_keep_css_sections = TRUE;
+
+  /* Cached stylesheets don't have the sections */
+  gtk_css_stylesheet_cache_clear ();
+}
+
+/* This is exported privately for use in the testsuite.
+ */
+gboolean
+gtk_css_provider_shares_stylesheet (GtkCssProvider *provider,
+                                    GtkCssProvider *other)
+{
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (provider);
+  GtkCssProviderPrivate *other_priv = gtk_css_provider_get_instance_private (other);
+
+  return priv->sheet == other_priv->sheet;
 }
 
 static void
@@ -376,6 +465,12 @@ gtk_css_provider_class_init (GtkCssProviderClass *klass)
                                                            G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_EXPLICIT_NOTIFY);
 
   g_object_class_install_properties (object_class, NUM_PROPERTIES, pspecs);
+
+  if (match_hits_counter == 0)
+    {
+      match_hits_counter = gdk_profiler_define_int_counter ("css-match-hits", "CSS selector matches reused");
+      match_misses_counter = gdk_profiler_define_int_counter ("css-match-misses", "CSS selector matches computed");
+    }
 }
 
 static void
@@ -486,6 +581,159 @@ gtk_css_ruleset_add_custom (GtkCssRuleset       *ruleset,
   g_hash_table_replace (ruleset->custom_properties, GINT_TO_POINTER (id), value);
 }
 
+static GtkCssStylesheet *
+gtk_css_stylesheet_new (void)
+{
+  GtkCssStylesheet *self;
+
+  self = g_new0 (GtkCssStylesheet, 1);
+  self->ref_count = 1;
+
+  self->rulesets = g_array_new (FALSE, FALSE, sizeof (GtkCssRuleset));
+
+  self->symbolic_colors = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                                 (GDestroyNotify) g_free,
+                                                 (GDestroyNotify) gtk_css_value_unref);
+  self->keyframes = g_hash_table_new_full (g_str_hash, g_str_equal,
+                                           (GDestroyNotify) g_free,
+                                           (GDestroyNotify) _gtk_css_keyframes_unref);
+
+  return self;
+}
+
+static GtkCssStylesheet *
+gtk_css_stylesheet_ref (GtkCssStylesheet *self)
+{
+  self->ref_count++;
+
+  return self;
+}
+
+static void
+gtk_css_stylesheet_unref (GtkCssStylesheet *self)
+{
+  guint i;
+
+  self->ref_count--;
+  if (self->ref_count > 0)
+    return;
+
+  for (i = 0; i < self->rulesets->len; i++)
+    gtk_css_ruleset_clear (&g_array_index (self->rulesets, GtkCssRuleset, i));
+
+  g_array_free (self->rulesets, TRUE);
+  g_clear_pointer (&self->tree, _gtk_css_selector_tree_free);
+
+  g_hash_table_destroy (self->symbolic_colors);
+  g_hash_table_destroy (self->keyframes);
+  g_clear_pointer (&self->matches, g_hash_table_unref);
+
+  g_clear_pointer (&self->bytes, g_bytes_unref);
+  g_clear_object (&self->file);
+
+  g_free (self);
+}
+
+static guint
+gtk_css_stylesheet_hash (gconstpointer data)
+{
+  const GtkCssStylesheet *self = data;
+
+  return g_bytes_hash (self->bytes) ^
+         (self->file ? g_file_hash (self->file) : 0) ^
+         (self->prefers_color_scheme << 0) ^
+         (self->prefers_contrast << 4) ^
+         (self->prefers_reduced_motion << 8);
+}
+
+static gboolean
+gtk_css_stylesheet_equal (gconstpointer data1,
+                          gconstpointer data2)
+{
+  const GtkCssStylesheet *a = data1;
+  const GtkCssStylesheet *b = data2;
+
+  if (a->prefers_color_scheme != b->prefers_color_scheme ||
+      a->prefers_contrast != b->prefers_contrast ||
+      a->prefers_reduced_motion != b->prefers_reduced_motion)
+    return FALSE;
+
+  if (a->file != b->file &&
+      (a->file == NULL || b->file == NULL || !g_file_equal (a->file, b->file)))
+    return FALSE;
+
+  return g_bytes_equal (a->bytes, b->bytes);
+}
+
+/* Themes get reloaded whenever the display, the theme or the color
+ * scheme changes. Keep the last few parsed stylesheets around, so
+ * that switching back and forth or loading the same theme for
+ * multiple displays doesn't parse it again.
+ *
+ * This cache only lives as long as the process, so the first load
+ * of a theme at startup still parses it.
+ */
+#define GTK_CSS_STYLESHEET_CACHE_SIZE 4
+
+static GHashTable *stylesheet_cache;
+static GQueue stylesheet_cache_lru = G_QUEUE_INIT;
+
+static GtkCssStylesheet *
+gtk_css_stylesheet_cache_lookup (GBytes                  *bytes,
+                                 GFile                   *file,
+                                 GtkInterfaceColorScheme  prefers_color_scheme,
+                                 GtkInterfaceContrast     prefers_contrast,
+                                 GtkReducedMotion         prefers_reduced_motion)
+{
+  GtkCssStylesheet *sheet;
+
+  if (stylesheet_cache == NULL)
+    return NULL;
+
+  sheet = g_hash_table_lookup (stylesheet_cache,
+                               &(GtkCssStylesheet) {
+                                 .bytes = bytes,
+                                 .file = file,
+                                 .prefers_color_scheme = prefers_color_scheme,
+                                 .prefers_contrast = prefers_contrast,
+                                 .prefers_reduced_motion = prefers_reduced_motion,
+                               });
+  if (sheet == NULL)
+    return NULL;
+
+  /* Move to the front */
+  g_queue_remove (&stylesheet_cache_lru, sheet);
+  g_queue_push_head (&stylesheet_cache_lru, sheet);
+
+  return gtk_css_stylesheet_ref (sheet);
+}
+
+static void
+gtk_css_stylesheet_cache_add (GtkCssStylesheet *sheet)
+{
+  if (stylesheet_cache == NULL)
+    stylesheet_cache = g_hash_table_new_full (gtk_css_stylesheet_hash,
+                                              gtk_css_stylesheet_equal,
+                                              NULL,
+                                              (GDestroyNotify) gtk_css_stylesheet_unref);
+
+  if (g_hash_table_contains (stylesheet_cache, sheet))
+    return;
+
+  g_hash_table_add (stylesheet_cache, gtk_css_stylesheet_ref (sheet));
+  g_queue_push_head (&stylesheet_cache_lru, sheet);
+
+  if (g_queue_get_length (&stylesheet_cache_lru) > GTK_CSS_STYLESHEET_CACHE_SIZE)
+    g_hash_table_remove (stylesheet_cache, g_queue_pop_tail (&stylesheet_cache_lru));
+}
+
+static void
+gtk_css_stylesheet_cache_clear (void)
+{
+  g_queue_clear (&stylesheet_cache_lru);
+  g_clear_pointer (&stylesheet_cache, g_hash_table_unref);
+}
+
 static void
 gtk_css_scanner_destroy (GtkCssScanner *scanner)
 {
@@ -514,8 +762,12 @@ gtk_css_scanner_parser_error (GtkCssParser         *parser,
                               gpointer              user_data)
 {
   GtkCssScanner *scanner = user_data;
+  GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (scanner->provider);
   GtkCssSection *section;
 
+  /* Errors must be emitted every time the data is loaded */
+  priv->cacheable = FALSE;
+
   section = gtk_css_section_new_with_bytes (gtk_css_parser_get_file (parser),
                                             gtk_css_parser_get_bytes (parser),
                                             start,
@@ -656,14 +908,7 @@ gtk_css_provider_init (GtkCssProvider *css_provider)
   priv->prefers_contrast = GTK_INTERFACE_CONTRAST_NO_PREFERENCE;
   priv->needs_rerender = FALSE;
 
-  priv->rulesets = g_array_new (FALSE, FALSE, sizeof (GtkCssRuleset));
-
-  priv->symbolic_colors = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                                 (GDestroyNotify) g_free,
-                                                 (GDestroyNotify) gtk_css_value_unref);
-  priv->keyframes = g_hash_table_new_full (g_str_hash, g_str_equal,
-                                           (GDestroyNotify) g_free,
-                                           (GDestroyNotify) _gtk_css_keyframes_unref);
+  priv->sheet = gtk_css_stylesheet_new ();
 }
 
 static void
@@ -677,11 +922,11 @@ verify_tree_match_results (GtkCssProvider        *provider,
   gboolean should_match;
   int i, j;
 
-  for (i = 0; i < priv->rulesets->len; i++)
+  for (i = 0; i < priv->sheet->rulesets->len; i++)
     {
       gboolean found = FALSE;
 
-      ruleset = &g_array_index (priv->rulesets, GtkCssRuleset, i);
+      ruleset = &g_array_index (priv->sheet->rulesets, GtkCssRuleset, i);
 
       for (j = 0; j < gtk_css_selector_matches_get_size (tree_rules); j++)
 	{
@@ -710,7 +955,7 @@ gtk_css_style_provider_get_color (GtkStyleProvider *provider,
   GtkCssProvider *css_provider = GTK_CSS_PROVIDER (provider);
   GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (css_provider);
 
-  return g_hash_table_lookup (priv->symbolic_colors, name);
+  return g_hash_table_lookup (priv->sheet->symbolic_colors, name);
 }
 
 static GtkCssKeyframes *
@@ -720,7 +965,150 @@ gtk_css_style_provider_get_keyframes (GtkStyleProvider *provider,
   GtkCssProvider *css_provider = GTK_CSS_PROVIDER (provider);
   GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (css_provider);
 
-  return g_hash_table_lookup (priv->keyframes, name);
+  return g_hash_table_lookup (priv->sheet->keyframes, name);
+}
+
+static void
+gtk_css_match_free (gpointer data)
+{
+  GtkCssMatch *match = data;
+
+  for (guint i = 0; i < match->n_nodes; i++)
+    gtk_css_node_declaration_unref (match->nodes[i].decl);
+
+  g_free (match->nodes);
+  g_free (match->rulesets);
+  g_free (match);
+}
+
+static guint
+gtk_css_match_hash (gconstpointer data)
+{
+  const GtkCssMatch *match = data;
+
+  return match->hash;
+}
+
+static gboolean
+gtk_css_match_equal (gconstpointer data1,
+                     gconstpointer data2)
+{
+  const GtkCssMatch *a = data1;
+  const GtkCssMatch *b = data2;
+
+  if (a->hash != b->hash || a->n_nodes != b->n_nodes)
+    return FALSE;
+
+  for (guint i = 0; i < a->n_nodes; i++)
+    {
+      if (a->nodes[i].is_first != b->nodes[i].is_first ||
+          a->nodes[i].is_last != b->nodes[i].is_last)
+        return FALSE;
+
+      if (a->nodes[i].decl != b->nodes[i].decl &&
+          !gtk_css_node_declaration_equal (a->nodes[i].decl, b->nodes[i].decl))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
+static GtkCssNode *
+get_previous_visible_sibling (GtkCssNode *node)
+{
+  do {
+    node = gtk_css_node_get_previous_sibling (node);
+  } while (node && !gtk_css_node_get_visible (node));
+
+  return node;
+}
+
+static GtkCssNode *
+get_next_visible_sibling (GtkCssNode *node)
+{
+  do {
+    node = gtk_css_node_get_next_sibling (node);
+  } while (node && !gtk_css_node_get_visible (node));
+
+  return node;
+}
+
+/* Fills in the key of @match for @node. The nodes array of
+ * @match must have room for GTK_CSS_MATCH_MAX_DEPTH nodes.
+ *
+ * @change is the union of the changes of all selectors in the
+ * stylesheet. Positions that no selector looks at are left out
+ * of the key, so we don't walk the siblings of every ancestor.
+ */
+static gboolean
+gtk_css_match_init_key (GtkCssMatch  *match,
+                        GtkCssNode   *node,
+                        GtkCssChange  change)
+{
+  GtkCssChange first = GTK_CSS_CHANGE_FIRST_CHILD;
+  GtkCssChange last = GTK_CSS_CHANGE_LAST_CHILD;
+  guint hash = 0;
+  guint n = 0;
+
+  for (; node != NULL; node = gtk_css_node_get_parent (node))
+    {
+      GtkCssMatchNode *mnode;
+
+      if (n == GTK_CSS_MATCH_MAX_DEPTH)
+        return FALSE;
+
+      mnode = &match->nodes[n++];
+      mnode->decl = (GtkCssNodeDeclaration *) gtk_css_node_get_declaration (node);
+      mnode->is_first = (change & first) && get_previous_visible_sibling (node) == NULL;
+      mnode->is_last = (change & last) && get_next_visible_sibling (node) == NULL;
+
+      /* Only use odd multipliers, so the nodes below don't get
+       * shifted out of the hash.
+       */
+      hash = hash * 31 + gtk_css_node_declaration_hash (mnode->decl);
+      hash = hash * 5 + ((mnode->is_first << 1) | mnode->is_last);
+
+      first = GTK_CSS_CHANGE_PARENT_FIRST_CHILD;
+      last = GTK_CSS_CHANGE_PARENT_LAST_CHILD;
+    }
+
+  match->hash = hash;
+  match->n_nodes = n;
+
+  return TRUE;
+}
+
+static void
+gtk_css_stylesheet_add_match (GtkCssStylesheet            *sheet,
+                              const GtkCssMatch           *key,
+                              const GtkCssSelectorMatches *rulesets,
+                              GtkCssChange                 change)
+{
+  GtkCssMatch *match;
+
+  if (sheet->matches == NULL)
+    sheet->matches = g_hash_table_new_full (gtk_css_match_hash,
+                                            gtk_css_match_equal,
+                                            gtk_css_match_free,
+                                            NULL);
+  else if (g_hash_table_size (sheet->matches) >= GTK_CSS_MATCH_CACHE_SIZE)
+    g_hash_table_remove_all (sheet->matches);
+
+  match = g_new (GtkCssMatch, 1);
+  match->hash = key->hash;
+  match->n_nodes = key->n_nodes;
+  match->nodes = g_new (GtkCssMatchNode, key->n_nodes);
+  for (guint i = 0; i < key->n_nodes; i++)
+    {
+      match->nodes[i] = key->nodes[i];
+      gtk_css_node_declaration_ref (match->nodes[i].decl);
+    }
+  match->change = change;
+  match->n_rulesets = gtk_css_selector_matches_get_size (rulesets);
+  match->rulesets = g_memdup2 (gtk_css_selector_matches_get_data (rulesets),
+                               match->n_rulesets * sizeof (GtkCssRuleset *));
+
+  g_hash_table_add (sheet->matches, match);
 }
 
 static void
@@ -736,20 +1124,58 @@ gtk_css_style_provider_lookup (GtkStyleProvider             *provider,
   guint j;
   int i;
   GtkCssSelectorMatches tree_rules;
-
-  if (_gtk_css_selector_tree_is_empty (priv->tree))
+  GtkCssMatchNode key_nodes[GTK_CSS_MATCH_MAX_DEPTH];
+  GtkCssMatch key = { .nodes = key_nodes };
+  GtkCssMatch *match = NULL;
+  gboolean use_cache;
+  GtkCssRuleset **rulesets;
+  gsize n_rulesets;
+  GtkCssChange tree_change = 0;
+
+  if (_gtk_css_selector_tree_is_empty (priv->sheet->tree))
     return;
 
+  use_cache = !GTK_DEBUG_CHECK (NO_CSS_CACHE) &&
+              gtk_css_match_init_key (&key, node, priv->sheet->change);
+
+  if (use_cache && priv->sheet->matches)
+    match = g_hash_table_lookup (priv->sheet->matches, &key);
+
   gtk_css_selector_matches_init (&tree_rules);
-  _gtk_css_selector_tree_match_all (priv->tree, filter, node, &tree_rules);
 
-  if (!gtk_css_selector_matches_is_empty (&tree_rules))
+  if (match)
+    {
+      match_hits++;
+
+      rulesets = match->rulesets;
+      n_rulesets = match->n_rulesets;
+      tree_change = match->change;
+    }
+  else
     {
-      verify_tree_match_results (css_provider, node, &tree_rules);
+      if (use_cache)
+        match_misses++;
+
+      _gtk_css_selector_tree_match_all (priv->sheet->tree, filter, node, &tree_rules);
+
+      if (change || use_cache)
+        tree_change = gtk_css_selector_tree_get_change_all (priv->sheet->tree, filter, node);
 
-      for (i = gtk_css_selector_matches_get_size (&tree_rules) - 1; i >= 0; i--)
+      if (use_cache && (tree_change & GTK_CSS_MATCH_UNCACHEABLE) == 0)
+        gtk_css_stylesheet_add_match (priv->sheet, &key, &tree_rules, tree_change);
+
+      if (!gtk_css_selector_matches_is_empty (&tree_rules))
+        verify_tree_match_results (css_provider, node, &tree_rules);
+
+      rulesets = (GtkCssRuleset **) gtk_css_selector_matches_get_data (&tree_rules);
+      n_rulesets = gtk_css_selector_matches_get_size (&tree_rules);
+    }
+
+  if (n_rulesets > 0)
+    {
+      for (i = n_rulesets - 1; i >= 0; i--)
         {
-          ruleset = gtk_css_selector_matches_get (&tree_rules, i);
+          ruleset = rulesets[i];
 
           if (ruleset->styles == NULL && ruleset->custom_properties == NULL)
             continue;
@@ -784,7 +1210,20 @@ gtk_css_style_provider_lookup (GtkStyleProvider             *provider,
   gtk_css_selector_matches_clear (&tree_rules);
 
   if (change)
-    *change = gtk_css_selector_tree_get_change_all (priv->tree, filter, node);
+    *change = tree_change;
+}
+
+/* Reports the selector match cache statistics to the profiler
+ * and resets them.
+ */
+void
+gtk_css_provider_report_match_stats (void)
+{
+  gdk_profiler_set_int_counter (match_hits_counter, match_hits);
+  gdk_profiler_set_int_counter (match_misses_counter, match_misses);
+
+  match_hits = 0;
+  match_misses = 0;
 }
 
 static gboolean
@@ -812,16 +1251,8 @@ gtk_css_provider_finalize (GObject *object)
 {
   GtkCssProvider *css_provider = GTK_CSS_PROVIDER (object);
   GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (css_provider);
-  guint i;
-
-  for (i = 0; i < priv->rulesets->len; i++)
-    gtk_css_ruleset_clear (&g_array_index (priv->rulesets, GtkCssRuleset, i));
 
-  g_array_free (priv->rulesets, TRUE);
-  _gtk_css_selector_tree_free (priv->tree);
-
-  g_hash_table_destroy (priv->symbolic_colors);
-  g_hash_table_destroy (priv->keyframes);
+  gtk_css_stylesheet_unref (priv->sheet);
 
   g_clear_pointer (&priv->source, g_bytes_unref);
   g_clear_object (&priv->source_file);
@@ -981,9 +1412,9 @@ css_provider_commit (GtkCssProvider  *css_provider,
     {
       GtkCssRuleset *new;
 
-      g_array_set_size (priv->rulesets, priv->rulesets->len + 1);
+      g_array_set_size (priv->sheet->rulesets, priv->sheet->rulesets->len + 1);
 
-      new = &g_array_index (priv->rulesets, GtkCssRuleset, priv->rulesets->len - 1);
+      new = &g_array_index (priv->sheet->rulesets, GtkCssRuleset, priv->sheet->rulesets->len - 1);
       gtk_css_ruleset_init_copy (new, ruleset, gtk_css_selectors_get (selectors, i));
     }
 }
@@ -992,7 +1423,6 @@ static void
 gtk_css_provider_reset (GtkCssProvider *css_provider)
 {
   GtkCssProviderPrivate *priv = gtk_css_provider_get_instance_private (css_provider);
-  guint i;
 
   g_clear_pointer (&priv->source, g_bytes_unref);
   g_clear_object (&priv->source_file);
@@ -1005,13 +1435,8 @@ gtk_css_provider_reset (GtkCssProvider *css_provider)
 
   g_clear_pointer (&priv->path, g_free);
 
-  g_hash_table_remove_all (priv->symbolic_colors);
-  g_hash_table_remove_all (priv->keyframes);
-
-  for (i = 0; i < priv->rulesets->len; i++)
-    gtk_css_ruleset_clear (&g_array_index (priv->rulesets, GtkCssRuleset, i));
-  g_array_set_size (priv->rulesets, 0);
-  g_clear_pointer (&priv->tree, _gtk_css_selector_tree_free);
+  gtk_css_stylesheet_unref (priv->sheet);
+  priv->sheet = gtk_css_stylesheet_new ();
 }
 
 static gboolean
@@ -1174,7 +1599,7 @@ parse_color_definition (GtkCssScanner *scanner)
     }
 
   if (gtk_css_scanner_should_commit (scanner))
-    g_hash_table_insert (priv->symbolic_colors, name, color);
+    g_hash_table_insert (priv->sheet->symbolic_colors, name, color);
   else
     {
       gtk_css_value_unref (color);
@@ -1210,7 +1635,7 @@ parse_keyframes (GtkCssScanner *scanner)
   if (keyframes != NULL)
     {
       if (gtk_css_scanner_should_commit (scanner))
-        g_hash_table_insert (priv->keyframes, name, keyframes);
+        g_hash_table_insert (priv->sheet->keyframes, name, keyframes);
       else
         _gtk_css_keyframes_unref (keyframes);
     }
@@ -1571,14 +1996,16 @@ gtk_css_provider_postprocess (GtkCssProvider *css_provider)
 
   before = GDK_PROFILER_CURRENT_TIME;
 
-  g_array_sort (priv->rulesets, gtk_css_provider_compare_rule);
+  g_array_sort (priv->sheet->rulesets, gtk_css_provider_compare_rule);
 
   builder = _gtk_css_selector_tree_builder_new ();
-  for (i = 0; i < priv->rulesets->len; i++)
+  for (i = 0; i < priv->sheet->rulesets->len; i++)
     {
       GtkCssRuleset *ruleset;
 
-      ruleset = &g_array_index (priv->rulesets, GtkCssRuleset, i);
+      ruleset = &g_array_index (priv->sheet->rulesets, GtkCssRuleset, i);
+
+      priv->sheet->change |= _gtk_css_selector_get_change (ruleset->selector);
 
       _gtk_css_selector_tree_builder_add (builder,
 					  ruleset->selector,
@@ -1586,15 +2013,15 @@ gtk_css_provider_postprocess (GtkCssProvider *css_provider)
 					  ruleset);
     }
 
-  priv->tree = _gtk_css_selector_tree_builder_build (builder);
+  priv->sheet->tree = _gtk_css_selector_tree_builder_build (builder);
   _gtk_css_selector_tree_builder_free (builder);
 
 #ifndef VERIFY_TREE
-  for (i = 0; i < priv->rulesets->len; i++)
+  for (i = 0; i < priv->sheet->rulesets->len; i++)
     {
       GtkCssRuleset *ruleset;
 
-      ruleset = &g_array_index (priv->rulesets, GtkCssRuleset, i);
+      ruleset = &g_array_index (priv->sheet->rulesets, GtkCssRuleset, i);
 
       g_clear_pointer (&ruleset->selector, _gtk_css_selector_free);
     }
@@ -1615,6 +2042,38 @@ gtk_css_provider_load_internal (GtkCssProvider *self,
 
   before = GDK_PROFILER_CURRENT_TIME;
 
+  /* Only cache themes loaded from files. Data passed in by the
+   * application may be static bytes that don't outlive the provider.
+   * Imports also turn this off, since the cache key doesn't cover
+   * imported files.
+   */
+  if (parent == NULL && file != NULL)
+    {
+      GtkCssStylesheet *cached;
+
+      cached = gtk_css_stylesheet_cache_lookup (bytes,
+                                                file,
+                                                priv->prefers_color_scheme,
+                                                priv->prefers_contrast,
+                                                priv->prefers_reduced_motion);
+      if (cached)
+        {
+          GTK_DEBUG (CSS, "Reusing parsed stylesheet for %s", g_file_peek_path (file));
+
+          gtk_css_stylesheet_unref (priv->sheet);
+          priv->sheet = cached;
+          /* Sections point to the bytes that were parsed */
+          priv->bytes = cached->bytes;
+
+          gdk_profiler_end_mark (before, "CSS theme load (cached)", NULL);
+          return;
+        }
+
+      priv->cacheable = TRUE;
+    }
+  else
+    priv->cacheable = FALSE;
+
   priv->bytes = bytes;
 
   scanner = gtk_css_scanner_new (self,
@@ -1627,7 +2086,20 @@ gtk_css_provider_load_internal (GtkCssProvider *self,
   gtk_css_scanner_destroy (scanner);
 
   if (parent == NULL)
-    gtk_css_provider_postprocess (self);
+    {
+      gtk_css_provider_postprocess (self);
+
+      if (priv->cacheable)
+        {
+          priv->sheet->bytes = g_bytes_ref (bytes);
+          priv->sheet->file = g_object_ref (file);
+          priv->sheet->prefers_color_scheme = priv->prefers_color_scheme;
+          priv->sheet->prefers_contrast = priv->prefers_contrast;
+          priv->sheet->prefers_reduced_motion = priv->prefers_reduced_motion;
+
+          gtk_css_stylesheet_cache_add (priv->sheet);
+        }
+    }
 
   if (GDK_PROFILER_IS_RUNNING)
     {
@@ -2232,14 +2704,14 @@ gtk_css_provider_to_string (GtkCssProvider *provider)
 
   str = g_string_new ("");
 
-  gtk_css_provider_print_colors (priv->symbolic_colors, str);
-  gtk_css_provider_print_keyframes (priv->keyframes, str);
+  gtk_css_provider_print_colors (priv->sheet->symbolic_colors, str);
+  gtk_css_provider_print_keyframes (priv->sheet->keyframes, str);
 
-  for (i = 0; i < priv->rulesets->len; i++)
+  for (i = 0; i < priv->sheet->rulesets->len; i++)
     {
       if (str->len != 0)
         g_string_append (str, "\n");
-      gtk_css_ruleset_print (&g_array_index (priv->rulesets, GtkCssRuleset, i), str);
+      gtk_css_ruleset_print (&g_array_index (priv->sheet->rulesets, GtkCssRuleset, i), str);
     }
 
   return g_string_free (str, FALSE);
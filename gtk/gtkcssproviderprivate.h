@@ -27,5 +27,10 @@ const char *_gtk_css_provider_get_theme_dir (GtkCssProvider *provider);
 
 void   gtk_css_provider_set_keep_css_sections (void);
 
+void   gtk_css_provider_report_match_stats    (void);
+
+gboolean gtk_css_provider_shares_stylesheet  (GtkCssProvider *provider,
+                                              GtkCssProvider *other);
+
 G_END_DECLS
 
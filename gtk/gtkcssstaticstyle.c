@@ -93,6 +93,8 @@ gtk_css_ ## NAME ## _values_new_compute (GtkCssStaticStyle    *sstyle, \
                                           lookup->values[id].section, \
                                           context); \
     } \
+\
+  style->NAME = (GtkCss ## TYPE ## Values *)gtk_css_values_intern ((GtkCssValues *)style->NAME); \
 } \
 static GtkBitmask * gtk_css_ ## NAME ## _values_mask; \
 static GtkCssValues * gtk_css_ ## NAME ## _initial_values; \
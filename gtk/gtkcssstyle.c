@@ -45,6 +45,8 @@
 #include "gtkstyleproviderprivate.h"
 #include "gtkcssvaluesprivate.h"
 
+#include <string.h>
+
 G_DEFINE_ABSTRACT_TYPE (GtkCssStyle, gtk_css_style, G_TYPE_OBJECT)
 
 static GtkCssSection *
@@ -922,6 +924,44 @@ static const int values_size[] = {
 
 #define GET_VALUES(v) (GtkCssValue **)((guint8 *)(v) + sizeof (GtkCssValues))
 
+/* Groups computed for different nodes are often identical, because
+ * they were computed from the same rulesets. Computed groups are
+ * interned, so that equal groups are shared across the whole widget
+ * tree and style changes can compare them by pointer.
+ *
+ * Values are compared by pointer, which is cheap and catches values
+ * that came from the same declaration or were inherited.
+ */
+static GHashTable *interned_values;
+
+static guint
+gtk_css_values_hash (gconstpointer data)
+{
+  const GtkCssValues *values = data;
+  GtkCssValue **v = GET_VALUES (values);
+  guint hash = values->type;
+
+  for (int i = 0; i < N_VALUES (values->type); i++)
+    hash = (hash << 5) - hash + g_direct_hash (v[i]);
+
+  return hash;
+}
+
+static gboolean
+gtk_css_values_equal (gconstpointer data1,
+                      gconstpointer data2)
+{
+  const GtkCssValues *values1 = data1;
+  const GtkCssValues *values2 = data2;
+
+  if (values1->type != values2->type)
+    return FALSE;
+
+  return memcmp (GET_VALUES (values1),
+                 GET_VALUES (values2),
+                 N_VALUES (values1->type) * sizeof (GtkCssValue *)) == 0;
+}
+
 GtkCssValues *gtk_css_values_ref (GtkCssValues *values)
 {
   values->ref_count++;
@@ -934,6 +974,10 @@ gtk_css_values_free (GtkCssValues *values)
 {
   GtkCssValue **v = GET_VALUES (values);
 
+  if (interned_values &&
+      g_hash_table_lookup (interned_values, values) == values)
+    g_hash_table_remove (interned_values, values);
+
   for (int i = 0; i < N_VALUES (values->type); i++)
     {
       if (v[i])
@@ -986,6 +1030,39 @@ gtk_css_values_new (GtkCssValuesType type)
   return values;
 }
 
+/*
+ * gtk_css_values_intern:
+ * @values: (transfer full): a computed group of values
+ *
+ * Looks for a group that is equal to @values and returns it
+ * instead, so equal groups are only kept once.
+ *
+ * The group must not be modified afterwards. Use
+ * gtk_css_values_copy() to get a group that can be modified.
+ *
+ * Returns: (transfer full): the interned group
+ */
+GtkCssValues *
+gtk_css_values_intern (GtkCssValues *values)
+{
+  GtkCssValues *interned;
+
+  if (interned_values == NULL)
+    interned_values = g_hash_table_new (gtk_css_values_hash, gtk_css_values_equal);
+
+  interned = g_hash_table_lookup (interned_values, values);
+  if (interned)
+    {
+      gtk_css_values_ref (interned);
+      gtk_css_values_unref (values);
+      return interned;
+    }
+
+  g_hash_table_add (interned_values, values);
+
+  return values;
+}
+
 GtkCssVariableValue *
 gtk_css_style_get_custom_property (GtkCssStyle *style,
                                    int          id)
@@ -350,6 +350,7 @@ GtkCssValues *gtk_css_values_new   (GtkCssValuesType  type);
 GtkCssValues *gtk_css_values_ref   (GtkCssValues     *values);
 void          gtk_css_values_unref (GtkCssValues     *values);
 GtkCssValues *gtk_css_values_copy  (GtkCssValues     *values);
+GtkCssValues *gtk_css_values_intern (GtkCssValues    *values);
 
 void gtk_css_core_values_compute_changes_and_affects (GtkCssStyle *style1,
                                                       GtkCssStyle *style2,
@@ -34,6 +34,7 @@
 #include "gtkgesturedrag.h"
 #include "gtkgesturedragprivate.h"
 #include "gtkmarshalers.h"
+#include "gtkmotionpredictorprivate.h"
 #include "gtkprivate.h"
 
 typedef struct _GtkGestureDragPrivate GtkGestureDragPrivate;
@@ -45,6 +46,9 @@ struct _GtkGestureDragPrivate
   double start_y;
   double last_x;
   double last_y;
+
+  /* Only created once predictions are asked for */
+  GtkMotionPredictor *predictor;
 };
 
 enum {
@@ -58,6 +62,16 @@ static guint signals[N_SIGNALS] = { 0 };
 
 G_DEFINE_TYPE_WITH_PRIVATE (GtkGestureDrag, gtk_gesture_drag, GTK_TYPE_GESTURE_SINGLE)
 
+static void
+gtk_gesture_drag_finalize (GObject *object)
+{
+  GtkGestureDragPrivate *priv = gtk_gesture_drag_get_instance_private (GTK_GESTURE_DRAG (object));
+
+  g_clear_pointer (&priv->predictor, gtk_motion_predictor_free);
+
+  G_OBJECT_CLASS (gtk_gesture_drag_parent_class)->finalize (object);
+}
+
 static gboolean
 gtk_gesture_drag_filter_event (GtkEventController *controller,
                                GdkEvent           *event)
@@ -94,6 +108,14 @@ gtk_gesture_drag_begin (GtkGesture       *gesture,
   priv->last_x = priv->start_x;
   priv->last_y = priv->start_y;
 
+  if (priv->predictor)
+    {
+      gtk_motion_predictor_reset (priv->predictor);
+      gtk_motion_predictor_add_event (priv->predictor,
+                                      gtk_gesture_get_last_event (gesture, current),
+                                      priv->start_x, priv->start_y);
+    }
+
   g_signal_emit (gesture, signals[DRAG_BEGIN], 0, priv->start_x, priv->start_y);
 }
 
@@ -109,6 +131,11 @@ gtk_gesture_drag_update (GtkGesture       *gesture,
   x = priv->last_x - priv->start_x;
   y = priv->last_y - priv->start_y;
 
+  if (priv->predictor)
+    gtk_motion_predictor_add_event (priv->predictor,
+                                    gtk_gesture_get_last_event (gesture, sequence),
+                                    priv->last_x, priv->last_y);
+
   g_signal_emit (gesture, signals[DRAG_UPDATE], 0, x, y);
 }
 
@@ -133,9 +160,12 @@ gtk_gesture_drag_end (GtkGesture       *gesture,
 static void
 gtk_gesture_drag_class_init (GtkGestureDragClass *klass)
 {
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
   GtkGestureClass *gesture_class = GTK_GESTURE_CLASS (klass);
   GtkEventControllerClass *event_controller_class = GTK_EVENT_CONTROLLER_CLASS (klass);
 
+  object_class->finalize = gtk_gesture_drag_finalize;
+
   event_controller_class->filter_event = gtk_gesture_drag_filter_event;
 
   gesture_class->begin = gtk_gesture_drag_begin;
@@ -299,3 +329,74 @@ gtk_gesture_drag_get_offset (GtkGestureDrag *gesture,
 
   return TRUE;
 }
+
+/**
+ * gtk_gesture_drag_get_predicted_offset:
+ * @gesture: a `GtkGesture`
+ * @x: (out) (optional): predicted X offset
+ * @y: (out) (optional): predicted Y offset
+ *
+ * Gets the predicted offset from the start point at the time
+ * the next frame is presented.
+ *
+ * The prediction extrapolates the recent movement of the pointer,
+ * including the motion history of compressed events. Using it to
+ * draw what follows the pointer hides some of the input latency,
+ * at the cost of slightly overshooting when the pointer changes
+ * direction.
+ *
+ * Predictions are only tracked once this function has been called,
+ * so the first call returns the same as [method@Gtk.GestureDrag.get_offset].
+ *
+ * If the @gesture is active, this function returns %TRUE and
+ * fills in @x and @y.
+ *
+ * Returns: %TRUE if the gesture is active
+ *
+ * Since: 4.24
+ */
+gboolean
+gtk_gesture_drag_get_predicted_offset (GtkGestureDrag *gesture,
+                                       double         *x,
+                                       double         *y)
+{
+  GtkGestureDragPrivate *priv;
+  GdkEventSequence *sequence;
+  double predicted_x, predicted_y;
+
+  g_return_val_if_fail (GTK_IS_GESTURE_DRAG (gesture), FALSE);
+
+  sequence = gtk_gesture_single_get_current_sequence (GTK_GESTURE_SINGLE (gesture));
+
+  if (!gtk_gesture_handles_sequence (GTK_GESTURE (gesture), sequence))
+    return FALSE;
+
+  priv = gtk_gesture_drag_get_instance_private (gesture);
+
+  if (priv->predictor == NULL)
+    {
+      GdkEvent *event;
+
+      priv->predictor = gtk_motion_predictor_new ();
+
+      event = gtk_gesture_get_last_event (GTK_GESTURE (gesture), sequence);
+      if (event)
+        gtk_motion_predictor_add_event (priv->predictor, event, priv->last_x, priv->last_y);
+    }
+
+  if (!gtk_motion_predictor_predict_for_widget (priv->predictor,
+                                                gtk_event_controller_get_widget (GTK_EVENT_CONTROLLER (gesture)),
+                                                &predicted_x, &predicted_y))
+    {
+      predicted_x = priv->last_x;
+      predicted_y = priv->last_y;
+    }
+
+  if (x)
+    *x = predicted_x - priv->start_x;
+
+  if (y)
+    *y = predicted_y - priv->start_y;
+
+  return TRUE;
+}
@@ -51,6 +51,11 @@ GDK_AVAILABLE_IN_ALL
 gboolean     gtk_gesture_drag_get_offset        (GtkGestureDrag *gesture,
                                                  double         *x,
                                                  double         *y);
+GDK_AVAILABLE_IN_4_24
+gboolean     gtk_gesture_drag_get_predicted_offset
+                                                (GtkGestureDrag *gesture,
+                                                 double         *x,
+                                                 double         *y);
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GtkGestureDrag, g_object_unref)
 
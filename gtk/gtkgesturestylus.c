@@ -32,10 +32,14 @@
 #include "gtkprivate.h"
 #include "gtkmarshalers.h"
 #include "gtkmain.h"
+#include "gtkmotionpredictorprivate.h"
 #include "gtknative.h"
 
 typedef struct {
   gboolean stylus_only;
+
+  /* Only created once predictions are asked for */
+  GtkMotionPredictor *predictor;
 } GtkGestureStylusPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (GtkGestureStylus, gtk_gesture_stylus, GTK_TYPE_GESTURE_SINGLE)
@@ -90,6 +94,16 @@ static void gtk_gesture_stylus_set_property (GObject      *object,
       }
 }
 
+static void
+gtk_gesture_stylus_finalize (GObject *object)
+{
+  GtkGestureStylusPrivate *priv = gtk_gesture_stylus_get_instance_private (GTK_GESTURE_STYLUS (object));
+
+  g_clear_pointer (&priv->predictor, gtk_motion_predictor_free);
+
+  G_OBJECT_CLASS (gtk_gesture_stylus_parent_class)->finalize (object);
+}
+
 static gboolean
 gtk_gesture_stylus_handle_event (GtkEventController *controller,
                                  GdkEvent           *event,
@@ -135,6 +149,15 @@ gtk_gesture_stylus_handle_event (GtkEventController *controller,
       return FALSE;
     }
 
+  if (priv->predictor)
+    {
+      /* Strokes are predicted on their own */
+      if (n_signal == DOWN || n_signal == UP)
+        gtk_motion_predictor_reset (priv->predictor);
+
+      gtk_motion_predictor_add_event (priv->predictor, event, x, y);
+    }
+
   g_signal_emit (controller, signals[n_signal], 0, x, y);
 
   return TRUE;
@@ -149,6 +172,7 @@ gtk_gesture_stylus_class_init (GtkGestureStylusClass *klass)
   object_class = G_OBJECT_CLASS (klass);
   object_class->get_property = gtk_gesture_stylus_get_property;
   object_class->set_property = gtk_gesture_stylus_set_property;
+  object_class->finalize = gtk_gesture_stylus_finalize;
 
   /**
    * GtkGestureStylus:stylus-only:
@@ -489,6 +513,71 @@ gtk_gesture_stylus_get_backlog (GtkGestureStylus  *gesture,
   return TRUE;
 }
 
+/**
+ * gtk_gesture_stylus_get_predicted_position:
+ * @gesture: a `GtkGestureStylus`
+ * @x: (out) (optional): predicted X coordinate
+ * @y: (out) (optional): predicted Y coordinate
+ *
+ * Predicts where the stylus will be when the next frame is presented.
+ *
+ * The prediction extrapolates the recent movement of the stylus,
+ * including the backlog returned by [method@Gtk.GestureStylus.get_backlog].
+ * Drawing the end of a stroke up to the predicted position hides some
+ * of the input latency, but the predicted part should be replaced
+ * by the real positions as they arrive.
+ *
+ * Predictions are only tracked once this function has been called,
+ * so the first call returns the latest position.
+ *
+ * The coordinates are relative to the widget of @gesture.
+ *
+ * Returns: %TRUE if a position was predicted
+ *
+ * Since: 4.24
+ */
+gboolean
+gtk_gesture_stylus_get_predicted_position (GtkGestureStylus *gesture,
+                                           double           *x,
+                                           double           *y)
+{
+  GtkGestureStylusPrivate *priv;
+  double predicted_x, predicted_y;
+
+  g_return_val_if_fail (GTK_IS_GESTURE_STYLUS (gesture), FALSE);
+
+  priv = gtk_gesture_stylus_get_instance_private (gesture);
+
+  if (priv->predictor == NULL)
+    {
+      GdkEvent *event;
+      double event_x, event_y;
+
+      priv->predictor = gtk_motion_predictor_new ();
+
+      /* Start from the current event, if there is one */
+      event = gtk_event_controller_get_current_event (GTK_EVENT_CONTROLLER (gesture));
+      if (event &&
+          gtk_gesture_get_point (GTK_GESTURE (gesture),
+                                 gdk_event_get_event_sequence (event),
+                                 &event_x, &event_y))
+        gtk_motion_predictor_add_event (priv->predictor, event, event_x, event_y);
+    }
+
+  if (!gtk_motion_predictor_predict_for_widget (priv->predictor,
+                                                gtk_event_controller_get_widget (GTK_EVENT_CONTROLLER (gesture)),
+                                                &predicted_x, &predicted_y))
+    return FALSE;
+
+  if (x)
+    *x = predicted_x;
+
+  if (y)
+    *y = predicted_y;
+
+  return TRUE;
+}
+
 /**
  * gtk_gesture_stylus_get_device_tool:
  * @gesture: a `GtkGestureStylus`
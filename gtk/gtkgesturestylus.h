@@ -63,6 +63,11 @@ gboolean          gtk_gesture_stylus_get_backlog (GtkGestureStylus  *gesture,
 GDK_AVAILABLE_IN_ALL
 GdkDeviceTool *   gtk_gesture_stylus_get_device_tool (GtkGestureStylus *gesture);
 
+GDK_AVAILABLE_IN_4_24
+gboolean          gtk_gesture_stylus_get_predicted_position (GtkGestureStylus *gesture,
+                                                             double           *x,
+                                                             double           *y);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GtkGestureStylus, g_object_unref)
 
 G_END_DECLS
@@ -105,6 +105,7 @@ icon_ensure_paintable__locked (GtkIconPaintable *icon,
 {
   gint64 before;
   GError *load_error = NULL;
+  int pixel_size;
 
   icon_cache_mark_used_if_cached (icon);
 
@@ -113,22 +114,27 @@ icon_ensure_paintable__locked (GtkIconPaintable *icon,
 
   before = GDK_PROFILER_CURRENT_TIME;
 
+  /* Big images, like thumbnails or icons that only exist in
+   * big sizes, are decoded at the size they are drawn at.
+   */
+  pixel_size = icon->desired_size * icon->desired_scale;
+  icon->loaded_size = pixel_size;
+
   if (icon->is_resource)
     {
-      icon->paintable = gdk_paintable_new_from_resource (icon->filename);
+      icon->paintable = gdk_paintable_new_from_resource (icon->filename, pixel_size);
     }
   else if (icon->filename)
     {
-      icon->paintable = gdk_paintable_new_from_filename (icon->filename, &load_error);
+      icon->paintable = gdk_paintable_new_from_filename (icon->filename, pixel_size, &load_error);
     }
   else if (icon->loadable)
     {
       GInputStream *stream;
-      int pixel_size = icon->desired_size * icon->desired_scale;
       stream = g_loadable_icon_load (icon->loadable, pixel_size, NULL, NULL, &load_error);
       if (stream)
         {
-          icon->paintable = gdk_paintable_new_from_stream (stream, NULL, &load_error);
+          icon->paintable = gdk_paintable_new_from_stream (stream, pixel_size, NULL, &load_error);
           g_object_unref (stream);
         }
     }
@@ -410,6 +416,24 @@ gtk_icon_paintable_get_property (GObject    *object,
     }
 }
 
+/* A paintable that was decoded at a reduced size has to be
+ * loaded again when it is drawn bigger.
+ */
+static void
+gtk_icon_paintable_check_loaded_size (GtkIconPaintable *icon)
+{
+  g_mutex_lock (&icon->texture_lock);
+
+  if (icon->loaded_size > 0 &&
+      icon->loaded_size < icon->desired_size * icon->desired_scale)
+    {
+      g_clear_object (&icon->paintable);
+      icon->loaded_size = 0;
+    }
+
+  g_mutex_unlock (&icon->texture_lock);
+}
+
 static void
 gtk_icon_paintable_set_property (GObject      *object,
                                  guint         prop_id,
@@ -440,6 +464,7 @@ gtk_icon_paintable_set_property (GObject      *object,
       if (icon->desired_size != g_value_get_int (value))
         {
           icon->desired_size = g_value_get_int (value);
+          gtk_icon_paintable_check_loaded_size (icon);
           g_object_notify_by_pspec (object, pspec);
         }
       break;
@@ -448,6 +473,7 @@ gtk_icon_paintable_set_property (GObject      *object,
       if (icon->desired_scale != g_value_get_int (value))
         {
           icon->desired_scale = g_value_get_int (value);
+          gtk_icon_paintable_check_loaded_size (icon);
           g_object_notify_by_pspec (object, pspec);
         }
       break;
@@ -44,6 +44,8 @@ struct _GtkIconPaintable
   GdkPaintable *paintable;
   double width;
   double height;
+  /* the size the paintable was decoded for, or 0 for the full size */
+  int loaded_size;
 };
 
 GtkIconPaintable *gtk_icon_paintable_new_for_texture (GdkTexture *texture,
@@ -26,6 +26,7 @@
 
 #include "gtkimageprivate.h"
 
+#include "gtkcssstylechangeprivate.h"
 #include "gtkiconhelperprivate.h"
 #include "gtkprivate.h"
 #include "gtksnapshot.h"
@@ -96,6 +97,8 @@ struct _GtkImage
   float baseline_align;
 
   char *filename;
+  /* the size the file was decoded for */
+  int file_size;
   char *resource_path;
 };
 
@@ -284,6 +287,30 @@ gtk_image_class_init (GtkImageClass *class)
   gtk_widget_class_set_accessible_role (widget_class, GTK_ACCESSIBLE_ROLE_IMG);
 }
 
+/* Files are decoded at the size they are drawn at, so that
+ * big images don't keep pixels in memory that are never drawn.
+ */
+static int
+gtk_image_get_file_size (GtkImage *image)
+{
+  return gtk_icon_helper_get_size (image->icon_helper) *
+         gtk_widget_get_scale_factor (GTK_WIDGET (image));
+}
+
+static void
+gtk_image_update_file_size (GtkImage *image)
+{
+  char *filename;
+
+  if (image->filename == NULL ||
+      image->file_size >= gtk_image_get_file_size (image))
+    return;
+
+  filename = g_strdup (image->filename);
+  gtk_image_set_from_file (image, filename);
+  g_free (filename);
+}
+
 static void
 gtk_image_init (GtkImage *image)
 {
@@ -292,6 +319,8 @@ gtk_image_init (GtkImage *image)
   widget_node = gtk_widget_get_css_node (GTK_WIDGET (image));
 
   image->icon_helper = gtk_icon_helper_new (widget_node, GTK_WIDGET (image));
+
+  g_signal_connect_swapped (image, "notify::scale-factor", G_CALLBACK (gtk_image_update_file_size), image);
 }
 
 static void
@@ -587,6 +616,9 @@ gtk_image_new_from_gicon (GIcon *icon)
  *
  * See [ctor@Gtk.Image.new_from_file] for details.
  *
+ * Raster images may be decoded at a reduced size that still
+ * covers the size the image is drawn at.
+ *
  * ::: warning
  *     Note that this function should not be used with untrusted data.
  *     Use a proper image loading framework such as libglycin, which can
@@ -598,6 +630,7 @@ gtk_image_set_from_file (GtkImage    *image,
                          const char *filename)
 {
   GdkPaintable *paintable;
+  int file_size;
 
   g_return_if_fail (GTK_IS_IMAGE (image));
 
@@ -612,7 +645,8 @@ gtk_image_set_from_file (GtkImage    *image,
       return;
     }
 
-  paintable = gdk_paintable_new_from_filename (filename, NULL);
+  file_size = gtk_image_get_file_size (image);
+  paintable = gdk_paintable_new_from_filename (filename, file_size, NULL);
 
   if (paintable == NULL)
     {
@@ -623,6 +657,12 @@ gtk_image_set_from_file (GtkImage    *image,
 
   gtk_image_set_from_paintable (image, paintable);
 
+  /* Only textures are decoded at a reduced size */
+  if (GDK_IS_TEXTURE (paintable))
+    image->file_size = file_size;
+  else
+    image->file_size = G_MAXINT;
+
   g_object_unref (paintable);
 
   image->filename = g_strdup (filename);
@@ -694,7 +734,7 @@ gtk_image_set_from_resource (GtkImage   *image,
     }
   else
     {
-      paintable = gdk_paintable_new_from_resource (resource_path);
+      paintable = gdk_paintable_new_from_resource (resource_path, -1);
     }
 
   if (paintable == NULL)
@@ -1209,6 +1249,10 @@ gtk_image_css_changed (GtkWidget         *widget,
 
   gtk_icon_helper_invalidate_for_change (image->icon_helper, change);
 
+  if (change == NULL ||
+      gtk_css_style_change_affects (change, GTK_CSS_AFFECTS_ICON_SIZE))
+    gtk_image_update_file_size (image);
+
   GTK_WIDGET_CLASS (gtk_image_parent_class)->css_changed (widget, change);
 
   image->baseline_align = 0.0;
@@ -1244,6 +1288,7 @@ gtk_image_set_pixel_size (GtkImage *image,
 
   if (_gtk_icon_helper_set_pixel_size (image->icon_helper, pixel_size))
     {
+      gtk_image_update_file_size (image);
       if (gtk_widget_get_visible (GTK_WIDGET (image)))
         gtk_widget_queue_resize (GTK_WIDGET (image));
       g_object_notify_by_pspec (G_OBJECT (image), image_props[PROP_PIXEL_SIZE]);
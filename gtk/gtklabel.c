@@ -53,6 +53,7 @@
 #include "gtkshortcutcontroller.h"
 #include "gtkshortcuttrigger.h"
 #include "gtksnapshot.h"
+#include "gtktextmeasurecacheprivate.h"
 #include "gtktextutilprivate.h"
 #include "gtktooltip.h"
 #include "gtktypebuiltins.h"
@@ -1351,6 +1352,28 @@ gtk_label_measure (GtkWidget      *widget,
                    int            *natural_baseline)
 {
   GtkLabel *self = GTK_LABEL (widget);
+  GtkTextMeasureKey key;
+  gboolean cacheable;
+
+  gtk_label_ensure_layout (self);
+
+  /* Labels with the same text and style have the same size,
+   * so share the measurement with all of them.
+   */
+  cacheable = gtk_text_measure_key_init (&key,
+                                         self->layout,
+                                         (int[GTK_TEXT_MEASURE_N_PARAMS]) {
+                                           self->width_chars,
+                                           self->max_width_chars,
+                                           self->lines,
+                                           self->wrap | self->wrap_mode << 1 |
+                                           self->natural_wrap_mode << 4 | self->ellipsize << 8
+                                         },
+                                         orientation,
+                                         for_size);
+  if (cacheable &&
+      gtk_text_measure_cache_lookup (&key, minimum, natural, minimum_baseline, natural_baseline))
+    return;
 
   if (for_size > 0)
     for_size *= PANGO_SCALE;
@@ -1368,6 +1391,9 @@ gtk_label_measure (GtkWidget      *widget,
     *minimum_baseline = PANGO_PIXELS_CEIL (*minimum_baseline);
   if (*natural_baseline > 0)
     *natural_baseline = PANGO_PIXELS_CEIL (*natural_baseline);
+
+  if (cacheable)
+    gtk_text_measure_cache_commit (&key, *minimum, *natural, *minimum_baseline, *natural_baseline);
 }
 
 void
@@ -0,0 +1,293 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+#include "gtkmotionpredictorprivate.h"
+
+/*
+ * Predicts where a pointer will be at some point in the near future,
+ * usually the time the next frame is presented.
+ *
+ * The velocity is estimated with a least-squares line fit over the
+ * samples of the last few milliseconds, using the event timestamps,
+ * which are more precise than the time the events arrive at. The
+ * prediction then extrapolates from the latest sample, by the time
+ * between its arrival and the target time.
+ *
+ * A higher order fit would follow curves better, but it overshoots
+ * badly whenever the direction changes, which is worse for drawing
+ * than a bit of lag.
+ */
+
+#define N_SAMPLES 16
+
+/* Only samples this close to the latest one are used for the fit (ms) */
+#define FIT_WINDOW 40
+
+/* Don't extrapolate further than this (µs). If the latest sample is
+ * older than that, the pointer has most likely stopped moving.
+ */
+#define MAX_HORIZON 50000
+
+#define DEFAULT_REFRESH_INTERVAL 16667
+
+typedef struct
+{
+  guint32 time;
+  double x;
+  double y;
+} Sample;
+
+struct _GtkMotionPredictor
+{
+  Sample samples[N_SAMPLES];
+  guint first;
+  guint n_samples;
+
+  /* monotonic time when the latest sample arrived */
+  gint64 arrival_time;
+};
+
+GtkMotionPredictor *
+gtk_motion_predictor_new (void)
+{
+  return g_new0 (GtkMotionPredictor, 1);
+}
+
+void
+gtk_motion_predictor_free (GtkMotionPredictor *self)
+{
+  g_free (self);
+}
+
+void
+gtk_motion_predictor_reset (GtkMotionPredictor *self)
+{
+  self->first = 0;
+  self->n_samples = 0;
+  self->arrival_time = 0;
+}
+
+static inline const Sample *
+get_sample (const GtkMotionPredictor *self,
+            guint                     i)
+{
+  return &self->samples[(self->first + i) % N_SAMPLES];
+}
+
+static inline const Sample *
+get_latest_sample (const GtkMotionPredictor *self)
+{
+  return get_sample (self, self->n_samples - 1);
+}
+
+/* Event times are 32bit milliseconds and may wrap around */
+static inline gint32
+time_diff (guint32 a,
+           guint32 b)
+{
+  return (gint32) (a - b);
+}
+
+void
+gtk_motion_predictor_add_sample (GtkMotionPredictor *self,
+                                 guint32             time,
+                                 double              x,
+                                 double              y,
+                                 gint64              arrival_time)
+{
+  Sample *sample;
+
+  /* Out-of-order samples would only confuse the fit */
+  if (self->n_samples > 0 &&
+      time_diff (time, get_latest_sample (self)->time) < 0)
+    return;
+
+  if (self->n_samples < N_SAMPLES)
+    {
+      sample = &self->samples[(self->first + self->n_samples) % N_SAMPLES];
+      self->n_samples++;
+    }
+  else
+    {
+      sample = &self->samples[self->first];
+      self->first = (self->first + 1) % N_SAMPLES;
+    }
+
+  sample->time = time;
+  sample->x = x;
+  sample->y = y;
+
+  self->arrival_time = arrival_time;
+}
+
+/*
+ * Adds the position of @event, and of the events that were compressed
+ * into its history. @x and @y are the position of @event in the
+ * coordinate system the predictions should be in.
+ */
+void
+gtk_motion_predictor_add_event (GtkMotionPredictor *self,
+                                GdkEvent           *event,
+                                double              x,
+                                double              y)
+{
+  gint64 now = g_get_monotonic_time ();
+
+  if (gdk_event_get_event_type (event) == GDK_MOTION_NOTIFY)
+    {
+      GdkTimeCoord *history;
+      guint i, n_coords;
+
+      history = gdk_event_get_history (event, &n_coords);
+      if (history)
+        {
+          double event_x, event_y;
+
+          /* The history is in surface coordinates, like the event position */
+          gdk_event_get_position (event, &event_x, &event_y);
+
+          for (i = 0; i < n_coords; i++)
+            gtk_motion_predictor_add_sample (self,
+                                             history[i].time,
+                                             history[i].axes[GDK_AXIS_X] - event_x + x,
+                                             history[i].axes[GDK_AXIS_Y] - event_y + y,
+                                             now);
+
+          g_free (history);
+        }
+    }
+
+  gtk_motion_predictor_add_sample (self, gdk_event_get_time (event), x, y, now);
+}
+
+/*
+ * Predicts the position at @target_time, in monotonic time.
+ *
+ * Returns: %FALSE if there are no samples. Otherwise @x and @y are
+ *   set, possibly to the latest position if there is nothing to
+ *   predict from.
+ */
+gboolean
+gtk_motion_predictor_predict (GtkMotionPredictor *self,
+                              gint64              target_time,
+                              double             *x,
+                              double             *y)
+{
+  const Sample *latest;
+  double mean_t, mean_x, mean_y;
+  double stt, stx, sty;
+  gint64 horizon;
+  guint i, first, n;
+
+  if (self->n_samples == 0)
+    return FALSE;
+
+  latest = get_latest_sample (self);
+  *x = latest->x;
+  *y = latest->y;
+
+  horizon = target_time - self->arrival_time;
+  if (horizon <= 0 || horizon > MAX_HORIZON)
+    return TRUE;
+
+  for (first = self->n_samples - 1; first > 0; first--)
+    {
+      if (time_diff (get_sample (self, first - 1)->time, latest->time) < -FIT_WINDOW)
+        break;
+    }
+
+  n = self->n_samples - first;
+  if (n < 3)
+    return TRUE;
+
+  mean_t = mean_x = mean_y = 0;
+  for (i = first; i < self->n_samples; i++)
+    {
+      const Sample *sample = get_sample (self, i);
+
+      mean_t += time_diff (sample->time, latest->time);
+      mean_x += sample->x;
+      mean_y += sample->y;
+    }
+  mean_t /= n;
+  mean_x /= n;
+  mean_y /= n;
+
+  stt = stx = sty = 0;
+  for (i = first; i < self->n_samples; i++)
+    {
+      const Sample *sample = get_sample (self, i);
+      double dt = time_diff (sample->time, latest->time) - mean_t;
+
+      stt += dt * dt;
+      stx += dt * (sample->x - mean_x);
+      sty += dt * (sample->y - mean_y);
+    }
+
+  /* All samples have the same timestamp */
+  if (stt == 0)
+    return TRUE;
+
+  /* The velocity is in pixels per ms, the horizon in µs */
+  *x += stx / stt * horizon / 1000.;
+  *y += sty / stt * horizon / 1000.;
+
+  return TRUE;
+}
+
+/*
+ * Predicts the position at the time the next frame of @widget
+ * will be presented.
+ */
+gboolean
+gtk_motion_predictor_predict_for_widget (GtkMotionPredictor *self,
+                                         GtkWidget          *widget,
+                                         double             *x,
+                                         double             *y)
+{
+  GdkFrameClock *frame_clock;
+  gint64 now, target_time;
+
+  now = g_get_monotonic_time ();
+  frame_clock = gtk_widget_get_frame_clock (widget);
+
+  if (frame_clock)
+    {
+      gint64 frame_time, refresh_interval, presentation_time;
+
+      frame_time = gdk_frame_clock_get_frame_time (frame_clock);
+      gdk_frame_clock_get_refresh_info (frame_clock,
+                                        frame_time,
+                                        &refresh_interval,
+                                        &presentation_time);
+
+      if (refresh_interval <= 0)
+        refresh_interval = DEFAULT_REFRESH_INTERVAL;
+      if (presentation_time == 0)
+        presentation_time = frame_time + refresh_interval;
+
+      if (presentation_time <= now)
+        presentation_time += ((now - presentation_time) / refresh_interval + 1) * refresh_interval;
+
+      target_time = presentation_time;
+    }
+  else
+    target_time = now;
+
+  return gtk_motion_predictor_predict (self, target_time, x, y);
+}
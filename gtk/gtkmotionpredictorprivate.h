@@ -0,0 +1,51 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <gdk/gdk.h>
+#include "gtkwidget.h"
+
+G_BEGIN_DECLS
+
+typedef struct _GtkMotionPredictor GtkMotionPredictor;
+
+GtkMotionPredictor *    gtk_motion_predictor_new                (void);
+void                    gtk_motion_predictor_free               (GtkMotionPredictor *self);
+
+void                    gtk_motion_predictor_reset              (GtkMotionPredictor *self);
+
+void                    gtk_motion_predictor_add_sample         (GtkMotionPredictor *self,
+                                                                 guint32             time,
+                                                                 double              x,
+                                                                 double              y,
+                                                                 gint64              arrival_time);
+void                    gtk_motion_predictor_add_event          (GtkMotionPredictor *self,
+                                                                 GdkEvent           *event,
+                                                                 double              x,
+                                                                 double              y);
+
+gboolean                gtk_motion_predictor_predict            (GtkMotionPredictor *self,
+                                                                 gint64              target_time,
+                                                                 double             *x,
+                                                                 double             *y);
+gboolean                gtk_motion_predictor_predict_for_widget (GtkMotionPredictor *self,
+                                                                 GtkWidget          *widget,
+                                                                 double             *x,
+                                                                 double             *y);
+
+G_END_DECLS
@@ -125,7 +125,19 @@ surface_layout_cb (GdkSurface *surface,
                    int         height,
                    GtkNative  *native)
 {
+  GdkFrameClock *frame_clock;
+  gint64 refresh_interval = 16667;
+
+  /* Give the layout half a frame before we start to postpone
+   * allocating widgets that aren't visible.
+   */
+  frame_clock = gdk_surface_get_frame_clock (surface);
+  if (frame_clock)
+    gdk_frame_clock_get_refresh_info (frame_clock, 0, &refresh_interval, NULL);
+
+  gtk_widget_begin_layout_budget (refresh_interval / 2);
   gtk_native_layout (native, width, height);
+  gtk_widget_end_layout_budget ();
 
   if (gtk_widget_needs_allocate (GTK_WIDGET (native)))
     gtk_native_queue_relayout (native);
@@ -770,6 +770,9 @@ gtk_revealer_init (GtkRevealer *revealer)
   revealer->transition_duration = 250;
   revealer->current_pos = 0.0;
   revealer->target_pos = 0.0;
+
+  /* The child is allocated even while it is concealed */
+  gtk_widget_set_defer_child_allocate (GTK_WIDGET (revealer), TRUE);
 }
 
 /**
@@ -0,0 +1,482 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "gtktextmeasurecacheprivate.h"
+
+#include "gdk/gdkprofilerprivate.h"
+
+#include <pango/pangocairo.h>
+#include <string.h>
+
+/* A cache of text measurements that is shared between widgets.
+ *
+ * Lists and grids often contain many labels with the same text and
+ * style, and each of them would otherwise shape and break its text
+ * on its own. The key contains everything that influences the size
+ * of a PangoLayout, so it does not need to be invalidated when a
+ * widget changes - a changed widget just produces a different key.
+ *
+ * Attributes that only influence rendering, like colors, are not
+ * part of the key, so restyling text does not cause it to be
+ * measured again.
+ *
+ * The size in the opposite orientation is not part of the key
+ * either. Every entry keeps the results for the last few sizes
+ * instead, so resizing a window with wrapped labels replaces
+ * their results instead of filling the cache with them.
+ */
+
+/* Drop everything when the cache gets bigger than this */
+#define MAX_CACHED_MEASUREMENTS 4096
+
+static GHashTable *measurements;
+static guint hits, misses;
+static guint hits_counter, misses_counter;
+
+static gboolean
+attr_affects_rendering_only (PangoAttribute *attr,
+                             gpointer        data)
+{
+  switch ((int) attr->klass->type)
+    {
+    case PANGO_ATTR_FOREGROUND:
+    case PANGO_ATTR_BACKGROUND:
+    case PANGO_ATTR_UNDERLINE_COLOR:
+    case PANGO_ATTR_STRIKETHROUGH_COLOR:
+    case PANGO_ATTR_OVERLINE_COLOR:
+    case PANGO_ATTR_FOREGROUND_ALPHA:
+    case PANGO_ATTR_BACKGROUND_ALPHA:
+      return TRUE;
+
+    default:
+      return FALSE;
+    }
+}
+
+static PangoAttrList *
+copy_size_attributes (PangoAttrList *attrs)
+{
+  PangoAttrList *copy, *removed;
+
+  if (attrs == NULL)
+    return NULL;
+
+  copy = pango_attr_list_copy (attrs);
+  removed = pango_attr_list_filter (copy, attr_affects_rendering_only, NULL);
+  g_clear_pointer (&removed, pango_attr_list_unref);
+
+  return copy;
+}
+
+/* pango_attr_list_filter() is the only way to visit the attributes
+ * of a list without copying them. The callbacks below never filter
+ * anything out, so the list stays unchanged.
+ */
+static gboolean
+hash_size_attribute (PangoAttribute *attr,
+                     gpointer        data)
+{
+  guint *hash = data;
+
+  if (!attr_affects_rendering_only (attr, NULL))
+    *hash = ((*hash * 31 + attr->klass->type) * 31 + attr->start_index) * 31 + attr->end_index;
+
+  return FALSE;
+}
+
+static guint
+size_attributes_hash (PangoAttrList *attrs)
+{
+  guint hash = 0;
+
+  if (attrs)
+    pango_attr_list_filter (attrs, hash_size_attribute, &hash);
+
+  return hash;
+}
+
+static gboolean
+collect_size_attribute (PangoAttribute *attr,
+                        gpointer        data)
+{
+  if (!attr_affects_rendering_only (attr, NULL))
+    g_ptr_array_add (data, attr);
+
+  return FALSE;
+}
+
+/* Compares the attributes that influence the size. The keys
+ * that are looked up still have all attributes of the layout.
+ *
+ * This is only called when everything else about the keys,
+ * including the hash of the attributes, is equal.
+ */
+static gboolean
+size_attributes_equal (PangoAttrList *a,
+                       PangoAttrList *b)
+{
+  GPtrArray *list_a, *list_b;
+  gboolean result;
+  guint i;
+
+  if (a == b)
+    return TRUE;
+
+  list_a = g_ptr_array_new ();
+  list_b = g_ptr_array_new ();
+  if (a)
+    pango_attr_list_filter (a, collect_size_attribute, list_a);
+  if (b)
+    pango_attr_list_filter (b, collect_size_attribute, list_b);
+
+  result = list_a->len == list_b->len;
+  for (i = 0; result && i < list_a->len; i++)
+    {
+      PangoAttribute *attr_a = g_ptr_array_index (list_a, i);
+      PangoAttribute *attr_b = g_ptr_array_index (list_b, i);
+
+      result = attr_a->start_index == attr_b->start_index &&
+               attr_a->end_index == attr_b->end_index &&
+               pango_attribute_equal (attr_a, attr_b);
+    }
+
+  g_ptr_array_unref (list_a);
+  g_ptr_array_unref (list_b);
+
+  return result;
+}
+
+static guint
+font_description_hash (const PangoFontDescription *desc)
+{
+  return desc ? pango_font_description_hash (desc) : 0;
+}
+
+static gboolean
+font_description_equal (const PangoFontDescription *a,
+                        const PangoFontDescription *b)
+{
+  if (a == NULL || b == NULL)
+    return a == b;
+
+  return pango_font_description_equal (a, b);
+}
+
+static gboolean
+font_options_equal (const cairo_font_options_t *a,
+                    const cairo_font_options_t *b)
+{
+  if (a == NULL || b == NULL)
+    return a == b;
+
+  return cairo_font_options_equal (a, b);
+}
+
+/*<private>
+ * gtk_text_measure_key_init:
+ * @key: the key to initialize
+ * @layout: the layout that is measured
+ * @params: values used by the widget that influence the result
+ * @orientation: the orientation that is measured
+ * @for_size: the size in the opposite orientation, or -1
+ *
+ * Initializes a key for looking up the measurement of @layout.
+ *
+ * The key borrows from @layout, so it must not outlive it, and
+ * nothing but the width of @layout may change while it is in use.
+ * The cache copies it in gtk_text_measure_cache_commit().
+ *
+ * The width of @layout is not part of the key, widgets are
+ * expected to set it up from @params and @for_size while
+ * measuring.
+ *
+ * Returns: %FALSE if the layout uses features that make it
+ *   unsuitable for caching
+ */
+gboolean
+gtk_text_measure_key_init (GtkTextMeasureKey *key,
+                           PangoLayout       *layout,
+                           const int          params[GTK_TEXT_MEASURE_N_PARAMS],
+                           GtkOrientation     orientation,
+                           int                for_size)
+{
+  PangoContext *context = pango_layout_get_context (layout);
+  PangoTabArray *tabs;
+  guint hash;
+  int i;
+
+  if (pango_context_get_matrix (context) != NULL)
+    return FALSE;
+
+  tabs = pango_layout_get_tabs (layout);
+  if (tabs != NULL)
+    {
+      pango_tab_array_free (tabs);
+      return FALSE;
+    }
+
+  *key = (GtkTextMeasureKey) {
+    .text = pango_layout_get_text (layout),
+    .attrs = pango_layout_get_attributes (layout),
+    .context_font = pango_context_get_font_description (context),
+    .layout_font = pango_layout_get_font_description (layout),
+    .font_map = pango_context_get_font_map (context),
+    .language = pango_context_get_language (context),
+    .font_options = pango_cairo_context_get_font_options (context),
+    .resolution = pango_cairo_context_get_resolution (context),
+    .base_dir = pango_context_get_base_dir (context),
+    .gravity = pango_context_get_gravity (context),
+    .round_glyph_positions = pango_context_get_round_glyph_positions (context),
+    .wrap = pango_layout_get_wrap (layout),
+    .ellipsize = pango_layout_get_ellipsize (layout),
+    .spacing = pango_layout_get_spacing (layout),
+    .line_spacing = pango_layout_get_line_spacing (layout),
+    .indent = pango_layout_get_indent (layout),
+    .height = pango_layout_get_height (layout),
+    .justify = pango_layout_get_justify (layout),
+    .justify_last_line = pango_layout_get_justify_last_line (layout),
+    .single_paragraph = pango_layout_get_single_paragraph_mode (layout),
+    .auto_dir = pango_layout_get_auto_dir (layout),
+    .orientation = orientation,
+    .for_size = for_size,
+  };
+  memcpy (key->params, params, sizeof (key->params));
+
+  hash = g_str_hash (key->text);
+  hash = hash * 31 + font_description_hash (key->context_font);
+  hash = hash * 31 + font_description_hash (key->layout_font);
+  hash = hash * 31 + size_attributes_hash (key->attrs);
+  for (i = 0; i < GTK_TEXT_MEASURE_N_PARAMS; i++)
+    hash = hash * 31 + key->params[i];
+  hash = hash * 31 + key->orientation;
+  key->hash = hash;
+
+  return TRUE;
+}
+
+static GtkTextMeasureKey *
+gtk_text_measure_key_copy (const GtkTextMeasureKey *key)
+{
+  GtkTextMeasureKey *copy;
+
+  copy = g_memdup2 (key, sizeof (GtkTextMeasureKey));
+
+  copy->text = g_strdup (key->text);
+  copy->attrs = copy_size_attributes (key->attrs);
+  copy->context_font = key->context_font ? pango_font_description_copy (key->context_font) : NULL;
+  copy->layout_font = key->layout_font ? pango_font_description_copy (key->layout_font) : NULL;
+  g_object_ref (copy->font_map);
+  copy->font_options = key->font_options ? cairo_font_options_copy (key->font_options) : NULL;
+
+  return copy;
+}
+
+static void
+gtk_text_measure_key_free (GtkTextMeasureKey *key)
+{
+  g_free ((char *) key->text);
+  g_clear_pointer (&key->attrs, pango_attr_list_unref);
+  g_clear_pointer ((PangoFontDescription **) &key->context_font, pango_font_description_free);
+  g_clear_pointer ((PangoFontDescription **) &key->layout_font, pango_font_description_free);
+  g_object_unref (key->font_map);
+  g_clear_pointer ((cairo_font_options_t **) &key->font_options, cairo_font_options_destroy);
+  g_free (key);
+}
+
+static guint
+gtk_text_measure_key_hash (gconstpointer data)
+{
+  const GtkTextMeasureKey *key = data;
+
+  return key->hash;
+}
+
+static gboolean
+gtk_text_measure_key_equal (gconstpointer data1,
+                            gconstpointer data2)
+{
+  const GtkTextMeasureKey *a = data1;
+  const GtkTextMeasureKey *b = data2;
+
+  if (a->hash != b->hash ||
+      a->orientation != b->orientation ||
+      memcmp (a->params, b->params, sizeof (a->params)) != 0 ||
+      a->font_map != b->font_map ||
+      a->language != b->language ||
+      a->resolution != b->resolution ||
+      a->base_dir != b->base_dir ||
+      a->gravity != b->gravity ||
+      a->round_glyph_positions != b->round_glyph_positions ||
+      a->wrap != b->wrap ||
+      a->ellipsize != b->ellipsize ||
+      a->spacing != b->spacing ||
+      a->line_spacing != b->line_spacing ||
+      a->indent != b->indent ||
+      a->height != b->height ||
+      a->justify != b->justify ||
+      a->justify_last_line != b->justify_last_line ||
+      a->single_paragraph != b->single_paragraph ||
+      a->auto_dir != b->auto_dir)
+    return FALSE;
+
+  if (strcmp (a->text, b->text) != 0)
+    return FALSE;
+
+  if (!font_description_equal (a->context_font, b->context_font) ||
+      !font_description_equal (a->layout_font, b->layout_font) ||
+      !font_options_equal (a->font_options, b->font_options))
+    return FALSE;
+
+  return size_attributes_equal (a->attrs, b->attrs);
+}
+
+static void
+update_profiler_counters (void)
+{
+  if (!GDK_PROFILER_IS_RUNNING)
+    return;
+
+  if (hits_counter == 0)
+    {
+      hits_counter = gdk_profiler_define_int_counter ("text-measure-hits", "Text measurements reused");
+      misses_counter = gdk_profiler_define_int_counter ("text-measure-misses", "Text measurements computed");
+    }
+
+  gdk_profiler_set_int_counter (hits_counter, hits);
+  gdk_profiler_set_int_counter (misses_counter, misses);
+}
+
+gboolean
+gtk_text_measure_cache_lookup (const GtkTextMeasureKey *key,
+                               int                     *minimum,
+                               int                     *natural,
+                               int                     *minimum_baseline,
+                               int                     *natural_baseline)
+{
+  const GtkTextMeasureKey *cached;
+  guint i;
+
+  if (measurements == NULL)
+    return FALSE;
+
+  cached = g_hash_table_lookup (measurements, key);
+  if (cached == NULL)
+    return FALSE;
+
+  for (i = 0; i < cached->n_sizes; i++)
+    {
+      const GtkTextMeasurement *size = &cached->sizes[i];
+
+      if (size->for_size != key->for_size)
+        continue;
+
+      *minimum = size->minimum;
+      *natural = size->natural;
+      *minimum_baseline = size->minimum_baseline;
+      *natural_baseline = size->natural_baseline;
+
+      hits++;
+      update_profiler_counters ();
+
+      return TRUE;
+    }
+
+  return FALSE;
+}
+
+/*<private>
+ * gtk_text_measure_cache_commit:
+ * @key: the key that was looked up
+ * @minimum: the minimum size
+ * @natural: the natural size
+ * @minimum_baseline: the minimum baseline
+ * @natural_baseline: the natural baseline
+ *
+ * Stores a measurement that was not found in the cache.
+ * The cache keeps a copy of @key.
+ *
+ * If the cache has results for too many other sizes
+ * already, the oldest one is replaced.
+ */
+void
+gtk_text_measure_cache_commit (const GtkTextMeasureKey *key,
+                               int                      minimum,
+                               int                      natural,
+                               int                      minimum_baseline,
+                               int                      natural_baseline)
+{
+  GtkTextMeasureKey *cached;
+  GtkTextMeasurement *size;
+
+  if (measurements == NULL)
+    measurements = g_hash_table_new_full (gtk_text_measure_key_hash,
+                                          gtk_text_measure_key_equal,
+                                          (GDestroyNotify) gtk_text_measure_key_free,
+                                          NULL);
+
+  cached = g_hash_table_lookup (measurements, key);
+  if (cached == NULL)
+    {
+      if (g_hash_table_size (measurements) >= MAX_CACHED_MEASUREMENTS)
+        g_hash_table_remove_all (measurements);
+
+      cached = gtk_text_measure_key_copy (key);
+      cached->n_sizes = 0;
+      cached->next_size = 0;
+      g_hash_table_add (measurements, cached);
+    }
+
+  size = &cached->sizes[cached->next_size];
+  size->for_size = key->for_size;
+  size->minimum = minimum;
+  size->natural = natural;
+  size->minimum_baseline = minimum_baseline;
+  size->natural_baseline = natural_baseline;
+
+  cached->next_size = (cached->next_size + 1) % GTK_TEXT_MEASURE_N_SIZES;
+  cached->n_sizes = MIN (cached->n_sizes + 1, GTK_TEXT_MEASURE_N_SIZES);
+
+  misses++;
+  update_profiler_counters ();
+}
+
+/*<private>
+ * gtk_text_measure_cache_clear:
+ *
+ * Drops all measurements, because the fonts they were
+ * computed with may have changed.
+ */
+void
+gtk_text_measure_cache_clear (void)
+{
+  if (measurements)
+    g_hash_table_remove_all (measurements);
+}
+
+/* This is exported privately for use in the testsuite.
+ */
+void
+gtk_text_measure_cache_get_stats (guint *n_hits,
+                                  guint *n_misses,
+                                  guint *n_cached)
+{
+  *n_hits = hits;
+  *n_misses = misses;
+  *n_cached = measurements ? g_hash_table_size (measurements) : 0;
+}
@@ -0,0 +1,107 @@
+/* GTK - The GIMP Toolkit
+ * Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#pragma once
+
+#include <pango/pango.h>
+#include <cairo.h>
+#include <gtk/gtkenums.h>
+
+G_BEGIN_DECLS
+
+/* The number of widget-specific parameters that are part of the key */
+#define GTK_TEXT_MEASURE_N_PARAMS 4
+
+/* The number of sizes in the opposite orientation that are kept per key */
+#define GTK_TEXT_MEASURE_N_SIZES 4
+
+typedef struct _GtkTextMeasureKey GtkTextMeasureKey;
+typedef struct _GtkTextMeasurement GtkTextMeasurement;
+
+struct _GtkTextMeasurement
+{
+  int for_size;
+  int minimum;
+  int natural;
+  int minimum_baseline;
+  int natural_baseline;
+};
+
+/* Keys that are looked up borrow everything from the layout,
+ * so they can live on the stack. Only the keys that are stored
+ * in the cache own copies.
+ */
+struct _GtkTextMeasureKey
+{
+  guint hash;
+
+  const char *text;
+  PangoAttrList *attrs;
+  const PangoFontDescription *context_font;
+  const PangoFontDescription *layout_font;
+  PangoFontMap *font_map;
+  PangoLanguage *language;
+  const cairo_font_options_t *font_options;
+  double resolution;
+  PangoDirection base_dir;
+  PangoGravity gravity;
+  PangoWrapMode wrap;
+  PangoEllipsizeMode ellipsize;
+  int spacing;
+  float line_spacing;
+  int indent;
+  int height;
+  guint round_glyph_positions : 1;
+  guint justify : 1;
+  guint justify_last_line : 1;
+  guint single_paragraph : 1;
+  guint auto_dir : 1;
+
+  int params[GTK_TEXT_MEASURE_N_PARAMS];
+  GtkOrientation orientation;
+  /* Not part of the hash, the cache keeps results for multiple sizes */
+  int for_size;
+
+  /* The cached results, only set in the cache */
+  GtkTextMeasurement sizes[GTK_TEXT_MEASURE_N_SIZES];
+  guint n_sizes;
+  guint next_size;
+};
+
+gboolean                gtk_text_measure_key_init               (GtkTextMeasureKey      *key,
+                                                                 PangoLayout            *layout,
+                                                                 const int               params[GTK_TEXT_MEASURE_N_PARAMS],
+                                                                 GtkOrientation          orientation,
+                                                                 int                     for_size);
+
+gboolean                gtk_text_measure_cache_lookup           (const GtkTextMeasureKey *key,
+                                                                 int                    *minimum,
+                                                                 int                    *natural,
+                                                                 int                    *minimum_baseline,
+                                                                 int                    *natural_baseline);
+void                    gtk_text_measure_cache_commit           (const GtkTextMeasureKey *key,
+                                                                 int                     minimum,
+                                                                 int                     natural,
+                                                                 int                     minimum_baseline,
+                                                                 int                     natural_baseline);
+void                    gtk_text_measure_cache_clear            (void);
+
+void                    gtk_text_measure_cache_get_stats        (guint                  *n_hits,
+                                                                 guint                  *n_misses,
+                                                                 guint                  *n_cached);
+
+G_END_DECLS
@@ -69,12 +69,14 @@
 #include "gtkwindowgroup.h"
 #include "gtkwindowprivate.h"
 #include "gtktestatcontextprivate.h"
+#include "gtktextmeasurecacheprivate.h"
 
 #include "inspector/window.h"
 
 #include "gdk/gdkdisplayprivate.h"
 #include "gdk/gdkeventsprivate.h"
 #include "gdk/gdkmonitorprivate.h"
+#include "gsk/gskdebugnodeprivate.h"
 #include "gsk/gskdebugprivate.h"
 #include "gsk/gskrendererprivate.h"
 
@@ -571,6 +573,7 @@ enum {
   PROP_CSS_CLASSES,
   PROP_LAYOUT_MANAGER,
   PROP_LIMIT_EVENTS,
+  PROP_RENDER_BOUNDARY,
   /* GtkAccessible */
   PROP_ACCESSIBLE_ROLE,
   NUM_PROPERTIES,
@@ -625,6 +628,7 @@ static void             gtk_widget_pop_verify_invariants        (GtkWidget
 #endif
 static PangoContext*    gtk_widget_peek_pango_context           (GtkWidget          *widget);
 static void             gtk_widget_update_default_pango_context (GtkWidget          *widget);
+static void             gtk_widget_set_alloc_needed             (GtkWidget          *widget);
 static void             gtk_widget_propagate_state              (GtkWidget          *widget,
                                                                  const GtkStateData *data);
 static gboolean         gtk_widget_real_mnemonic_activate       (GtkWidget          *widget,
@@ -1061,6 +1065,9 @@ gtk_widget_set_property (GObject      *object,
     case PROP_LIMIT_EVENTS:
       gtk_widget_set_limit_events (widget, g_value_get_boolean (value));
       break;
+    case PROP_RENDER_BOUNDARY:
+      gtk_widget_set_render_boundary (widget, g_value_get_boolean (value));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1197,6 +1204,9 @@ gtk_widget_get_property (GObject    *object,
     case PROP_LIMIT_EVENTS:
       g_value_set_boolean (value, gtk_widget_get_limit_events (widget));
       break;
+    case PROP_RENDER_BOUNDARY:
+      g_value_set_boolean (value, gtk_widget_get_render_boundary (widget));
+      break;
     default:
       G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
       break;
@@ -1690,6 +1700,21 @@ gtk_widget_class_init (GtkWidgetClass *klass)
                             FALSE,
                             G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_EXPLICIT_NOTIFY);
 
+  /**
+   * GtkWidget:render-boundary:
+   *
+   * Whether the renderer may keep the rendering of this widget
+   * around and reuse it in later frames.
+   *
+   * See [method@Gtk.Widget.set_render_boundary].
+   *
+   * Since: 4.24
+   */
+  widget_props[PROP_RENDER_BOUNDARY] =
+      g_param_spec_boolean ("render-boundary", NULL, NULL,
+                            FALSE,
+                            G_PARAM_READWRITE | G_PARAM_STATIC_NAME | G_PARAM_EXPLICIT_NOTIFY);
+
   /* GtkAccessible */
   iface = g_type_default_interface_peek (GTK_TYPE_ACCESSIBLE);
   widget_props[PROP_ACCESSIBLE_ROLE] =
@@ -2994,6 +3019,13 @@ gtk_widget_map (GtkWidget *widget)
       if (!_gtk_widget_get_realized (widget))
         gtk_widget_realize (widget);
 
+      /* We skipped an allocation while we were hidden, catch up now */
+      if (widget->priv->alloc_deferred)
+        {
+          widget->priv->alloc_deferred = FALSE;
+          gtk_widget_set_alloc_needed (widget);
+        }
+
       g_signal_emit (widget, widget_signals[MAP], 0);
 
       update_cursor_on_state_change (widget);
@@ -3679,9 +3711,6 @@ gtk_widget_queue_draw (GtkWidget *widget)
   gtk_widget_pop_verify_invariants (widget);
 }
 
-static void
-gtk_widget_set_alloc_needed (GtkWidget *widget);
-
 /**
  * gtk_widget_queue_allocate:
  * @widget: a widget
@@ -4148,6 +4177,150 @@ gtk_widget_ensure_allocate_on_children (GtkWidget *widget)
     }
 }
 
+/* While the layout phase is running, allocating children that are
+ * hidden by a parent that opted in with
+ * gtk_widget_set_defer_child_allocate() - like the child of a
+ * concealed GtkRevealer - is postponed once the time budget for the
+ * frame is used up. Those allocations are done in an idle afterwards,
+ * or when the widget gets mapped, whichever happens first.
+ */
+static gint64 layout_deadline;
+static GPtrArray *deferred_allocations;
+static guint deferred_allocations_id;
+
+/* How long one run of the idle may spend on deferred allocations */
+#define DEFERRED_ALLOCATION_BUDGET (2 * G_TIME_SPAN_MILLISECOND)
+
+/*<private>
+ * gtk_widget_begin_layout_budget:
+ * @budget: the time the layout phase may take, in microseconds
+ *
+ * Starts the clock for a layout phase. After @budget has passed,
+ * allocation of unmapped children of mapped widgets that allow it
+ * is deferred until gtk_widget_end_layout_budget() is called.
+ */
+void
+gtk_widget_begin_layout_budget (gint64 budget)
+{
+  layout_deadline = g_get_monotonic_time () + budget;
+}
+
+void
+gtk_widget_end_layout_budget (void)
+{
+  layout_deadline = 0;
+}
+
+/*<private>
+ * gtk_widget_set_defer_child_allocate:
+ * @widget: a widget
+ * @defer: whether allocating hidden children may be postponed
+ *
+ * Allows postponing the allocation of children of @widget that
+ * are not mapped while @widget is, when a layout phase runs out
+ * of time.
+ *
+ * Only containers that keep allocating children they hide should
+ * use this.
+ */
+void
+gtk_widget_set_defer_child_allocate (GtkWidget *widget,
+                                     gboolean   defer)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+
+  priv->defer_child_allocate = defer;
+}
+
+static gboolean
+gtk_widget_run_deferred_allocations (gpointer data)
+{
+  gint64 deadline;
+
+  deadline = g_get_monotonic_time () + DEFERRED_ALLOCATION_BUDGET;
+
+  while (deferred_allocations->len > 0)
+    {
+      GtkWidget *widget = g_ptr_array_steal_index (deferred_allocations, deferred_allocations->len - 1);
+      GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+
+      if (priv->alloc_deferred)
+        {
+          priv->alloc_deferred = FALSE;
+
+          /* If a resize got queued in the meantime, the parent
+           * will allocate the widget again in the next layout.
+           */
+          if (priv->parent != NULL && !priv->in_destruction && !priv->resize_queued)
+            {
+              gtk_widget_allocate (widget,
+                                   priv->allocated_width,
+                                   priv->allocated_height,
+                                   priv->allocated_baseline,
+                                   gsk_transform_ref (priv->allocated_transform));
+            }
+        }
+
+      g_object_unref (widget);
+
+      if (g_get_monotonic_time () > deadline)
+        return G_SOURCE_CONTINUE;
+    }
+
+  deferred_allocations_id = 0;
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+gtk_widget_defer_allocate (GtkWidget    *widget,
+                           int           width,
+                           int           height,
+                           int           baseline,
+                           GskTransform *transform)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+
+  if (layout_deadline == 0 ||
+      priv->mapped ||
+      priv->parent == NULL ||
+      !priv->parent->priv->defer_child_allocate ||
+      !_gtk_widget_get_mapped (priv->parent) ||
+      g_get_monotonic_time () < layout_deadline)
+    return FALSE;
+
+  /* Remember what we were asked for, so the allocation can be
+   * done later without involving the parent.
+   */
+  gsk_transform_unref (priv->allocated_transform);
+  priv->allocated_transform = transform;
+  priv->allocated_width = width;
+  priv->allocated_height = height;
+  priv->allocated_baseline = baseline;
+  priv->alloc_needed = TRUE;
+  priv->alloc_needed_on_child = FALSE;
+
+  if (priv->alloc_deferred)
+    return TRUE;
+
+  priv->alloc_deferred = TRUE;
+
+  if (deferred_allocations == NULL)
+    deferred_allocations = g_ptr_array_new ();
+  g_ptr_array_add (deferred_allocations, g_object_ref (widget));
+
+  if (deferred_allocations_id == 0)
+    {
+      deferred_allocations_id = g_idle_add_full (G_PRIORITY_DEFAULT_IDLE,
+                                                 gtk_widget_run_deferred_allocations,
+                                                 NULL, NULL);
+      g_source_set_static_name (g_main_context_find_source_by_id (NULL, deferred_allocations_id),
+                                "[gtk] deferred allocations");
+    }
+
+  return TRUE;
+}
+
 /**
  * gtk_widget_allocate:
  * @widget: a widget
@@ -4196,6 +4369,12 @@ gtk_widget_allocate (GtkWidget    *widget,
       goto out;
     }
 
+  if (gtk_widget_defer_allocate (widget, width, height, baseline, transform))
+    goto out;
+
+  /* This allocation replaces any that is still pending */
+  priv->alloc_deferred = FALSE;
+
 #ifdef G_ENABLE_CONSISTENCY_CHECKS
   {
     SizeRequestCache *cache;
@@ -11226,6 +11405,11 @@ gtk_system_setting_changed (GdkDisplay       *display,
 {
   GList *list, *toplevels;
 
+  if (setting == GTK_SYSTEM_SETTING_DPI ||
+      setting == GTK_SYSTEM_SETTING_FONT_NAME ||
+      setting == GTK_SYSTEM_SETTING_FONT_CONFIG)
+    gtk_text_measure_cache_clear ();
+
   toplevels = gtk_window_list_toplevels ();
   g_list_foreach (toplevels, (GFunc) g_object_ref, NULL);
 
@@ -11664,7 +11848,7 @@ gtk_widget_class_set_template (GtkWidgetClass *widget_class,
       return;
     }
 
-  data = _gtk_buildable_parser_precompile (bytes_data, bytes_size, &error);
+  data = _gtk_buildable_parser_precompile (bytes_data, bytes_size, NULL, &error);
   if (data == NULL)
     {
       g_warning ("Failed to precompile template for class %s: %s", G_OBJECT_CLASS_NAME (widget_class), error->message);
@@ -12150,6 +12334,7 @@ gtk_widget_create_render_node (GtkWidget   *widget,
   double css_opacity, opacity;
   GtkCssStyle *style;
   gboolean has_backdrop_filter;
+  GskRenderNode *node;
 
   style = gtk_css_node_get_style (priv->cssnode);
 
@@ -12239,7 +12424,21 @@ gtk_widget_create_render_node (GtkWidget   *widget,
 
   gtk_snapshot_pop (snapshot); /* debug */
 
-  return gtk_snapshot_pop_collect (snapshot);
+  node = gtk_snapshot_pop_collect (snapshot);
+
+  if (node && priv->render_boundary)
+    {
+      GskRenderNode *cached;
+
+      cached = gsk_debug_node_new_cached (node,
+                                          widget,
+                                          g_strdup_printf ("Render boundary for %s %p",
+                                                           G_OBJECT_TYPE_NAME (widget), widget));
+      gsk_render_node_unref (node);
+      node = cached;
+    }
+
+  return node;
 }
 
 static void
@@ -13606,3 +13805,62 @@ gtk_widget_get_limit_events (GtkWidget *widget)
 
   return priv->limit_events;
 }
+
+/**
+ * gtk_widget_set_render_boundary:
+ * @widget: a `GtkWidget`
+ * @render_boundary: whether the widget is a render boundary
+ *
+ * Sets whether the rendering of the widget may be kept
+ * around and reused in later frames.
+ *
+ * This is useful for complex widgets that rarely change,
+ * but are redrawn often because of what happens around them,
+ * such as a sidebar next to an animation. The rendering is
+ * reused as long as the widget does not queue a redraw, and
+ * it is composited with the transform and opacity of its
+ * surroundings.
+ *
+ * Renderers that can't reuse renderings ignore this.
+ *
+ * Since: 4.24
+ */
+void
+gtk_widget_set_render_boundary (GtkWidget *widget,
+                                gboolean   render_boundary)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+
+  g_return_if_fail (GTK_IS_WIDGET (widget));
+
+  render_boundary = !!render_boundary;
+
+  if (priv->render_boundary == render_boundary)
+    return;
+
+  priv->render_boundary = render_boundary;
+
+  gtk_widget_queue_draw (widget);
+
+  g_object_notify_by_pspec (G_OBJECT (widget), widget_props[PROP_RENDER_BOUNDARY]);
+}
+
+/**
+ * gtk_widget_get_render_boundary:
+ * @widget: a `GtkWidget`
+ *
+ * Gets the value of the [property@Gtk.Widget:render-boundary] property.
+ *
+ * Returns: whether the widget is a render boundary
+ *
+ * Since: 4.24
+ */
+gboolean
+gtk_widget_get_render_boundary (GtkWidget *widget)
+{
+  GtkWidgetPrivate *priv = gtk_widget_get_instance_private (widget);
+
+  g_return_val_if_fail (GTK_IS_WIDGET (widget), FALSE);
+
+  return priv->render_boundary;
+}
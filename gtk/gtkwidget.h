@@ -990,6 +990,12 @@ void                    gtk_widget_set_limit_events             (GtkWidget
 GDK_AVAILABLE_IN_4_18
 gboolean                gtk_widget_get_limit_events             (GtkWidget         *widget);
 
+GDK_AVAILABLE_IN_4_24
+void                    gtk_widget_set_render_boundary          (GtkWidget         *widget,
+                                                                 gboolean           render_boundary);
+GDK_AVAILABLE_IN_4_24
+gboolean                gtk_widget_get_render_boundary          (GtkWidget         *widget);
+
 
 
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(GtkWidget, g_object_unref)
@@ -82,11 +82,14 @@ struct _GtkWidgetPrivate
   guint child_visible         : 1;
   guint can_target            : 1;
   guint limit_events          : 1;
+  guint render_boundary       : 1;
 
   /* Queue-resize related flags */
   guint resize_queued         : 1; /* queue_resize() has been called but no get_preferred_size() yet */
   guint alloc_needed          : 1; /* this widget needs a size_allocate() call */
   guint alloc_needed_on_child : 1; /* 0 or more children - or this widget - need a size_allocate() call */
+  guint alloc_deferred        : 1; /* size_allocate() was postponed because the widget isn't mapped */
+  guint defer_child_allocate  : 1; /* unmapped children may have their size_allocate() postponed */
 
   /* Queue-draw related flags */
   guint draw_needed           : 1;
@@ -228,6 +231,11 @@ gboolean     _gtk_widget_get_alloc_needed   (GtkWidget *widget);
 gboolean     gtk_widget_needs_allocate      (GtkWidget *widget);
 void         gtk_widget_clear_resize_queued (GtkWidget *widget);
 void         gtk_widget_ensure_allocate     (GtkWidget *widget);
+
+void         gtk_widget_begin_layout_budget (gint64     budget);
+void         gtk_widget_end_layout_budget   (void);
+void         gtk_widget_set_defer_child_allocate (GtkWidget *widget,
+                                                  gboolean   defer);
 void          _gtk_widget_scale_changed     (GtkWidget *widget);
 void         gtk_widget_monitor_changed     (GtkWidget *widget);
 
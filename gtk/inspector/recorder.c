@@ -1753,6 +1753,10 @@ G_GNUC_END_IGNORE_DEPRECATIONS
                       profile->total.n_bases, (unsigned long long) profile->total.base_pixels);
         add_text_row (store, "base self", "%zu @ %'llu",
                       profile->self.n_bases, (unsigned long long) profile->self.base_pixels);
+        add_text_row (store, "culled total", "%zu @ %'llu",
+                      profile->total.n_culled, (unsigned long long) profile->total.culled_pixels);
+        add_text_row (store, "culled self", "%zu @ %'llu",
+                      profile->self.n_culled, (unsigned long long) profile->self.culled_pixels);
     }
 }
 
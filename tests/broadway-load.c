@@ -0,0 +1,1244 @@
+/* broadway-load: A headless load test for broadwayd
+ *
+ * This program stands in for the browser side of the Broadway protocol.
+ * It connects to one or more running broadwayd instances over the
+ * websocket, answers the requests that a browser would answer (roundtrips,
+ * configure notifies, grabs), replays a scripted input session and
+ * measures how the server and the application behind it keep up.
+ *
+ * A broadwayd instance only serves a single client at a time, so every
+ * session talks to its own broadwayd: session N connects to --port + N.
+ * A typical setup looks like:
+ *
+ *   for i in 0 1 2 3; do
+ *     broadwayd :$i & GDK_BACKEND=broadway BROADWAY_DISPLAY=:$i gtk4-demo &
+ *   done
+ *   broadway-load --sessions 4 --duration 30 --script session.txt \
+ *                 --pid $(pidof broadwayd | tr ' ' ',')
+ *
+ * The script is a plain text file with one input event per line:
+ *
+ *   # delay-ms  event        arguments
+ *   16          move         100 120
+ *   100         press        1
+ *   50          release      1
+ *   16          scroll       1
+ *   200         key-press    65293
+ *   20          key-release  65293
+ *   1000        screen-size  1280 800 1
+ *
+ * The delay is the time to wait after the previous event, pointer
+ * coordinates are relative to the most recently shown surface, buttons
+ * are numbered like in GDK, scroll directions are 0 for up and 1 for
+ * down, and keys are keysyms. The script is replayed in a loop until
+ * the duration has passed.
+ *
+ * To record a script from a real browser session, run broadwayd with
+ * GDK_DEBUG=broadway-record. It writes the input it receives to
+ * broadway$N-input.txt in the current directory.
+ *
+ * For every session the program reports the number of frames (node
+ * updates) it received, the latency from an input event to the next
+ * frame, and the bytes per frame both on the wire and after
+ * decompression. With --pid, it also reports the CPU time the given
+ * processes used during the run.
+ */
+
+#include "config.h"
+
+#include <gio/gio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <zlib.h>
+
+#include "gdk/broadway/broadway-protocol.h"
+
+typedef enum {
+  SCRIPT_MOVE,
+  SCRIPT_PRESS,
+  SCRIPT_RELEASE,
+  SCRIPT_SCROLL,
+  SCRIPT_KEY_PRESS,
+  SCRIPT_KEY_RELEASE,
+  SCRIPT_SCREEN_SIZE,
+} ScriptOp;
+
+static const struct {
+  const char *name;
+  int n_args;
+} script_ops[] = {
+  [SCRIPT_MOVE] = { "move", 2 },
+  [SCRIPT_PRESS] = { "press", 1 },
+  [SCRIPT_RELEASE] = { "release", 1 },
+  [SCRIPT_SCROLL] = { "scroll", 1 },
+  [SCRIPT_KEY_PRESS] = { "key-press", 1 },
+  [SCRIPT_KEY_RELEASE] = { "key-release", 1 },
+  [SCRIPT_SCREEN_SIZE] = { "screen-size", 3 },
+};
+
+typedef struct {
+  guint delay;
+  ScriptOp op;
+  int args[3];
+} ScriptEvent;
+
+/* Used when no script is given: sweep the pointer across the
+ * surface and click once per sweep.
+ */
+static const char default_script[] =
+  "16 move 10 10\n"
+  "16 move 60 40\n"
+  "16 move 110 70\n"
+  "16 move 160 100\n"
+  "16 move 210 130\n"
+  "16 move 260 160\n"
+  "16 move 310 190\n"
+  "100 press 1\n"
+  "50 release 1\n"
+  "16 move 260 160\n"
+  "16 move 210 130\n"
+  "16 move 160 100\n"
+  "16 move 110 70\n"
+  "16 move 60 40\n"
+  "16 scroll 1\n"
+  "16 scroll 0\n";
+
+typedef struct {
+  int id;
+  int x, y;
+  int width, height;
+  gboolean visible;
+} Surface;
+
+typedef struct {
+  int index;
+  const char *host;
+  guint16 port;
+  gboolean deflate;
+
+  GSocketConnection *connection;
+  GSocket *socket;
+
+  GByteArray *buffer;
+  GByteArray *message;
+  gboolean message_compressed;
+  z_stream *inflate;
+  GByteArray *inflated;
+
+  guint32 last_serial;
+  GHashTable *surfaces;
+  int target;
+  int pointer_x, pointer_y;
+  guint32 state;
+
+  gint64 start_time;
+  gint64 input_time;
+  GArray *latencies;
+
+  guint64 wire_bytes;
+  guint64 payload_bytes;
+  guint64 n_messages;
+  guint64 n_frames;
+  guint64 node_bytes;
+  guint64 n_textures;
+  guint64 texture_bytes;
+  guint64 n_roundtrips;
+  guint64 n_events;
+
+  gboolean closed;
+  char *error;
+} Session;
+
+static char *host = NULL;
+static int port = 8080;
+static int n_sessions = 1;
+static int duration = 10;
+static char *script_file = NULL;
+static char *pids = NULL;
+static gboolean deflate = FALSE;
+static gboolean verbose = FALSE;
+
+static GArray *script;
+
+static gboolean
+parse_script (const char  *contents,
+              GError     **error)
+{
+  char **lines;
+  int i;
+
+  script = g_array_new (FALSE, FALSE, sizeof (ScriptEvent));
+
+  lines = g_strsplit (contents, "\n", 0);
+  for (i = 0; lines[i] != NULL; i++)
+    {
+      const char *line = g_strstrip (lines[i]);
+      ScriptEvent event = { 0, };
+      char name[32];
+      guint op;
+      int n;
+
+      if (line[0] == '\0' || line[0] == '#')
+        continue;
+
+      n = sscanf (line, "%u %31s %d %d %d",
+                  &event.delay, name,
+                  &event.args[0], &event.args[1], &event.args[2]);
+
+      for (op = 0; op < G_N_ELEMENTS (script_ops); op++)
+        {
+          if (n >= 2 && strcmp (name, script_ops[op].name) == 0)
+            break;
+        }
+
+      if (op == G_N_ELEMENTS (script_ops) || n - 2 != script_ops[op].n_args)
+        {
+          g_set_error (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                       "Line %d: Cannot parse \"%s\"", i + 1, line);
+          g_strfreev (lines);
+          return FALSE;
+        }
+
+      event.op = op;
+      g_array_append_val (script, event);
+    }
+
+  g_strfreev (lines);
+
+  if (script->len == 0)
+    {
+      g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_INVALID_DATA,
+                           "The script contains no events");
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+static gboolean
+read_process_cpu (int      pid,
+                  guint64 *ticks)
+{
+  char *path, *contents, *p;
+  char **fields;
+  gboolean result = FALSE;
+
+  path = g_strdup_printf ("/proc/%d/stat", pid);
+  if (!g_file_get_contents (path, &contents, NULL, NULL))
+    {
+      g_free (path);
+      return FALSE;
+    }
+
+  /* The command name may contain spaces, so skip past it.
+   * utime and stime are fields 14 and 15, the state is field 3.
+   */
+  p = strrchr (contents, ')');
+  if (p != NULL)
+    {
+      fields = g_strsplit (p + 2, " ", 0);
+      if (g_strv_length (fields) > 12)
+        {
+          *ticks = g_ascii_strtoull (fields[11], NULL, 10) +
+                   g_ascii_strtoull (fields[12], NULL, 10);
+          result = TRUE;
+        }
+      g_strfreev (fields);
+    }
+
+  g_free (contents);
+  g_free (path);
+
+  return result;
+}
+
+/* {{{ Websocket */
+
+static gboolean
+session_send_frame (Session       *session,
+                    guint8         opcode,
+                    const guint8  *data,
+                    gsize          len)
+{
+  guint8 *frame;
+  gsize p, i;
+  guint32 mask;
+  GError *error = NULL;
+  gboolean result;
+
+  frame = g_malloc (len + 14);
+
+  /* Clients must mask their frames */
+  frame[0] = 0x80 | opcode;
+  if (len < 126)
+    {
+      frame[1] = 0x80 | len;
+      p = 2;
+    }
+  else if (len <= 65535)
+    {
+      frame[1] = 0x80 | 126;
+      frame[2] = len >> 8;
+      frame[3] = len;
+      p = 4;
+    }
+  else
+    {
+      frame[1] = 0x80 | 127;
+      for (i = 0; i < 8; i++)
+        frame[2 + i] = ((guint64) len) >> (56 - 8 * i);
+      p = 10;
+    }
+
+  mask = g_random_int ();
+  memcpy (frame + p, &mask, 4);
+  for (i = 0; i < len; i++)
+    frame[p + 4 + i] = data[i] ^ frame[p + i % 4];
+
+  result = g_output_stream_write_all (g_io_stream_get_output_stream (G_IO_STREAM (session->connection)),
+                                      frame, p + 4 + len, NULL, NULL, &error);
+  if (!result)
+    {
+      session->error = g_strdup (error->message);
+      session->closed = TRUE;
+      g_error_free (error);
+    }
+
+  g_free (frame);
+
+  return result;
+}
+
+static void
+session_send_input (Session  *session,
+                    int       type,
+                    int       n_args,
+                    ...)
+{
+  guint32 msg[16];
+  va_list args;
+  int i;
+
+  g_assert (n_args + 3 <= G_N_ELEMENTS (msg));
+
+  msg[0] = GUINT32_TO_BE (type);
+  msg[1] = GUINT32_TO_BE (session->last_serial);
+  msg[2] = GUINT32_TO_BE (1 + (g_get_monotonic_time () - session->start_time) / 1000);
+
+  va_start (args, n_args);
+  for (i = 0; i < n_args; i++)
+    msg[3 + i] = GUINT32_TO_BE (va_arg (args, int));
+  va_end (args);
+
+  session_send_frame (session, 0x2, (const guint8 *) msg, (n_args + 3) * 4);
+}
+
+static gboolean
+session_connect (Session  *session,
+                 GError  **error)
+{
+  GSocketClient *client;
+  GInputStream *in;
+  GString *response;
+  guint8 nonce[16];
+  char *key, *request;
+  gsize i;
+
+  client = g_socket_client_new ();
+  session->connection = g_socket_client_connect_to_host (client, session->host, session->port, NULL, error);
+  g_object_unref (client);
+  if (session->connection == NULL)
+    return FALSE;
+
+  session->socket = g_socket_connection_get_socket (session->connection);
+  g_socket_set_blocking (session->socket, TRUE);
+
+  for (i = 0; i < sizeof (nonce); i++)
+    nonce[i] = g_random_int_range (0, 256);
+  key = g_base64_encode (nonce, sizeof (nonce));
+
+  request = g_strdup_printf ("GET /socket HTTP/1.1\r\n"
+                             "Host: %s:%u\r\n"
+                             "Upgrade: websocket\r\n"
+                             "Connection: Upgrade\r\n"
+                             "Sec-WebSocket-Key: %s\r\n"
+                             "Sec-WebSocket-Version: 13\r\n"
+                             "Sec-WebSocket-Protocol: broadway\r\n"
+                             "%s"
+                             "\r\n",
+                             session->host, session->port, key,
+                             session->deflate ? "Sec-WebSocket-Extensions: permessage-deflate\r\n" : "");
+  g_free (key);
+
+  if (!g_output_stream_write_all (g_io_stream_get_output_stream (G_IO_STREAM (session->connection)),
+                                  request, strlen (request), NULL, NULL, error))
+    {
+      g_free (request);
+      return FALSE;
+    }
+  g_free (request);
+
+  /* Read the response headers. Anything after them is already
+   * websocket data, so keep it.
+   */
+  in = g_io_stream_get_input_stream (G_IO_STREAM (session->connection));
+  response = g_string_new (NULL);
+  while (strstr (response->str, "\r\n\r\n") == NULL)
+    {
+      char buf[1024];
+      gssize n;
+
+      n = g_input_stream_read (in, buf, sizeof (buf), NULL, error);
+      if (n < 0)
+        {
+          g_string_free (response, TRUE);
+          return FALSE;
+        }
+      if (n == 0)
+        {
+          g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_CONNECTION_CLOSED,
+                               "Connection closed during handshake");
+          g_string_free (response, TRUE);
+          return FALSE;
+        }
+
+      g_string_append_len (response, buf, n);
+    }
+
+  if (!g_str_has_prefix (response->str, "HTTP/1.1 101"))
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                   "Websocket handshake failed: %.*s",
+                   (int) strcspn (response->str, "\r\n"), response->str);
+      g_string_free (response, TRUE);
+      return FALSE;
+    }
+
+  if (session->deflate && strstr (response->str, "permessage-deflate") != NULL)
+    {
+      session->inflate = g_new0 (z_stream, 1);
+      if (inflateInit2 (session->inflate, -MAX_WBITS) != Z_OK)
+        {
+          g_set_error_literal (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                               "Failed to set up decompression");
+          g_clear_pointer (&session->inflate, g_free);
+          g_string_free (response, TRUE);
+          return FALSE;
+        }
+      session->inflated = g_byte_array_new ();
+    }
+
+  i = strstr (response->str, "\r\n\r\n") + 4 - response->str;
+  g_byte_array_append (session->buffer, (guint8 *) response->str + i, response->len - i);
+  session->wire_bytes += response->len - i;
+
+  g_string_free (response, TRUE);
+
+  return TRUE;
+}
+
+static gboolean
+session_inflate (Session      *session,
+                 const guint8 *data,
+                 gsize         len)
+{
+  static const guint8 tail[] = { 0x00, 0x00, 0xff, 0xff };
+  z_stream *zs = session->inflate;
+  guint8 out[16384];
+  int res;
+
+  g_byte_array_set_size (session->inflated, 0);
+
+  for (int i = 0; i < 2; i++)
+    {
+      zs->next_in = (Bytef *) (i == 0 ? data : tail);
+      zs->avail_in = i == 0 ? len : sizeof (tail);
+
+      do
+        {
+          zs->next_out = out;
+          zs->avail_out = sizeof (out);
+
+          res = inflate (zs, Z_SYNC_FLUSH);
+          if (res != Z_OK && res != Z_BUF_ERROR && res != Z_STREAM_END)
+            return FALSE;
+
+          g_byte_array_append (session->inflated, out, sizeof (out) - zs->avail_out);
+        }
+      while (zs->avail_out == 0);
+    }
+
+  return TRUE;
+}
+
+/* }}} */
+/* {{{ Broadway protocol */
+
+static Surface *
+session_get_target (Session *session)
+{
+  return g_hash_table_lookup (session->surfaces, GINT_TO_POINTER (session->target));
+}
+
+static void
+session_pick_target (Session *session)
+{
+  GHashTableIter iter;
+  Surface *surface;
+
+  session->target = -1;
+
+  g_hash_table_iter_init (&iter, session->surfaces);
+  while (g_hash_table_iter_next (&iter, NULL, (gpointer *) &surface))
+    {
+      if (surface->visible)
+        {
+          session->target = surface->id;
+          break;
+        }
+    }
+}
+
+static void
+session_configure_notify (Session *session,
+                          Surface *surface)
+{
+  session_send_input (session, BROADWAY_EVENT_CONFIGURE_NOTIFY, 5,
+                      surface->id, surface->x, surface->y, surface->width, surface->height);
+}
+
+static inline guint16
+get_uint16 (const guint8 *p)
+{
+  return p[0] | (p[1] << 8);
+}
+
+static inline guint32
+get_uint32 (const guint8 *p)
+{
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((guint32) p[3] << 24);
+}
+
+/* Walks through all the commands in one message. This has to know
+ * the size of every command, since the protocol does not encode it.
+ */
+static gboolean
+session_handle_message (Session      *session,
+                        const guint8 *data,
+                        gsize         len)
+{
+  const guint8 *end = data + len;
+  Surface *surface;
+
+  session->n_messages++;
+  session->payload_bytes += len;
+
+#define NEED(n) G_STMT_START { if (end - data < (n)) goto truncated; } G_STMT_END
+
+  while (data < end)
+    {
+      guint8 op;
+
+      NEED (5);
+      op = data[0];
+      session->last_serial = get_uint32 (data + 1);
+      data += 5;
+
+      switch (op)
+        {
+        case BROADWAY_OP_GRAB_POINTER:
+          NEED (3);
+          data += 3;
+          session_send_input (session, BROADWAY_EVENT_GRAB_NOTIFY, 1, 0);
+          break;
+
+        case BROADWAY_OP_UNGRAB_POINTER:
+          session_send_input (session, BROADWAY_EVENT_UNGRAB_NOTIFY, 1, 0);
+          break;
+
+        case BROADWAY_OP_NEW_SURFACE:
+          NEED (10);
+          surface = g_new0 (Surface, 1);
+          surface->id = get_uint16 (data);
+          surface->x = (gint16) get_uint16 (data + 2);
+          surface->y = (gint16) get_uint16 (data + 4);
+          surface->width = get_uint16 (data + 6);
+          surface->height = get_uint16 (data + 8);
+          data += 10;
+          g_hash_table_replace (session->surfaces, GINT_TO_POINTER (surface->id), surface);
+          session_configure_notify (session, surface);
+          break;
+
+        case BROADWAY_OP_SHOW_SURFACE:
+        case BROADWAY_OP_HIDE_SURFACE:
+        case BROADWAY_OP_DESTROY_SURFACE:
+          NEED (2);
+          surface = g_hash_table_lookup (session->surfaces, GINT_TO_POINTER (get_uint16 (data)));
+          data += 2;
+          if (surface == NULL)
+            break;
+          if (op == BROADWAY_OP_SHOW_SURFACE)
+            {
+              surface->visible = TRUE;
+              session->target = surface->id;
+            }
+          else
+            {
+              gboolean was_target = surface->id == session->target;
+
+              if (op == BROADWAY_OP_HIDE_SURFACE)
+                surface->visible = FALSE;
+              else
+                g_hash_table_remove (session->surfaces, GINT_TO_POINTER (surface->id));
+
+              if (was_target)
+                session_pick_target (session);
+            }
+          break;
+
+        case BROADWAY_OP_RAISE_SURFACE:
+        case BROADWAY_OP_LOWER_SURFACE:
+        case BROADWAY_OP_SET_SHOW_KEYBOARD:
+          NEED (2);
+          data += 2;
+          break;
+
+        case BROADWAY_OP_MOVE_RESIZE:
+          {
+            guint8 flags;
+
+            NEED (3);
+            surface = g_hash_table_lookup (session->surfaces, GINT_TO_POINTER (get_uint16 (data)));
+            flags = data[2];
+            data += 3;
+            if (flags & 1)
+              {
+                NEED (4);
+                if (surface)
+                  {
+                    surface->x = (gint16) get_uint16 (data);
+                    surface->y = (gint16) get_uint16 (data + 2);
+                  }
+                data += 4;
+              }
+            if (flags & 2)
+              {
+                NEED (4);
+                if (surface)
+                  {
+                    surface->width = get_uint16 (data);
+                    surface->height = get_uint16 (data + 2);
+                  }
+                data += 4;
+              }
+            if (surface)
+              session_configure_notify (session, surface);
+          }
+          break;
+
+        case BROADWAY_OP_SET_TRANSIENT_FOR:
+          NEED (4);
+          data += 4;
+          break;
+
+        case BROADWAY_OP_DISCONNECTED:
+          session->error = g_strdup ("Another client took over the display");
+          session->closed = TRUE;
+          return FALSE;
+
+        case BROADWAY_OP_UPLOAD_TEXTURE:
+        case BROADWAY_OP_UPLOAD_TEXTURE_DELTA:
+          {
+            gsize size = op == BROADWAY_OP_UPLOAD_TEXTURE ? 8 : 16;
+            guint32 data_len;
+
+            NEED (size);
+            data_len = get_uint32 (data + size - 4);
+            data += size;
+            NEED (data_len);
+            data += data_len;
+            session->n_textures++;
+            session->texture_bytes += data_len;
+          }
+          break;
+
+        case BROADWAY_OP_RELEASE_TEXTURE:
+          NEED (4);
+          data += 4;
+          break;
+
+        case BROADWAY_OP_SET_NODES:
+          {
+            guint32 n_words;
+
+            NEED (6);
+            n_words = get_uint32 (data + 2);
+            data += 6;
+            NEED ((gsize) n_words * 4);
+            data += (gsize) n_words * 4;
+
+            session->n_frames++;
+            session->node_bytes += (gsize) n_words * 4;
+
+            if (session->input_time != 0)
+              {
+                gint64 latency = g_get_monotonic_time () - session->input_time;
+
+                g_array_append_val (session->latencies, latency);
+                session->input_time = 0;
+              }
+          }
+          break;
+
+        case BROADWAY_OP_ROUNDTRIP:
+          NEED (6);
+          session_send_input (session, BROADWAY_EVENT_ROUNDTRIP_NOTIFY, 2,
+                              (int) get_uint16 (data), (int) get_uint32 (data + 2));
+          data += 6;
+          session->n_roundtrips++;
+          break;
+
+        default:
+          session->error = g_strdup_printf ("Unknown command %u", op);
+          session->closed = TRUE;
+          return FALSE;
+        }
+    }
+
+#undef NEED
+
+  return TRUE;
+
+truncated:
+  session->error = g_strdup ("Truncated message");
+  session->closed = TRUE;
+  return FALSE;
+}
+
+/* Splits the received data into websocket frames and handles
+ * complete messages.
+ */
+static void
+session_process_buffer (Session *session)
+{
+  while (session->buffer->len >= 2 && !session->closed)
+    {
+      guint8 *buf = session->buffer->data;
+      gsize len = session->buffer->len;
+      gboolean fin, compressed;
+      guint8 opcode;
+      guint64 payload_len;
+      gsize header_len;
+
+      fin = buf[0] & 0x80;
+      compressed = buf[0] & 0x40;
+      opcode = buf[0] & 0x0f;
+      payload_len = buf[1] & 0x7f;
+      header_len = 2;
+
+      if (payload_len == 126)
+        {
+          if (len < 4)
+            return;
+          payload_len = (buf[2] << 8) | buf[3];
+          header_len = 4;
+        }
+      else if (payload_len == 127)
+        {
+          if (len < 10)
+            return;
+          payload_len = 0;
+          for (int i = 0; i < 8; i++)
+            payload_len = (payload_len << 8) | buf[2 + i];
+          header_len = 10;
+        }
+
+      if (len < header_len + payload_len)
+        return;
+
+      switch (opcode)
+        {
+        case 0x0: /* continuation */
+        case 0x1: /* text */
+        case 0x2: /* binary */
+          if (opcode != 0x0)
+            {
+              g_byte_array_set_size (session->message, 0);
+              session->message_compressed = compressed;
+            }
+          g_byte_array_append (session->message, buf + header_len, payload_len);
+          if (fin)
+            {
+              const guint8 *message = session->message->data;
+              gsize message_len = session->message->len;
+
+              if (session->message_compressed)
+                {
+                  if (session->inflate == NULL ||
+                      !session_inflate (session, message, message_len))
+                    {
+                      session->error = g_strdup ("Failed to decompress message");
+                      session->closed = TRUE;
+                      return;
+                    }
+                  message = session->inflated->data;
+                  message_len = session->inflated->len;
+                }
+
+              session_handle_message (session, message, message_len);
+            }
+          break;
+
+        case 0x8: /* close */
+          session->closed = TRUE;
+          break;
+
+        case 0x9: /* ping */
+          session_send_frame (session, 0xa, buf + header_len, payload_len);
+          break;
+
+        default:
+          break;
+        }
+
+      g_byte_array_remove_range (session->buffer, 0, header_len + payload_len);
+    }
+}
+
+static gboolean
+session_receive (Session  *session,
+                 gint64    timeout)
+{
+  GError *error = NULL;
+  guint8 buf[65536];
+  gssize n;
+
+  if (!g_socket_condition_timed_wait (session->socket, G_IO_IN, timeout, NULL, &error))
+    {
+      if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_TIMED_OUT))
+        {
+          g_error_free (error);
+          return TRUE;
+        }
+
+      session->error = g_strdup (error->message);
+      session->closed = TRUE;
+      g_error_free (error);
+      return FALSE;
+    }
+
+  n = g_socket_receive (session->socket, (char *) buf, sizeof (buf), NULL, &error);
+  if (n <= 0)
+    {
+      if (n < 0)
+        {
+          session->error = g_strdup (error->message);
+          g_error_free (error);
+        }
+      session->closed = TRUE;
+      return FALSE;
+    }
+
+  session->wire_bytes += n;
+  g_byte_array_append (session->buffer, buf, n);
+  session_process_buffer (session);
+
+  return !session->closed;
+}
+
+/* }}} */
+/* {{{ Script replay */
+
+static void
+session_send_pointer (Session *session,
+                      int      type,
+                      int      extra)
+{
+  Surface *surface = session_get_target (session);
+  int id, x, y;
+
+  if (surface)
+    {
+      id = surface->id;
+      x = surface->x;
+      y = surface->y;
+    }
+  else
+    {
+      id = 0;
+      x = y = 0;
+    }
+
+  /* Pointer motion is the only pointer event without an extra argument */
+  session_send_input (session, type, type == BROADWAY_EVENT_POINTER_MOVE ? 7 : 8,
+                      id, id,
+                      x + session->pointer_x, y + session->pointer_y,
+                      session->pointer_x, session->pointer_y,
+                      session->state,
+                      extra);
+}
+
+static void
+session_replay (Session           *session,
+                const ScriptEvent *event)
+{
+  switch (event->op)
+    {
+    case SCRIPT_MOVE:
+      session->pointer_x = event->args[0];
+      session->pointer_y = event->args[1];
+      session_send_pointer (session, BROADWAY_EVENT_POINTER_MOVE, 0);
+      break;
+
+    case SCRIPT_PRESS:
+      session_send_pointer (session, BROADWAY_EVENT_BUTTON_PRESS, event->args[0]);
+      session->state |= 1 << (7 + event->args[0]);
+      break;
+
+    case SCRIPT_RELEASE:
+      session->state &= ~(1 << (7 + event->args[0]));
+      session_send_pointer (session, BROADWAY_EVENT_BUTTON_RELEASE, event->args[0]);
+      break;
+
+    case SCRIPT_SCROLL:
+      session_send_pointer (session, BROADWAY_EVENT_SCROLL, event->args[0]);
+      break;
+
+    case SCRIPT_KEY_PRESS:
+      session_send_input (session, BROADWAY_EVENT_KEY_PRESS, 2, event->args[0], session->state);
+      break;
+
+    case SCRIPT_KEY_RELEASE:
+      session_send_input (session, BROADWAY_EVENT_KEY_RELEASE, 2, event->args[0], session->state);
+      break;
+
+    case SCRIPT_SCREEN_SIZE:
+      session_send_input (session, BROADWAY_EVENT_SCREEN_SIZE_CHANGED, 3,
+                          event->args[0], event->args[1], event->args[2]);
+      break;
+
+    default:
+      g_assert_not_reached ();
+    }
+
+  session->n_events++;
+
+  /* Latency is measured from the first input event after a frame */
+  if (session->input_time == 0)
+    session->input_time = g_get_monotonic_time ();
+}
+
+static gpointer
+session_run (gpointer data)
+{
+  Session *session = data;
+  GError *error = NULL;
+  gint64 end_time, next_time;
+  guint pos;
+
+  if (!session_connect (session, &error))
+    {
+      session->error = g_strdup (error->message);
+      g_error_free (error);
+      return NULL;
+    }
+
+  session->start_time = g_get_monotonic_time ();
+
+  session_send_input (session, BROADWAY_EVENT_SCREEN_SIZE_CHANGED, 3, 1920, 1080, 1);
+  session_process_buffer (session);
+
+  /* Give the application some time to show a surface, input
+   * without a surface to go to is not very interesting.
+   */
+  end_time = session->start_time + 10 * G_USEC_PER_SEC;
+  while (!session->closed && session->target < 0 && g_get_monotonic_time () < end_time)
+    session_receive (session, 100);
+
+  if (session->closed)
+    return NULL;
+
+  if (session->target < 0)
+    g_printerr ("Session %d: No surface shown, sending input anyway\n", session->index);
+
+  /* Only count what happens during the replay */
+  session->n_frames = 0;
+  session->node_bytes = 0;
+  session->n_textures = 0;
+  session->texture_bytes = 0;
+  session->n_messages = 0;
+  session->payload_bytes = 0;
+  session->wire_bytes = 0;
+  session->input_time = 0;
+
+  session->start_time = g_get_monotonic_time ();
+  end_time = session->start_time + duration * G_USEC_PER_SEC;
+  next_time = session->start_time;
+  pos = 0;
+
+  while (!session->closed)
+    {
+      gint64 now = g_get_monotonic_time ();
+
+      if (now >= end_time)
+        break;
+
+      if (now >= next_time)
+        {
+          const ScriptEvent *event = &g_array_index (script, ScriptEvent, pos);
+
+          session_replay (session, event);
+          pos = (pos + 1) % script->len;
+          next_time += g_array_index (script, ScriptEvent, pos).delay * 1000;
+          continue;
+        }
+
+      session_receive (session, (MIN (next_time, end_time) - now + 999) / 1000);
+    }
+
+  return NULL;
+}
+
+/* }}} */
+/* {{{ Reporting */
+
+static int
+compare_latency (gconstpointer a,
+                 gconstpointer b)
+{
+  gint64 la = *(const gint64 *) a;
+  gint64 lb = *(const gint64 *) b;
+
+  return la < lb ? -1 : la > lb;
+}
+
+static void
+print_stats (const char *name,
+             GArray     *latencies,
+             guint64     n_frames,
+             guint64     n_events,
+             guint64     wire_bytes,
+             guint64     payload_bytes,
+             guint64     texture_bytes,
+             double      seconds)
+{
+  double sum = 0;
+  guint i;
+
+  g_array_sort (latencies, compare_latency);
+  for (i = 0; i < latencies->len; i++)
+    sum += g_array_index (latencies, gint64, i);
+
+  g_print ("%-10s %7" G_GUINT64_FORMAT " frames (%5.1f fps), %7" G_GUINT64_FORMAT " events\n",
+           name, n_frames, n_frames / seconds, n_events);
+
+  if (latencies->len > 0)
+    g_print ("%-10s latency avg %.2f ms, median %.2f ms, 95%% %.2f ms, max %.2f ms\n",
+             "",
+             sum / latencies->len / 1000.,
+             g_array_index (latencies, gint64, latencies->len / 2) / 1000.,
+             g_array_index (latencies, gint64, latencies->len * 95 / 100) / 1000.,
+             g_array_index (latencies, gint64, latencies->len - 1) / 1000.);
+
+  if (n_frames > 0)
+    g_print ("%-10s %.0f bytes/frame on the wire, %.0f bytes/frame uncompressed, %.0f texture bytes/frame\n",
+             "",
+             (double) wire_bytes / n_frames,
+             (double) payload_bytes / n_frames,
+             (double) texture_bytes / n_frames);
+}
+
+/* }}} */
+
+static GOptionEntry options[] = {
+  { "host", 0, 0, G_OPTION_ARG_STRING, &host, "Host to connect to", "HOST" },
+  { "port", 'p', 0, G_OPTION_ARG_INT, &port, "Port of the first broadwayd", "PORT" },
+  { "sessions", 'n', 0, G_OPTION_ARG_INT, &n_sessions, "Number of sessions, on consecutive ports", "N" },
+  { "duration", 'd', 0, G_OPTION_ARG_INT, &duration, "Duration of the run", "SECONDS" },
+  { "script", 's', 0, G_OPTION_ARG_FILENAME, &script_file, "Input script to replay", "FILE" },
+  { "pid", 0, 0, G_OPTION_ARG_STRING, &pids, "Report CPU usage of these processes", "PID,…" },
+  { "deflate", 0, 0, G_OPTION_ARG_NONE, &deflate, "Ask for compressed messages", NULL },
+  { "verbose", 'v', 0, G_OPTION_ARG_NONE, &verbose, "Report every session", NULL },
+  { NULL, }
+};
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  Session *sessions;
+  GThread **threads;
+  char **pid_list = NULL;
+  guint64 *cpu_before = NULL;
+  gint64 start, elapsed;
+  GArray *all_latencies;
+  guint64 n_frames, n_events, wire_bytes, payload_bytes, texture_bytes;
+  int n_failed;
+  int i;
+
+  context = g_option_context_new ("");
+  g_option_context_add_main_entries (context, options, NULL);
+  g_option_context_set_summary (context, "Replay input against broadwayd and measure the response.");
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return 1;
+    }
+  g_option_context_free (context);
+
+  if (n_sessions < 1 || duration < 1 || port < 1 || port + n_sessions > 65536)
+    {
+      g_printerr ("Invalid arguments\n");
+      return 1;
+    }
+
+  if (script_file)
+    {
+      char *contents;
+
+      if (!g_file_get_contents (script_file, &contents, NULL, &error))
+        {
+          g_printerr ("%s\n", error->message);
+          return 1;
+        }
+      if (!parse_script (contents, &error))
+        {
+          g_printerr ("%s: %s\n", script_file, error->message);
+          return 1;
+        }
+      g_free (contents);
+    }
+  else
+    {
+      parse_script (default_script, NULL);
+    }
+
+  if (pids)
+    {
+      pid_list = g_strsplit (pids, ",", 0);
+      cpu_before = g_new0 (guint64, g_strv_length (pid_list));
+      for (i = 0; pid_list[i]; i++)
+        {
+          if (!read_process_cpu (atoi (pid_list[i]), &cpu_before[i]))
+            g_printerr ("Cannot read CPU usage of process %s\n", pid_list[i]);
+        }
+    }
+
+  sessions = g_new0 (Session, n_sessions);
+  threads = g_new0 (GThread *, n_sessions);
+
+  start = g_get_monotonic_time ();
+
+  for (i = 0; i < n_sessions; i++)
+    {
+      Session *session = &sessions[i];
+      char *name;
+
+      session->index = i;
+      session->host = host ? host : "localhost";
+      session->port = port + i;
+      session->deflate = deflate;
+      session->buffer = g_byte_array_new ();
+      session->message = g_byte_array_new ();
+      session->surfaces = g_hash_table_new_full (NULL, NULL, NULL, g_free);
+      session->target = -1;
+      session->latencies = g_array_new (FALSE, FALSE, sizeof (gint64));
+
+      name = g_strdup_printf ("session-%d", i);
+      threads[i] = g_thread_new (name, session_run, session);
+      g_free (name);
+    }
+
+  for (i = 0; i < n_sessions; i++)
+    g_thread_join (threads[i]);
+
+  elapsed = g_get_monotonic_time () - start;
+
+  all_latencies = g_array_new (FALSE, FALSE, sizeof (gint64));
+  n_frames = n_events = wire_bytes = payload_bytes = texture_bytes = 0;
+  n_failed = 0;
+
+  for (i = 0; i < n_sessions; i++)
+    {
+      Session *session = &sessions[i];
+
+      if (session->error)
+        {
+          g_printerr ("Session %d (port %u): %s\n", i, session->port, session->error);
+          n_failed++;
+        }
+
+      if (verbose)
+        {
+          char *name = g_strdup_printf ("#%d", i);
+          GArray *latencies = g_array_copy (session->latencies);
+
+          print_stats (name, latencies,
+                       session->n_frames, session->n_events,
+                       session->wire_bytes, session->payload_bytes, session->texture_bytes,
+                       duration);
+          g_array_unref (latencies);
+          g_free (name);
+        }
+
+      g_array_append_vals (all_latencies, session->latencies->data, session->latencies->len);
+      n_frames += session->n_frames;
+      n_events += session->n_events;
+      wire_bytes += session->wire_bytes;
+      payload_bytes += session->payload_bytes;
+      texture_bytes += session->texture_bytes;
+    }
+
+  print_stats ("total", all_latencies,
+               n_frames, n_events, wire_bytes, payload_bytes, texture_bytes,
+               duration);
+
+  if (pid_list)
+    {
+      double ticks_per_second = sysconf (_SC_CLK_TCK);
+
+      for (i = 0; pid_list[i]; i++)
+        {
+          guint64 cpu_after;
+
+          if (!read_process_cpu (atoi (pid_list[i]), &cpu_after))
+            continue;
+
+          g_print ("process %s: %.1f%% CPU\n",
+                   pid_list[i],
+                   100. * (cpu_after - cpu_before[i]) / ticks_per_second / (elapsed / (double) G_USEC_PER_SEC));
+        }
+    }
+
+  for (i = 0; i < n_sessions; i++)
+    {
+      Session *session = &sessions[i];
+
+      g_clear_object (&session->connection);
+      g_byte_array_unref (session->buffer);
+      g_byte_array_unref (session->message);
+      if (session->inflate)
+        {
+          inflateEnd (session->inflate);
+          g_free (session->inflate);
+          g_byte_array_unref (session->inflated);
+        }
+      g_hash_table_unref (session->surfaces);
+      g_array_unref (session->latencies);
+      g_free (session->error);
+    }
+
+  g_array_unref (all_latencies);
+  g_strfreev (pid_list);
+  g_free (cpu_before);
+  g_free (sessions);
+  g_free (threads);
+  g_array_unref (script);
+
+  return n_failed > 0 ? 1 : 0;
+}
+
+/* vim:set foldmethod=marker expandtab: */
@@ -0,0 +1,301 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+#include "gtk/gtkcssproviderprivate.h"
+
+static char *
+write_css (const char *dir,
+           const char *name,
+           const char *contents)
+{
+  GError *error = NULL;
+  char *path;
+
+  path = g_build_filename (dir, name, NULL);
+  g_file_set_contents (path, contents, -1, &error);
+  g_assert_no_error (error);
+
+  return path;
+}
+
+static void
+count_error (GtkCssProvider *provider,
+             GtkCssSection  *section,
+             const GError   *error,
+             gpointer        data)
+{
+  guint *n_errors = data;
+
+  (*n_errors)++;
+}
+
+static GtkCssProvider *
+load_css (const char *path,
+          guint      *n_errors)
+{
+  GtkCssProvider *provider;
+
+  provider = gtk_css_provider_new ();
+  if (n_errors)
+    g_signal_connect (provider, "parsing-error", G_CALLBACK (count_error), n_errors);
+  gtk_css_provider_load_from_path (provider, path);
+
+  return provider;
+}
+
+static void
+test_stylesheet_reuse (void)
+{
+  GtkCssProvider *p1, *p2, *p3;
+  char *dir, *path;
+
+  dir = g_dir_make_tmp ("cssproviderXXXXXX", NULL);
+  path = write_css (dir, "reuse.css", "label { color: red; }");
+
+  p1 = load_css (path, NULL);
+  p2 = load_css (path, NULL);
+  g_assert_true (gtk_css_provider_shares_stylesheet (p1, p2));
+
+  /* Reloading the same provider keeps using the same sheet */
+  gtk_css_provider_load_from_path (p1, path);
+  g_assert_true (gtk_css_provider_shares_stylesheet (p1, p2));
+
+  /* A changed file is parsed again */
+  g_free (write_css (dir, "reuse.css", "label { color: blue; }"));
+  p3 = load_css (path, NULL);
+  g_assert_false (gtk_css_provider_shares_stylesheet (p1, p3));
+
+  g_object_unref (p1);
+  g_object_unref (p2);
+  g_object_unref (p3);
+  g_unlink (path);
+  g_rmdir (dir);
+  g_free (path);
+  g_free (dir);
+}
+
+static void
+test_stylesheet_media_features (void)
+{
+  GtkCssProvider *p1, *p2;
+  char *dir, *path;
+
+  dir = g_dir_make_tmp ("cssproviderXXXXXX", NULL);
+  path = write_css (dir, "media.css",
+                    "label { color: red; }\n"
+                    "@media (prefers-color-scheme: dark) { label { color: blue; } }");
+
+  p1 = load_css (path, NULL);
+  p2 = load_css (path, NULL);
+  g_assert_true (gtk_css_provider_shares_stylesheet (p1, p2));
+
+  g_object_set (p2, "prefers-color-scheme", GTK_INTERFACE_COLOR_SCHEME_DARK, NULL);
+  g_assert_false (gtk_css_provider_shares_stylesheet (p1, p2));
+
+  g_object_set (p1, "prefers-contrast", GTK_INTERFACE_CONTRAST_MORE, NULL);
+  g_object_set (p1, "prefers-color-scheme", GTK_INTERFACE_COLOR_SCHEME_DARK, NULL);
+  g_assert_false (gtk_css_provider_shares_stylesheet (p1, p2));
+
+  g_object_set (p1, "prefers-contrast", GTK_INTERFACE_CONTRAST_NO_PREFERENCE, NULL);
+  g_assert_true (gtk_css_provider_shares_stylesheet (p1, p2));
+
+  g_object_set (p2, "prefers-reduced-motion", GTK_REDUCED_MOTION_REDUCE, NULL);
+  g_assert_false (gtk_css_provider_shares_stylesheet (p1, p2));
+
+  g_object_unref (p1);
+  g_object_unref (p2);
+  g_unlink (path);
+  g_rmdir (dir);
+  g_free (path);
+  g_free (dir);
+}
+
+static void
+test_stylesheet_errors (void)
+{
+  GtkCssProvider *p1, *p2;
+  guint n_errors1 = 0, n_errors2 = 0;
+  char *dir, *path;
+
+  dir = g_dir_make_tmp ("cssproviderXXXXXX", NULL);
+  path = write_css (dir, "errors.css", "label { nonsense-property: 1; }");
+
+  p1 = load_css (path, &n_errors1);
+  g_assert_cmpuint (n_errors1, >, 0);
+
+  p2 = load_css (path, &n_errors2);
+  g_assert_cmpuint (n_errors2, ==, n_errors1);
+  g_assert_false (gtk_css_provider_shares_stylesheet (p1, p2));
+
+  n_errors1 = 0;
+  gtk_css_provider_load_from_path (p1, path);
+  g_assert_cmpuint (n_errors1, ==, n_errors2);
+
+  g_object_unref (p1);
+  g_object_unref (p2);
+  g_unlink (path);
+  g_rmdir (dir);
+  g_free (path);
+  g_free (dir);
+}
+
+static void
+test_stylesheet_import (void)
+{
+  GtkCssProvider *p1, *p2;
+  guint n_errors1 = 0, n_errors2 = 0;
+  char *dir, *path, *imported;
+
+  dir = g_dir_make_tmp ("cssproviderXXXXXX", NULL);
+  imported = write_css (dir, "imported.css", "label { nonsense-property: 1; }");
+  path = write_css (dir, "import.css",
+                    "@import url(\"imported.css\");\n"
+                    "label { background-color: red; }");
+
+  p1 = load_css (path, &n_errors1);
+  g_assert_cmpuint (n_errors1, >, 0);
+
+  p2 = load_css (path, &n_errors2);
+  g_assert_cmpuint (n_errors2, ==, n_errors1);
+  g_assert_false (gtk_css_provider_shares_stylesheet (p1, p2));
+
+  /* The imported file is not part of the cache key, so a fixed
+   * import must be picked up even though the main file is unchanged.
+   */
+  g_free (write_css (dir, "imported.css", "label { color: blue; }"));
+  n_errors1 = 0;
+  gtk_css_provider_load_from_path (p1, path);
+  g_assert_cmpuint (n_errors1, ==, 0);
+
+  g_object_unref (p1);
+  g_object_unref (p2);
+  g_unlink (imported);
+  g_unlink (path);
+  g_rmdir (dir);
+  g_free (imported);
+  g_free (path);
+  g_free (dir);
+}
+
+/* Appends a chain of @depth boxes below @root and returns
+ * the label at its bottom.
+ */
+static GtkWidget *
+make_chain (GtkWidget *root,
+            guint      depth)
+{
+  GtkWidget *widget, *child;
+
+  widget = root;
+  for (guint i = 0; i < depth; i++)
+    {
+      child = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
+      gtk_box_append (GTK_BOX (widget), child);
+      widget = child;
+    }
+
+  child = gtk_label_new ("");
+  gtk_box_append (GTK_BOX (widget), child);
+
+  return child;
+}
+
+static GtkWidget *
+make_root (const char *css_class)
+{
+  GtkWidget *root;
+
+  root = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
+  gtk_widget_add_css_class (root, css_class);
+
+  return g_object_ref_sink (root);
+}
+
+static gboolean
+has_color (GtkWidget  *widget,
+           const char *expected)
+{
+  GdkRGBA color, expected_color;
+
+  gtk_widget_get_color (widget, &color);
+  g_assert_true (gdk_rgba_parse (&expected_color, expected));
+
+  return gdk_rgba_equal (&color, &expected_color);
+}
+
+static void
+test_match_deep (void)
+{
+  GtkCssProvider *provider;
+  guint depths[] = { 1, 8, 16, 24, 30, 40 };
+
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_string (provider,
+                                     ".a label { color: rgb(255,0,0); }\n"
+                                     ".b label { color: rgb(0,0,255); }\n"
+                                     ".pos > box:last-child label { color: rgb(0,255,0); }");
+  gtk_style_context_add_provider_for_display (gdk_display_get_default (),
+                                              GTK_STYLE_PROVIDER (provider),
+                                              GTK_STYLE_PROVIDER_PRIORITY_USER);
+
+  for (guint i = 0; i < G_N_ELEMENTS (depths); i++)
+    {
+      GtkWidget *a, *b, *pos;
+      GtkWidget *a_label, *b_label, *first_label, *last_label;
+
+      /* These only differ in the declaration of their topmost ancestor */
+      a = make_root ("a");
+      b = make_root ("b");
+      a_label = make_chain (a, depths[i]);
+      b_label = make_chain (b, depths[i]);
+
+      g_assert_true (has_color (a_label, "rgb(255,0,0)"));
+      g_assert_true (has_color (b_label, "rgb(0,0,255)"));
+
+      /* These only differ in the position of an ancestor */
+      pos = make_root ("pos");
+      first_label = make_chain (pos, depths[i]);
+      last_label = make_chain (pos, depths[i]);
+
+      g_assert_false (has_color (first_label, "rgb(0,255,0)"));
+      g_assert_true (has_color (last_label, "rgb(0,255,0)"));
+
+      g_object_unref (a);
+      g_object_unref (b);
+      g_object_unref (pos);
+    }
+
+  gtk_style_context_remove_provider_for_display (gdk_display_get_default (),
+                                                 GTK_STYLE_PROVIDER (provider));
+  g_object_unref (provider);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/css/provider/stylesheet/reuse", test_stylesheet_reuse);
+  g_test_add_func ("/css/provider/stylesheet/media-features", test_stylesheet_media_features);
+  g_test_add_func ("/css/provider/stylesheet/errors", test_stylesheet_errors);
+  g_test_add_func ("/css/provider/stylesheet/import", test_stylesheet_import);
+  g_test_add_func ("/css/provider/match/deep", test_match_deep);
+
+  return g_test_run ();
+}
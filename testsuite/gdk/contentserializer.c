@@ -249,6 +249,180 @@ test_content_texture (gconstpointer data)
   g_object_unref (texture);
 }
 
+static void
+serialize_memory_texture_done (GObject      *source,
+                               GAsyncResult *result,
+                               gpointer      user_data)
+{
+  gboolean *done = user_data;
+  GError *error = NULL;
+
+  g_assert_true (gdk_content_serialize_finish (result, &error));
+  g_assert_no_error (error);
+
+  *done = TRUE;
+  g_main_context_wakeup (NULL);
+}
+
+static GBytes *
+serialize_memory_texture (GdkTexture *texture)
+{
+  GValue value = G_VALUE_INIT;
+  GOutputStream *ostream;
+  GBytes *bytes;
+  gboolean done;
+
+  g_value_init (&value, GDK_TYPE_TEXTURE);
+  g_value_set_object (&value, texture);
+
+  ostream = g_memory_output_stream_new_resizable ();
+  done = FALSE;
+  gdk_content_serialize_async (ostream,
+                               "application/x-gtk-memory-texture",
+                               &value,
+                               G_PRIORITY_DEFAULT,
+                               NULL,
+                               serialize_memory_texture_done,
+                               &done);
+  while (!done)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_output_stream_close (ostream, NULL, NULL);
+  bytes = g_memory_output_stream_steal_as_bytes (G_MEMORY_OUTPUT_STREAM (ostream));
+
+  g_object_unref (ostream);
+  g_value_unset (&value);
+
+  return bytes;
+}
+
+typedef struct {
+  gboolean done;
+  int code;
+} DeserializeErrorData;
+
+static void
+deserialize_error_done (GObject      *source,
+                        GAsyncResult *result,
+                        gpointer      user_data)
+{
+  DeserializeErrorData *data = user_data;
+  GValue value = G_VALUE_INIT;
+  GError *error = NULL;
+
+  g_value_init (&value, GDK_TYPE_TEXTURE);
+  g_assert_false (gdk_content_deserialize_finish (result, &value, &error));
+  g_assert_error (error, G_IO_ERROR, data->code);
+  g_assert_null (g_value_get_object (&value));
+  g_value_unset (&value);
+  g_error_free (error);
+
+  data->done = TRUE;
+  g_main_context_wakeup (NULL);
+}
+
+static void
+assert_deserialize_error (const guchar *data,
+                          gsize         size,
+                          int           code)
+{
+  DeserializeErrorData error_data = { FALSE, code };
+  GInputStream *istream;
+
+  istream = g_memory_input_stream_new_from_data (data, size, NULL);
+  gdk_content_deserialize_async (istream,
+                                 "application/x-gtk-memory-texture",
+                                 GDK_TYPE_TEXTURE,
+                                 G_PRIORITY_DEFAULT,
+                                 NULL,
+                                 deserialize_error_done,
+                                 &error_data);
+  while (!error_data.done)
+    g_main_context_iteration (NULL, TRUE);
+
+  g_object_unref (istream);
+}
+
+static GdkTexture *
+load_test_image (void)
+{
+  GdkTexture *texture;
+  GError *error = NULL;
+  char *path;
+
+  path = g_test_build_filename (G_TEST_DIST, "image-data", "image.png", NULL);
+  texture = gdk_texture_new_from_filename (path, &error);
+  g_assert_no_error (error);
+  g_free (path);
+
+  return texture;
+}
+
+static void
+test_content_texture_truncated (void)
+{
+  GdkTexture *texture;
+  GBytes *bytes;
+
+  texture = load_test_image ();
+  bytes = serialize_memory_texture (texture);
+
+  /* Cut off the last row of pixels */
+  assert_deserialize_error (g_bytes_get_data (bytes, NULL),
+                            g_bytes_get_size (bytes) - 4 * gdk_texture_get_width (texture),
+                            G_IO_ERROR_PARTIAL_INPUT);
+
+  g_bytes_unref (bytes);
+  g_object_unref (texture);
+}
+
+static guint32
+read_le32 (const guchar *data)
+{
+  return data[0] | (data[1] << 8) | (data[2] << 16) | ((guint32) data[3] << 24);
+}
+
+static void
+test_content_texture_header (void)
+{
+  GdkTexture *texture;
+  GBytes *bytes;
+  const guchar *data;
+  guchar *copy;
+  gsize size;
+
+  texture = load_test_image ();
+  bytes = serialize_memory_texture (texture);
+  data = g_bytes_get_data (bytes, &size);
+
+  /* The header is the same on every platform */
+  g_assert_cmpuint (size, >, 44);
+  g_assert_cmpmem (data, 8, "GTKMEMTX", 8);
+  g_assert_cmpuint (read_le32 (data + 8), ==, 2);
+  g_assert_cmpuint (read_le32 (data + 16), ==, gdk_texture_get_format (texture));
+  g_assert_cmpuint (read_le32 (data + 20), ==, gdk_texture_get_width (texture));
+  g_assert_cmpuint (read_le32 (data + 24), ==, gdk_texture_get_height (texture));
+  g_assert_cmpuint (read_le32 (data + 28), ==, 1);
+
+  /* An unknown version */
+  copy = g_memdup2 (data, size);
+  copy[8] = 3;
+  assert_deserialize_error (copy, size, G_IO_ERROR_INVALID_DATA);
+  g_free (copy);
+
+  /* A plane count that doesn't match the format */
+  copy = g_memdup2 (data, size);
+  copy[28] = 4;
+  assert_deserialize_error (copy, size, G_IO_ERROR_INVALID_DATA);
+  g_free (copy);
+
+  /* A header that ends early */
+  assert_deserialize_error (data, 40, G_IO_ERROR_INVALID_DATA);
+
+  g_bytes_unref (bytes);
+  g_object_unref (texture);
+}
+
 static void
 test_content_file (void)
 {
@@ -651,6 +825,9 @@ main (int argc, char *argv[])
   g_test_add_func ("/content/color", test_content_color);
   g_test_add_data_func ("/content/texture/png", "image/png", test_content_texture);
   g_test_add_data_func ("/content/texture/tiff", "image/tiff", test_content_texture);
+  g_test_add_data_func ("/content/texture/memory", "application/x-gtk-memory-texture", test_content_texture);
+  g_test_add_func ("/content/texture/memory-truncated", test_content_texture_truncated);
+  g_test_add_func ("/content/texture/memory-header", test_content_texture_header);
   g_test_add_func ("/content/file", test_content_file);
   g_test_add_func ("/content/files", test_content_files);
   g_test_add_func ("/content/custom", test_custom_format);
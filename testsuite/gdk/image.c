@@ -2,6 +2,9 @@
 #include "gdk/loaders/gdkpngprivate.h"
 #include "gdk/loaders/gdktiffprivate.h"
 #include "gdk/loaders/gdkjpegprivate.h"
+#include "gdk/gdktextureprivate.h"
+#include "gdk/gdkmemorytextureprivate.h"
+#include "gdk/gdkmemoryformatprivate.h"
 
 static void
 assert_texture_equal (GdkTexture *t1,
@@ -68,6 +71,272 @@ test_load_image (gconstpointer data)
   g_free (path);
 }
 
+static GdkTexture *
+load_image_at_size (GBytes     *bytes,
+                    const char *filename,
+                    int         min_width,
+                    int         min_height,
+                    GError    **error)
+{
+  /* use the internal api, we want to avoid pixbuf fallback here */
+  if (g_str_has_suffix (filename, ".png"))
+    return gdk_load_png_at_size (bytes, NULL, min_width, min_height, error);
+  else if (g_str_has_suffix (filename, ".tiff"))
+    return gdk_load_tiff_at_size (bytes, min_width, min_height, error);
+  else if (g_str_has_suffix (filename, ".jpeg"))
+    return gdk_load_jpeg_at_size (bytes, min_width, min_height, error);
+  else
+    g_assert_not_reached ();
+}
+
+/* Checks that @small has the pixels that gdk_memory_mipmap()
+ * produces for @texture at @lod_level */
+static void
+assert_texture_is_mipmap (GdkTexture *small,
+                          GdkTexture *texture,
+                          guint       lod_level)
+{
+  GdkMemoryTexture *memtex;
+  const GdkMemoryLayout *layout;
+  GdkMemoryLayout mipmap_layout;
+  GdkTexture *mipmap;
+  GBytes *bytes;
+  guchar *data;
+  gsize n = 1 << lod_level;
+
+  memtex = gdk_memory_texture_from_texture (texture);
+  layout = gdk_memory_texture_get_layout (memtex);
+
+  gdk_memory_layout_init (&mipmap_layout,
+                          layout->format,
+                          (layout->width + n - 1) >> lod_level,
+                          (layout->height + n - 1) >> lod_level,
+                          1);
+  data = g_malloc (mipmap_layout.size);
+  gdk_memory_mipmap (data,
+                     &mipmap_layout,
+                     g_bytes_get_data (gdk_memory_texture_get_bytes (memtex), NULL),
+                     layout,
+                     lod_level,
+                     TRUE);
+  bytes = g_bytes_new_take (data, mipmap_layout.size);
+  mipmap = gdk_memory_texture_new_from_layout (bytes,
+                                               &mipmap_layout,
+                                               gdk_texture_get_color_state (texture),
+                                               NULL, NULL);
+
+  assert_texture_equal (small, mipmap);
+
+  g_object_unref (mipmap);
+  g_bytes_unref (bytes);
+  g_object_unref (memtex);
+}
+
+static void
+test_load_image_at_size (gconstpointer data)
+{
+  const char *filename = data;
+  GdkTexture *texture, *small;
+  char *path;
+  GFile *file;
+  GBytes *bytes;
+  GError *error = NULL;
+  int width, height;
+
+  path = g_test_build_filename (G_TEST_DIST, "image-data", filename, NULL);
+  file = g_file_new_for_path (path);
+  bytes = g_file_load_bytes (file, NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  texture = load_image_at_size (bytes, filename, -1, -1, &error);
+  g_assert_no_error (error);
+
+  width = gdk_texture_get_width (texture);
+  height = gdk_texture_get_height (texture);
+
+  small = load_image_at_size (bytes, filename, width / 4, height / 4, &error);
+  g_assert_no_error (error);
+  g_assert_true (GDK_IS_TEXTURE (small));
+
+  if (g_str_has_suffix (filename, ".jpeg"))
+    {
+      /* libjpeg scales during the IDCT, so the pixels differ from
+       * our mipmaps, but the size is always reduced */
+      g_assert_cmpint (gdk_texture_get_width (small), ==, (width + 3) / 4);
+      g_assert_cmpint (gdk_texture_get_height (small), ==, (height + 3) / 4);
+    }
+  else if (gdk_texture_get_width (small) != width ||
+           gdk_texture_get_height (small) != height)
+    {
+      /* interlaced pngs and some tiffs load at full size,
+       * everything else must be exactly the mipmap */
+      assert_texture_is_mipmap (small, texture, 2);
+    }
+
+  g_object_unref (small);
+  g_object_unref (texture);
+  g_bytes_unref (bytes);
+  g_object_unref (file);
+  g_free (path);
+}
+
+static GdkTexture *
+make_test_texture (int width,
+                   int height)
+{
+  GdkMemoryTextureBuilder *builder;
+  GdkTexture *texture;
+  GBytes *bytes;
+  guchar *pixels;
+  gsize stride = width * 4;
+
+  pixels = g_malloc (stride * height);
+  for (gsize y = 0; y < height; y++)
+    for (gsize x = 0; x < width; x++)
+      {
+        guchar *p = pixels + y * stride + x * 4;
+
+        p[0] = x * 255 / width;
+        p[1] = y * 255 / height;
+        p[2] = (x * 7 + y * 13) & 0xff;
+        p[3] = 255;
+      }
+
+  bytes = g_bytes_new_take (pixels, stride * height);
+  builder = gdk_memory_texture_builder_new ();
+  gdk_memory_texture_builder_set_bytes (builder, bytes);
+  gdk_memory_texture_builder_set_stride (builder, stride);
+  gdk_memory_texture_builder_set_width (builder, width);
+  gdk_memory_texture_builder_set_height (builder, height);
+  gdk_memory_texture_builder_set_format (builder, GDK_MEMORY_R8G8B8A8);
+  texture = gdk_memory_texture_builder_build (builder);
+  g_object_unref (builder);
+  g_bytes_unref (bytes);
+
+  return texture;
+}
+
+static void
+test_load_reduced (gconstpointer data)
+{
+  const char *filename = data;
+  GdkTexture *texture, *full, *small;
+  GBytes *bytes;
+  GError *error = NULL;
+
+  /* Odd sizes, so that the last band and column are partial */
+  texture = make_test_texture (67, 45);
+
+  if (g_str_has_suffix (filename, ".png"))
+    bytes = gdk_save_png (texture, NULL);
+  else if (g_str_has_suffix (filename, ".tiff"))
+    bytes = gdk_save_tiff (texture);
+  else if (g_str_has_suffix (filename, ".jpeg"))
+    bytes = gdk_save_jpeg (texture);
+  else
+    g_assert_not_reached ();
+
+  full = load_image_at_size (bytes, filename, -1, -1, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (gdk_texture_get_width (full), ==, 67);
+  g_assert_cmpint (gdk_texture_get_height (full), ==, 45);
+
+  /* A request that allows exactly two halvings */
+  small = load_image_at_size (bytes, filename, 16, 11, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (gdk_texture_get_width (small), ==, 17);
+  g_assert_cmpint (gdk_texture_get_height (small), ==, 12);
+  if (!g_str_has_suffix (filename, ".jpeg"))
+    assert_texture_is_mipmap (small, full, 2);
+  g_object_unref (small);
+
+  /* A request that is too large to reduce at all */
+  small = load_image_at_size (bytes, filename, 40, 10, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (gdk_texture_get_width (small), ==, 67);
+  g_assert_cmpint (gdk_texture_get_height (small), ==, 45);
+  assert_texture_equal (small, full);
+  g_object_unref (small);
+
+  g_object_unref (full);
+  g_object_unref (texture);
+  g_bytes_unref (bytes);
+}
+
+/* image-tiled.tiff is 100x70 in 16x16 tiles, so it has partial
+ * tiles on the right and bottom edges */
+static void
+test_load_tiled_tiff (void)
+{
+  GdkTexture *expected, *texture, *tiled, *tile, *sub;
+  char *path;
+  GFile *file;
+  GBytes *bytes;
+  GError *error = NULL;
+  const cairo_rectangle_int_t areas[] = {
+    { 0, 0, 100, 70 },
+    { 0, 0, 16, 16 },
+    { 10, 5, 40, 30 },
+    { 17, 33, 1, 1 },
+    { 90, 60, 10, 10 },
+    { 96, 0, 4, 70 },
+    { 0, 64, 100, 6 },
+    { 33, 21, 67, 49 },
+  };
+
+  path = g_test_build_filename (G_TEST_DIST, "image-data", "image-tiled.tiff", NULL);
+  file = g_file_new_for_path (path);
+  bytes = g_file_load_bytes (file, NULL, NULL, &error);
+  g_assert_no_error (error);
+
+  expected = make_test_texture (100, 70);
+
+  /* Small tiled images are decoded right away */
+  texture = gdk_load_tiff (bytes, &error);
+  g_assert_no_error (error);
+  g_assert_false (gdk_texture_has_tiles (texture));
+  assert_texture_equal (texture, expected);
+
+  tiled = gdk_load_tiff_tiled (bytes, &error);
+  g_assert_no_error (error);
+  g_assert_true (gdk_texture_has_tiles (tiled));
+  g_assert_cmpint (gdk_texture_get_format (tiled), ==, gdk_texture_get_format (texture));
+  assert_texture_equal (tiled, texture);
+
+  for (gsize i = 0; i < G_N_ELEMENTS (areas); i++)
+    {
+      const cairo_rectangle_int_t *area = &areas[i];
+
+      sub = gdk_memory_texture_new_subtexture (GDK_MEMORY_TEXTURE (expected),
+                                               area->x, area->y,
+                                               area->width, area->height);
+
+      for (guint lod_level = 0; lod_level < 4; lod_level++)
+        {
+          tile = gdk_texture_get_tile (tiled, lod_level, area);
+          g_assert_nonnull (tile);
+          g_assert_cmpint (gdk_texture_get_width (tile), ==, (area->width + (1 << lod_level) - 1) >> lod_level);
+          g_assert_cmpint (gdk_texture_get_height (tile), ==, (area->height + (1 << lod_level) - 1) >> lod_level);
+
+          if (lod_level == 0)
+            assert_texture_equal (tile, sub);
+          else
+            assert_texture_is_mipmap (tile, sub, lod_level);
+
+          g_object_unref (tile);
+        }
+
+      g_object_unref (sub);
+    }
+
+  g_object_unref (tiled);
+  g_object_unref (texture);
+  g_object_unref (expected);
+  g_bytes_unref (bytes);
+  g_object_unref (file);
+  g_free (path);
+}
+
 static void
 test_save_image (gconstpointer test_data)
 {
@@ -117,6 +386,54 @@ test_save_image (gconstpointer test_data)
   g_free (path);
 }
 
+static void
+test_save_png_large (gconstpointer data)
+{
+  GdkPngCompression compression = GPOINTER_TO_INT (data);
+  GdkMemoryFormat formats[] = { GDK_MEMORY_R8G8B8A8, GDK_MEMORY_R8G8B8, GDK_MEMORY_R16G16B16A16 };
+
+  for (gsize f = 0; f < G_N_ELEMENTS (formats); f++)
+    {
+      GdkMemoryTextureBuilder *builder;
+      GdkTexture *texture, *texture2;
+      GBytes *bytes;
+      guchar *pixels;
+      gsize stride, size;
+      GError *error = NULL;
+      int width = 1000, height = 700;
+
+      stride = width * (formats[f] == GDK_MEMORY_R8G8B8 ? 3 : formats[f] == GDK_MEMORY_R8G8B8A8 ? 4 : 8);
+      size = stride * height;
+      pixels = g_malloc (size);
+      for (gsize i = 0; i < size; i++)
+        pixels[i] = (i % stride) * 7 + (i / stride) * 3 + g_test_rand_int_range (0, 4);
+
+      bytes = g_bytes_new_take (pixels, size);
+      builder = gdk_memory_texture_builder_new ();
+      gdk_memory_texture_builder_set_bytes (builder, bytes);
+      gdk_memory_texture_builder_set_stride (builder, stride);
+      gdk_memory_texture_builder_set_width (builder, width);
+      gdk_memory_texture_builder_set_height (builder, height);
+      gdk_memory_texture_builder_set_format (builder, formats[f]);
+      texture = gdk_memory_texture_builder_build (builder);
+      g_object_unref (builder);
+      g_bytes_unref (bytes);
+
+      bytes = gdk_save_png_with_compression (texture, NULL, compression);
+      g_assert_nonnull (bytes);
+
+      texture2 = gdk_load_png (bytes, NULL, &error);
+      g_assert_no_error (error);
+      g_assert_cmpint (gdk_texture_get_format (texture2), ==, formats[f]);
+
+      assert_texture_equal (texture, texture2);
+
+      g_object_unref (texture2);
+      g_object_unref (texture);
+      g_bytes_unref (bytes);
+    }
+}
+
 static void
 test_load_image_fail (gconstpointer data)
 {
@@ -155,6 +472,9 @@ main (int argc, char *argv[])
      char *test = g_strconcat ("/image/load/", name, NULL);
      g_test_add_data_func_full (test, g_strdup (name), test_load_image, g_free);
      g_free (test);
+     test = g_strconcat ("/image/load-at-size/", name, NULL);
+     g_test_add_data_func_full (test, g_strdup (name), test_load_image_at_size, g_free);
+     g_free (test);
    }
 
   g_dir_close (dir);
@@ -173,9 +493,15 @@ main (int argc, char *argv[])
 
   g_dir_close (dir);
 
+  g_test_add_func ("/image/load/tiled-tiff", test_load_tiled_tiff);
+  g_test_add_data_func ("/image/load-reduced/png", "image.png", test_load_reduced);
+  g_test_add_data_func ("/image/load-reduced/tiff", "image.tiff", test_load_reduced);
+  g_test_add_data_func ("/image/load-reduced/jpeg", "image.jpeg", test_load_reduced);
   g_test_add_data_func ("/image/save/image.png", "image.png", test_save_image);
   g_test_add_data_func ("/image/save/image.tiff", "image.tiff", test_save_image);
   g_test_add_data_func ("/image/save/image.jpeg", "image.jpeg", test_save_image);
+  g_test_add_data_func ("/image/save/large-png", GINT_TO_POINTER (GDK_PNG_COMPRESSION_DEFAULT), test_save_png_large);
+  g_test_add_data_func ("/image/save/large-png-fast", GINT_TO_POINTER (GDK_PNG_COMPRESSION_FAST), test_save_png_large);
 
   return g_test_run ();
 }
@@ -0,0 +1,176 @@
+#include <gtk/gtk.h>
+#include <glib/gstdio.h>
+
+#define N_ROWS 12
+#define ROW_HEIGHT 20
+
+/* A list of rows that draw the same, but like the rows of a
+ * real list, each of them has its own nodes.
+ */
+static GskRenderNode *
+create_list (void)
+{
+  GskRenderNode *rows[N_ROWS];
+  GskRenderNode *row, *parts[2];
+  GskRenderNode *list;
+  guint i;
+
+  for (i = 0; i < N_ROWS; i++)
+    {
+      parts[0] = gsk_color_node_new (&(GdkRGBA) { 1, 0, 0, 1 }, &GRAPHENE_RECT_INIT (0, 0, 100, ROW_HEIGHT));
+      /* One row differs, it must not be drawn like the others */
+      if (i == N_ROWS / 2)
+        parts[1] = gsk_color_node_new (&(GdkRGBA) { 0, 1, 0, 1 }, &GRAPHENE_RECT_INIT (10, 5, 30, 10));
+      else
+        parts[1] = gsk_color_node_new (&(GdkRGBA) { 0, 0, 1, 1 }, &GRAPHENE_RECT_INIT (10, 5, 30, 10));
+
+      row = gsk_container_node_new (parts, G_N_ELEMENTS (parts));
+      rows[i] = gsk_transform_node_new (row,
+                                        gsk_transform_translate (NULL, &GRAPHENE_POINT_INIT (0, i * ROW_HEIGHT)));
+
+      gsk_render_node_unref (row);
+      gsk_render_node_unref (parts[0]);
+      gsk_render_node_unref (parts[1]);
+    }
+
+  list = gsk_container_node_new (rows, N_ROWS);
+
+  for (i = 0; i < N_ROWS; i++)
+    gsk_render_node_unref (rows[i]);
+
+  return list;
+}
+
+static GskRenderer *
+create_renderer (void)
+{
+  GskRenderer *renderer;
+  GError *error = NULL;
+
+  renderer = gsk_gl_renderer_new ();
+  if (!gsk_renderer_realize_for_display (renderer, gdk_display_get_default (), &error))
+    {
+      g_test_skip_printf ("%s not available: %s", G_OBJECT_TYPE_NAME (renderer), error->message);
+      g_clear_error (&error);
+      g_clear_object (&renderer);
+    }
+
+  return renderer;
+}
+
+/* Runs in a subprocess, because GSK_GPU_DISABLE is only read once */
+static void
+render_list (void)
+{
+  GskRenderer *renderer;
+  GskRenderNode *node;
+  GdkTexture *texture;
+
+  renderer = create_renderer ();
+  if (renderer == NULL)
+    return;
+
+  node = create_list ();
+  texture = gsk_renderer_render_texture (renderer, node, NULL);
+  g_assert_true (gdk_texture_save_to_png (texture, g_getenv ("INSTANCE_TEST_OUTPUT")));
+
+  g_object_unref (texture);
+  gsk_render_node_unref (node);
+  gsk_renderer_unrealize (renderer);
+  g_object_unref (renderer);
+}
+
+static GdkTexture *
+render_list_in_subprocess (const char *filename,
+                           const char *gpu_disable,
+                           gboolean    expect_instances)
+{
+  GdkTexture *texture;
+  GError *error = NULL;
+  char **envp;
+
+  envp = g_get_environ ();
+  envp = g_environ_setenv (envp, "INSTANCE_TEST_OUTPUT", filename, TRUE);
+  envp = g_environ_setenv (envp, "GSK_DEBUG", "cache", TRUE);
+  if (gpu_disable)
+    envp = g_environ_setenv (envp, "GSK_GPU_DISABLE", gpu_disable, TRUE);
+  else
+    envp = g_environ_unsetenv (envp, "GSK_GPU_DISABLE");
+
+  g_test_trap_subprocess_with_envp (NULL, (const char * const *) envp, 0, G_TEST_SUBPROCESS_DEFAULT);
+  g_test_trap_assert_passed ();
+  if (expect_instances)
+    g_test_trap_assert_stderr ("*instanced subtrees*");
+  else
+    g_test_trap_assert_stderr_unmatched ("*instanced subtrees*");
+
+  texture = gdk_texture_new_from_filename (filename, &error);
+  g_assert_no_error (error);
+
+  g_strfreev (envp);
+
+  return texture;
+}
+
+static void
+test_instance_matches_disabled (void)
+{
+  GskRenderer *renderer;
+  GdkTexture *instanced, *direct;
+  GdkTextureDownloader *downloader;
+  GBytes *instanced_bytes, *direct_bytes;
+  gsize instanced_stride, direct_stride;
+  char *dir, *instanced_file, *direct_file;
+
+  if (g_test_subprocess ())
+    {
+      render_list ();
+      return;
+    }
+
+  renderer = create_renderer ();
+  if (renderer == NULL)
+    return;
+  gsk_renderer_unrealize (renderer);
+  g_object_unref (renderer);
+
+  dir = g_dir_make_tmp ("instanceXXXXXX", NULL);
+  instanced_file = g_build_filename (dir, "instanced.png", NULL);
+  direct_file = g_build_filename (dir, "direct.png", NULL);
+
+  instanced = render_list_in_subprocess (instanced_file, NULL, TRUE);
+  direct = render_list_in_subprocess (direct_file, "instance", FALSE);
+
+  g_assert_cmpint (gdk_texture_get_width (instanced), ==, gdk_texture_get_width (direct));
+  g_assert_cmpint (gdk_texture_get_height (instanced), ==, gdk_texture_get_height (direct));
+
+  downloader = gdk_texture_downloader_new (instanced);
+  instanced_bytes = gdk_texture_downloader_download_bytes (downloader, &instanced_stride);
+  gdk_texture_downloader_set_texture (downloader, direct);
+  direct_bytes = gdk_texture_downloader_download_bytes (downloader, &direct_stride);
+
+  g_assert_cmpuint (instanced_stride, ==, direct_stride);
+  g_assert_true (g_bytes_equal (instanced_bytes, direct_bytes));
+
+  g_bytes_unref (instanced_bytes);
+  g_bytes_unref (direct_bytes);
+  gdk_texture_downloader_free (downloader);
+  g_object_unref (instanced);
+  g_object_unref (direct);
+  g_unlink (instanced_file);
+  g_unlink (direct_file);
+  g_rmdir (dir);
+  g_free (instanced_file);
+  g_free (direct_file);
+  g_free (dir);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/instance/matches-disabled", test_instance_matches_disabled);
+
+  return g_test_run ();
+}
@@ -3,6 +3,7 @@
 #include "gsk/gskbordernodeprivate.h"
 #include "gsk/gskgradientprivate.h"
 #include "gsk/gskradialgradientnodeprivate.h"
+#include "gsk/gskrendernodeprivate.h"
 
 #include <gobject/gvaluecollector.h>
 
@@ -152,6 +153,46 @@ test_container_disjoint (void)
   gsk_render_node_unref (nodes[1]);
 }
 
+static void
+test_rendernode_recycle (void)
+{
+  GskRenderNode *node, *node2, *container;
+  graphene_rect_t bounds;
+  gpointer freed;
+
+  if (!gsk_render_node_can_recycle ())
+    {
+      g_test_skip ("Node recycling is disabled");
+      return;
+    }
+
+  node = gsk_color_node_new (&(GdkRGBA) { 1, 0, 0, 1 }, &GRAPHENE_RECT_INIT (0, 0, 50, 50));
+  freed = node;
+  gsk_render_node_unref (node);
+
+  /* A node of another type must not get the memory */
+  container = gsk_container_node_new (NULL, 0);
+  g_assert_true ((gpointer) container != freed);
+
+  /* A node of the same type gets it, fully reinitialized */
+  node = gsk_color_node_new (&(GdkRGBA) { 0, 0, 1, 0.5 }, &GRAPHENE_RECT_INIT (10, 20, 30, 40));
+  g_assert_true ((gpointer) node == freed);
+  g_assert_cmpint (gsk_render_node_get_node_type (node), ==, GSK_COLOR_NODE);
+  g_assert_true (gdk_rgba_equal (gsk_color_node_get_color (node), &(GdkRGBA) { 0, 0, 1, 0.5 }));
+  gsk_render_node_get_bounds (node, &bounds);
+  g_assert_true (graphene_rect_equal (&bounds, &GRAPHENE_RECT_INIT (10, 20, 30, 40)));
+  g_assert_false (gsk_render_node_is_fully_opaque (node));
+
+  /* Nodes that are alive are never handed out again */
+  node2 = gsk_color_node_new (&(GdkRGBA) { 0, 1, 0, 1 }, &GRAPHENE_RECT_INIT (0, 0, 10, 10));
+  g_assert_true (node2 != node);
+  g_assert_true (gdk_rgba_equal (gsk_color_node_get_color (node), &(GdkRGBA) { 0, 0, 1, 0.5 }));
+
+  gsk_render_node_unref (node2);
+  gsk_render_node_unref (node);
+  gsk_render_node_unref (container);
+}
+
 static void
 test_renderer (GskRenderer *renderer)
 {
@@ -334,6 +375,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/rendernode/border/uniform", test_bordernode_uniform);
   g_test_add_func ("/rendernode/conic-gradient/angle", test_conic_gradient_angle);
   g_test_add_func ("/rendernode/container/disjoint", test_container_disjoint);
+  g_test_add_func ("/rendernode/recycle", test_rendernode_recycle);
   g_test_add_func ("/renderer/cairo", test_cairo_renderer);
   g_test_add_func ("/renderer/gl", test_gl_renderer);
   g_test_add_func ("/renderer/vulkan", test_vulkan_renderer);
@@ -0,0 +1,193 @@
+#include <gtk/gtk.h>
+#include <glib/gstdio.h>
+#include <stdlib.h>
+
+static GskRenderNode *
+load_node (void)
+{
+  GskRenderNode *node;
+  GError *error = NULL;
+  GBytes *bytes;
+  char *contents;
+  gsize length;
+
+  g_file_get_contents (g_test_get_filename (G_TEST_DIST, "pool", "shadows.node", NULL),
+                       &contents, &length, &error);
+  g_assert_no_error (error);
+
+  bytes = g_bytes_new_take (contents, length);
+  node = gsk_render_node_deserialize (bytes, NULL, NULL);
+  g_assert_nonnull (node);
+  g_bytes_unref (bytes);
+
+  return node;
+}
+
+static GskRenderer *
+create_renderer (void)
+{
+  GskRenderer *renderer;
+  GError *error = NULL;
+
+  renderer = gsk_gl_renderer_new ();
+  if (!gsk_renderer_realize_for_display (renderer, gdk_display_get_default (), &error))
+    {
+      g_test_skip_printf ("%s not available: %s", G_OBJECT_TYPE_NAME (renderer), error->message);
+      g_clear_error (&error);
+      g_clear_object (&renderer);
+    }
+
+  return renderer;
+}
+
+/* Runs in a subprocess, because GSK_GPU_DISABLE is only read once.
+ * Every run after the first one can take its offscreens from the pool.
+ */
+static void
+render_shadows (void)
+{
+  GskRenderer *renderer;
+  GskRenderNode *node;
+  GdkTexture *texture;
+  guint i, n_runs;
+  double elapsed;
+  char *str;
+
+  renderer = create_renderer ();
+  if (renderer == NULL)
+    return;
+
+  node = load_node ();
+  n_runs = atoi (g_getenv ("POOL_TEST_RUNS"));
+
+  texture = gsk_renderer_render_texture (renderer, node, NULL);
+
+  g_test_timer_start ();
+  for (i = 0; i < n_runs; i++)
+    {
+      g_object_unref (texture);
+      texture = gsk_renderer_render_texture (renderer, node, NULL);
+    }
+  elapsed = g_test_timer_elapsed ();
+
+  g_assert_true (gdk_texture_save_to_png (texture, g_getenv ("POOL_TEST_OUTPUT")));
+
+  str = g_strdup_printf ("%g", elapsed / n_runs);
+  g_assert_true (g_file_set_contents (g_getenv ("POOL_TEST_TIME"), str, -1, NULL));
+  g_free (str);
+
+  g_object_unref (texture);
+  gsk_render_node_unref (node);
+  gsk_renderer_unrealize (renderer);
+  g_object_unref (renderer);
+}
+
+static GdkTexture *
+render_shadows_in_subprocess (const char *dir,
+                              const char *name,
+                              gboolean    pool,
+                              double     *seconds)
+{
+  GdkTexture *texture;
+  GError *error = NULL;
+  char *filename, *time_file, *contents;
+  char **envp;
+
+  filename = g_strdup_printf ("%s/%s.png", dir, name);
+  time_file = g_strdup_printf ("%s/%s.time", dir, name);
+
+  envp = g_get_environ ();
+  envp = g_environ_setenv (envp, "POOL_TEST_OUTPUT", filename, TRUE);
+  envp = g_environ_setenv (envp, "POOL_TEST_TIME", time_file, TRUE);
+  /* The subprocess does not know that we run in perf mode */
+  envp = g_environ_setenv (envp, "POOL_TEST_RUNS", g_test_perf () ? "100" : "3", TRUE);
+  envp = g_environ_setenv (envp, "GSK_DEBUG", "cache", TRUE);
+  if (pool)
+    envp = g_environ_unsetenv (envp, "GSK_GPU_DISABLE");
+  else
+    envp = g_environ_setenv (envp, "GSK_GPU_DISABLE", "pool", TRUE);
+
+  g_test_trap_subprocess_with_envp (NULL, (const char * const *) envp, 0, G_TEST_SUBPROCESS_DEFAULT);
+  g_test_trap_assert_passed ();
+  if (pool)
+    g_test_trap_assert_stderr ("*Offscreen pool: reused*");
+  else
+    g_test_trap_assert_stderr_unmatched ("*Offscreen pool: reused*");
+
+  texture = gdk_texture_new_from_filename (filename, &error);
+  g_assert_no_error (error);
+
+  g_file_get_contents (time_file, &contents, NULL, &error);
+  g_assert_no_error (error);
+  *seconds = g_ascii_strtod (contents, NULL);
+  g_free (contents);
+
+  g_unlink (filename);
+  g_unlink (time_file);
+  g_free (filename);
+  g_free (time_file);
+  g_strfreev (envp);
+
+  return texture;
+}
+
+static void
+test_pool_matches_disabled (void)
+{
+  GskRenderer *renderer;
+  GdkTexture *pooled, *direct;
+  GdkTextureDownloader *downloader;
+  GBytes *pooled_bytes, *direct_bytes;
+  gsize pooled_stride, direct_stride;
+  double pooled_time, direct_time;
+  char *dir;
+
+  if (g_test_subprocess ())
+    {
+      render_shadows ();
+      return;
+    }
+
+  renderer = create_renderer ();
+  if (renderer == NULL)
+    return;
+  gsk_renderer_unrealize (renderer);
+  g_object_unref (renderer);
+
+  dir = g_dir_make_tmp ("offscreenpoolXXXXXX", NULL);
+
+  pooled = render_shadows_in_subprocess (dir, "pooled", TRUE, &pooled_time);
+  direct = render_shadows_in_subprocess (dir, "direct", FALSE, &direct_time);
+
+  downloader = gdk_texture_downloader_new (pooled);
+  pooled_bytes = gdk_texture_downloader_download_bytes (downloader, &pooled_stride);
+  gdk_texture_downloader_set_texture (downloader, direct);
+  direct_bytes = gdk_texture_downloader_download_bytes (downloader, &direct_stride);
+
+  g_assert_cmpuint (pooled_stride, ==, direct_stride);
+  g_assert_true (g_bytes_equal (pooled_bytes, direct_bytes));
+
+  if (g_test_perf ())
+    {
+      g_test_message ("Rendering shadows without the offscreen pool: %g seconds", direct_time);
+      g_test_minimized_result (pooled_time, "Rendering shadows with the offscreen pool: %g seconds", pooled_time);
+    }
+
+  g_bytes_unref (pooled_bytes);
+  g_bytes_unref (direct_bytes);
+  gdk_texture_downloader_free (downloader);
+  g_object_unref (pooled);
+  g_object_unref (direct);
+  g_rmdir (dir);
+  g_free (dir);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/offscreen-pool/matches-disabled", test_pool_matches_disabled);
+
+  return g_test_run ();
+}
@@ -24,6 +24,7 @@
 
 #include <gtk/gtk.h>
 #include <gdk/gdkkeysyms.h>
+#include "gtk/gtkbuilderprivate.h"
 
 G_GNUC_BEGIN_IGNORE_DEPRECATIONS
 
@@ -2993,6 +2994,66 @@ test_picture (void)
   g_free (uri);
 }
 
+static void
+test_precompiled_version (void)
+{
+  /* Precompiled data in an unsupported format version */
+  const char data[] = "GBU\xff\x01\x00\x00";
+  GtkBuilder *builder;
+  GError *error = NULL;
+
+  builder = gtk_builder_new ();
+  g_assert_false (gtk_builder_add_from_string (builder, data, sizeof (data) - 1, &error));
+  g_assert_error (error, GTK_BUILDER_ERROR, GTK_BUILDER_ERROR_VERSION_MISMATCH);
+  g_error_free (error);
+  g_object_unref (builder);
+}
+
+static void
+test_precompiled_values (void)
+{
+  const char buffer[] =
+    "<interface>"
+    "  <object class=\"GtkEntry\" id=\"entry\">"
+    "    <property name=\"input_purpose\">email</property>"
+    "    <property name=\"input-hints\">spellcheck|no-emoji</property>"
+    "    <property name=\"xalign\">0.5</property>"
+    "  </object>"
+    "</interface>";
+  GtkBuilder *builder;
+  GtkWidget *entry;
+  GError *error = NULL;
+  GBytes *bytes;
+  const char *data;
+  gsize size;
+
+  builder = gtk_builder_new ();
+  bytes = _gtk_buildable_parser_precompile (buffer, -1, builder, &error);
+  g_assert_no_error (error);
+  g_object_unref (builder);
+
+  data = g_bytes_get_data (bytes, &size);
+  g_assert_true (_gtk_buildable_parser_is_precompiled (data, size));
+
+  /* Enum and flags values and property names are resolved */
+  g_assert_null (g_strstr_len (data, size, "email"));
+  g_assert_null (g_strstr_len (data, size, "spellcheck"));
+  g_assert_null (g_strstr_len (data, size, "input_purpose"));
+
+  builder = gtk_builder_new ();
+  gtk_builder_add_from_string (builder, data, size, &error);
+  g_assert_no_error (error);
+
+  entry = GTK_WIDGET (gtk_builder_get_object (builder, "entry"));
+  g_assert_true (GTK_IS_ENTRY (entry));
+  g_assert_cmpint (gtk_entry_get_input_purpose (GTK_ENTRY (entry)), ==, GTK_INPUT_PURPOSE_EMAIL);
+  g_assert_cmpint (gtk_entry_get_input_hints (GTK_ENTRY (entry)), ==, GTK_INPUT_HINT_SPELLCHECK | GTK_INPUT_HINT_NO_EMOJI);
+  g_assert_cmpfloat (gtk_editable_get_alignment (GTK_EDITABLE (entry)), ==, 0.5);
+
+  g_object_unref (builder);
+  g_bytes_unref (bytes);
+}
+
 int
 main (int argc, char **argv)
 {
@@ -3043,6 +3104,8 @@ main (int argc, char **argv)
   g_test_add_func ("/Builder/Child Dispose Order", test_child_dispose_order);
   g_test_add_func ("/Builder/Buildable", test_buildable);
   g_test_add_func ("/Builder/Picture", test_picture);
+  g_test_add_func ("/Builder/Precompiled Version", test_precompiled_version);
+  g_test_add_func ("/Builder/Precompiled Values", test_precompiled_values);
 
   return g_test_run();
 }
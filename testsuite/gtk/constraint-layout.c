@@ -0,0 +1,135 @@
+/* Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <gtk/gtk.h>
+
+#define CHILD_WIDTH 10
+#define CHILD_HEIGHT 20
+
+static void
+add_constraint (GtkConstraintLayout    *layout,
+                GtkConstraintTarget    *target,
+                GtkConstraintAttribute  target_attribute,
+                GtkConstraintTarget    *source,
+                GtkConstraintAttribute  source_attribute,
+                double                  constant)
+{
+  gtk_constraint_layout_add_constraint (layout,
+                                        gtk_constraint_new (target, target_attribute,
+                                                            GTK_CONSTRAINT_RELATION_EQ,
+                                                            source, source_attribute,
+                                                            1.0, constant,
+                                                            GTK_CONSTRAINT_STRENGTH_REQUIRED));
+}
+
+/* A row of children, each one starting where the previous one
+ * ends, so every allocation has to resolve the whole chain.
+ */
+static GtkWidget *
+create_chain (guint       n_children,
+              GtkWidget **last)
+{
+  GtkConstraintLayout *layout;
+  GtkWidget *parent, *child, *prev;
+  guint i;
+
+  parent = g_object_ref_sink (gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0));
+  layout = GTK_CONSTRAINT_LAYOUT (gtk_constraint_layout_new ());
+  gtk_widget_set_layout_manager (parent, GTK_LAYOUT_MANAGER (layout));
+
+  prev = NULL;
+  for (i = 0; i < n_children; i++)
+    {
+      child = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
+      gtk_widget_set_parent (child, parent);
+
+      if (prev)
+        add_constraint (layout, GTK_CONSTRAINT_TARGET (child), GTK_CONSTRAINT_ATTRIBUTE_START,
+                        GTK_CONSTRAINT_TARGET (prev), GTK_CONSTRAINT_ATTRIBUTE_END, 0);
+      else
+        add_constraint (layout, GTK_CONSTRAINT_TARGET (child), GTK_CONSTRAINT_ATTRIBUTE_START,
+                        NULL, GTK_CONSTRAINT_ATTRIBUTE_START, 0);
+
+      add_constraint (layout, GTK_CONSTRAINT_TARGET (child), GTK_CONSTRAINT_ATTRIBUTE_WIDTH,
+                      NULL, GTK_CONSTRAINT_ATTRIBUTE_NONE, CHILD_WIDTH);
+      add_constraint (layout, GTK_CONSTRAINT_TARGET (child), GTK_CONSTRAINT_ATTRIBUTE_TOP,
+                      NULL, GTK_CONSTRAINT_ATTRIBUTE_TOP, 0);
+      add_constraint (layout, GTK_CONSTRAINT_TARGET (child), GTK_CONSTRAINT_ATTRIBUTE_HEIGHT,
+                      NULL, GTK_CONSTRAINT_ATTRIBUTE_NONE, CHILD_HEIGHT);
+
+      prev = child;
+    }
+
+  add_constraint (layout, NULL, GTK_CONSTRAINT_ATTRIBUTE_END,
+                  GTK_CONSTRAINT_TARGET (prev), GTK_CONSTRAINT_ATTRIBUTE_END, 0);
+  add_constraint (layout, NULL, GTK_CONSTRAINT_ATTRIBUTE_BOTTOM,
+                  GTK_CONSTRAINT_TARGET (prev), GTK_CONSTRAINT_ATTRIBUTE_BOTTOM, 0);
+
+  *last = prev;
+
+  return parent;
+}
+
+static void
+test_chain (void)
+{
+  GtkWidget *parent, *last;
+  graphene_rect_t bounds;
+  guint n_children, n_layouts, i;
+  int min_width, nat_width, min_height, nat_height;
+  double elapsed;
+
+  n_children = g_test_perf () ? 500 : 50;
+  n_layouts = g_test_perf () ? 100 : 5;
+
+  parent = create_chain (n_children, &last);
+
+  g_test_timer_start ();
+
+  for (i = 0; i < n_layouts; i++)
+    {
+      gtk_widget_queue_resize (parent);
+
+      gtk_widget_measure (parent, GTK_ORIENTATION_HORIZONTAL, -1, &min_width, &nat_width, NULL, NULL);
+      gtk_widget_measure (parent, GTK_ORIENTATION_VERTICAL, -1, &min_height, &nat_height, NULL, NULL);
+      gtk_widget_allocate (parent, min_width, min_height, -1, NULL);
+    }
+
+  elapsed = g_test_timer_elapsed ();
+
+  g_assert_cmpint (min_width, ==, n_children * CHILD_WIDTH);
+  g_assert_cmpint (min_height, ==, CHILD_HEIGHT);
+
+  g_assert_true (gtk_widget_compute_bounds (last, parent, &bounds));
+  g_assert_cmpfloat (bounds.origin.x, ==, (n_children - 1) * CHILD_WIDTH);
+  g_assert_cmpfloat (bounds.size.width, ==, CHILD_WIDTH);
+
+  if (g_test_perf ())
+    g_test_minimized_result (elapsed / n_layouts, "Laying out a chain of %u children: %g seconds",
+                             n_children, elapsed / n_layouts);
+
+  g_object_unref (parent);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/constraint-layout/chain", test_chain);
+
+  return g_test_run ();
+}
@@ -360,6 +360,79 @@ constraint_solver_paper (void)
   g_object_unref (solver);
 }
 
+static void
+constraint_solver_edit_chain (void)
+{
+  GtkConstraintSolver *solver = gtk_constraint_solver_new ();
+  GtkConstraintVariable **left, **width;
+  guint n_boxes, n_edits, i;
+  double elapsed;
+
+  n_boxes = g_test_perf () ? 200 : 20;
+  n_edits = g_test_perf () ? 1000 : 10;
+
+  left = g_new (GtkConstraintVariable *, n_boxes);
+  width = g_new (GtkConstraintVariable *, n_boxes);
+
+  /* A row of boxes, each one starting where the previous one ends */
+  for (i = 0; i < n_boxes; i++)
+    {
+      left[i] = gtk_constraint_solver_create_variable (solver, NULL, "left", 0.0);
+      width[i] = gtk_constraint_solver_create_variable (solver, NULL, "width", 10.0);
+
+      gtk_constraint_solver_add_stay_variable (solver, width[i], GTK_CONSTRAINT_STRENGTH_WEAK);
+
+      if (i > 0)
+        {
+          GtkConstraintExpressionBuilder builder;
+
+          gtk_constraint_expression_builder_init (&builder, solver);
+          gtk_constraint_expression_builder_term (&builder, left[i - 1]);
+          gtk_constraint_expression_builder_plus (&builder);
+          gtk_constraint_expression_builder_term (&builder, width[i - 1]);
+
+          gtk_constraint_solver_add_constraint (solver,
+                                                left[i], GTK_CONSTRAINT_RELATION_EQ,
+                                                gtk_constraint_expression_builder_finish (&builder),
+                                                GTK_CONSTRAINT_STRENGTH_REQUIRED);
+        }
+    }
+
+  gtk_constraint_solver_add_edit_variable (solver, left[0], GTK_CONSTRAINT_STRENGTH_STRONG);
+  gtk_constraint_solver_begin_edit (solver);
+
+  g_test_timer_start ();
+
+  for (i = 0; i < n_edits; i++)
+    {
+      gtk_constraint_solver_suggest_value (solver, left[0], i);
+      gtk_constraint_solver_resolve (solver);
+
+      g_assert_cmpfloat_with_epsilon (gtk_constraint_variable_get_value (left[n_boxes - 1]),
+                                      i + (n_boxes - 1) * 10.0,
+                                      0.001);
+    }
+
+  elapsed = g_test_timer_elapsed ();
+
+  gtk_constraint_solver_end_edit (solver);
+
+  if (g_test_perf ())
+    g_test_minimized_result (elapsed / n_edits, "Resolving a chain of %u boxes: %g seconds",
+                             n_boxes, elapsed / n_edits);
+
+  for (i = 0; i < n_boxes; i++)
+    {
+      gtk_constraint_variable_unref (left[i]);
+      gtk_constraint_variable_unref (width[i]);
+    }
+
+  g_free (left);
+  g_free (width);
+
+  g_object_unref (solver);
+}
+
 int
 main (int argc, char *argv[])
 {
@@ -376,6 +449,7 @@ main (int argc, char *argv[])
   g_test_add_func ("/constraint-solver/cassowary", constraint_solver_cassowary);
   g_test_add_func ("/constraint-solver/edit/required", constraint_solver_edit_var_required);
   g_test_add_func ("/constraint-solver/edit/suggest", constraint_solver_edit_var_suggest);
+  g_test_add_func ("/constraint-solver/edit/chain", constraint_solver_edit_chain);
 
   return g_test_run ();
 }
@@ -0,0 +1,238 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+#include "gtk/gtkwidgetprivate.h"
+
+/* Shows @container in a window, with a child that it hides */
+static GtkWidget *
+show_hidden_child (GtkWidget *container,
+                   GtkWidget *child)
+{
+  GtkWidget *window;
+
+  window = gtk_window_new ();
+  gtk_window_set_child (GTK_WINDOW (window), container);
+  gtk_window_present (GTK_WINDOW (window));
+
+  while (!gtk_widget_get_mapped (container))
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert_false (gtk_widget_get_mapped (child));
+
+  return window;
+}
+
+/* Allocates @child after the layout budget is used up */
+static void
+allocate_late (GtkWidget *child,
+               int        width,
+               int        height)
+{
+  gtk_widget_begin_layout_budget (0);
+  gtk_widget_allocate (child, width, height, -1, NULL);
+  gtk_widget_end_layout_budget ();
+}
+
+static void
+wait_for_deferred_allocations (GtkWidget *child)
+{
+  while (child->priv->alloc_deferred)
+    g_main_context_iteration (NULL, TRUE);
+}
+
+static GtkWidget *
+concealed_revealer (GtkWidget *child)
+{
+  GtkWidget *revealer;
+
+  revealer = gtk_revealer_new ();
+  gtk_revealer_set_transition_type (GTK_REVEALER (revealer), GTK_REVEALER_TRANSITION_TYPE_NONE);
+  gtk_revealer_set_child (GTK_REVEALER (revealer), child);
+
+  return revealer;
+}
+
+static void
+test_defer_opt_in (void)
+{
+  GtkWidget *window, *box, *child;
+
+  /* GtkBox doesn't allow deferring, so this must happen right away */
+  box = gtk_box_new (GTK_ORIENTATION_HORIZONTAL, 0);
+  child = gtk_label_new ("");
+  gtk_box_append (GTK_BOX (box), child);
+  gtk_widget_set_child_visible (child, FALSE);
+
+  window = show_hidden_child (box, child);
+
+  allocate_late (child, 100, 50);
+  g_assert_false (child->priv->alloc_deferred);
+  g_assert_cmpint (gtk_widget_get_width (child), ==, 100);
+  g_assert_cmpint (gtk_widget_get_height (child), ==, 50);
+
+  gtk_window_destroy (GTK_WINDOW (window));
+}
+
+static void
+test_defer_idle (void)
+{
+  GtkWidget *window, *child;
+
+  child = gtk_label_new ("");
+  window = show_hidden_child (concealed_revealer (child), child);
+
+  allocate_late (child, 100, 50);
+  g_assert_true (child->priv->alloc_deferred);
+  g_assert_cmpint (gtk_widget_get_width (child), !=, 100);
+
+  wait_for_deferred_allocations (child);
+  g_assert_cmpint (gtk_widget_get_width (child), ==, 100);
+  g_assert_cmpint (gtk_widget_get_height (child), ==, 50);
+
+  gtk_window_destroy (GTK_WINDOW (window));
+}
+
+static void
+test_defer_then_allocate (void)
+{
+  GtkWidget *window, *child;
+
+  child = gtk_label_new ("");
+  window = show_hidden_child (concealed_revealer (child), child);
+
+  allocate_late (child, 100, 50);
+  g_assert_true (child->priv->alloc_deferred);
+
+  /* A normal allocation replaces the deferred one */
+  gtk_widget_allocate (child, 80, 40, -1, NULL);
+  g_assert_false (child->priv->alloc_deferred);
+  g_assert_cmpint (gtk_widget_get_width (child), ==, 80);
+
+  /* and the idle must not apply the stale one */
+  while (g_main_context_iteration (NULL, FALSE));
+  g_assert_cmpint (gtk_widget_get_width (child), ==, 80);
+  g_assert_cmpint (gtk_widget_get_height (child), ==, 40);
+
+  gtk_window_destroy (GTK_WINDOW (window));
+}
+
+static void
+test_defer_map (void)
+{
+  GtkWidget *window, *revealer, *child;
+
+  child = gtk_label_new ("");
+  revealer = concealed_revealer (child);
+  window = show_hidden_child (revealer, child);
+
+  allocate_late (child, 100, 50);
+  g_assert_true (child->priv->alloc_deferred);
+
+  /* Mapping the child must catch up before it is drawn */
+  gtk_revealer_set_reveal_child (GTK_REVEALER (revealer), TRUE);
+  g_assert_true (gtk_widget_get_mapped (child));
+  g_assert_false (child->priv->alloc_deferred);
+  g_assert_true (gtk_widget_needs_allocate (child));
+
+  gtk_window_destroy (GTK_WINDOW (window));
+}
+
+/* GtkStack and the list widgets don't opt in to deferring, because
+ * they never allocate a child they hide. These tests make sure that
+ * stays true, since otherwise they would have to.
+ */
+static void
+test_stack_hidden_pages (void)
+{
+  GtkWidget *window, *stack, *visible, *hidden;
+
+  stack = gtk_stack_new ();
+  visible = gtk_label_new ("visible");
+  hidden = gtk_label_new ("hidden");
+  gtk_stack_add_child (GTK_STACK (stack), visible);
+  gtk_stack_add_child (GTK_STACK (stack), hidden);
+  gtk_stack_set_visible_child (GTK_STACK (stack), visible);
+
+  window = show_hidden_child (stack, hidden);
+
+  g_assert_true (gtk_widget_get_mapped (visible));
+  g_assert_cmpint (gtk_widget_get_width (visible), >, 0);
+  g_assert_cmpint (gtk_widget_get_width (hidden), ==, 0);
+  g_assert_cmpint (gtk_widget_get_height (hidden), ==, 0);
+
+  gtk_window_destroy (GTK_WINDOW (window));
+}
+
+static void
+setup_row (GtkSignalListItemFactory *factory,
+           GObject                  *item)
+{
+  gtk_list_item_set_child (GTK_LIST_ITEM (item), gtk_label_new ("row"));
+}
+
+static void
+test_list_hidden_rows (void)
+{
+  GtkWidget *window, *list, *child;
+  GtkListItemFactory *factory;
+  GtkStringList *strings;
+  guint i;
+
+  strings = gtk_string_list_new (NULL);
+  for (i = 0; i < 1000; i++)
+    gtk_string_list_take (strings, g_strdup_printf ("%u", i));
+
+  factory = gtk_signal_list_item_factory_new ();
+  g_signal_connect (factory, "setup", G_CALLBACK (setup_row), NULL);
+  list = gtk_list_view_new (GTK_SELECTION_MODEL (gtk_no_selection_new (G_LIST_MODEL (strings))), factory);
+
+  window = gtk_window_new ();
+  gtk_window_set_default_size (GTK_WINDOW (window), 200, 200);
+  gtk_window_set_child (GTK_WINDOW (window), gtk_scrolled_window_new ());
+  gtk_scrolled_window_set_child (GTK_SCROLLED_WINDOW (gtk_window_get_child (GTK_WINDOW (window))), list);
+  gtk_window_present (GTK_WINDOW (window));
+
+  while (!gtk_widget_get_mapped (list) || gtk_widget_needs_allocate (list))
+    g_main_context_iteration (NULL, TRUE);
+
+  /* Rows outside the viewport are hidden and not allocated,
+   * every other row is mapped.
+   */
+  for (child = gtk_widget_get_first_child (list);
+       child != NULL;
+       child = gtk_widget_get_next_sibling (child))
+    {
+      if (gtk_widget_get_child_visible (child) && gtk_widget_get_visible (child))
+        g_assert_true (gtk_widget_get_mapped (child));
+    }
+
+  gtk_window_destroy (GTK_WINDOW (window));
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/widget/deferred-allocate/opt-in", test_defer_opt_in);
+  g_test_add_func ("/widget/deferred-allocate/idle", test_defer_idle);
+  g_test_add_func ("/widget/deferred-allocate/then-allocate", test_defer_then_allocate);
+  g_test_add_func ("/widget/deferred-allocate/map", test_defer_map);
+  g_test_add_func ("/widget/deferred-allocate/stack-hidden-pages", test_stack_hidden_pages);
+  g_test_add_func ("/widget/deferred-allocate/list-hidden-rows", test_list_hidden_rows);
+
+  return g_test_run ();
+}
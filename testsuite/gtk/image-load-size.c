@@ -0,0 +1,149 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+#include <glib/gstdio.h>
+#include "gtk/gdktextureutilsprivate.h"
+#include "gtk/gtkiconpaintableprivate.h"
+
+#define IMAGE_WIDTH 512
+#define IMAGE_HEIGHT 256
+
+static char *dir;
+static char *filename;
+
+static void
+write_image (void)
+{
+  GdkTexture *texture;
+  GBytes *bytes;
+  guchar *data;
+  gsize i;
+
+  data = g_malloc (IMAGE_WIDTH * IMAGE_HEIGHT * 4);
+  for (i = 0; i < IMAGE_WIDTH * IMAGE_HEIGHT * 4; i++)
+    data[i] = i % 255;
+
+  bytes = g_bytes_new_take (data, IMAGE_WIDTH * IMAGE_HEIGHT * 4);
+  texture = gdk_memory_texture_new (IMAGE_WIDTH, IMAGE_HEIGHT,
+                                    GDK_MEMORY_R8G8B8A8,
+                                    bytes,
+                                    IMAGE_WIDTH * 4);
+
+  dir = g_dir_make_tmp ("imageloadsizeXXXXXX", NULL);
+  filename = g_build_filename (dir, "image.png", NULL);
+  g_assert_true (gdk_texture_save_to_png (texture, filename));
+
+  g_object_unref (texture);
+  g_bytes_unref (bytes);
+}
+
+static void
+assert_texture_size (GdkPaintable *paintable,
+                     int           width,
+                     int           height)
+{
+  g_assert_true (GDK_IS_TEXTURE (paintable));
+  g_assert_cmpint (gdk_texture_get_width (GDK_TEXTURE (paintable)), ==, width);
+  g_assert_cmpint (gdk_texture_get_height (GDK_TEXTURE (paintable)), ==, height);
+}
+
+static void
+test_paintable (void)
+{
+  GdkPaintable *paintable;
+
+  paintable = gdk_paintable_new_from_filename (filename, -1, NULL);
+  assert_texture_size (paintable, IMAGE_WIDTH, IMAGE_HEIGHT);
+  g_object_unref (paintable);
+
+  /* The smallest power of 2 reduction that is at least 40x40 */
+  paintable = gdk_paintable_new_from_filename (filename, 40, NULL);
+  assert_texture_size (paintable, IMAGE_WIDTH / 4, IMAGE_HEIGHT / 4);
+  g_object_unref (paintable);
+
+  paintable = gdk_paintable_new_from_filename (filename, IMAGE_WIDTH, NULL);
+  assert_texture_size (paintable, IMAGE_WIDTH, IMAGE_HEIGHT);
+  g_object_unref (paintable);
+}
+
+static void
+test_image (void)
+{
+  GtkWidget *image;
+  char *file;
+
+  image = g_object_ref_sink (gtk_image_new ());
+  gtk_image_set_pixel_size (GTK_IMAGE (image), 40);
+  gtk_image_set_from_file (GTK_IMAGE (image), filename);
+  assert_texture_size (gtk_image_get_paintable (GTK_IMAGE (image)), IMAGE_WIDTH / 4, IMAGE_HEIGHT / 4);
+
+  /* Growing the image loads the file again */
+  gtk_image_set_pixel_size (GTK_IMAGE (image), 100);
+  g_object_get (image, "file", &file, NULL);
+  g_assert_cmpstr (file, ==, filename);
+  g_free (file);
+  assert_texture_size (gtk_image_get_paintable (GTK_IMAGE (image)), IMAGE_WIDTH / 2, IMAGE_HEIGHT / 2);
+
+  /* but shrinking it doesn't */
+  gtk_image_set_pixel_size (GTK_IMAGE (image), 20);
+  assert_texture_size (gtk_image_get_paintable (GTK_IMAGE (image)), IMAGE_WIDTH / 2, IMAGE_HEIGHT / 2);
+
+  g_object_unref (image);
+}
+
+static void
+test_icon (void)
+{
+  GtkIconPaintable *icon;
+  GFile *file;
+
+  file = g_file_new_for_path (filename);
+  icon = gtk_icon_paintable_new_for_file (file, 20, 2);
+
+  gtk_icon_paintable_load_in_thread (icon);
+  assert_texture_size (icon->paintable, IMAGE_WIDTH / 4, IMAGE_HEIGHT / 4);
+
+  /* Drawing it bigger loads it again */
+  g_object_set (icon, "scale", 4, NULL);
+  gtk_icon_paintable_load_in_thread (icon);
+  assert_texture_size (icon->paintable, IMAGE_WIDTH / 2, IMAGE_HEIGHT / 2);
+
+  g_object_unref (icon);
+  g_object_unref (file);
+}
+
+int
+main (int argc, char *argv[])
+{
+  int result;
+
+  gtk_test_init (&argc, &argv, NULL);
+
+  write_image ();
+
+  g_test_add_func ("/image-load-size/paintable", test_paintable);
+  g_test_add_func ("/image-load-size/image", test_image);
+  g_test_add_func ("/image-load-size/icon", test_icon);
+
+  result = g_test_run ();
+
+  g_unlink (filename);
+  g_rmdir (dir);
+  g_free (filename);
+  g_free (dir);
+
+  return result;
+}
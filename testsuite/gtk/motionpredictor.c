@@ -0,0 +1,153 @@
+/* Copyright (C) 2026 Red Hat, Inc.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+#include <gtk/gtk.h>
+#include <gtk/gtkmotionpredictorprivate.h>
+
+/* Arrival times are in µs, event times in ms */
+#define ARRIVAL(t) ((gint64) (t) * 1000)
+
+static void
+test_empty (void)
+{
+  GtkMotionPredictor *predictor;
+  double x, y;
+
+  predictor = gtk_motion_predictor_new ();
+
+  g_assert_false (gtk_motion_predictor_predict (predictor, ARRIVAL (10), &x, &y));
+
+  gtk_motion_predictor_add_sample (predictor, 0, 5, 7, ARRIVAL (0));
+  g_assert_true (gtk_motion_predictor_predict (predictor, ARRIVAL (10), &x, &y));
+  g_assert_cmpfloat (x, ==, 5);
+  g_assert_cmpfloat (y, ==, 7);
+
+  gtk_motion_predictor_reset (predictor);
+  g_assert_false (gtk_motion_predictor_predict (predictor, ARRIVAL (10), &x, &y));
+
+  gtk_motion_predictor_free (predictor);
+}
+
+static void
+test_linear (void)
+{
+  GtkMotionPredictor *predictor;
+  double x, y;
+  guint t;
+
+  predictor = gtk_motion_predictor_new ();
+
+  /* 1 pixel per ms to the right, 0.5 pixels per ms up */
+  for (t = 100; t <= 120; t += 4)
+    gtk_motion_predictor_add_sample (predictor, t, t, - 0.5 * t, ARRIVAL (t));
+
+  g_assert_true (gtk_motion_predictor_predict (predictor, ARRIVAL (136), &x, &y));
+  g_assert_cmpfloat_with_epsilon (x, 136, 0.0001);
+  g_assert_cmpfloat_with_epsilon (y, -68, 0.0001);
+
+  /* Targets in the past don't predict anything */
+  g_assert_true (gtk_motion_predictor_predict (predictor, ARRIVAL (110), &x, &y));
+  g_assert_cmpfloat (x, ==, 120);
+  g_assert_cmpfloat (y, ==, -60);
+
+  gtk_motion_predictor_free (predictor);
+}
+
+static void
+test_wraparound (void)
+{
+  GtkMotionPredictor *predictor;
+  double x, y;
+  guint32 t;
+  int i;
+
+  predictor = gtk_motion_predictor_new ();
+
+  for (i = 0; i < 6; i++)
+    {
+      t = G_MAXUINT32 - 8 + 4 * i;
+      gtk_motion_predictor_add_sample (predictor, t, 2 * i, 0, ARRIVAL (4 * i));
+    }
+
+  /* 0.5 pixels per ms for 10ms */
+  g_assert_true (gtk_motion_predictor_predict (predictor, ARRIVAL (30), &x, &y));
+  g_assert_cmpfloat_with_epsilon (x, 15, 0.0001);
+  g_assert_cmpfloat_with_epsilon (y, 0, 0.0001);
+
+  gtk_motion_predictor_free (predictor);
+}
+
+static void
+test_stopped (void)
+{
+  GtkMotionPredictor *predictor;
+  double x, y;
+  guint t;
+
+  predictor = gtk_motion_predictor_new ();
+
+  for (t = 0; t <= 20; t += 4)
+    gtk_motion_predictor_add_sample (predictor, t, t, t, ARRIVAL (t));
+
+  /* No new samples for a long time, so the pointer stopped */
+  g_assert_true (gtk_motion_predictor_predict (predictor, ARRIVAL (200), &x, &y));
+  g_assert_cmpfloat (x, ==, 20);
+  g_assert_cmpfloat (y, ==, 20);
+
+  /* Old samples are not used for the fit */
+  gtk_motion_predictor_add_sample (predictor, 500, 20, 20, ARRIVAL (500));
+  gtk_motion_predictor_add_sample (predictor, 504, 20, 20, ARRIVAL (504));
+  g_assert_true (gtk_motion_predictor_predict (predictor, ARRIVAL (520), &x, &y));
+  g_assert_cmpfloat (x, ==, 20);
+  g_assert_cmpfloat (y, ==, 20);
+
+  gtk_motion_predictor_free (predictor);
+}
+
+static void
+test_out_of_order (void)
+{
+  GtkMotionPredictor *predictor;
+  double x, y;
+  guint t;
+
+  predictor = gtk_motion_predictor_new ();
+
+  for (t = 0; t <= 20; t += 4)
+    gtk_motion_predictor_add_sample (predictor, t, t, 0, ARRIVAL (t));
+
+  gtk_motion_predictor_add_sample (predictor, 10, 1000, 1000, ARRIVAL (21));
+
+  g_assert_true (gtk_motion_predictor_predict (predictor, ARRIVAL (30), &x, &y));
+  g_assert_cmpfloat_with_epsilon (x, 30, 0.0001);
+  g_assert_cmpfloat_with_epsilon (y, 0, 0.0001);
+
+  gtk_motion_predictor_free (predictor);
+}
+
+int
+main (int   argc,
+      char *argv[])
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/motionpredictor/empty", test_empty);
+  g_test_add_func ("/motionpredictor/linear", test_linear);
+  g_test_add_func ("/motionpredictor/wraparound", test_wraparound);
+  g_test_add_func ("/motionpredictor/stopped", test_stopped);
+  g_test_add_func ("/motionpredictor/out-of-order", test_out_of_order);
+
+  return g_test_run ();
+}
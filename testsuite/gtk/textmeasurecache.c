@@ -0,0 +1,258 @@
+/*
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2.1 of the License, or (at your option) any later version.
+ *
+ * This library is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library. If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <gtk/gtk.h>
+#include "gtk/gtktextmeasurecacheprivate.h"
+
+static GtkWidget *
+new_label (const char *text)
+{
+  return g_object_ref_sink (gtk_label_new (text));
+}
+
+static void
+set_attribute (GtkWidget      *label,
+               PangoAttribute *attr)
+{
+  PangoAttrList *attrs;
+
+  attrs = pango_attr_list_new ();
+  pango_attr_list_insert (attrs, attr);
+  gtk_label_set_attributes (GTK_LABEL (label), attrs);
+  pango_attr_list_unref (attrs);
+}
+
+/* Measures the height of @label for @width and checks whether
+ * the cache was used
+ */
+static void
+measure_for_width (GtkWidget *label,
+                   int        width,
+                   gboolean   expect_hit)
+{
+  guint hits_before, misses_before, hits, misses, cached;
+  int min, nat;
+
+  gtk_text_measure_cache_get_stats (&hits_before, &misses_before, &cached);
+  if (width < 0)
+    gtk_widget_measure (label, GTK_ORIENTATION_HORIZONTAL, -1, &min, &nat, NULL, NULL);
+  else
+    gtk_widget_measure (label, GTK_ORIENTATION_VERTICAL, width, &min, &nat, NULL, NULL);
+  gtk_text_measure_cache_get_stats (&hits, &misses, &cached);
+
+  if (expect_hit)
+    {
+      g_assert_cmpuint (hits, >, hits_before);
+      g_assert_cmpuint (misses, ==, misses_before);
+    }
+  else
+    {
+      g_assert_cmpuint (misses, >, misses_before);
+      g_assert_cmpuint (hits, ==, hits_before);
+    }
+}
+
+/* Measures the width of @label and checks whether the cache was used */
+static void
+measure (GtkWidget *label,
+         gboolean   expect_hit)
+{
+  measure_for_width (label, -1, expect_hit);
+}
+
+static GtkWidget *
+new_wrapped_label (void)
+{
+  GtkWidget *label;
+
+  label = new_label ("A text that is long enough to wrap into multiple lines");
+  gtk_label_set_wrap (GTK_LABEL (label), TRUE);
+
+  return label;
+}
+
+static void
+test_share (void)
+{
+  GtkWidget *l1, *l2, *l3;
+
+  l1 = new_label ("Shared text");
+  l2 = new_label ("Shared text");
+  l3 = new_label ("Other text");
+
+  measure (l1, FALSE);
+  measure (l2, TRUE);
+  measure (l3, FALSE);
+
+  g_object_unref (l1);
+  g_object_unref (l2);
+  g_object_unref (l3);
+}
+
+static void
+test_size_changes (void)
+{
+  GtkCssProvider *provider;
+  GtkWidget *plain, *label;
+
+  plain = new_label ("Changing text");
+  measure (plain, FALSE);
+
+  /* Attributes that change the size */
+  label = new_label ("Changing text");
+  set_attribute (label, pango_attr_weight_new (PANGO_WEIGHT_BOLD));
+  measure (label, FALSE);
+  g_object_unref (label);
+
+  label = new_label ("Changing text");
+  set_attribute (label, pango_attr_font_desc_new (pango_font_description_from_string ("Serif 30")));
+  measure (label, FALSE);
+  g_object_unref (label);
+
+  /* Widget properties that change the size */
+  label = new_label ("Changing text");
+  gtk_label_set_width_chars (GTK_LABEL (label), 40);
+  measure (label, FALSE);
+  g_object_unref (label);
+
+  /* A font from CSS */
+  provider = gtk_css_provider_new ();
+  gtk_css_provider_load_from_string (provider, ".big { font-size: 30px; }");
+  gtk_style_context_add_provider_for_display (gdk_display_get_default (),
+                                              GTK_STYLE_PROVIDER (provider),
+                                              GTK_STYLE_PROVIDER_PRIORITY_USER);
+
+  label = new_label ("Changing text");
+  gtk_widget_add_css_class (label, "big");
+  measure (label, FALSE);
+  g_object_unref (label);
+
+  gtk_style_context_remove_provider_for_display (gdk_display_get_default (),
+                                                 GTK_STYLE_PROVIDER (provider));
+  g_object_unref (provider);
+
+  /* Changing the font of a label that was measured */
+  set_attribute (plain, pango_attr_size_new (30 * PANGO_SCALE));
+  measure (plain, FALSE);
+
+  g_object_unref (plain);
+}
+
+static void
+test_color_change (void)
+{
+  GtkWidget *l1, *l2;
+
+  l1 = new_label ("Colored text");
+  measure (l1, FALSE);
+
+  l2 = new_label ("Colored text");
+  set_attribute (l2, pango_attr_foreground_new (65535, 0, 0));
+  measure (l2, TRUE);
+
+  /* Restyling a label that was measured */
+  set_attribute (l1, pango_attr_background_new (0, 0, 65535));
+  measure (l1, TRUE);
+
+  g_object_unref (l1);
+  g_object_unref (l2);
+}
+
+static void
+test_wrapped (void)
+{
+  GtkWidget *labels[4];
+  guint hits, misses, cached, cached_before;
+  int width, min, nat;
+  guint i;
+
+  for (i = 0; i < G_N_ELEMENTS (labels); i++)
+    labels[i] = new_wrapped_label ();
+
+  /* Rows of a list all get the same width */
+  measure_for_width (labels[0], 100, FALSE);
+  measure_for_width (labels[1], 100, TRUE);
+
+  /* Other widths don't replace the earlier ones */
+  measure_for_width (labels[0], 200, FALSE);
+  measure_for_width (labels[2], 200, TRUE);
+  measure_for_width (labels[3], 100, TRUE);
+
+  /* Resizing doesn't fill the cache */
+  gtk_text_measure_cache_get_stats (&hits, &misses, &cached_before);
+  for (width = 150; width < 600; width++)
+    gtk_widget_measure (labels[0], GTK_ORIENTATION_VERTICAL, width, &min, &nat, NULL, NULL);
+  gtk_text_measure_cache_get_stats (&hits, &misses, &cached);
+  g_assert_cmpuint (cached, ==, cached_before);
+
+  for (i = 0; i < G_N_ELEMENTS (labels); i++)
+    g_object_unref (labels[i]);
+}
+
+static void
+test_clear_on_setting_change (void)
+{
+  GtkSettings *settings = gtk_settings_get_default ();
+  GtkWidget *label;
+  guint hits, misses, cached;
+  char *font_name;
+  int dpi;
+
+  g_object_get (settings,
+                "gtk-font-name", &font_name,
+                "gtk-xft-dpi", &dpi,
+                NULL);
+
+  label = new_label ("Settings text");
+  measure (label, FALSE);
+  gtk_text_measure_cache_get_stats (&hits, &misses, &cached);
+  g_assert_cmpuint (cached, >, 0);
+
+  g_object_set (settings, "gtk-xft-dpi", dpi > 0 ? 2 * dpi : 192 * 1024, NULL);
+  gtk_text_measure_cache_get_stats (&hits, &misses, &cached);
+  g_assert_cmpuint (cached, ==, 0);
+
+  g_object_unref (label);
+  label = new_label ("Settings text");
+  measure (label, FALSE);
+  gtk_text_measure_cache_get_stats (&hits, &misses, &cached);
+  g_assert_cmpuint (cached, >, 0);
+
+  g_object_set (settings, "gtk-font-name", "Serif 30", NULL);
+  gtk_text_measure_cache_get_stats (&hits, &misses, &cached);
+  g_assert_cmpuint (cached, ==, 0);
+
+  g_object_set (settings,
+                "gtk-font-name", font_name,
+                "gtk-xft-dpi", dpi,
+                NULL);
+
+  g_object_unref (label);
+  g_free (font_name);
+}
+
+int
+main (int argc, char *argv[])
+{
+  gtk_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/textmeasurecache/share", test_share);
+  g_test_add_func ("/textmeasurecache/size-changes", test_size_changes);
+  g_test_add_func ("/textmeasurecache/color-change", test_color_change);
+  g_test_add_func ("/textmeasurecache/wrapped", test_wrapped);
+  g_test_add_func ("/textmeasurecache/clear-on-setting-change", test_clear_on_setting_change);
+
+  return g_test_run ();
+}
@@ -0,0 +1,124 @@
+/*  Copyright 2026 Red Hat, Inc.
+ *
+ * GTK is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * GLib is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with GTK; see the file COPYING.  If not,
+ * see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+
+#include <glib/gi18n-lib.h>
+#include <glib/gprintf.h>
+#include <glib/gstdio.h>
+#include <gtk/gtk.h>
+#include "gtkbuilderprivate.h"
+#include "gtk-builder-tool.h"
+
+void
+do_precompile (int *argc, const char ***argv)
+{
+  GtkBuilder *builder;
+  GError *error = NULL;
+  char *contents;
+  gsize length;
+  GBytes *bytes;
+  gconstpointer data;
+  gsize size;
+  char **filenames = NULL;
+  char *output = NULL;
+  GOptionContext *context;
+  const GOptionEntry entries[] = {
+    { "output", 'o', 0, G_OPTION_ARG_FILENAME, &output, N_("Write to this file instead of stdout"), N_("FILE") },
+    { G_OPTION_REMAINING, 0, 0, G_OPTION_ARG_FILENAME_ARRAY, &filenames, NULL, N_("FILE") },
+    { NULL, }
+  };
+
+  g_set_prgname ("gtk4-builder-tool precompile");
+  context = g_option_context_new (NULL);
+  g_option_context_set_translation_domain (context, GETTEXT_PACKAGE);
+  g_option_context_add_main_entries (context, entries, NULL);
+  g_option_context_set_summary (context, _("Convert the file to the binary format."));
+
+  if (!g_option_context_parse (context, argc, (char ***)argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      g_error_free (error);
+      exit (1);
+    }
+
+  g_option_context_free (context);
+
+  if (filenames == NULL)
+    {
+      g_printerr (_("No .ui file specified\n"));
+      exit (1);
+    }
+
+  if (g_strv_length (filenames) > 1)
+    {
+      g_printerr (_("Can only precompile a single .ui file\n"));
+      exit (1);
+    }
+
+  if (!g_file_get_contents (filenames[0], &contents, &length, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      exit (1);
+    }
+
+  if (_gtk_buildable_parser_is_precompiled (contents, length))
+    {
+      g_printerr (_("%s is already precompiled\n"), filenames[0]);
+      exit (1);
+    }
+
+  /* The builder is only used to look up types */
+  builder = gtk_builder_new ();
+
+  bytes = _gtk_buildable_parser_precompile (contents, length, builder, &error);
+  if (bytes == NULL)
+    {
+      g_printerr ("%s\n", error->message);
+      exit (1);
+    }
+
+  data = g_bytes_get_data (bytes, &size);
+
+  if (output)
+    {
+      if (!g_file_set_contents (output, data, size, &error))
+        {
+          g_printerr ("%s\n", error->message);
+          exit (1);
+        }
+    }
+  else
+    {
+      if (fwrite (data, 1, size, stdout) != size)
+        {
+          g_printerr (_("Failed to write output: %s\n"), g_strerror (errno));
+          exit (1);
+        }
+    }
+
+  g_bytes_unref (bytes);
+  g_object_unref (builder);
+  g_free (contents);
+  g_free (output);
+  g_strfreev (filenames);
+}
@@ -45,6 +45,7 @@ usage (void)
              "  preview      Preview the file\n"
              "  render       Take a screenshot of the file\n"
              "  screenshot   Take a screenshot of the file\n"
+             "  precompile   Convert the file to the binary format\n"
              "\n"));
   exit (0);
 }
@@ -122,6 +123,8 @@ main (int argc, const char *argv[])
   else if (strcmp (argv[0], "render") == 0 ||
            strcmp (argv[0], "screenshot") == 0)
     do_screenshot (&argc, &argv);
+  else if (strcmp (argv[0], "precompile") == 0)
+    do_precompile (&argc, &argv);
   else
     usage ();
 
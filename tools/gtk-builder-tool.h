@@ -5,3 +5,4 @@ void do_validate   (int *argc, const char ***argv);
 void do_enumerate  (int *argc, const char ***argv);
 void do_preview    (int *argc, const char ***argv);
 void do_screenshot (int *argc, const char ***argv);
+void do_precompile (int *argc, const char ***argv);